@@ -9,6 +9,8 @@
 #include "glm/gtx/quaternion.hpp"
 
 #include "ImGuiSupport.h"
+#include "llrm_trace.h"
+#include "llrm_capture.h"
 
 static Ruby::ObjectId gCube;
 
@@ -113,6 +115,22 @@ void DrawEditorWindows()
 		{ 
 			ImGui::Checkbox("Shadows", &Settings.mShadowsEnabled);
 		}
+#ifdef LLRM_TRACE
+		if (ImGui::CollapsingHeader("Profiling"))
+		{
+			if (ImGui::Button("Export Trace"))
+				llrm::TraceExportChrome("EditorTrace.json");
+		}
+#endif
+#ifdef LLRM_CAPTURE
+		if (ImGui::CollapsingHeader("Capture"))
+		{
+			if (llrm::IsCapturing())
+				ImGui::Text("Capturing...");
+			else if (ImGui::Button("Capture Frame"))
+				llrm::CaptureFrames("EditorCapture.llrmcap");
+		}
+#endif
 	}
 	ImGui::End();
 
@@ -127,7 +145,7 @@ int main()
 		return 0;
 	}
 
-#if LLRM_VULKAN
+#if LLRM_VULKAN || LLRM_NULL
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 #endif
 
@@ -2,14 +2,15 @@
 
 #ifdef LLRM_BUILD_IMGUI
 
-#include "llrm_vulkan.h"
 #include "imgui_internal.h"
 #include "backends/imgui_impl_glfw.h"
+
+#ifdef LLRM_VULKAN
+#include "llrm_vulkan.h"
 #include "backends/imgui_impl_vulkan.h"
 
 struct VulkanCommandBuffer;
 
-#ifdef LLRM_VULKAN
 void RecordImGuiCmds(llrm::CommandBuffer Dst)
 {
     VulkanCommandBuffer* VkCmd = static_cast<VulkanCommandBuffer*>(Dst);
@@ -17,6 +18,25 @@ void RecordImGuiCmds(llrm::CommandBuffer Dst)
 }
 #endif
 
+#ifdef LLRM_NULL
+// Nothing is rendered, the draw data is only built so the CPU cost of the UI is still measured
+void RecordImGuiCmds(llrm::CommandBuffer Dst)
+{
+}
+
+void InitImGuiNull(GLFWwindow* Wnd)
+{
+    ImGui_ImplGlfw_InitForOther(Wnd, true);
+
+    // Renderer backends build the font atlas when they upload it
+    unsigned char* Pixels;
+    int Width, Height;
+    ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&Pixels, &Width, &Height);
+}
+#endif
+
+#ifdef LLRM_VULKAN
+
 void InitImGuiVulkan(GLFWwindow* Wnd, llrm::Context Context, llrm::RenderGraph Graph, llrm::SwapChain Swap)
 {
     VulkanContext* VkContext = static_cast<VulkanContext*>(Context);
@@ -50,6 +70,7 @@ void InitImGuiVulkan(GLFWwindow* Wnd, llrm::Context Context, llrm::RenderGraph G
     ImGui_ImplVulkan_DestroyFontUploadObjects();
 
 }
+#endif
 
 void BeginImGuiFrame()
 {
@@ -75,6 +96,11 @@ void UpdateImGuiViewports()
     if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
     {
         ImGui::UpdatePlatformWindows();
+
+#ifdef LLRM_VULKAN
+        // ImGui's Vulkan backend submits and presents the extra viewports itself
+        std::lock_guard<std::mutex> QueueLock(llrm::GQueueMutex);
+#endif
         ImGui::RenderPlatformWindowsDefault();
     }
 }
@@ -103,6 +129,8 @@ ImGuiContext* InitImGui(GLFWwindow* Wnd, llrm::Context Context, llrm::SwapChain
     // Initialize backend
 #ifdef LLRM_VULKAN
     InitImGuiVulkan(Wnd, Context, Graph, Swap);
+#elif defined(LLRM_NULL)
+    InitImGuiNull(Wnd);
 #endif
 
     // Setup Platform/Renderer bindings
@@ -114,7 +142,10 @@ void ShutdownImGui(llrm::Context Context)
 {
 #ifdef LLRM_VULKAN
     VulkanContext* VkContext = static_cast<VulkanContext*>(Context);
-	vkDeviceWaitIdle(VkContext->Device);
+	{
+		std::lock_guard<std::mutex> QueueLock(llrm::GQueueMutex);
+		vkDeviceWaitIdle(VkContext->Device);
+	}
     ImGui_ImplVulkan_Shutdown();
 #endif
 
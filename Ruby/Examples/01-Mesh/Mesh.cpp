@@ -4,6 +4,7 @@
 #include "MeshGenerator.h"
 #include "Utill.h"
 #include <chrono>
+#include <cstdio>
 
 static Ruby::ObjectId gCube;
 
@@ -49,7 +50,7 @@ int main()
 		return 0;
 	}
 
-#if LLRM_VULKAN
+#if LLRM_VULKAN || LLRM_NULL
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 #endif
 
@@ -64,6 +65,7 @@ int main()
 	Ruby::SceneId NewScene = CreateScene();
 
 	auto Last = std::chrono::high_resolution_clock::now();
+	uint32_t Frame = 0;
 
 	while(!glfwWindowShouldClose(Wnd))
 	{
@@ -84,7 +86,19 @@ int main()
 		Cam.mProjection = Ruby::BuildPerspective(70.0f, Width / (float)Height, 0.1f, 15000.0f);
 		Cam.mPosition.z = 10.0f;
 
-		Ruby::RenderScene(NewScene, Target, glm::ivec2{Width, Height}, Cam, Swap, {true});
+		// The cube is always in front of the camera, so once its query has been resolved it must never be culled.
+		// Query results are read inside the frame, after that the next resolve may already be overwriting them.
+		bool bCubeOccluded = false;
+		Ruby::RenderScene(NewScene, Target, glm::ivec2{Width, Height}, Cam, Swap, {true, true}, [&](const llrm::CommandBuffer&)
+		{
+			bCubeOccluded = Ruby::IsObjectOccluded(NewScene, gCube);
+		});
+
+		if (++Frame > llrm::GetFramesInFlight() && bCubeOccluded)
+		{
+			std::fprintf(stderr, "The cube in front of the camera was occluded on frame %u\n", Frame);
+			return 1;
+		}
 	}
 
 	return 0;
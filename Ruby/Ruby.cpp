@@ -1,13 +1,25 @@
 #include "Ruby.h"
 
 #include "llrm.h"
+#include "llrm_trace.h"
 #include "GLFW/glfw3.h"
 #include "Utill.h"
 #include "ShaderManager.h"
 #include "glm/vec2.hpp"
 #include "Vertex.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define RUBY_SSE2 1
+#else
+	#define RUBY_SSE2 0
+#endif
 
 #define SHADOW_MAP_RESOLUTION uint32_t(1024)
+#define MAX_OCCLUSION_QUERIES uint32_t(4096) // Mesh objects past this many are always drawn
+#define MAX_LIGHT_DATA uint32_t(1 + 3 * MAX_DIR_LIGHTS + 5 * MAX_SPOT_LIGHTS) // Rows of light data: the light count, then 3 rows per directional and 5 per spot light
 
 namespace Ruby
 {
@@ -40,7 +52,8 @@ namespace Ruby
 		return Distance * TO_METERS;
 	}
 
-#if LLRM_VULKAN
+#if LLRM_VULKAN || LLRM_NULL
+	// The null backend takes the same SPIR-V, so it shares the Vulkan shader cache
 	RenderingAPI GAPI = RenderingAPI::Vulkan;
 #endif
 
@@ -161,9 +174,10 @@ namespace Ruby
 		{
 			// Create string
 			std::string UberFrag = "DeferredShade_" + std::to_string(uint32_t(UseShadows));
+			llrm::ShaderProgram Program = LoadRasterShader("DeferredShade", UberFrag);
 			llrm::Pipeline NewPipe = llrm::CreatePipeline({
-				LoadRasterShader("DeferredShade", UberFrag),
-				GContext.mDeferredShadeRG,
+				Program,
+				GContext.mDeferredRG,
 				{GContext.mLightsResourceLayout, GContext.mDeferredShadeRl},
 				sizeof(PosUV),
 				{
@@ -173,9 +187,12 @@ namespace Ruby
 				llrm::PipelineRenderPrimitive::TRIANGLES,
 				{{false}},
 				{false},
-				0
+				1
 			});
 
+			// Permutations share the vertex stage, and the pipeline no longer needs either module
+			llrm::ReleaseShaderModules(Program);
+
 			mDeferredShadePipelines[Params] = NewPipe;
 
 			return NewPipe;
@@ -198,10 +215,14 @@ namespace Ruby
 			NewContext.ShadersRoot = GetDefaultShadersPath();
 		}
 
-		if (!glfwInit())
+		if (!Params.Headless && !glfwInit())
 			return {}; // Error
 
-		NewContext.LLContext = llrm::CreateContext();
+		llrm::ContextCreateInfo ContextInfo{};
+		ContextInfo.bHeadless = Params.Headless;
+		ContextInfo.FramesInFlight = Params.FramesInFlight;
+		ContextInfo.Device = Params.Device;
+		NewContext.LLContext = llrm::CreateContext(ContextInfo);
 
 		Ruby::InitShaderCompilation();
 
@@ -224,11 +245,14 @@ namespace Ruby
 		NewContext.mLightsResourceLayout = llrm::CreateResourceLayout({
 			{},
 			{
-				{0, llrm::ShaderStage::Fragment, 1}, // Light data texture
 				{1, llrm::ShaderStage::Fragment, 1}, // Shadow map texture array
-				{2, llrm::ShaderStage::Fragment, 1} // Shadow map frustum data texture
 			},
-			{}
+			{},
+			{},
+			{
+				{0, llrm::ShaderStage::Fragment, 1}, // Light data
+				{2, llrm::ShaderStage::Fragment, 1} // Shadow map frustum data
+			}
 		});
 
 		NewContext.mObjectResourceLayout = llrm::CreateResourceLayout({
@@ -245,17 +269,23 @@ namespace Ruby
 {
 				{5, llrm::ShaderStage::Fragment, sizeof(DeferredShadeResources), 1}
 			},
+			{},
+			{
+				{0, llrm::ShaderStage::Fragment, 1} // Nearest sampler for reading the G-buffer
+			},
 			{
 				{1, llrm::ShaderStage::Fragment, 1}, // Albedo
 				{2, llrm::ShaderStage::Fragment, 1}, // Position
 				{3, llrm::ShaderStage::Fragment, 1}, // Normal
 				{4, llrm::ShaderStage::Fragment, 1}  // Roughness, metallic, ambient occlusion, unused
-			},
-			{
-				{0, llrm::ShaderStage::Fragment, 1} // Albedo
 			}
 		});
 
+		NewContext.mOcclusionProxyLayout = llrm::CreateResourceLayout({
+{
+		{0, llrm::ShaderStage::Vertex, sizeof(OcclusionProxyUniforms), 1}
+		}, {} });
+
 		NewContext.mMaterialLayout = llrm::CreateResourceLayout({{
 				{0, llrm::ShaderStage::Fragment, sizeof(ShaderUniform_Material), 1}
 			},
@@ -269,61 +299,121 @@ namespace Ruby
 		llrm::UpdateUniformBuffer(NewContext.mDefaultMaterial, 0, &DefaultMaterial, sizeof(DefaultMaterial), false);
 
 		// Create render graphs
-		NewContext.mDeferredGeoRG = llrm::CreateRenderGraph({
+		// The G-buffer and depth only live for the duration of the render graph, so they're never stored
+		NewContext.mDeferredRG = llrm::CreateRenderGraph({
 			{
-				{llrm::AttachmentUsage::ColorAttachment, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentFormat::RGBA16F_Float}, // Albedo
-				{llrm::AttachmentUsage::ColorAttachment, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentFormat::RGBA16F_Float}, // Position
-				{llrm::AttachmentUsage::ColorAttachment, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentFormat::RGBA16F_Float}, // Normal
-				{llrm::AttachmentUsage::ColorAttachment, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentFormat::RGBA16F_Float}, // Roughness, metallic, ambient occlusion, unused
-				{llrm::AttachmentUsage::DepthStencilAttachment, llrm::AttachmentUsage::DepthStencilAttachment, llrm::AttachmentFormat::D24_UNORM_S8_UINT} // Depth
+				{llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ColorAttachment, llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentLoadOp::Clear, llrm::AttachmentStoreOp::DontCare}, // Albedo
+				{llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ColorAttachment, llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentLoadOp::Clear, llrm::AttachmentStoreOp::DontCare}, // Position
+				{llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ColorAttachment, llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentLoadOp::Clear, llrm::AttachmentStoreOp::DontCare}, // Normal
+				{llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ColorAttachment, llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentLoadOp::Clear, llrm::AttachmentStoreOp::DontCare}, // Roughness, metallic, ambient occlusion, unused
+				{
+					llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::DepthStencilAttachment, llrm::AttachmentFormat::D24_UNORM_S8_UINT,
+					llrm::AttachmentLoadOp::Clear, llrm::AttachmentStoreOp::DontCare
+				},
+				// HDR buffer, every pixel gets shaded so the previous contents don't need to be loaded
+				{
+					llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentFormat::RGBA16F_Float,
+					llrm::AttachmentLoadOp::DontCare, llrm::AttachmentStoreOp::Store
+				}
 			},
-			{{{0, 1, 2, 3, 4}}}
-		});
-		NewContext.mDeferredShadeRG = llrm::CreateRenderGraph({
-			{{llrm::AttachmentUsage::ColorAttachment, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentFormat::RGBA16F_Float}}, // HDR buffer
-			{{{0}}}
-		});
-		NewContext.mShadowMapRG = llrm::CreateRenderGraph({
-			{{llrm::AttachmentUsage::DepthStencilAttachment, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentFormat::D24_UNORM_S8_UINT}},
-			{{{0}}}
+			{
+				{{0, 1, 2, 3, 4}},		// Geometry
+				{{5}, {0, 1, 2, 3}}		// Shade
+			}
 		});
+		// Each shadow map layer is cleared, so it can start from an undefined layout without being transitioned first
+		NewContext.mDynamicShadowRendering = llrm::GetCaps().bDynamicRendering;
+		if (!NewContext.mDynamicShadowRendering)
+		{
+			NewContext.mShadowMapRG = llrm::CreateRenderGraph({
+				{{llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentFormat::D24_UNORM_S8_UINT}},
+				{{{0}}}
+			});
+		}
 
 		// Set global compiled shaders location so we can load shaders
 		GContext.CompiledShaders = NewContext.CompiledShaders;
 
-		// Create pipelines
+		NewContext.mTonemapShader = LoadRasterShader("Tonemap", "Tonemap");
+
+		// Mesh vertex shaders decode quantized vertices when UBER_QUANTIZED is 1, only the permutation that's used is compiled
+		NewContext.mQuantizedVertices = Params.QuantizedVertices;
+		uint32_t Quantized = uint32_t(Params.QuantizedVertices);
+		CompileRasterProgram("DeferredGeometry", "DeferredGeometry", {{"UBER_QUANTIZED", Quantized, Quantized}}, {});
+		CompileRasterProgram("DepthRender", "DepthRender", {{"UBER_QUANTIZED", Quantized, Quantized}}, {});
+
+		uint32_t MeshVertexStride = sizeof(MeshVertex);
+		std::vector<std::pair<llrm::VertexAttributeFormat, uint32_t>> MeshVertexAttributes = {
+			{llrm::VertexAttributeFormat::Float3, offsetof(MeshVertex, mPosition)},
+			{llrm::VertexAttributeFormat::Float3, offsetof(MeshVertex, mNormal)}
+		};
+		if (Params.QuantizedVertices)
+		{
+			MeshVertexStride = sizeof(QuantizedMeshVertex);
+			MeshVertexAttributes = {
+				{llrm::VertexAttributeFormat::Short4Norm, offsetof(QuantizedMeshVertex, mPosition)},
+				{llrm::VertexAttributeFormat::Short2Norm, offsetof(QuantizedMeshVertex, mNormal)}
+			};
+		}
+
+		// Create pipelines. Their programs aren't used for anything else, so their shader modules are released right away.
+		llrm::ShaderProgram DeferredGeoProgram = LoadRasterShader("DeferredGeometry_" + std::to_string(Quantized), "DeferredGeometry");
+		llrm::ShaderProgram ShadowMapProgram = LoadRasterShader("DepthRender_" + std::to_string(Quantized), "DepthRender");
+		llrm::ShaderProgram OcclusionProxyProgram = LoadRasterShader("OcclusionProxy", "OcclusionProxy");
+
 		NewContext.mDeferredGeoPipe = llrm::CreatePipeline({
-			LoadRasterShader("DeferredGeometry", "DeferredGeometry"),
-			NewContext.mDeferredGeoRG,
+			DeferredGeoProgram,
+			NewContext.mDeferredRG,
 			{NewContext.mSceneResourceLayout, NewContext.mObjectResourceLayout, NewContext.mMaterialLayout},
-			sizeof(MeshVertex),
-			{
-				{llrm::VertexAttributeFormat::Float3, offsetof(MeshVertex, mPosition)},
-				{llrm::VertexAttributeFormat::Float3, offsetof(MeshVertex, mNormal)}
-			},
+			MeshVertexStride,
+			MeshVertexAttributes,
 			llrm::PipelineRenderPrimitive::TRIANGLES,
 			{{false}, {false}, {false}, {false}},
 			{true},
 			0
 		});
 
+		// Proxies only test against the depth buffer. Both faces are drawn so a box the camera is inside of still passes,
+		// and a proxy face lying on the surface of the mesh it stands in for passes against the depth that mesh wrote.
+		llrm::PipelineBlendSettings NoColorWrites{};
+		NoColorWrites.WriteMask = 0;
+
+		NewContext.mOcclusionProxyPipe = llrm::CreatePipeline({
+			OcclusionProxyProgram,
+			NewContext.mDeferredRG,
+			{NewContext.mSceneResourceLayout, NewContext.mObjectResourceLayout, NewContext.mOcclusionProxyLayout},
+			sizeof(glm::vec3),
+			{
+				{llrm::VertexAttributeFormat::Float3, 0}
+			},
+			llrm::PipelineRenderPrimitive::TRIANGLES,
+			{NoColorWrites, NoColorWrites, NoColorWrites, NoColorWrites},
+			{true, false, llrm::CompareOp::LessOrEqual},
+			0,
+			llrm::VertexWinding::CounterClockwise,
+			llrm::CullMode::None
+		});
+		NewContext.mConditionalRendering = llrm::GetCaps().bConditionalRendering;
+
 		NewContext.mShadowMapPipe = llrm::CreatePipeline({
-			LoadRasterShader("DepthRender", "DepthRender"),
+			ShadowMapProgram,
 			NewContext.mShadowMapRG,
 			{NewContext.mLightObjectResourceLayout, NewContext.mObjectResourceLayout},
-			sizeof(MeshVertex),
-			{
-				{llrm::VertexAttributeFormat::Float3, offsetof(MeshVertex, mPosition)},
-				{llrm::VertexAttributeFormat::Float3, offsetof(MeshVertex, mNormal)}
-			},
+			MeshVertexStride,
+			MeshVertexAttributes,
 			llrm::PipelineRenderPrimitive::TRIANGLES,
 			{{false}},
 			{true},
 			0,
 			llrm::VertexWinding::CounterClockwise,
-			llrm::CullMode::Front
+			llrm::CullMode::Front,
+			{llrm::AttachmentFormat::D24_UNORM_S8_UINT}
 		});
 
+		llrm::ReleaseShaderModules(DeferredGeoProgram);
+		llrm::ReleaseShaderModules(ShadowMapProgram);
+		llrm::ReleaseShaderModules(OcclusionProxyProgram);
+
 		GContext = NewContext;
 
 		CompileRasterProgram("DeferredShade", "DeferredShade", 
@@ -358,10 +448,13 @@ namespace Ruby
 		// Create render graph for window
 		{
 			llrm::RenderGraphCreateInfo Info{};
+			// Tonemapping covers the whole image, so there's nothing to clear
 			Info.Attachments.push_back({
 				llrm::AttachmentUsage::Undefined,
 				llrm::AttachmentUsage::Presentation,
 				llrm::GetTextureFormat(llrm::GetSwapChainImage(Swap.mSwap, 0)),
+				llrm::AttachmentLoadOp::DontCare,
+				llrm::AttachmentStoreOp::Store
 				});
 			Info.Passes = { {{0}} };
 
@@ -372,7 +465,7 @@ namespace Ruby
 
 		// Create final pipeline stage
 		Swap.mTonemapPipeline = llrm::CreatePipeline({
-			LoadRasterShader("Tonemap", "Tonemap"),
+			GContext.mTonemapShader,
 			Swap.mTonemapGraph,
 			{GContext.mTonemapLayout},
 			sizeof(PosUV),
@@ -417,13 +510,17 @@ namespace Ruby
 	void ResizeSwapChain(SwapChain& Swap, uint32_t NewWidth, uint32_t NewHeight)
 	{
 		llrm::DestroySwapChain(Swap.mSwap);
-		llrm::DestroyRenderGraph(Swap.mTonemapGraph);
-		llrm::DestroyPipeline(Swap.mTonemapPipeline);
-		llrm::DestroyResourceSet(Swap.mTonemapResources);
 
-		// Re-create swap resources
+		// Re-create swap resources before destroying the old ones, so the render graph and pipeline are shared instead of created again
+		llrm::RenderGraph OldGraph = Swap.mTonemapGraph;
+		llrm::Pipeline OldPipeline = Swap.mTonemapPipeline;
+		llrm::ResourceSet OldResources = Swap.mTonemapResources;
 		CreateSwapResources(Swap, NewWidth, NewHeight);
 
+		llrm::DestroyPipeline(OldPipeline);
+		llrm::DestroyRenderGraph(OldGraph);
+		llrm::DestroyResourceSet(OldResources);
+
 		// Recreate frame buffers
 		UpdateSwapChain(Swap.mSwap, Swap.mTonemapGraph, Swap.mFrameBuffers, Swap.mCmdBuffers);
 	}
@@ -437,31 +534,35 @@ namespace Ruby
 		Target.mHDRColorView = llrm::CreateTextureView(Target.mHDRColor, llrm::AspectFlags::COLOR_ASPECT);
 
 		// Create scene depth
-		Target.mDepth = llrm::CreateTexture(llrm::AttachmentFormat::D24_UNORM_S8_UINT, llrm::AttachmentUsage::DepthStencilAttachment, Width, Height, llrm::TEXTURE_USAGE_RT, 1);
+		Target.mDepth = llrm::CreateTexture(llrm::AttachmentFormat::D24_UNORM_S8_UINT, llrm::AttachmentUsage::DepthStencilAttachment, Width, Height, llrm::TEXTURE_USAGE_RT | llrm::TEXTURE_USAGE_TRANSIENT, 1);
 		Target.mDepthView = llrm::CreateTextureView(Target.mDepth, llrm::AspectFlags::DEPTH_ASPECT);
 
-		// Create deferred geometry textures
-		Target.mDeferredAlbedo = llrm::CreateTexture(llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentUsage::ShaderRead, Width, Height, llrm::TEXTURE_USAGE_SAMPLE | llrm::TEXTURE_USAGE_RT, 1);
-		Target.mDeferredPosition = llrm::CreateTexture(llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentUsage::ShaderRead, Width, Height, llrm::TEXTURE_USAGE_SAMPLE | llrm::TEXTURE_USAGE_RT, 1);
-		Target.mDeferredNormal = llrm::CreateTexture(llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentUsage::ShaderRead, Width, Height, llrm::TEXTURE_USAGE_SAMPLE | llrm::TEXTURE_USAGE_RT, 1);
-		Target.mDeferredRMAO = llrm::CreateTexture(llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentUsage::ShaderRead, Width, Height, llrm::TEXTURE_USAGE_SAMPLE | llrm::TEXTURE_USAGE_RT, 1);
+		// Create deferred geometry textures, these are only read as input attachments by the shade pass so they never leave tile memory
+		const uint64_t GBufferUsage = llrm::TEXTURE_USAGE_RT | llrm::TEXTURE_USAGE_INPUT_ATTACHMENT | llrm::TEXTURE_USAGE_TRANSIENT;
+		Target.mDeferredAlbedo = llrm::CreateTexture(llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentUsage::ColorAttachment, Width, Height, GBufferUsage, 1);
+		Target.mDeferredPosition = llrm::CreateTexture(llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentUsage::ColorAttachment, Width, Height, GBufferUsage, 1);
+		Target.mDeferredNormal = llrm::CreateTexture(llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentUsage::ColorAttachment, Width, Height, GBufferUsage, 1);
+		Target.mDeferredRMAO = llrm::CreateTexture(llrm::AttachmentFormat::RGBA16F_Float, llrm::AttachmentUsage::ColorAttachment, Width, Height, GBufferUsage, 1);
 		Target.mDeferredAlbedoView = llrm::CreateTextureView(Target.mDeferredAlbedo, llrm::AspectFlags::COLOR_ASPECT);
 		Target.mDeferredPositionView = llrm::CreateTextureView(Target.mDeferredPosition, llrm::AspectFlags::COLOR_ASPECT);
 		Target.mDeferredNormalView = llrm::CreateTextureView(Target.mDeferredNormal, llrm::AspectFlags::COLOR_ASPECT);
 		Target.mDeferredRMAOView = llrm::CreateTextureView(Target.mDeferredRMAO, llrm::AspectFlags::COLOR_ASPECT);
 
-		// Create deferred framebuffers
-		Target.mDeferredGeoFB = llrm::CreateFrameBuffer({
+		// Create deferred framebuffer
+		Target.mDeferredFB = llrm::CreateFrameBuffer({
 			Width, Height,
-			{Target.mDeferredAlbedoView, Target.mDeferredPositionView, Target.mDeferredNormalView, Target.mDeferredRMAOView, Target.mDepthView},
-			GContext.mDeferredGeoRG
+			{Target.mDeferredAlbedoView, Target.mDeferredPositionView, Target.mDeferredNormalView, Target.mDeferredRMAOView, Target.mDepthView, Target.mHDRColorView},
+			GContext.mDeferredRG
 		});
 
-		Target.mDeferredShadeFB = llrm::CreateFrameBuffer({
-			Width, Height,
-			{Target.mHDRColorView},
-			GContext.mDeferredShadeRG
-		});
+		// Shows up in graphics debuggers and profilers when LLRM_DEBUG_LABELS is enabled
+		llrm::SetObjectName(llrm::DebugObjectType::Texture, Target.mHDRColor, "Ruby HDR Color");
+		llrm::SetObjectName(llrm::DebugObjectType::Texture, Target.mDepth, "Ruby Depth");
+		llrm::SetObjectName(llrm::DebugObjectType::Texture, Target.mDeferredAlbedo, "Ruby G-Buffer Albedo");
+		llrm::SetObjectName(llrm::DebugObjectType::Texture, Target.mDeferredPosition, "Ruby G-Buffer Position");
+		llrm::SetObjectName(llrm::DebugObjectType::Texture, Target.mDeferredNormal, "Ruby G-Buffer Normal");
+		llrm::SetObjectName(llrm::DebugObjectType::Texture, Target.mDeferredRMAO, "Ruby G-Buffer RMAO");
+		llrm::SetObjectName(llrm::DebugObjectType::FrameBuffer, Target.mDeferredFB, "Ruby Deferred");
 
 		return Target;
 	}
@@ -475,8 +576,7 @@ namespace Ruby
 		llrm::DestroyTexture(Target.mDeferredNormal);
 		llrm::DestroyTexture(Target.mDeferredRMAO);
 
-		llrm::DestroyFrameBuffer(Target.mDeferredGeoFB);
-		llrm::DestroyFrameBuffer(Target.mDeferredShadeFB);
+		llrm::DestroyFrameBuffer(Target.mDeferredFB);
 
 		llrm::DestroyTextureView(Target.mDepthView);
 		llrm::DestroyTextureView(Target.mHDRColorView);
@@ -492,8 +592,7 @@ namespace Ruby
 		Target.mDeferredNormal = nullptr;
 		Target.mDeferredRMAO = nullptr;
 
-		Target.mDeferredGeoFB = nullptr;
-		Target.mDeferredShadeFB = nullptr;
+		Target.mDeferredFB = nullptr;
 
 		Target.mDepthView = nullptr;
 		Target.mHDRColorView = nullptr;
@@ -551,16 +650,130 @@ namespace Ruby
 		return GContext.mLights[Light];
 	}
 
+	// Maps a unit vector onto the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper half into the [-1, 1] square
+	glm::vec2 OctahedralEncode(glm::vec3 Normal)
+	{
+		Normal /= std::max(std::abs(Normal.x) + std::abs(Normal.y) + std::abs(Normal.z), 1e-20f);
+		if (Normal.z >= 0.0f)
+			return glm::vec2(Normal);
+
+		return glm::vec2(
+			(1.0f - std::abs(Normal.y)) * (Normal.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(Normal.x)) * (Normal.y >= 0.0f ? 1.0f : -1.0f)
+		);
+	}
+
+	int16_t FloatToSNorm16(float Value)
+	{
+		return int16_t(std::lround(glm::clamp(Value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	/*
+	 * Encodes each vertex as a QuantizedMeshVertex, with positions relative to the center and half size of the bounds.
+	 * With SSE2 a vertex is converted with a handful of vector instructions, and its position and normal are rounded and packed to 16 bits together.
+	 */
+	void QuantizeVertices(const std::vector<MeshVertex>& Verts, glm::vec3 BoundsMin, glm::vec3 BoundsMax, std::vector<QuantizedMeshVertex>& OutVerts)
+	{
+		glm::vec3 Center = (BoundsMin + BoundsMax) * 0.5f;
+		glm::vec3 Extent = (BoundsMax - BoundsMin) * 0.5f;
+
+		// Flat meshes have no extent along an axis, every vertex is at the center there
+		glm::vec3 InvExtent = glm::vec3(
+			Extent.x > 0.0f ? 1.0f / Extent.x : 0.0f,
+			Extent.y > 0.0f ? 1.0f / Extent.y : 0.0f,
+			Extent.z > 0.0f ? 1.0f / Extent.z : 0.0f
+		);
+
+		OutVerts.resize(Verts.size());
+
+#if RUBY_SSE2
+		const __m128 VCenter = _mm_set_ps(0.0f, Center.z, Center.y, Center.x);
+		const __m128 VInvExtent = _mm_set_ps(0.0f, InvExtent.z, InvExtent.y, InvExtent.x);
+		const __m128 SignMask = _mm_set1_ps(-0.0f);
+		const __m128 One = _mm_set1_ps(1.0f);
+		const __m128 MinusOne = _mm_set1_ps(-1.0f);
+		const __m128 SNormScale = _mm_set1_ps(32767.0f);
+		const __m128 XYMask = _mm_castsi128_ps(_mm_set_epi32(0, 0, -1, -1));
+
+		for (size_t Index = 0; Index < Verts.size(); Index++)
+		{
+			const MeshVertex& Vert = Verts[Index];
+
+			__m128 Position = _mm_set_ps(0.0f, Vert.mPosition.z, Vert.mPosition.y, Vert.mPosition.x);
+			Position = _mm_mul_ps(_mm_sub_ps(Position, VCenter), VInvExtent);
+
+			// Project onto the octahedron by dividing by |x| + |y| + |z|, which ends up in every lane
+			__m128 Normal = _mm_set_ps(0.0f, Vert.mNormal.z, Vert.mNormal.y, Vert.mNormal.x);
+			__m128 AbsNormal = _mm_andnot_ps(SignMask, Normal);
+			__m128 Sum = _mm_add_ps(AbsNormal, _mm_shuffle_ps(AbsNormal, AbsNormal, _MM_SHUFFLE(2, 3, 0, 1)));
+			Sum = _mm_add_ps(Sum, _mm_shuffle_ps(Sum, Sum, _MM_SHUFFLE(1, 0, 3, 2)));
+			Normal = _mm_div_ps(Normal, _mm_max_ps(Sum, _mm_set1_ps(1e-20f)));
+
+			// Fold the lower hemisphere: (1 - |yx|) with the signs of xy
+			__m128 Swapped = _mm_andnot_ps(SignMask, _mm_shuffle_ps(Normal, Normal, _MM_SHUFFLE(3, 2, 0, 1)));
+			__m128 Folded = _mm_or_ps(_mm_sub_ps(One, Swapped), _mm_and_ps(SignMask, Normal));
+			__m128 Lower = _mm_cmplt_ps(_mm_shuffle_ps(Normal, Normal, _MM_SHUFFLE(2, 2, 2, 2)), _mm_setzero_ps());
+			Normal = _mm_or_ps(_mm_and_ps(Lower, Folded), _mm_andnot_ps(Lower, Normal));
+			Normal = _mm_and_ps(Normal, XYMask);
+
+			// Round both to 16-bit signed normalized integers, packed into position xyzw then normal xy
+			__m128i PositionBits = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(Position, MinusOne), One), SNormScale));
+			__m128i NormalBits = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(Normal, MinusOne), One), SNormScale));
+
+			alignas(16) int16_t Packed[8];
+			_mm_store_si128(reinterpret_cast<__m128i*>(Packed), _mm_packs_epi32(PositionBits, NormalBits));
+			std::memcpy(&OutVerts[Index], Packed, sizeof(QuantizedMeshVertex));
+		}
+#else
+		for (size_t Index = 0; Index < Verts.size(); Index++)
+		{
+			const MeshVertex& Vert = Verts[Index];
+			QuantizedMeshVertex& Out = OutVerts[Index];
+
+			glm::vec3 Position = (Vert.mPosition - Center) * InvExtent;
+			glm::vec2 Normal = OctahedralEncode(Vert.mNormal);
+
+			Out.mPosition[0] = FloatToSNorm16(Position.x);
+			Out.mPosition[1] = FloatToSNorm16(Position.y);
+			Out.mPosition[2] = FloatToSNorm16(Position.z);
+			Out.mPosition[3] = 0;
+			Out.mNormal[0] = FloatToSNorm16(Normal.x);
+			Out.mNormal[1] = FloatToSNorm16(Normal.y);
+		}
+#endif
+	}
+
 	Mesh& CreateMesh(const Tesselation& Tesselation, uint32_t MatId)
 	{
 		Mesh Result;
 
 		Result.mId = GContext.mNextMeshId;
-		Result.mVbo = llrm::CreateVertexBuffer(Tesselation.mVerts.size() * sizeof(MeshVertex), Tesselation.mVerts.data());
 		Result.mIbo = llrm::CreateIndexBuffer(Tesselation.mIndicies.size() * sizeof(uint32_t), Tesselation.mIndicies.data());
 		Result.mIndexCount = Tesselation.mIndicies.size();
 		Result.mMat = MatId;
 
+		if (!Tesselation.mVerts.empty())
+		{
+			Result.mBoundsMin = Result.mBoundsMax = Tesselation.mVerts[0].mPosition;
+			for (const MeshVertex& Vert : Tesselation.mVerts)
+			{
+				Result.mBoundsMin = glm::min(Result.mBoundsMin, Vert.mPosition);
+				Result.mBoundsMax = glm::max(Result.mBoundsMax, Vert.mPosition);
+			}
+		}
+
+		// Quantized positions are relative to the bounds, so they're encoded once the bounds are known
+		if (GContext.mQuantizedVertices)
+		{
+			std::vector<QuantizedMeshVertex> Quantized;
+			QuantizeVertices(Tesselation.mVerts, Result.mBoundsMin, Result.mBoundsMax, Quantized);
+			Result.mVbo = llrm::CreateVertexBuffer(Quantized.size() * sizeof(QuantizedMeshVertex), Quantized.data());
+		}
+		else
+		{
+			Result.mVbo = llrm::CreateVertexBuffer(Tesselation.mVerts.size() * sizeof(MeshVertex), Tesselation.mVerts.data());
+		}
+
 		GContext.mNextMeshId++;
 		GContext.mMeshes.emplace(Result.mId, Result);
 
@@ -738,6 +951,7 @@ namespace Ruby
 		Res.mSceneResources = llrm::CreateResourceSet({ GContext.mSceneResourceLayout});
 		Res.mLightResources = llrm::CreateResourceSet({ GContext.mLightsResourceLayout });
 		Res.mDeferredShadeRes = llrm::CreateResourceSet({ GContext.mDeferredShadeRl });
+		Res.mFrameGraph = llrm::CreateFrameGraph();
 	}
 
 	void CreateDeferredResources(SceneResources& Res, glm::uvec2 Size)
@@ -747,24 +961,15 @@ namespace Ruby
 
 	void CreateLightDataResources(SceneResources& Res)
 	{
-		uint32_t MaxSize = llrm::GetCaps().MaxTextureSize;
-		Res.mLightDataTexture = llrm::CreateTexture(llrm::AttachmentFormat::RGBA32F_Float, llrm::AttachmentUsage::ShaderRead,
-			MaxSize, 1,
-			llrm::TEXTURE_USAGE_SAMPLE | llrm::TEXTURE_USAGE_WRITE, 1);
-		Res.mLightDataTextureView = llrm::CreateTextureView(Res.mLightDataTexture, llrm::AspectFlags::COLOR_ASPECT, llrm::TextureViewType::TYPE_2D);
+		// Rewritten every frame, so each frame in flight gets its own copy
+		Res.mLightDataBuffer = llrm::CreateStorageBuffer(MAX_LIGHT_DATA * sizeof(glm::vec4), nullptr, llrm::BUFFER_PER_FRAME);
+		llrm::SetObjectName(llrm::DebugObjectType::StorageBuffer, Res.mLightDataBuffer, "Ruby Light Data");
 	}
 
 	void CreateShadowResources(SceneResources& Res)
 	{
 		uint32_t Frustums = std::min(llrm::GetCaps().MaxImageArrayLayers, (uint32_t)10);
-		uint32_t Size = Frustums * 4;
-		Res.mShadowMapFrustums = llrm::CreateTexture(llrm::AttachmentFormat::RGBA32F_Float, 
-			llrm::AttachmentUsage::ShaderRead, 
-			Size, 1, 
-			llrm::TEXTURE_USAGE_SAMPLE | llrm::TEXTURE_USAGE_WRITE,
-			1
-		);
-		Res.mShadowMapFrustumsView = llrm::CreateTextureView(Res.mShadowMapFrustums, llrm::AspectFlags::COLOR_ASPECT);
+		Res.mShadowMapFrustums = llrm::CreateStorageBuffer(Frustums * 4 * sizeof(glm::vec4), nullptr, llrm::BUFFER_PER_FRAME);
 
 		Res.mShadowMaps = llrm::CreateTexture(llrm::AttachmentFormat::D24_UNORM_S8_UINT,
 			llrm::AttachmentUsage::ShaderRead, 
@@ -778,6 +983,9 @@ namespace Ruby
 			llrm::TextureViewType::TYPE_2D_ARRAY,
 			0, Frustums);
 
+		llrm::SetObjectName(llrm::DebugObjectType::Texture, Res.mShadowMaps, "Ruby Shadow Maps");
+		llrm::SetObjectName(llrm::DebugObjectType::StorageBuffer, Res.mShadowMapFrustums, "Ruby Shadow Map Frustums");
+
 		for(uint32_t Frustum = 0; Frustum < Frustums; Frustum++)
 		{
 			llrm::TextureView ShadowMapTextureView = llrm::CreateTextureView(Res.mShadowMaps,
@@ -785,14 +993,18 @@ namespace Ruby
 				llrm::TextureViewType::TYPE_2D_ARRAY,
 				Frustum, 1);
 
-			llrm::FrameBuffer ShadowMapFbo = llrm::CreateFrameBuffer({
-				SHADOW_MAP_RESOLUTION, SHADOW_MAP_RESOLUTION,
-				{ShadowMapTextureView},
-				GContext.mShadowMapRG
-			});
-
 			Res.mShadowMapAttachmentViews.push_back(ShadowMapTextureView);
-			Res.mShadowMapFbos.push_back(ShadowMapFbo);
+
+			if (!GContext.mDynamicShadowRendering)
+			{
+				llrm::FrameBuffer ShadowMapFbo = llrm::CreateFrameBuffer({
+					SHADOW_MAP_RESOLUTION, SHADOW_MAP_RESOLUTION,
+					{ShadowMapTextureView},
+					GContext.mShadowMapRG
+				});
+
+				Res.mShadowMapFbos.push_back(ShadowMapFbo);
+			}
 		}
 
 	}
@@ -820,6 +1032,69 @@ namespace Ruby
 		Res.mFullScreenQuadIbo = llrm::CreateIndexBuffer(sizeof(Index), Index);
 	}
 
+	void CreateOcclusionResources(SceneResources& Res)
+	{
+		Res.mOcclusionQueries = llrm::CreateOcclusionQueryPool(MAX_OCCLUSION_QUERIES);
+
+		glm::vec3 Corners[8] = {
+			{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 0.0f},
+			{0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f, 1.0f}
+		};
+
+		uint32_t Index[36] = {
+			0, 1, 2, 2, 3, 0, // -Z
+			4, 6, 5, 6, 4, 7, // +Z
+			0, 3, 7, 7, 4, 0, // -X
+			1, 5, 6, 6, 2, 1, // +X
+			0, 4, 5, 5, 1, 0, // -Y
+			3, 2, 6, 6, 7, 3  // +Y
+		};
+
+		Res.mUnitCubeVbo = llrm::CreateVertexBuffer(sizeof(Corners), Corners);
+		Res.mUnitCubeIbo = llrm::CreateIndexBuffer(sizeof(Index), Index);
+	}
+
+	// The query of a mesh object, INVALID_ID once every query of the scene is taken
+	uint32_t GetOcclusionQuery(SceneResources& Res, ObjectId Id)
+	{
+		auto Found = Res.mOcclusionQueryIndices.find(Id);
+		if (Found != Res.mOcclusionQueryIndices.end())
+			return Found->second;
+
+		if (Res.mOcclusionQueryIndices.size() >= MAX_OCCLUSION_QUERIES)
+			return INVALID_ID;
+
+		uint32_t Query = static_cast<uint32_t>(Res.mOcclusionQueryIndices.size());
+		Res.mOcclusionQueryIndices.emplace(Id, Query);
+		return Query;
+	}
+
+	// The proxy box is pushed slightly outside of the mesh bounds. The mesh's vertices are transformed differently than the box's,
+	// so a box lying exactly on the faces of a box shaped mesh can land just behind them and flicker between visible and occluded.
+	OcclusionProxyUniforms GetOcclusionProxyUniforms(const Mesh& Mesh)
+	{
+		glm::vec3 Extent = Mesh.mBoundsMax - Mesh.mBoundsMin;
+		glm::vec3 Padding = glm::vec3(std::max(std::max(Extent.x, Extent.y), Extent.z) * 0.001f + 0.0001f);
+
+		return {
+			glm::vec4(Mesh.mBoundsMin - Padding, 0.0f),
+			glm::vec4(Extent + Padding * 2.0f, 0.0f)
+		};
+	}
+
+	bool IsObjectOccluded(SceneId Scene, ObjectId Object)
+	{
+		auto Found = GContext.mResources.find(Scene);
+		if (Found == GContext.mResources.end() || !Found->second.mOcclusionQueries)
+			return false;
+
+		auto Query = Found->second.mOcclusionQueryIndices.find(Object);
+		if (Query == Found->second.mOcclusionQueryIndices.end())
+			return false;
+
+		return llrm::GetQueryResult(Found->second.mOcclusionQueries, Query->second) == 0;
+	}
+
 	void InitSceneResources(const Scene& Scene, glm::uvec2 Size)
 	{
 		// Create scene resources
@@ -831,6 +1106,7 @@ namespace Ruby
 		CreateDeferredResources(NewResources, Size);
 		CreateLightDataResources(NewResources);
 		CreateShadowResources(NewResources);
+		CreateOcclusionResources(NewResources);
 
 		GContext.mResources.emplace(Scene.mId, NewResources);
 	}
@@ -860,22 +1136,30 @@ glm::transpose(CamProj * CamView)
 			ShadowUniforms.mViewProjection = CreateDirectionalVPMatrix(Light.mRotation, CamView, CamProj);
 		}
 
-		// Transition shadow maps texture array to correct usage
-		llrm::TransitionTexture(DstCmd, Resources.mShadowMaps, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::DepthStencilAttachment, FrustumBase, 1);
-
-		// Update resources
-		llrm::UpdateUniformBuffer(Light.mObjectResources, 0, &ShadowUniforms, sizeof(ShadowUniforms));
+		// The light's view changes with the camera every frame, so its uniforms live in a transient resource set
+		llrm::ResourceSet ShadowResources = llrm::CreateTransientResourceSet({ GContext.mLightObjectResourceLayout });
+		llrm::UpdateUniformBuffer(ShadowResources, 0, &ShadowUniforms, sizeof(ShadowUniforms));
 
 		// TODO: Need to handle multiple light cascades/frustums
 
 		// Depth render
-		std::vector<llrm::ClearValue> ClearValues = {
+		llrm::ClearValue ClearValues[] = {
 			{llrm::ClearType::Float, 1.0f}
 		};
 
-		llrm::FrameBuffer FrustumFbo = Resources.mShadowMapFbos[FrustumBase];
-		 
-		llrm::BeginRenderGraph(DstCmd, GContext.mShadowMapRG, FrustumFbo, ClearValues);
+		if (GContext.mDynamicShadowRendering)
+		{
+			llrm::RenderingInfo Rendering{ ShadowMapSize.x, ShadowMapSize.y };
+			Rendering.DepthStencilAttachment.View = Resources.mShadowMapAttachmentViews[FrustumBase];
+			Rendering.DepthStencilAttachment.Clear = ClearValues[0];
+
+			llrm::BeginRenderGraph(DstCmd, Rendering);
+		}
+		else
+		{
+			llrm::BeginRenderGraph(DstCmd, GContext.mShadowMapRG, Resources.mShadowMapFbos[FrustumBase], ClearValues);
+		}
+
 		{	
 			llrm::SetViewport(DstCmd, 0, 0, ShadowMapSize.x, ShadowMapSize.y);
 			llrm::SetScissor(DstCmd, 0, 0, ShadowMapSize.x, ShadowMapSize.y);
@@ -889,7 +1173,7 @@ glm::transpose(CamProj * CamView)
 				{
 					Ruby::Mesh& Mesh = GetMesh(Obj.mReferenceId);
 
-					llrm::BindResources(DstCmd, { Light.mObjectResources, Obj.mObjectResources });
+					llrm::BindResources(DstCmd, { ShadowResources, Obj.mObjectResources });
 					llrm::DrawVertexBufferIndexed(DstCmd, Mesh.mVbo, Mesh.mIbo, Mesh.mIndexCount);
 				}
 			}
@@ -917,6 +1201,8 @@ glm::transpose(CamProj * CamView)
 		std::function<void(const llrm::CommandBuffer&)> PostTonemap
 	)
 	{
+		LLRM_TRACE_FUNCTION();
+
 		if(!GContext.mResources.contains(Scene.mId))
 		{
 			InitSceneResources(Scene, ViewportSize);
@@ -929,15 +1215,14 @@ glm::transpose(CamProj * CamView)
 		UpdateCameraUniforms(Resources.mSceneResources, CamView, Camera.mProjection);
 
 		uint32_t MAX_FRUSTUMS = std::min(llrm::GetCaps().MaxImageArrayLayers, (uint32_t)10);
-		uint32_t MaxImageSize = llrm::GetCaps().MaxTextureSize;
 		if(Resources.mShadowFrustumsData.size() != MAX_FRUSTUMS * 4)
 		{
 			Resources.mShadowFrustumsData.resize(MAX_FRUSTUMS * 4);
 		}
 
-		if (Resources.mLightData.size() != MaxImageSize)
+		if (Resources.mLightData.size() != MAX_LIGHT_DATA)
 		{
-			Resources.mLightData.resize(MaxImageSize);
+			Resources.mLightData.resize(MAX_LIGHT_DATA);
 		}
 
 		// Object processing:
@@ -956,9 +1241,12 @@ glm::transpose(CamProj * CamView)
 
 			if(IsMeshObject(Obj.mId))
 			{
-				// Create transform matrix
+				// Create transform matrix, along with the bounds that quantized positions are relative to
+				const Ruby::Mesh& Mesh = GetMesh(Obj.mReferenceId);
 				ModelVertexUniforms ModelUniforms{
-					glm::transpose(BuildTransform(Obj.mPosition, Obj.mRotation, {1, 1, 1}))
+					glm::transpose(BuildTransform(Obj.mPosition, Obj.mRotation, {1, 1, 1})),
+					glm::vec4((Mesh.mBoundsMin + Mesh.mBoundsMax) * 0.5f, 0.0f),
+					glm::vec4((Mesh.mBoundsMax - Mesh.mBoundsMin) * 0.5f, 0.0f)
 				};
 				llrm::UpdateUniformBuffer(Obj.mObjectResources, 0, &ModelUniforms, sizeof(ModelUniforms));
 			}
@@ -1043,27 +1331,19 @@ glm::transpose(CamProj * CamView)
 			llrm::UpdateUniformBuffer(Material.second.mMaterialResources, 0, &MaterialParams, sizeof(MaterialParams));
 		}
 
-		// Write light data texture. TODO: Are light textures too slow? Use uniforms instead?
-		llrm::WriteTexture(Resources.mLightDataTexture,
-			llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::ShaderRead,
-			MaxImageSize, 1, 0,
-			Resources.mLightData.size() * sizeof(glm::vec4), Resources.mLightData.data()
-		);
+		// Write the light data rows that are in use into this frame's slice
+		llrm::UploadStorageBufferData(Resources.mLightDataBuffer, Resources.mLightData.data(), LightDataIndex * sizeof(glm::vec4));
 
-		// Update frustums data texture
+		// Update frustums data
 		if(Settings.mShadowsEnabled)
 		{
-			llrm::WriteTexture(Resources.mShadowMapFrustums,
-				llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::ShaderRead,
-				MAX_FRUSTUMS * 4, 1, 0,
-				Resources.mShadowFrustumsData.size() * sizeof(glm::vec4), Resources.mShadowFrustumsData.data()
-			);
+			llrm::UploadStorageBufferData(Resources.mShadowMapFrustums, Resources.mShadowFrustumsData.data(), Resources.mShadowFrustumsData.size() * sizeof(glm::vec4));
 		}
 
-		// Update lights
-		llrm::UpdateTextureResource(Resources.mLightResources, { Resources.mLightDataTextureView }, 0);
+		// Update lights, which point this frame's descriptors at this frame's slices
+		llrm::UpdateStorageBufferResource(Resources.mLightResources, Resources.mLightDataBuffer, 0);
 		llrm::UpdateTextureResource(Resources.mLightResources, {Resources.mShadowMapsResourceView}, 1);
-		llrm::UpdateTextureResource(Resources.mLightResources, { Resources.mShadowMapFrustumsView }, 2);
+		llrm::UpdateStorageBufferResource(Resources.mLightResources, Resources.mShadowMapFrustums, 2);
 
 		// Update tonemap inputs
 		llrm::UpdateSamplerResource(DstResources, Resources.mNearestSampler, 0);
@@ -1071,24 +1351,29 @@ glm::transpose(CamProj * CamView)
 
 		// Update deferred shade inputs
 		llrm::UpdateSamplerResource(Resources.mDeferredShadeRes, Resources.mNearestSampler, 0);
-		llrm::UpdateTextureResource(Resources.mDeferredShadeRes, { RT.mDeferredAlbedoView }, 1);
-		llrm::UpdateTextureResource(Resources.mDeferredShadeRes, { RT.mDeferredPositionView }, 2);
-		llrm::UpdateTextureResource(Resources.mDeferredShadeRes, { RT.mDeferredNormalView }, 3);
-		llrm::UpdateTextureResource(Resources.mDeferredShadeRes, { RT.mDeferredRMAOView }, 4);
+		llrm::UpdateInputAttachmentResource(Resources.mDeferredShadeRes, RT.mDeferredAlbedoView, 1);
+		llrm::UpdateInputAttachmentResource(Resources.mDeferredShadeRes, RT.mDeferredPositionView, 2);
+		llrm::UpdateInputAttachmentResource(Resources.mDeferredShadeRes, RT.mDeferredNormalView, 3);
+		llrm::UpdateInputAttachmentResource(Resources.mDeferredShadeRes, RT.mDeferredRMAOView, 4);
 
 		DeferredShadeResources ShadeRes = { Camera.mPosition};
 		llrm::UpdateUniformBuffer(Resources.mDeferredShadeRes, 0, &ShadeRes, sizeof(ShadeRes));
 
-		// Render the scene
-		llrm::Begin(DstCmd);
-		{
+		// Build the frame graph. The render graphs that write the shadow maps and HDR color start from an undefined layout
+		// and leave them ready to be sampled, so the frame graph only needs to track them.
+		llrm::FrameGraph Graph = Resources.mFrameGraph;
+		llrm::FGReset(Graph);
 
-			// Transition shadow maps texture array to correct usage
-			//llrm::TransitionTexture(DstCmd, Resources.mShadowMaps, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::DepthStencilAttachment, 0, 10);
+		llrm::FrameGraphResource ShadowMaps = llrm::FGImportTexture(Graph, "ShadowMaps", Resources.mShadowMaps, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::ShaderRead);
+		llrm::FrameGraphResource HDRColor = llrm::FGImportTexture(Graph, "HDRColor", RT.mHDRColor, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::ShaderRead);
 
-			// Render shadow maps
-			if(Settings.mShadowsEnabled)
+		// Render shadow maps
+		if(Settings.mShadowsEnabled)
+		{
+			llrm::FrameGraphPass ShadowPass = llrm::FGAddPass(Graph, "Shadows", [&](llrm::CommandBuffer Cmd)
 			{
+				LLRM_TRACE_ZONE("Ruby Shadows");
+
 				for (uint32_t Object : Scene.mObjects)
 				{
 					Ruby::Object& Obj = GetObject(Object);
@@ -1102,7 +1387,7 @@ glm::transpose(CamProj * CamView)
 							RenderShadowMap(Scene,
 								Resources,
 								BaseFrustum,
-								DstCmd,
+								Cmd,
 								{ SHADOW_MAP_RESOLUTION, SHADOW_MAP_RESOLUTION },
 								Obj,
 								CamView,
@@ -1111,27 +1396,40 @@ glm::transpose(CamProj * CamView)
 						}
 					}
 				}
-			}
-			
-			llrm::TransitionTexture(DstCmd, RT.mDeferredAlbedo, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::ColorAttachment);
-			llrm::TransitionTexture(DstCmd, RT.mDeferredPosition, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::ColorAttachment);
-			llrm::TransitionTexture(DstCmd, RT.mDeferredNormal, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::ColorAttachment);
-			llrm::TransitionTexture(DstCmd, RT.mDeferredRMAO, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::ColorAttachment);
+			});
+			// Dynamic rendering doesn't transition attachments, so the frame graph moves the shadow maps in and out of the attachment usage
+			if (GContext.mDynamicShadowRendering)
+				llrm::FGWrite(Graph, ShadowPass, ShadowMaps, llrm::AttachmentUsage::DepthStencilAttachment);
+			else
+				llrm::FGWrite(Graph, ShadowPass, ShadowMaps, llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ShaderRead);
+		}
+
+		llrm::FrameGraphPass DeferredPass = llrm::FGAddPass(Graph, "Deferred", [&](llrm::CommandBuffer Cmd)
+		{
+			LLRM_TRACE_ZONE("Ruby Deferred");
+
+			// Meshes are tested with their bounds after the geometry pass, the results decide what's drawn in later frames
+			const bool bOcclusionCulling = Settings.mOcclusionCulling && Resources.mOcclusionQueries;
+			if (bOcclusionCulling)
+				llrm::ResetQueries(Cmd, Resources.mOcclusionQueries);
 
 			// Deferred geometry stage
-			std::vector<llrm::ClearValue> ClearValues = {
+			llrm::ClearValue ClearValues[] = {
 				{llrm::ClearType::Float, 0.0, 0.0, 0.0, 1.0f},
 				{llrm::ClearType::Float, 0.0, 0.0, 0.0, 0.0f},
 				{llrm::ClearType::Float, 0.0, 0.0, 0.0, 0.0f},
 				{llrm::ClearType::Float, 0.0, 0.0, 0.0, 0.0f},
-				{llrm::ClearType::Float, 1.0f}
+				{llrm::ClearType::Float, 1.0f},
+				{llrm::ClearType::Float, 0.0, 0.0, 0.0, 1.0f}
 			};
-			llrm::BeginRenderGraph(DstCmd, GContext.mDeferredGeoRG, RT.mDeferredGeoFB, ClearValues);
+			llrm::BeginRenderGraph(Cmd, GContext.mDeferredRG, RT.mDeferredFB, ClearValues);
 			{
-				llrm::SetViewport(DstCmd, 0, 0, ViewportSize.x, ViewportSize.y);
-				llrm::SetScissor(DstCmd, 0, 0, ViewportSize.x, ViewportSize.y);
+				llrm::BeginLabel(Cmd, "G-Buffer");
+
+				llrm::SetViewport(Cmd, 0, 0, ViewportSize.x, ViewportSize.y);
+				llrm::SetScissor(Cmd, 0, 0, ViewportSize.x, ViewportSize.y);
 
-				llrm::BindPipeline(DstCmd, GContext.mDeferredGeoPipe);
+				llrm::BindPipeline(Cmd, GContext.mDeferredGeoPipe);
 
 				for(uint32_t Object : Scene.mObjects)
 				{
@@ -1144,45 +1442,105 @@ glm::transpose(CamProj * CamView)
 						if (IsValidId(Mesh.mMat))
 							MaterialResources = GetMaterial(Mesh.mMat).mMaterialResources;
 
-						llrm::BindResources(DstCmd, { Resources.mSceneResources, Obj.mObjectResources, MaterialResources});
-						llrm::DrawVertexBufferIndexed(DstCmd, Mesh.mVbo, Mesh.mIbo, Mesh.mIndexCount);
+						uint32_t Query = bOcclusionCulling ? GetOcclusionQuery(Resources, Obj.mId) : INVALID_ID;
+						if (IsValidId(Query))
+						{
+							// Without conditional rendering the result is a few frames old, and read back on the CPU
+							if (!GContext.mConditionalRendering && llrm::GetQueryResult(Resources.mOcclusionQueries, Query) == 0)
+								continue;
+
+							llrm::BeginConditionalRendering(Cmd, Resources.mOcclusionQueries, Query);
+						}
+
+						llrm::BindResources(Cmd, { Resources.mSceneResources, Obj.mObjectResources, MaterialResources});
+						llrm::DrawVertexBufferIndexed(Cmd, Mesh.mVbo, Mesh.mIbo, Mesh.mIndexCount);
+
+						if (IsValidId(Query))
+							llrm::EndConditionalRendering(Cmd);
 					}
 				}
-			}
-			llrm::EndRenderGraph(DstCmd);
 
-			// Deferred shade stage
+				// Every mesh object's bounds are tested against the depth of what was drawn, including objects that were skipped
+				if (bOcclusionCulling)
+				{
+					LLRM_SCOPED_LABEL(Cmd, "Occlusion Proxies");
+
+					llrm::BindPipeline(Cmd, GContext.mOcclusionProxyPipe);
 
-			// Update deferred inputs
-			ClearValues = {
-				{llrm::ClearType::Float, 0.0, 0.0, 0.0, 1.0f},
-			};
-			llrm::TransitionTexture(DstCmd, RT.mHDRColor, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::ColorAttachment);
-			llrm::BeginRenderGraph(DstCmd, GContext.mDeferredShadeRG, RT.mDeferredShadeFB, ClearValues);
-			{
-				llrm::SetViewport(DstCmd, 0, 0, ViewportSize.x, ViewportSize.y);
-				llrm::SetScissor(DstCmd, 0, 0, ViewportSize.x, ViewportSize.y);
+					for (uint32_t Object : Scene.mObjects)
+					{
+						if (!IsMeshObject(Object))
+							continue;
 
-				llrm::BindPipeline(DstCmd, GContext.DeferredShadePipeline(Settings.mShadowsEnabled));
-				llrm::BindResources(DstCmd, { Resources.mLightResources, Resources.mDeferredShadeRes });
-				llrm::DrawVertexBufferIndexed(DstCmd, Resources.mFullScreenQuadVbo, Resources.mFullScreenQuadIbo, 6);
+						uint32_t Query = GetOcclusionQuery(Resources, Object);
+						if (!IsValidId(Query))
+							continue;
+
+						Ruby::Object& Obj = GetObject(Object);
+						Ruby::Mesh& Mesh = GetMesh(Obj.mReferenceId);
+
+						OcclusionProxyUniforms ProxyUniforms = GetOcclusionProxyUniforms(Mesh);
+						llrm::ResourceSet ProxyResources = llrm::CreateTransientResourceSet({ GContext.mOcclusionProxyLayout });
+						llrm::UpdateUniformBuffer(ProxyResources, 0, &ProxyUniforms, sizeof(ProxyUniforms));
+
+						llrm::BindResources(Cmd, { Resources.mSceneResources, Obj.mObjectResources, ProxyResources });
+						llrm::BeginQuery(Cmd, Resources.mOcclusionQueries, Query);
+						llrm::DrawVertexBufferIndexed(Cmd, Resources.mUnitCubeVbo, Resources.mUnitCubeIbo, 36);
+						llrm::EndQuery(Cmd, Resources.mOcclusionQueries, Query);
+					}
+				}
+
+				llrm::EndLabel(Cmd);
+
+				// Deferred shade stage, reads the G-buffer written above as input attachments
+				llrm::NextPass(Cmd);
+
+				llrm::BeginLabel(Cmd, "Shade");
+				llrm::BindPipeline(Cmd, GContext.DeferredShadePipeline(Settings.mShadowsEnabled));
+				llrm::BindResources(Cmd, { Resources.mLightResources, Resources.mDeferredShadeRes });
+				llrm::DrawVertexBufferIndexed(Cmd, Resources.mFullScreenQuadVbo, Resources.mFullScreenQuadIbo, 6);
+				llrm::EndLabel(Cmd);
 			}
-			llrm::EndRenderGraph(DstCmd);
+			llrm::EndRenderGraph(Cmd);
+
+			if (bOcclusionCulling)
+				llrm::ResolveQueries(Cmd, Resources.mOcclusionQueries);
+		});
+		llrm::FGRead(Graph, DeferredPass, ShadowMaps, llrm::AttachmentUsage::ShaderRead);
+		llrm::FGWrite(Graph, DeferredPass, HDRColor, llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ShaderRead);
+
+		// Writes to the destination frame buffer, which the frame graph doesn't know about
+		llrm::FrameGraphPass TonemapPass = llrm::FGAddPass(Graph, "Tonemap", [&](llrm::CommandBuffer Cmd)
+		{
+			LLRM_TRACE_ZONE("Ruby Tonemap");
 
 			// Tonemap stage
-			llrm::BeginRenderGraph(DstCmd, DstGraph, DstBuf, ClearValues);
+			llrm::ClearValue ClearValues[] = {
+				{llrm::ClearType::Float, 0.0, 0.0, 0.0, 1.0f},
+			};
+			llrm::BeginRenderGraph(Cmd, DstGraph, DstBuf, ClearValues);
 			{
-				llrm::SetViewport(DstCmd, 0, 0, ViewportSize.x, ViewportSize.y);
-				llrm::SetScissor(DstCmd, 0, 0, ViewportSize.x, ViewportSize.y);
+				llrm::SetViewport(Cmd, 0, 0, ViewportSize.x, ViewportSize.y);
+				llrm::SetScissor(Cmd, 0, 0, ViewportSize.x, ViewportSize.y);
 
-				llrm::BindPipeline(DstCmd, DstPipeline);
-				llrm::BindResources(DstCmd, { DstResources });
-				llrm::DrawVertexBufferIndexed(DstCmd, Resources.mFullScreenQuadVbo, Resources.mFullScreenQuadIbo, 6);
+				llrm::BindPipeline(Cmd, DstPipeline);
+				llrm::BindResources(Cmd, { DstResources });
+				llrm::DrawVertexBufferIndexed(Cmd, Resources.mFullScreenQuadVbo, Resources.mFullScreenQuadIbo, 6);
 
 				// Call post tonemap
-				PostTonemap(DstCmd);
+				PostTonemap(Cmd);
 			}
-			llrm::EndRenderGraph(DstCmd);
+			llrm::EndRenderGraph(Cmd);
+		}, true);
+		llrm::FGRead(Graph, TonemapPass, HDRColor, llrm::AttachmentUsage::ShaderRead);
+
+		llrm::FGCompile(Graph);
+
+		// Render the scene
+		llrm::Begin(DstCmd);
+		{
+			LLRM_TRACE_ZONE("Ruby Record");
+			llrm::FGExecute(Graph, DstCmd);
 		}
 		llrm::End(DstCmd);
 	}
@@ -1196,8 +1554,11 @@ glm::transpose(CamProj * CamView)
 		std::function<void(const llrm::CommandBuffer&)> PostTonemap
 	)
 	{
+		LLRM_TRACE_ZONE("Ruby Frame");
+
 		Scene& ToRender = GContext.mScenes[Id];
 
+		// No frame is begun while the window can't be rendered to, e.g. when it's minimized, so there's nothing to end either
 		int32_t ImageIndex = llrm::BeginFrame(Target.mWnd, Target.mSwap, Target.mSurface);
 
 		if(ImageIndex >= 0)
@@ -3,6 +3,7 @@
 #include <string>
 #include <unordered_set>
 #include "llrm.h"
+#include "llrm_framegraph.h"
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
 #include "Uniforms.h"
@@ -41,6 +42,9 @@ namespace Ruby
 	struct RenderSettings
 	{
 		bool mShadowsEnabled = false;
+
+		// Skips meshes whose bounding box was hidden when tested against the depth buffer in an earlier frame
+		bool mOcclusionCulling = false;
 	};
 
 	enum class DistanceUnits
@@ -75,19 +79,26 @@ namespace Ruby
 		llrm::ResourceSet	 mDeferredShadeRes;
 
 		// Light data resources
-		llrm::Texture			mLightDataTexture;
-		llrm::TextureView		mLightDataTextureView;
+		llrm::StorageBuffer		mLightDataBuffer;
 		std::vector<glm::vec4>  mLightData;
 
 		// Shadow map resources
 		llrm::Texture				   mShadowMaps;
 		llrm::TextureView			   mShadowMapsResourceView;
 		std::vector<llrm::TextureView> mShadowMapAttachmentViews;
-		std::vector<llrm::FrameBuffer> mShadowMapFbos;
+		std::vector<llrm::FrameBuffer> mShadowMapFbos; // Empty with dynamic shadow rendering
 		std::vector<glm::vec4>		   mShadowFrustumsData;
 
-		llrm::Texture		 mShadowMapFrustums;
-		llrm::TextureView	 mShadowMapFrustumsView;
+		llrm::StorageBuffer	 mShadowMapFrustums;
+
+		// Rebuilt every time the scene is rendered
+		llrm::FrameGraph	 mFrameGraph;
+
+		// Occlusion culling. Mesh objects keep their query, so a frame can look up the result an earlier frame got for the same object.
+		llrm::QueryPool							mOcclusionQueries;
+		std::unordered_map<ObjectId, uint32_t>	mOcclusionQueryIndices;
+		llrm::VertexBuffer						mUnitCubeVbo;
+		llrm::IndexBuffer						mUnitCubeIbo;
 	};
 
 	struct Camera
@@ -118,6 +129,10 @@ namespace Ruby
 		llrm::IndexBuffer mIbo;
 		uint32_t mIndexCount;
 		uint32_t mMat = INVALID_ID;
+
+		// Object space bounds, drawn in place of the mesh to test its visibility
+		glm::vec3 mBoundsMin{};
+		glm::vec3 mBoundsMax{};
 	};
 
 	enum class ObjectType
@@ -207,17 +222,28 @@ namespace Ruby
 		llrm::ResourceLayout mDeferredShadeRl;
 		llrm::ResourceLayout mMaterialLayout;
 
-		// Shadow map generation
-		llrm::RenderGraph	 mShadowMapRG;
+		// Shared by the tonemap pipeline of every swap chain
+		llrm::ShaderProgram  mTonemapShader{};
+
+		// Whether meshes are created with QuantizedMeshVertex, which the mesh pipelines are created to read
+		bool				 mQuantizedVertices = false;
+
+		// Shadow map generation. Shadow maps are rendered to without a render graph or frame buffers when the device supports dynamic rendering.
+		bool				 mDynamicShadowRendering = false;
+		llrm::RenderGraph	 mShadowMapRG{};
 		llrm::Pipeline		 mShadowMapPipe;
 
 		// Render graphs
-		llrm::RenderGraph	 mDeferredGeoRG;
-		llrm::RenderGraph	 mDeferredShadeRG;
+		llrm::RenderGraph	 mDeferredRG; // Geometry pass followed by the shade pass, which reads the G-buffer as input attachments
 
 		// Pipelines
 		llrm::Pipeline		 mDeferredGeoPipe;
 
+		// Draws mesh bounds into the geometry pass without writing anything, only to count the samples that pass the depth test
+		llrm::ResourceLayout mOcclusionProxyLayout;
+		llrm::Pipeline		 mOcclusionProxyPipe;
+		bool				 mConditionalRendering = false; // Hidden meshes are skipped on the GPU with the previous frame's results
+
 		// Default material
 		llrm::ResourceSet	 mDefaultMaterial;
 
@@ -251,11 +277,10 @@ namespace Ruby
 		llrm::TextureView	 mDeferredAlbedoView;
 		llrm::TextureView	 mDeferredPositionView;
 		llrm::TextureView	 mDeferredNormalView;
-		llrm::Texture		 mDeferredRMAOView;
-		llrm::FrameBuffer	 mDeferredGeoFB;
+		llrm::TextureView	 mDeferredRMAOView;
 
-		// Deferred shading stage
-		llrm::FrameBuffer	 mDeferredShadeFB;
+		// G-buffer, depth and HDR color
+		llrm::FrameBuffer	 mDeferredFB;
 
 		// Scene color/depth
 		llrm::Texture	  mHDRColor;
@@ -268,6 +293,10 @@ namespace Ruby
 	{
 		std::string ShadersRoot;
 		std::string CompiledShaders;
+		bool Headless = false; // Render without a window system, e.g. on servers without a display
+		uint32_t FramesInFlight = 3;
+		std::string Device; // Restricts the devices that can be picked, see llrm::ContextCreateInfo::Device
+		bool QuantizedVertices = false; // Store meshes as QuantizedMeshVertex, which halves the vertex data the GPU fetches
 	};
 
 	struct MeshVertex
@@ -276,6 +305,16 @@ namespace Ruby
 		glm::vec3 mNormal;
 	};
 
+	/*
+	 * The layout CreateMesh encodes MeshVertex into when the context uses quantized vertices, 12 bytes instead of 24.
+	 * Positions are normalized to the mesh's bounds and scaled back by the vertex shader, and normals are octahedral encoded.
+	 */
+	struct QuantizedMeshVertex
+	{
+		int16_t mPosition[4]; // Short4Norm, w is always zero
+		int16_t mNormal[2]; // Short2Norm
+	};
+
 	struct Tesselation
 	{
 		std::vector<MeshVertex> mVerts;
@@ -338,6 +377,10 @@ namespace Ruby
 	void AddObject(SceneId Scene, ObjectId Object);
 	void RemoveObject(SceneId Scene, ObjectId Object);
 
+	// Whether the object's occlusion query passed no samples the last time it was resolved, always false without occlusion culling.
+	// Only valid while a frame is being rendered, e.g. from the PostTonemap callback of RenderScene.
+	bool IsObjectOccluded(SceneId Scene, ObjectId Object);
+
 	extern RubyContext GContext;
 
 	struct FrameBuffer
@@ -2,6 +2,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 
 #include "Utill.h"
 #include "glslang/Include/ResourceLimits.h"
@@ -133,6 +134,7 @@ struct ShaderCompileResult
 {
     std::vector<uint32_t> OutVertShader;
     std::vector<uint32_t> OutFragShader;
+    std::vector<uint32_t> OutCompShader;
 };
 
 bool LoadShaderSource(std::string Name, std::string& OutSrc)
@@ -210,50 +212,33 @@ private:
 
 } Includer;
 
-bool HlslToSpv(const std::string& VertSrc, const std::string& FragSrc, ShaderCompileResult& OutResult)
+struct HlslStage
 {
-    glslang::TProgram ShaderProgram;
-
-    const char* VertSourcesArray[] = { VertSrc.c_str() };
-    const char* FragSourcesArray[] = { FragSrc.c_str() };
+    EShLanguage Language;
+    const char* Name; // Printed along with compile errors
+    const std::string& Src;
+    std::vector<uint32_t>& OutSpv;
+};
 
-    glslang::TShader VertexShader(EShLanguage::EShLangVertex);
-    glslang::TShader FragmentShader(EShLanguage::EShLangFragment);
+// Compiles the stages of one program and links them together, e.g. a vertex and fragment shader or a single compute shader
+bool HlslToSpv(std::initializer_list<HlslStage> Stages)
+{
+    glslang::TProgram ShaderProgram;
 
+    // The program refers to its shaders until the SPIR-V has been generated
+    std::vector<std::unique_ptr<glslang::TShader>> Shaders;
 
-    // Add vertex shader if present
-    if(!VertSrc.empty())
+    for (const HlslStage& Stage : Stages)
     {
-        VertexShader.setEnvInput(glslang::EShSource::EShSourceHlsl, EShLanguage::EShLangVertex, glslang::EShClientVulkan, glslang::EShTargetClientVersion::EShTargetVulkan_1_2);
-        VertexShader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_2);
-        VertexShader.setStrings(VertSourcesArray, 1);
-        VertexShader.setEntryPoint("main");
-
-        if (!VertexShader.parse(&DefaultTBuiltInResource,
-            0,
-            EProfile::ECoreProfile,
-            false,
-            false,
-            EShMessages::EShMsgDefault,
-            Includer)
-            )
-        {
-            std::cerr << "Vertex compile error: " << VertexShader.getInfoLog() << std::endl;
-            return false;
-        }
+        const char* SourcesArray[] = { Stage.Src.c_str() };
 
-        ShaderProgram.addShader(&VertexShader);
-    }
-
-    // Add fragment shader if present
-    if(!FragSrc.empty())
-    {
-        FragmentShader.setEnvInput(glslang::EShSource::EShSourceHlsl, EShLanguage::EShLangFragment, glslang::EShClientVulkan, glslang::EShTargetClientVersion::EShTargetVulkan_1_2);
-        FragmentShader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_2);
-        FragmentShader.setStrings(FragSourcesArray, 1);
-        FragmentShader.setEntryPoint("main");
+        glslang::TShader& Shader = *Shaders.emplace_back(std::make_unique<glslang::TShader>(Stage.Language));
+        Shader.setEnvInput(glslang::EShSource::EShSourceHlsl, Stage.Language, glslang::EShClientVulkan, glslang::EShTargetClientVersion::EShTargetVulkan_1_2);
+        Shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_2);
+        Shader.setStrings(SourcesArray, 1);
+        Shader.setEntryPoint("main");
 
-        if (!FragmentShader.parse(&DefaultTBuiltInResource,
+        if (!Shader.parse(&DefaultTBuiltInResource,
             0,
             EProfile::ECoreProfile,
             false,
@@ -262,11 +247,11 @@ bool HlslToSpv(const std::string& VertSrc, const std::string& FragSrc, ShaderCom
             Includer)
             )
         {
-            std::cerr << "Fragment compile error: " << FragmentShader.getInfoLog() << std::endl;
+            std::cerr << Stage.Name << " compile error: " << Shader.getInfoLog() << std::endl;
             return false;
         }
 
-        ShaderProgram.addShader(&FragmentShader);
+        ShaderProgram.addShader(&Shader);
     }
 
     // Link program
@@ -285,14 +270,9 @@ bool HlslToSpv(const std::string& VertSrc, const std::string& FragSrc, ShaderCom
     Opts.generateDebugInfo = true;
 
     // Get Spv for each shader stage
-    if(!VertSrc.empty())
-    {
-        glslang::GlslangToSpv(*ShaderProgram.getIntermediate(EShLanguage::EShLangVertex), OutResult.OutVertShader, &Opts);
-    }
-
-    if(!FragSrc.empty())
+    for (const HlslStage& Stage : Stages)
     {
-        glslang::GlslangToSpv(*ShaderProgram.getIntermediate(EShLanguage::EShLangFragment), OutResult.OutFragShader, &Opts);
+        glslang::GlslangToSpv(*ShaderProgram.getIntermediate(Stage.Language), Stage.OutSpv, &Opts);
     }
 
     return true;
@@ -300,6 +280,7 @@ bool HlslToSpv(const std::string& VertSrc, const std::string& FragSrc, ShaderCom
 
 static std::string VertExt = ".vert";
 static std::string FragExt = ".frag";
+static std::string CompExt = ".comp";
 
 bool CompileVertShader(std::string Vert, ShaderCompileResult& OutResult)
 {
@@ -307,8 +288,8 @@ bool CompileVertShader(std::string Vert, ShaderCompileResult& OutResult)
     if (!LoadShaderSource(Vert + VertExt + ".hlsl", VertSrc))
         return false;
 
-#ifdef LLRM_VULKAN
-    return HlslToSpv(VertSrc, "", OutResult);
+#if defined(LLRM_VULKAN) || defined(LLRM_NULL)
+    return HlslToSpv({ { EShLanguage::EShLangVertex, "Vertex", VertSrc, OutResult.OutVertShader } });
 #endif
 }
 
@@ -318,8 +299,8 @@ bool CompileFragShader(std::string Frag, ShaderCompileResult& OutResult)
     if (!LoadShaderSource(Frag + FragExt + ".hlsl", FragSrc))
         return false;
 
-#ifdef LLRM_VULKAN
-    return HlslToSpv("", FragSrc, OutResult);
+#if defined(LLRM_VULKAN) || defined(LLRM_NULL)
+    return HlslToSpv({ { EShLanguage::EShLangFragment, "Fragment", FragSrc, OutResult.OutFragShader } });
 #endif
 }
 
@@ -331,15 +312,29 @@ bool CompileRasterProgram(std::string Vert, std::string Frag, ShaderCompileResul
     if (!LoadShaderSource(Frag + FragExt + ".hlsl", FragSrc))
         return false;
 
-#ifdef LLRM_VULKAN
-    return HlslToSpv(VertSrc, FragSrc, OutResult);
+#if defined(LLRM_VULKAN) || defined(LLRM_NULL)
+    return HlslToSpv({
+        { EShLanguage::EShLangVertex, "Vertex", VertSrc, OutResult.OutVertShader },
+        { EShLanguage::EShLangFragment, "Fragment", FragSrc, OutResult.OutFragShader }
+    });
+#endif
+}
+
+bool CompileComputeProgram(std::string Comp, ShaderCompileResult& OutResult)
+{
+    std::string CompSrc{};
+    if (!LoadShaderSource(Comp + CompExt + ".hlsl", CompSrc))
+        return false;
+
+#if defined(LLRM_VULKAN) || defined(LLRM_NULL)
+    return HlslToSpv({ { EShLanguage::EShLangCompute, "Compute", CompSrc, OutResult.OutCompShader } });
 #endif
 }
 
 namespace Ruby
 {
 
-#ifdef LLRM_VULKAN
+#if defined(LLRM_VULKAN) || defined(LLRM_NULL)
     static std::string CompiledShaderExt = ".spv";
 #endif
 
@@ -366,7 +361,8 @@ namespace Ruby
     enum ShaderType
     {
 	    Vertex,
-        Fragment
+        Fragment,
+        Compute
     };
 
     void GenerateUberPerms(std::string ShaderName, ShaderType Type, std::vector<UberVar> Ubers, uint32_t UberIndex, std::vector<std::pair<std::string, uint32_t>> UberValues, std::vector<std::string>& OutShaders)
@@ -383,7 +379,7 @@ namespace Ruby
             {
                 // Terminal, generate shader
 
-            	const std::string& Ext = (Type == Vertex) ? VertExt : FragExt;
+            	const std::string& Ext = (Type == Vertex) ? VertExt : (Type == Fragment) ? FragExt : CompExt;
 
                 std::filesystem::path Root = GetProgramPath();
                 std::filesystem::path Shaders = Root.parent_path().parent_path() / "Shaders";
@@ -459,6 +455,57 @@ namespace Ruby
 
     }
 
+    bool CompileComputeProgram(std::string CompName, std::vector<UberVar> CompUbers)
+    {
+        std::filesystem::path Root = Ruby::GContext.CompiledShaders;
+
+        std::vector<std::string> OutCompShaders;
+        GenerateUberPerms(CompName, Compute, CompUbers, 0, {}, OutCompShaders);
+
+        for (const std::string& CompUber : OutCompShaders)
+        {
+            std::filesystem::path CompPath = Root / (CompUber + CompExt + CompiledShaderExt);
+
+            ShaderCompileResult Result{};
+            if (!CompileComputeProgram(CompUber, Result))
+            {
+                // Error
+                return false;
+            }
+
+            std::filesystem::create_directories(CompPath.parent_path());
+            WriteBinaryFile(CompPath.string(), Result.OutCompShader);
+        }
+
+        return true;
+    }
+
+    llrm::ShaderProgram LoadComputeShader(std::string CompName)
+    {
+        std::filesystem::path Root = Ruby::GContext.CompiledShaders;
+        std::filesystem::path CompPath = Root / (CompName + CompExt + CompiledShaderExt);
+
+        ShaderCompileResult Result{};
+
+        if (gForceBuildShaders || !std::filesystem::exists(CompPath))
+        {
+            if (!CompileComputeProgram(CompName, Result))
+            {
+                // Error
+                return nullptr;
+            }
+
+            std::filesystem::create_directories(CompPath.parent_path());
+            WriteBinaryFile(CompPath.string(), Result.OutCompShader);
+        }
+        else
+        {
+            LoadBinaryFile(CompPath.string(), Result.OutCompShader);
+        }
+
+        return llrm::CreateComputeProgram(Result.OutCompShader);
+    }
+
     llrm::ShaderProgram LoadRasterShader(std::string VertName, std::string FragName)
     {
         std::filesystem::path Root = Ruby::GContext.CompiledShaders;
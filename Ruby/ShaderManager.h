@@ -14,10 +14,12 @@ namespace Ruby
 	};
 
 	llrm::ShaderProgram LoadRasterShader(std::string VertName, std::string FragName);
+	llrm::ShaderProgram LoadComputeShader(std::string CompName);
 
 	void InitShaderCompilation();
 	void FinishShaderCompilation();
 
 	bool CompileRasterProgram(std::string VertName, std::string FragName, std::vector<UberVar> VertUbers, std::vector<UberVar> FragUbers);
+	bool CompileComputeProgram(std::string CompName, std::vector<UberVar> CompUbers);
 
 }
@@ -1,3 +1,9 @@
+#include "Math.hlsl"
+
+#ifndef UBER_QUANTIZED
+	#error Must define UBER_QUANTIZED to be 0 or 1
+#endif
+
 cbuffer CameraUniforms : register(b0, space0)
 {
     float4x4 ViewProjection;
@@ -7,12 +13,19 @@ cbuffer CameraUniforms : register(b0, space0)
 cbuffer ModelUniforms : register(b0, space1)
 {
     float4x4 Transform;
+    float4 PositionCenter;
+    float4 PositionExtent;
 }
 
 struct VSIn
 {
+#if UBER_QUANTIZED
+    float4 Position : SV_Position; // Relative to the mesh bounds, w is unused
+	float2 Normal   : SV_Normal; // Octahedral encoded
+#else
     float3 Position : SV_Position;
 	float3 Normal   : SV_Normal;
+#endif
 };
 
 struct VSOut
@@ -24,10 +37,18 @@ struct VSOut
 
 VSOut main(VSIn Input)
 {
+#if UBER_QUANTIZED
+    float3 Position = PositionCenter.xyz + Input.Position.xyz * PositionExtent.xyz;
+    float3 Normal = OctahedralDecode(Input.Normal);
+#else
+    float3 Position = Input.Position;
+    float3 Normal = Input.Normal;
+#endif
+
     VSOut Output;
-    Output.WorldPosition = (Transform * float4(Input.Position, 1.0)).xyz;
+    Output.WorldPosition = (Transform * float4(Position, 1.0)).xyz;
 	Output.Position = ViewProjection * float4(Output.WorldPosition, 1.0f);
-    Output.Normal = Transform * float4(Input.Normal, 0.0);
+    Output.Normal = Transform * float4(Normal, 0.0);
 
     return Output;
 }
\ No newline at end of file
@@ -17,16 +17,19 @@ struct PSOut
 
 // Num direction lights, directional light, etc.
 // Num spot lights, spot light, etc.
-Texture2D<float4>      LightDataTexture    : register(t0, space0);
-Texture2DArray<float>  ShadowMaps          : register(t1, space0);
-Texture2D<float4>      ShadowMapFrustums   : register(t2, space0);
+StructuredBuffer<float4> LightData         : register(t0, space0);
+Texture2DArray<float>    ShadowMaps        : register(t1, space0);
+StructuredBuffer<float4> ShadowMapFrustums : register(t2, space0); // Four rows per frustum
 
 // Per material uniforms
 SamplerState           Nearest             : register(t0, space1);
-Texture2D<float4>      Albedo              : register(t1, space1);
-Texture2D<float4>      Position            : register(t2, space1);
-Texture2D<float4>      Normal              : register(t3, space1);
-Texture2D<float4>      RMAOTex             : register(t4, space1);
+
+// G-buffer, written by the previous pass of the render graph
+[[vk::input_attachment_index(0)]] SubpassInput<float4> Albedo   : register(t1, space1);
+[[vk::input_attachment_index(1)]] SubpassInput<float4> Position : register(t2, space1);
+[[vk::input_attachment_index(2)]] SubpassInput<float4> Normal   : register(t3, space1);
+[[vk::input_attachment_index(3)]] SubpassInput<float4> RMAOTex  : register(t4, space1);
+
 cbuffer SceneUniforms : register(b5, space1)
 {
     float3 ViewPosition;
@@ -36,12 +39,12 @@ PSOut main(PSIn Input)
 {
     PSOut Output;
 
-    float3 Position = Position.Sample(Nearest, Input.UV);
+    float3 Position = Position.SubpassLoad();
 
-    // Sample geometry
-    float4 Albedo = Albedo.Sample(Nearest, Input.UV);
-    float3 Normal = Normal.Sample(Nearest, Input.UV);
-    float3 RMAO   = RMAOTex.Sample(Nearest, Input.UV);
+    // Load geometry
+    float4 Albedo = Albedo.SubpassLoad();
+    float3 Normal = Normal.SubpassLoad();
+    float3 RMAO   = RMAOTex.SubpassLoad();
 
     // Used throughout
     float3 V = normalize(ViewPosition - Position);
@@ -57,14 +60,14 @@ PSOut main(PSIn Input)
 
     float3 Radiance = float(0.0);
 
-    float4 LightCounts = LightDataTexture.Load(int3(0, 0, 0));
+    float4 LightCounts = LightData[0];
 	uint LightDataIndex = 1;
     for (uint Light = 0; Light < LightCounts.x; Light++)
     {
-        float4 LightType = LightDataTexture.Load(int3(LightDataIndex + 0, 0, 0));
+        float4 LightType = LightData[LightDataIndex + 0];
         float3 LightColor = LightType.yzw;
 
-        float4 ShadowProperties = LightDataTexture.Load(int3(LightDataIndex + 1, 0, 0));
+        float4 ShadowProperties = LightData[LightDataIndex + 1];
 
     	bool LightEffectsSurface = true;
 
@@ -98,7 +101,7 @@ PSOut main(PSIn Input)
             if((uint) LightType.x == 0) // Light type == directional 
             {
                 // Lux (lumens/m^2)
-                float4 DirIntensity = LightDataTexture.Load(int3(LightDataIndex + 2, 0, 0));
+                float4 DirIntensity = LightData[LightDataIndex + 2];
                 DirectionalLight DirLight;
                 DirLight.Color = LightColor;
                 DirLight.Direction = DirIntensity.xyz;
@@ -109,9 +112,9 @@ PSOut main(PSIn Input)
 
             if((uint) LightType.x == 1) // Light type == spot light
             {
-                float4 DirIntensity = LightDataTexture.Load(int3(LightDataIndex + 2, 0, 0));
-                float4 SpotPosition = LightDataTexture.Load(int3(LightDataIndex + 3, 0, 0));
-            	float4 SpotParams = LightDataTexture.Load(int3(LightDataIndex + 4, 0, 0));
+                float4 DirIntensity = LightData[LightDataIndex + 2];
+                float4 SpotPosition = LightData[LightDataIndex + 3];
+            	float4 SpotParams = LightData[LightDataIndex + 4];
 
             	SpotLight Spot;
                 Spot.Position = SpotPosition.xyz;
@@ -1,3 +1,7 @@
+#ifndef UBER_QUANTIZED
+	#error Must define UBER_QUANTIZED to be 0 or 1
+#endif
+
 cbuffer LightUniforms : register(b0, space0)
 {
     float4x4 ViewProjection;
@@ -6,12 +10,19 @@ cbuffer LightUniforms : register(b0, space0)
 cbuffer ModelUniforms : register(b0, space1)
 {
     float4x4 Transform;
+    float4 PositionCenter;
+    float4 PositionExtent;
 }
 
 struct VSIn
 {
+#if UBER_QUANTIZED
+    float4 Position : SV_Position; // Relative to the mesh bounds, w is unused
+    float2 Normal   : SV_Normal;
+#else
     float3 Position : SV_Position;
     float3 Normal   : SV_Normal;
+#endif
 };
 
 struct VSOut
@@ -21,8 +32,14 @@ struct VSOut
 
 VSOut main(VSIn Input)
 {
+#if UBER_QUANTIZED
+    float3 Position = PositionCenter.xyz + Input.Position.xyz * PositionExtent.xyz;
+#else
+    float3 Position = Input.Position;
+#endif
+
     VSOut Output;
-    Output.Position = ViewProjection * (Transform * float4(Input.Position, 1.0));
+    Output.Position = ViewProjection * (Transform * float4(Position, 1.0));
 
     return Output;
 }
\ No newline at end of file
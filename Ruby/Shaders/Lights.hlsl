@@ -78,12 +78,12 @@ float3 CalcSpotLightRadiance(
 	return LightRadiance(BRDF, Radiance, NDotL);
 }
 
-float4x4 ExtractViewProjMatrix(Texture2D<float4> Tex, uint FrustumIndex)
+float4x4 ExtractViewProjMatrix(StructuredBuffer<float4> Frustums, uint FrustumIndex)
 {
-	float4 Row0 = Tex.Load(int3(FrustumIndex * 4 + 0, 0, 0));
-	float4 Row1 = Tex.Load(int3(FrustumIndex * 4 + 1, 0, 0));
-	float4 Row2 = Tex.Load(int3(FrustumIndex * 4 + 2, 0, 0));
-	float4 Row3 = Tex.Load(int3(FrustumIndex * 4 + 3, 0, 0));
+	float4 Row0 = Frustums[FrustumIndex * 4 + 0];
+	float4 Row1 = Frustums[FrustumIndex * 4 + 1];
+	float4 Row2 = Frustums[FrustumIndex * 4 + 2];
+	float4 Row3 = Frustums[FrustumIndex * 4 + 3];
 
 	return float4x4(Row0, Row1, Row2, Row3);
 }
\ No newline at end of file
@@ -1 +1,14 @@
-#define PI 3.14159
\ No newline at end of file
+#define PI 3.14159
+
+// Unit vector from the two components of an octahedral encoding, see QuantizeVertices in Ruby.cpp
+float3 OctahedralDecode(float2 Encoded)
+{
+    float3 Normal = float3(Encoded, 1.0 - abs(Encoded.x) - abs(Encoded.y));
+
+    // Unfold the lower hemisphere
+    float Fold = saturate(-Normal.z);
+    Normal.x += Normal.x >= 0.0 ? -Fold : Fold;
+    Normal.y += Normal.y >= 0.0 ? -Fold : Fold;
+
+    return normalize(Normal);
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+struct PSIn
+{
+    float4 Position : SV_Position;
+};
+
+// Nothing is written, the draw only counts the samples that pass the depth test
+void main(PSIn Input)
+{
+}
@@ -0,0 +1,36 @@
+cbuffer CameraUniforms : register(b0, space0)
+{
+    float4x4 ViewProjection;
+}
+
+cbuffer ModelUniforms : register(b0, space1)
+{
+    float4x4 Transform;
+}
+
+// Object space bounds the unit cube is stretched over
+cbuffer ProxyUniforms : register(b0, space2)
+{
+    float4 BoundsMin;
+    float4 BoundsExtent;
+}
+
+struct VSIn
+{
+    float3 Position : SV_Position;
+};
+
+struct VSOut
+{
+    float4 Position : SV_Position;
+};
+
+VSOut main(VSIn Input)
+{
+    VSOut Output;
+    float3 ObjectPosition = BoundsMin.xyz + Input.Position * BoundsExtent.xyz;
+    float3 WorldPosition = (Transform * float4(ObjectPosition, 1.0)).xyz;
+	Output.Position = ViewProjection * float4(WorldPosition, 1.0f);
+
+    return Output;
+}
@@ -10,6 +10,10 @@ struct CameraVertexUniforms
 struct ModelVertexUniforms
 {
 	glm::mat4 mTransform;
+
+	// Scales the positions of quantized meshes back to object space, the center and half size of the mesh's bounds
+	glm::vec4 mPositionCenter;
+	glm::vec4 mPositionExtent;
 };
 
 struct DeferredShadeResources
@@ -29,6 +33,12 @@ struct ShadowLightUniforms
 	glm::mat4 mViewProjection;
 };
 
+struct OcclusionProxyUniforms
+{
+	glm::vec4 mBoundsMin;
+	glm::vec4 mBoundsExtent;
+};
+
 #define MAX_DIR_LIGHTS 1000
 #define MAX_SPOT_LIGHTS 1000
 
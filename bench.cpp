@@ -0,0 +1,782 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "llrm.h"
+#include "llrm_framegraph.h"
+#include "shadercompile.h"
+
+/*
+ * Headless microbenchmarks of the backend, meant to be run on the same machine and driver (e.g. a software Vulkan driver in CI)
+ * from one commit to the next so regressions show up in the results.
+ *
+ * Every sample does a fixed amount of work. The first samples warm up caches, allocators and the driver and are discarded,
+ * and the median of the remaining samples is reported along with the min and max, so a single noisy sample doesn't move the result.
+ * Heap allocations made while timing are counted too. Recording draws is expected not to allocate once warmed up, and the run fails if it does.
+ * The run also fails if the frame graph stops placing transient textures in shared memory, or stops waiting on the texture that used it before.
+ *
+ * Usage: LLRM-bench [--out <file>] [--filter <substring>] [--samples <count>]
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+const uint32_t BENCH_TARGET_SIZE = 256;
+const uint64_t BENCH_UNIFORM_SIZE = 256;
+const uint64_t BENCH_BUFFER_SIZE = 4 * 1024 * 1024;
+const uint32_t BENCH_TEXTURE_SIZE = 1024;
+const uint32_t BENCH_BATCHED_TEXTURES = 8;
+
+struct BenchOptions
+{
+	std::string OutPath; // Printed to stdout when empty
+	std::string Filter; // Only benchmarks whose name contains this are run
+	uint32_t Samples = 15;
+	uint32_t WarmupSamples = 3;
+};
+
+struct BenchResult
+{
+	std::string Name;
+	uint64_t OpsPerSample = 0;
+
+	// Nanoseconds per operation over the measured samples
+	double Median = 0.0;
+	double Min = 0.0;
+	double Max = 0.0;
+
+	uint64_t BytesPerOp = 0; // Data moved by each operation, for the benchmarks that measure bandwidth
+	double AllocationsPerOp = 0.0; // Heap allocations made by each operation over the measured samples
+};
+
+// Every allocation made through operator new, the array and nothrow forms forward to it
+std::atomic<uint64_t> GBenchAllocations = 0;
+
+// The allocations made by the work of the last Time call
+uint64_t GBenchTimedAllocations = 0;
+
+void* operator new(size_t Size)
+{
+	GBenchAllocations.fetch_add(1, std::memory_order_relaxed);
+
+	if (void* Memory = std::malloc(Size > 0 ? Size : 1))
+		return Memory;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* Memory) noexcept
+{
+	std::free(Memory);
+}
+
+void operator delete(void* Memory, size_t) noexcept
+{
+	std::free(Memory);
+}
+
+struct BenchVertex
+{
+	float Position[2];
+};
+
+// Everything the benchmarks render with, created once up front
+struct BenchScene
+{
+	llrm::ShaderProgram Shader = nullptr;
+	llrm::ResourceLayout Layout = nullptr;
+	llrm::RenderGraph Graph = nullptr;
+	llrm::Texture Target = nullptr;
+	llrm::TextureView TargetView = nullptr;
+	llrm::FrameBuffer Fbo = nullptr;
+
+	// Two of each so rebinding can't be skipped as redundant
+	llrm::Pipeline Pipelines[2]{};
+	llrm::ResourceSet Resources[2]{};
+
+	llrm::VertexBuffer Vbo = nullptr;
+	llrm::CommandBuffer Cmd = nullptr;
+};
+
+template<typename Func>
+BenchClock::duration Time(Func&& Work)
+{
+	uint64_t Allocations = GBenchAllocations.load(std::memory_order_relaxed);
+	BenchClock::time_point Start = BenchClock::now();
+	Work();
+	BenchClock::duration Elapsed = BenchClock::now() - Start;
+	GBenchTimedAllocations = GBenchAllocations.load(std::memory_order_relaxed) - Allocations;
+
+	return Elapsed;
+}
+
+class BenchRunner
+{
+public:
+
+	BenchRunner(const BenchOptions& InOptions) :
+	Options(InOptions) {}
+
+	/*
+	 * Sample does OpsPerSample operations and returns the time spent in the part being measured,
+	 * so setup and teardown that's part of every sample can be left out.
+	 */
+	template<typename Func>
+	void Run(const std::string& Name, uint64_t OpsPerSample, uint64_t BytesPerOp, Func&& Sample)
+	{
+		if (!Options.Filter.empty() && Name.find(Options.Filter) == std::string::npos)
+			return;
+
+		std::cerr << "Running " << Name << std::endl;
+
+		std::vector<double> NsPerOp;
+		uint64_t Allocations = 0;
+		for (uint32_t SampleIndex = 0; SampleIndex < Options.WarmupSamples + Options.Samples; SampleIndex++)
+		{
+			GBenchTimedAllocations = 0;
+			BenchClock::duration Elapsed = Sample();
+			if (SampleIndex >= Options.WarmupSamples)
+			{
+				NsPerOp.push_back(std::chrono::duration<double, std::nano>(Elapsed).count() / OpsPerSample);
+				Allocations += GBenchTimedAllocations;
+			}
+		}
+
+		std::sort(NsPerOp.begin(), NsPerOp.end());
+
+		BenchResult Result;
+		Result.Name = Name;
+		Result.OpsPerSample = OpsPerSample;
+		Result.Median = NsPerOp[NsPerOp.size() / 2];
+		Result.Min = NsPerOp.front();
+		Result.Max = NsPerOp.back();
+		Result.BytesPerOp = BytesPerOp;
+		Result.AllocationsPerOp = static_cast<double>(Allocations) / (static_cast<double>(OpsPerSample) * Options.Samples);
+		Results.push_back(Result);
+	}
+
+	const std::vector<BenchResult>& GetResults() const { return Results; }
+
+private:
+
+	BenchOptions Options;
+	std::vector<BenchResult> Results;
+};
+
+std::string EscapeJson(const std::string& Str)
+{
+	std::string Result;
+	for (char Char : Str)
+	{
+		if (Char == '"' || Char == '\\')
+		{
+			Result += '\\';
+			Result += Char;
+		}
+		else if (static_cast<unsigned char>(Char) < 0x20)
+		{
+			Result += ' ';
+		}
+		else
+		{
+			Result += Char;
+		}
+	}
+
+	return Result;
+}
+
+const char* GetDeviceTypeName(llrm::DeviceType Type)
+{
+	switch (Type)
+	{
+	case llrm::DeviceType::Discrete:
+		return "discrete";
+	case llrm::DeviceType::Integrated:
+		return "integrated";
+	case llrm::DeviceType::Virtual:
+		return "virtual";
+	case llrm::DeviceType::Cpu:
+		return "cpu";
+	default:
+		return "other";
+	}
+}
+
+void WriteJson(std::ostream& Out, const BenchOptions& Options, const llrm::DeviceInfo& Device, const std::vector<BenchResult>& Results)
+{
+	Out << "{\n";
+#if defined(LLRM_NULL)
+	Out << "  \"backend\": \"null\",\n";
+#else
+	Out << "  \"backend\": \"vulkan\",\n";
+#endif
+	Out << "  \"device\": \"" << EscapeJson(Device.Name) << "\",\n";
+	Out << "  \"device_type\": \"" << GetDeviceTypeName(Device.Type) << "\",\n";
+	Out << "  \"samples\": " << Options.Samples << ",\n";
+	Out << "  \"warmup_samples\": " << Options.WarmupSamples << ",\n";
+	Out << "  \"benchmarks\": [\n";
+
+	for (size_t Index = 0; Index < Results.size(); Index++)
+	{
+		const BenchResult& Result = Results[Index];
+
+		Out << "    { \"name\": \"" << Result.Name << "\", \"ops_per_sample\": " << Result.OpsPerSample;
+		Out << ", \"ns_per_op\": { \"median\": " << Result.Median << ", \"min\": " << Result.Min << ", \"max\": " << Result.Max << " }";
+		if (Result.BytesPerOp > 0)
+			Out << ", \"mb_per_s\": " << (Result.BytesPerOp / (1024.0 * 1024.0)) / (Result.Median * 1e-9);
+		Out << ", \"allocs_per_op\": " << Result.AllocationsPerOp;
+		Out << " }" << (Index + 1 < Results.size() ? "," : "") << "\n";
+	}
+
+	Out << "  ]\n";
+	Out << "}\n";
+}
+
+bool ParseOptions(int ArgCount, char** Args, BenchOptions& OutOptions)
+{
+	for (int Arg = 1; Arg < ArgCount; Arg++)
+	{
+		std::string Name = Args[Arg];
+		if (Arg + 1 >= ArgCount)
+			return false;
+
+		if (Name == "--out")
+			OutOptions.OutPath = Args[++Arg];
+		else if (Name == "--filter")
+			OutOptions.Filter = Args[++Arg];
+		else if (Name == "--samples")
+			OutOptions.Samples = std::max(1ul, std::strtoul(Args[++Arg], nullptr, 10));
+		else
+			return false;
+	}
+
+	return true;
+}
+
+bool CreateScene(BenchScene& Scene)
+{
+	InitShaderCompilation();
+
+	ShaderCompileResult Result;
+	if (CompileShader("Example.vert", "Example.frag", Result))
+		Scene.Shader = llrm::CreateRasterProgram(Result.OutVertShader, Result.OutFragShader);
+
+	FinishShaderCompilation();
+
+	if (!Scene.Shader)
+		return false;
+
+	// The shader doesn't read it, but binding a set with a uniform buffer is what most draws pay for
+	Scene.Layout = llrm::CreateResourceLayout({
+		{{0, llrm::ShaderStage::Vertex, BENCH_UNIFORM_SIZE}}
+	});
+
+	Scene.Graph = llrm::CreateRenderGraph({
+		{{llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentFormat::B8G8R8A8_UNORM}},
+		{{{0}}}
+	});
+
+	Scene.Target = llrm::CreateTexture(llrm::AttachmentFormat::B8G8R8A8_UNORM, llrm::AttachmentUsage::ShaderRead,
+		BENCH_TARGET_SIZE, BENCH_TARGET_SIZE, llrm::TEXTURE_USAGE_RT | llrm::TEXTURE_USAGE_SAMPLE | llrm::TEXTURE_USAGE_READ, 1);
+	Scene.TargetView = llrm::CreateTextureView(Scene.Target, llrm::COLOR_ASPECT);
+	Scene.Fbo = llrm::CreateFrameBuffer({ BENCH_TARGET_SIZE, BENCH_TARGET_SIZE, {Scene.TargetView}, Scene.Graph });
+
+	for (uint32_t Index = 0; Index < 2; Index++)
+	{
+		llrm::PipelineState State{
+			Scene.Shader,
+			Scene.Graph,
+			{Scene.Layout},
+			sizeof(BenchVertex),
+			{std::make_pair(llrm::VertexAttributeFormat::Float2, offsetof(BenchVertex, Position))},
+			llrm::PipelineRenderPrimitive::TRIANGLES,
+			{{false}},
+			{},
+			0
+		};
+		State.Cull = Index == 0 ? llrm::CullMode::Back : llrm::CullMode::None;
+		Scene.Pipelines[Index] = llrm::CreatePipeline(State);
+
+		uint8_t Uniforms[BENCH_UNIFORM_SIZE]{};
+		Scene.Resources[Index] = llrm::CreateResourceSet({ Scene.Layout });
+		llrm::UpdateUniformBuffer(Scene.Resources[Index], 0, Uniforms, sizeof(Uniforms));
+	}
+
+	// A small triangle, so rasterization doesn't dominate on software drivers
+	BenchVertex Verts[3] = {
+		{0.01f, -0.01f},
+		{0.0f, 0.01f},
+		{-0.01f, -0.01f}
+	};
+	Scene.Vbo = llrm::CreateVertexBuffer(sizeof(Verts), Verts);
+	Scene.Cmd = llrm::CreateCommandBuffer();
+
+	return Scene.Layout && Scene.Graph && Scene.Fbo && Scene.Pipelines[0] && Scene.Pipelines[1] && Scene.Vbo && Scene.Cmd;
+}
+
+void DestroyScene(BenchScene& Scene)
+{
+	llrm::DestroyCommandBuffer(Scene.Cmd);
+	llrm::DestroyVertexBuffer(Scene.Vbo);
+
+	for (uint32_t Index = 0; Index < 2; Index++)
+	{
+		llrm::DestroyResourceSet(Scene.Resources[Index]);
+		llrm::DestroyPipeline(Scene.Pipelines[Index]);
+	}
+
+	llrm::DestroyFrameBuffer(Scene.Fbo);
+	llrm::DestroyTextureView(Scene.TargetView);
+	llrm::DestroyTexture(Scene.Target);
+	llrm::DestroyRenderGraph(Scene.Graph);
+	llrm::DestroyResourceLayout(Scene.Layout);
+	llrm::DestroyProgram(Scene.Shader);
+}
+
+// Records Draws draws into the scene's command buffer, binding the pipeline and resources before every draw when bRebind is set
+void RecordDraws(BenchScene& Scene, uint32_t Draws, bool bRebind)
+{
+	llrm::CommandBuffer Buf = Scene.Cmd;
+
+	llrm::Reset(Buf);
+	llrm::Begin(Buf);
+	{
+		llrm::BeginRenderGraph(Buf, Scene.Graph, Scene.Fbo, { {llrm::ClearType::Float, 0.0f, 0.0f, 0.0f, 1.0f} });
+		{
+			llrm::SetViewport(Buf, 0, 0, BENCH_TARGET_SIZE, BENCH_TARGET_SIZE);
+			llrm::SetScissor(Buf, 0, 0, BENCH_TARGET_SIZE, BENCH_TARGET_SIZE);
+
+			if (!bRebind)
+			{
+				llrm::BindPipeline(Buf, Scene.Pipelines[0]);
+				llrm::BindResources(Buf, { Scene.Resources[0] });
+			}
+
+			for (uint32_t Draw = 0; Draw < Draws; Draw++)
+			{
+				if (bRebind)
+				{
+					llrm::BindPipeline(Buf, Scene.Pipelines[Draw % 2]);
+					llrm::BindResources(Buf, { Scene.Resources[Draw % 2] });
+				}
+
+				llrm::DrawVertexBuffer(Buf, Scene.Vbo, 3);
+			}
+		}
+		llrm::EndRenderGraph(Buf);
+	}
+	llrm::End(Buf);
+}
+
+void RunDrawBenchmarks(BenchRunner& Runner, BenchScene& Scene)
+{
+	const uint32_t Draws = 10000;
+
+	for (bool bRebind : { false, true })
+	{
+		std::string Name = bRebind ? "draw_rebind" : "draw_static";
+
+		// CPU cost of recording alone
+		Runner.Run(Name + "_record", Draws, 0, [&]()
+		{
+			return Time([&]() { RecordDraws(Scene, Draws, bRebind); });
+		});
+
+		// Recording, submitting and waiting for the GPU, i.e. the draw throughput
+		Runner.Run(Name + "_execute", Draws, 0, [&]()
+		{
+			return Time([&]()
+			{
+				RecordDraws(Scene, Draws, bRebind);
+				llrm::SubmitCommandBuffer(Scene.Cmd, true);
+			});
+		});
+	}
+}
+
+void RunUniformBenchmarks(BenchRunner& Runner, BenchScene& Scene)
+{
+	const uint32_t Updates = 10000;
+	uint8_t Uniforms[BENCH_UNIFORM_SIZE]{};
+
+	// Inside a frame only the current frame's copy is written, which is how per-frame data is updated
+	Runner.Run("uniform_update", Updates, BENCH_UNIFORM_SIZE, [&]()
+	{
+		llrm::BeginFrame();
+
+		BenchClock::duration Elapsed = Time([&]()
+		{
+			for (uint32_t Update = 0; Update < Updates; Update++)
+			{
+				Uniforms[0] = static_cast<uint8_t>(Update);
+				llrm::UpdateUniformBuffer(Scene.Resources[Update % 2], 0, Uniforms, sizeof(Uniforms));
+			}
+		});
+
+		llrm::EndFrame({});
+
+		return Elapsed;
+	});
+}
+
+void RunUploadBenchmarks(BenchRunner& Runner)
+{
+	const uint32_t Uploads = 4;
+
+	std::vector<uint32_t> Data(BENCH_BUFFER_SIZE / sizeof(uint32_t));
+	for (size_t Index = 0; Index < Data.size(); Index++)
+		Data[Index] = static_cast<uint32_t>(Index);
+
+	llrm::VertexBuffer Vbo = llrm::CreateVertexBuffer(BENCH_BUFFER_SIZE);
+	Runner.Run("upload_vertex_buffer", Uploads, BENCH_BUFFER_SIZE, [&]()
+	{
+		return Time([&]()
+		{
+			for (uint32_t Upload = 0; Upload < Uploads; Upload++)
+				llrm::UploadVertexBufferData(Vbo, Data.data(), BENCH_BUFFER_SIZE);
+		});
+	});
+	llrm::DestroyVertexBuffer(Vbo);
+
+	llrm::IndexBuffer Ibo = llrm::CreateIndexBuffer(BENCH_BUFFER_SIZE);
+	Runner.Run("upload_index_buffer", Uploads, BENCH_BUFFER_SIZE, [&]()
+	{
+		return Time([&]()
+		{
+			for (uint32_t Upload = 0; Upload < Uploads; Upload++)
+				llrm::UploadIndexBufferData(Ibo, Data.data(), BENCH_BUFFER_SIZE);
+		});
+	});
+	llrm::DestroyIndexBuffer(Ibo);
+
+	const llrm::AttachmentFormat Format = llrm::AttachmentFormat::B8G8R8A8_UNORM;
+	const uint64_t TextureSize = llrm::CalcTextureSizeBytes(Format, BENCH_TEXTURE_SIZE, BENCH_TEXTURE_SIZE);
+	std::vector<uint8_t> TextureData(TextureSize, 0x80);
+
+	llrm::Texture Tex = llrm::CreateTexture(Format, llrm::AttachmentUsage::ShaderRead, BENCH_TEXTURE_SIZE, BENCH_TEXTURE_SIZE,
+		llrm::TEXTURE_USAGE_WRITE | llrm::TEXTURE_USAGE_SAMPLE, 1);
+	Runner.Run("upload_texture", Uploads, TextureSize, [&]()
+	{
+		return Time([&]()
+		{
+			for (uint32_t Upload = 0; Upload < Uploads; Upload++)
+			{
+				llrm::WriteTexture(Tex, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::ShaderRead,
+					BENCH_TEXTURE_SIZE, BENCH_TEXTURE_SIZE, 0, TextureSize, TextureData.data());
+			}
+		});
+	});
+	llrm::DestroyTexture(Tex);
+}
+
+void RunReadbackBenchmarks(BenchRunner& Runner, BenchScene& Scene)
+{
+	const uint32_t Reads = 8;
+	const uint64_t Size = llrm::CalcTextureSizeBytes(llrm::AttachmentFormat::B8G8R8A8_UNORM, BENCH_TARGET_SIZE, BENCH_TARGET_SIZE);
+	std::vector<uint8_t> Pixels(Size);
+
+	// Each read waits for the device, so this is the latency of getting a rendered image back to the CPU
+	Runner.Run("read_texture", Reads, Size, [&]()
+	{
+		return Time([&]()
+		{
+			for (uint32_t Read = 0; Read < Reads; Read++)
+				llrm::ReadTexture(Scene.Target, Pixels.data(), Size, llrm::AttachmentUsage::ShaderRead);
+		});
+	});
+}
+
+void RunCreationBenchmarks(BenchRunner& Runner, BenchScene& Scene)
+{
+	const uint32_t Pipelines = 16;
+	const uint32_t Lookups = 1000;
+	const uint32_t Sets = 1000;
+
+	llrm::PipelineState State{
+		Scene.Shader,
+		Scene.Graph,
+		{Scene.Layout},
+		sizeof(BenchVertex),
+		{std::make_pair(llrm::VertexAttributeFormat::Float2, offsetof(BenchVertex, Position))},
+		llrm::PipelineRenderPrimitive::LINES,
+		{{false}},
+		{},
+		0
+	};
+
+	// Pipelines are shared, so destroying each one before creating the next is what makes every creation a miss
+	Runner.Run("pipeline_create", Pipelines, 0, [&]()
+	{
+		return Time([&]()
+		{
+			for (uint32_t Index = 0; Index < Pipelines; Index++)
+				llrm::DestroyPipeline(llrm::CreatePipeline(State));
+		});
+	});
+
+	// While an identical pipeline is alive, creation only looks it up
+	llrm::Pipeline Alive = llrm::CreatePipeline(State);
+	Runner.Run("pipeline_create_cached", Lookups, 0, [&]()
+	{
+		return Time([&]()
+		{
+			for (uint32_t Index = 0; Index < Lookups; Index++)
+				llrm::DestroyPipeline(llrm::CreatePipeline(State));
+		});
+	});
+	llrm::DestroyPipeline(Alive);
+
+	Runner.Run("resource_set_create", Sets, 0, [&]()
+	{
+		return Time([&]()
+		{
+			for (uint32_t Index = 0; Index < Sets; Index++)
+				llrm::DestroyResourceSet(llrm::CreateResourceSet({ Scene.Layout }));
+		});
+	});
+
+	Runner.Run("transient_resource_set_create", Sets, 0, [&]()
+	{
+		llrm::BeginFrame();
+
+		BenchClock::duration Elapsed = Time([&]()
+		{
+			for (uint32_t Index = 0; Index < Sets; Index++)
+				llrm::CreateTransientResourceSet({ Scene.Layout });
+		});
+
+		llrm::EndFrame({});
+
+		return Elapsed;
+	});
+}
+
+void RunBarrierBenchmarks(BenchRunner& Runner, BenchScene& Scene)
+{
+	const uint32_t Barriers = 10000;
+
+	std::vector<llrm::Texture> Textures;
+	std::vector<llrm::TextureTransition> ToTransfer, ToShaderRead;
+	for (uint32_t Index = 0; Index < BENCH_BATCHED_TEXTURES; Index++)
+	{
+		llrm::Texture Tex = llrm::CreateTexture(llrm::AttachmentFormat::B8G8R8A8_UNORM, llrm::AttachmentUsage::ShaderRead,
+			BENCH_TARGET_SIZE, BENCH_TARGET_SIZE, llrm::TEXTURE_USAGE_WRITE | llrm::TEXTURE_USAGE_SAMPLE, 1);
+		Textures.push_back(Tex);
+		ToTransfer.push_back({ Tex, llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::TransferDestination });
+		ToShaderRead.push_back({ Tex, llrm::AttachmentUsage::TransferDestination, llrm::AttachmentUsage::ShaderRead });
+	}
+
+	// Records Barriers barriers (an even amount, so the textures end up back in ShaderRead), then submits and waits
+	auto RecordAndSubmit = [&](auto&& RecordBarrier)
+	{
+		llrm::Reset(Scene.Cmd);
+		llrm::Begin(Scene.Cmd);
+		for (uint32_t Barrier = 0; Barrier < Barriers; Barrier++)
+			RecordBarrier(Barrier);
+		llrm::End(Scene.Cmd);
+
+		llrm::SubmitCommandBuffer(Scene.Cmd, true);
+	};
+
+	Runner.Run("barrier_transition", Barriers, 0, [&]()
+	{
+		return Time([&]()
+		{
+			RecordAndSubmit([&](uint32_t Barrier)
+			{
+				if (Barrier % 2 == 0)
+					llrm::TransitionTexture(Scene.Cmd, Textures[0], llrm::AttachmentUsage::ShaderRead, llrm::AttachmentUsage::TransferDestination);
+				else
+					llrm::TransitionTexture(Scene.Cmd, Textures[0], llrm::AttachmentUsage::TransferDestination, llrm::AttachmentUsage::ShaderRead);
+			});
+		});
+	});
+
+	// One barrier transitioning every texture
+	Runner.Run("barrier_transition_batched", Barriers, 0, [&]()
+	{
+		return Time([&]()
+		{
+			RecordAndSubmit([&](uint32_t Barrier)
+			{
+				llrm::TransitionTextures(Scene.Cmd, Barrier % 2 == 0 ? ToTransfer : ToShaderRead);
+			});
+		});
+	});
+
+	// The same transitions along with the vertex buffer, the way an upload pass ends
+	std::vector<llrm::BufferBarrier> VertexBarriers = { { Scene.Vbo, llrm::BarrierBufferType::Vertex, llrm::PIPELINE_STAGE_TRANSFER, llrm::PIPELINE_STAGE_VERTEX_INPUT } };
+	Runner.Run("barrier_batched_buffers", Barriers, 0, [&]()
+	{
+		return Time([&]()
+		{
+			RecordAndSubmit([&](uint32_t Barrier)
+			{
+				llrm::PipelineBarrier(Scene.Cmd, Barrier % 2 == 0 ? ToTransfer : ToShaderRead, VertexBarriers);
+			});
+		});
+	});
+
+	Runner.Run("barrier_pipeline", Barriers, 0, [&]()
+	{
+		return Time([&]()
+		{
+			RecordAndSubmit([&](uint32_t Barrier)
+			{
+				llrm::PipelineBarrier(Scene.Cmd, llrm::PIPELINE_STAGE_TRANSFER, llrm::PIPELINE_STAGE_VERTEX_INPUT);
+			});
+		});
+	});
+
+	for (llrm::Texture Tex : Textures)
+		llrm::DestroyTexture(Tex);
+}
+
+// Declares two transient textures with non-overlapping lifetimes, which the frame graph places in the same memory
+void DeclareAliasedFrame(llrm::FrameGraph Graph)
+{
+	const llrm::FrameGraphTextureDesc Desc{ llrm::AttachmentFormat::B8G8R8A8_UNORM, BENCH_TARGET_SIZE, BENCH_TARGET_SIZE };
+
+	llrm::FGReset(Graph);
+	llrm::FrameGraphResource First = llrm::FGCreateTexture(Graph, "First", Desc);
+	llrm::FrameGraphResource Second = llrm::FGCreateTexture(Graph, "Second", Desc);
+
+	// The passes' render graphs would start from an undefined layout, so the textures are written with an undefined usage
+	llrm::FrameGraphPass WriteFirst = llrm::FGAddPass(Graph, "Write First", [](llrm::CommandBuffer) {});
+	llrm::FGWrite(Graph, WriteFirst, First, llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ShaderRead);
+
+	llrm::FrameGraphPass ReadFirst = llrm::FGAddPass(Graph, "Read First", [](llrm::CommandBuffer) {}, true);
+	llrm::FGRead(Graph, ReadFirst, First, llrm::AttachmentUsage::ShaderRead);
+
+	llrm::FrameGraphPass WriteSecond = llrm::FGAddPass(Graph, "Write Second", [](llrm::CommandBuffer) {}, true);
+	llrm::FGWrite(Graph, WriteSecond, Second, llrm::AttachmentUsage::Undefined, llrm::AttachmentUsage::ShaderRead);
+}
+
+// Returns false when the first frame didn't alias the two textures, or didn't record the barrier discarding the first one
+bool RunFrameGraphBenchmarks(BenchRunner& Runner, BenchScene& Scene)
+{
+	const uint32_t Frames = 1000;
+
+	llrm::FrameGraph Graph = llrm::CreateFrameGraph();
+
+	DeclareAliasedFrame(Graph);
+	llrm::Reset(Scene.Cmd);
+	llrm::Begin(Scene.Cmd);
+	llrm::FGExecute(Graph, Scene.Cmd);
+	llrm::End(Scene.Cmd);
+	llrm::SubmitCommandBuffer(Scene.Cmd, true);
+
+	// Only the second texture has a barrier in the first frame, since nothing used the memory before the first one
+	llrm::FrameGraphStats Stats = llrm::FGGetStats(Graph);
+	bool bAliased = Stats.TransientTextures == 2 && Stats.MemoryBlocks == 1 && Stats.Transitions == 1;
+	if (!bAliased)
+	{
+		std::cerr << "The frame graph placed " << Stats.TransientTextures << " transient textures in " << Stats.MemoryBlocks
+			<< " memory blocks with " << Stats.Transitions << " transitions, expected 2 textures in 1 block with 1 transition" << std::endl;
+	}
+
+	// Declaring, compiling and recording a whole frame, with the transient textures reused from the last one
+	Runner.Run("framegraph_execute", Frames, 0, [&]()
+	{
+		llrm::Reset(Scene.Cmd);
+		llrm::Begin(Scene.Cmd);
+
+		BenchClock::duration Elapsed = Time([&]()
+		{
+			for (uint32_t Frame = 0; Frame < Frames; Frame++)
+			{
+				DeclareAliasedFrame(Graph);
+				llrm::FGExecute(Graph, Scene.Cmd);
+			}
+		});
+
+		llrm::End(Scene.Cmd);
+		llrm::SubmitCommandBuffer(Scene.Cmd, true);
+
+		return Elapsed;
+	});
+
+	llrm::DestroyFrameGraph(Graph);
+
+	return bAliased;
+}
+
+int main(int ArgCount, char** Args)
+{
+	BenchOptions Options;
+	if (!ParseOptions(ArgCount, Args, Options))
+	{
+		std::cerr << "Usage: LLRM-bench [--out <file>] [--filter <substring>] [--samples <count>]" << std::endl;
+		return 1;
+	}
+
+	llrm::Context Context = llrm::CreateContext({ .bHeadless = true });
+	if (!Context)
+	{
+		std::cerr << "Failed to create a headless context" << std::endl;
+		return 1;
+	}
+
+	// Recorded with the results, since they're only comparable on the same device
+	llrm::DeviceInfo Device = llrm::GetDeviceInfo();
+
+	BenchScene Scene;
+	if (!CreateScene(Scene))
+	{
+		std::cerr << "Failed to create the benchmark scene" << std::endl;
+		return 2;
+	}
+
+	BenchRunner Runner(Options);
+	RunDrawBenchmarks(Runner, Scene);
+	RunUniformBenchmarks(Runner, Scene);
+	RunUploadBenchmarks(Runner);
+	RunReadbackBenchmarks(Runner, Scene);
+	RunCreationBenchmarks(Runner, Scene);
+	RunBarrierBenchmarks(Runner, Scene);
+	bool bFrameGraphAliased = RunFrameGraphBenchmarks(Runner, Scene);
+
+	DestroyScene(Scene);
+	llrm::DestroyContext(Context);
+
+	// Recording is expected to be allocation free in the steady state, except when capture or tracing keep a record of every call
+	bool bRecordingAllocated = false;
+#if !defined(LLRM_CAPTURE) && !defined(LLRM_TRACE)
+	for (const BenchResult& Result : Runner.GetResults())
+	{
+		if (Result.Name.starts_with("draw_") && Result.Name.ends_with("_record") && Result.AllocationsPerOp > 0.0)
+		{
+			std::cerr << Result.Name << " made " << Result.AllocationsPerOp << " heap allocations per draw" << std::endl;
+			bRecordingAllocated = true;
+		}
+	}
+#endif
+
+	if (Options.OutPath.empty())
+	{
+		WriteJson(std::cout, Options, Device, Runner.GetResults());
+	}
+	else
+	{
+		std::ofstream Out(Options.OutPath);
+		if (!Out.is_open())
+		{
+			std::cerr << "Failed to open " << Options.OutPath << std::endl;
+			return 1;
+		}
+
+		WriteJson(Out, Options, Device, Runner.GetResults());
+	}
+
+	if (!bFrameGraphAliased)
+		return 4;
+
+	return bRecordingAllocated ? 3 : 0;
+}
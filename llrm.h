@@ -2,6 +2,10 @@
 
 #include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <vector>
 
 struct GLFWwindow;
 
@@ -11,6 +15,33 @@ namespace llrm
 	const uint64_t TEXTURE_USAGE_SAMPLE = 1 << 2; // We will sample this texture in a shader
 	const uint64_t TEXTURE_USAGE_RT = 1 << 3; // Used as a render target (color, depth, etc.)
 	const uint64_t TEXTURE_USAGE_READ = 1 << 4; // We can read from this texture on the CPU, or we can transfer from this texture on the GPU
+	const uint64_t TEXTURE_USAGE_TRANSIENT = 1 << 5; // Contents only live within a render graph, so it can only be an attachment and may be lazily allocated
+	const uint64_t TEXTURE_USAGE_INPUT_ATTACHMENT = 1 << 6; // Read by a later pass of the same render graph as an input attachment
+	const uint64_t TEXTURE_USAGE_STORAGE = 1 << 7; // Read and written by shaders as a storage image
+
+	// Color components a pipeline writes to an attachment
+	const uint8_t COLOR_WRITE_R = 1 << 0;
+	const uint8_t COLOR_WRITE_G = 1 << 1;
+	const uint8_t COLOR_WRITE_B = 1 << 2;
+	const uint8_t COLOR_WRITE_A = 1 << 3;
+	const uint8_t COLOR_WRITE_ALL = COLOR_WRITE_R | COLOR_WRITE_G | COLOR_WRITE_B | COLOR_WRITE_A;
+
+	const uint64_t BUFFER_HOST_WRITE = 1 << 0; // Lives in host visible memory that stays mapped, uploads are plain copies instead of staged transfers. Without BUFFER_PER_FRAME an upload first waits for the frames in flight.
+	const uint64_t BUFFER_PER_FRAME = 1 << 1; // Host written with a slice per frame in flight, so a frame can be written while earlier ones still read theirs
+
+	// Pipeline stages a PipelineBarrier waits for and blocks
+	const uint32_t PIPELINE_STAGE_INDIRECT = 1 << 0; // Reading indirect dispatch and draw arguments
+	const uint32_t PIPELINE_STAGE_VERTEX_INPUT = 1 << 1; // Reading vertex and index buffers
+	const uint32_t PIPELINE_STAGE_VERTEX_SHADER = 1 << 2;
+	const uint32_t PIPELINE_STAGE_FRAGMENT_SHADER = 1 << 3;
+	const uint32_t PIPELINE_STAGE_COLOR_ATTACHMENT = 1 << 4;
+	const uint32_t PIPELINE_STAGE_COMPUTE_SHADER = 1 << 5;
+	const uint32_t PIPELINE_STAGE_TRANSFER = 1 << 6;
+
+	const uint32_t MIP_LEVELS_REMAINING = ~0u; // Refers to every mip level from the base mip level to the end of the chain
+	const uint32_t ARRAY_LAYERS_REMAINING = ~0u; // Refers to every array layer from the base array layer to the last layer
+	const uint64_t BUFFER_SIZE_REMAINING = ~0ull; // Refers to every byte from the offset to the end of the buffer
+	const float LOD_CLAMP_NONE = 1000.0f; // Don't clamp the maximum LOD of a sampler
 
 	// Rendering primitives
 	typedef void* Pipeline;
@@ -20,6 +51,9 @@ namespace llrm
 	typedef void* FrameBuffer;
 	typedef void* VertexBuffer;
 	typedef void* IndexBuffer;
+	typedef void* StorageBuffer;
+	typedef void* TexelBufferView;
+	typedef void* QueryPool;
 	typedef void* ShaderProgram;
 	typedef void* CommandBuffer;
 	typedef void* Fence;
@@ -28,6 +62,7 @@ namespace llrm
 	typedef void* Texture;
 	typedef void* TextureView;
 	typedef void* Sampler;
+	typedef void* DeviceMemory;
 
 	const uint32_t MAX_OUTPUT_COLORS = 8;
 
@@ -54,7 +89,31 @@ namespace llrm
 		R8_UINT,
 		RGBA16F_Float,
 		RGBA32F_Float,
-		D24_UNORM_S8_UINT
+		D24_UNORM_S8_UINT,
+
+		// Block compressed formats, these can only be sampled and uploaded to. Check Caps::CompressedFormats before use.
+		BC1_RGBA_UNORM,
+		BC1_RGBA_SRGB,
+		BC2_UNORM,
+		BC2_SRGB,
+		BC3_UNORM,
+		BC3_SRGB,
+		BC4_UNORM,
+		BC4_SNORM,
+		BC5_UNORM,
+		BC5_SNORM,
+		BC6H_UFLOAT,
+		BC6H_SFLOAT,
+		BC7_UNORM,
+		BC7_SRGB,
+		ETC2_R8G8B8_UNORM,
+		ETC2_R8G8B8_SRGB,
+		ETC2_R8G8B8A8_UNORM,
+		ETC2_R8G8B8A8_SRGB,
+		ASTC_4x4_UNORM,
+		ASTC_4x4_SRGB,
+		ASTC_8x8_UNORM,
+		ASTC_8x8_SRGB
 	};
 
 	enum class AttachmentUsage
@@ -66,16 +125,33 @@ namespace llrm
 		DepthStencilAttachment,
 		ShaderReadDepthStencil,
 		ShaderRead,
+		ShaderReadWrite, // Storage image access from shaders
 		Undefined
 	};
 
+	/*
+	 * Norm formats are integers that the vertex shader reads as floats, scaled to [-1, 1] when signed and [0, 1] when unsigned.
+	 * They're declared as float vectors in shaders, as are the half float formats.
+	 */
 	enum class VertexAttributeFormat
 	{
 		Float,
 		Float2,
 		Float3,
 		Float4,
-		Int32
+		Int32,
+		Half2,
+		Half4,
+		Byte2Norm,
+		Byte4Norm,
+		UByte2Norm,
+		UByte4Norm, // E.g. colors
+		Short2Norm,
+		Short4Norm,
+		UShort2Norm,
+		UShort4Norm,
+		UInt10_10_10_2Norm, // x, y and z in 10 bits each from the lowest bit, and w in the top 2 bits of a 32-bit integer
+		Int10_10_10_2Norm // Same layout, only usable when Caps::bPackedSNormVertexFormat is set
 	};
 
 	enum class BufferUsage
@@ -87,10 +163,19 @@ namespace llrm
 		Dynamic
 	};
 
+	enum class PresentMode
+	{
+		Fifo, // Waits for vertical blank, always supported
+		FifoRelaxed, // Waits for vertical blank unless a frame is late, which may tear
+		Mailbox, // Waits for vertical blank but replaces queued images with newer ones, lowest latency without tearing
+		Immediate // Doesn't wait for vertical blank, may tear
+	};
+
 	enum class ShaderStage
 	{
 		Vertex,
-		Fragment
+		Fragment,
+		Compute
 	};
 
 	struct VertexAttribute
@@ -123,11 +208,26 @@ namespace llrm
 		uint32_t Count = 1; // The amount of textures in this binding, in the case of arrays
 	};
 
+	// Used to describe storage buffer and storage image resources
+	struct StorageDescription
+	{
+		uint32_t Binding = 0;
+		llrm::ShaderStage StageUsedAt = llrm::ShaderStage::Compute;
+		uint32_t Count = 1;
+	};
+
 	struct ResourceLayoutCreateInfo
 	{
 		std::vector<ConstantBufferDescription> ConstantBuffers{};
 		std::vector<TextureSamplerDescription> Textures{};
 		std::vector<TextureSamplerDescription> Samplers{};
+		std::vector<TextureSamplerDescription> InputAttachments{}; // Render graph attachments written by a previous pass
+		std::vector<StorageDescription> StorageBuffers{};
+		std::vector<StorageDescription> StorageImages{}; // Texture views of TEXTURE_USAGE_STORAGE textures, accessed in the ShaderReadWrite usage
+		std::vector<StorageDescription> UniformTexelBuffers{}; // Formatted read only views of storage buffers, Buffer<T> in HLSL
+		std::vector<StorageDescription> StorageTexelBuffers{}; // Formatted read write views of storage buffers, RWBuffer<T> in HLSL
+		std::vector<StorageDescription> DynamicUniformBuffers{}; // Ranges of storage buffers read as uniform buffers, placed by the offsets given to BindResources
+		std::vector<StorageDescription> DynamicStorageBuffers{}; // Ranges of storage buffers placed by the offsets given to BindResources
 	};
 
 	enum class BlendOperation
@@ -162,6 +262,8 @@ namespace llrm
 
 		BlendOperation ColorOp = BlendOperation::Add;
 		BlendOperation AlphaOp = BlendOperation::Add;
+
+		uint8_t WriteMask = COLOR_WRITE_ALL; // Zero leaves the attachment untouched, e.g. for draws that only feed occlusion queries
 	};
 
 	enum class PipelineRenderPrimitive
@@ -191,12 +293,27 @@ namespace llrm
 	enum class CullMode
 	{
 		Front,
-		Back
+		Back,
+		None
+	};
+
+	enum class CompareOp
+	{
+		Never,
+		Less,
+		Equal,
+		LessOrEqual,
+		Greater,
+		NotEqual,
+		GreaterOrEqual,
+		Always
 	};
 
 	struct PipelineDepthStencilSettings
 	{
 		bool bEnableDepthTest = false;
+		bool bEnableDepthWrite = true; // Only applies when the depth test is enabled
+		CompareOp DepthCompare = CompareOp::Less; // A fragment passes when its depth compares true against the stored depth
 	};
 
 	struct PipelineState
@@ -220,6 +337,30 @@ namespace llrm
 
 		VertexWinding Winding = VertexWinding::CounterClockwise;
 		CullMode Cull = CullMode::Back;
+
+		// The formats of the attachments rendered to when CompatibleGraph is null, which creates the pipeline for dynamic rendering.
+		// A depth format is used for the depth stencil attachment, the remaining formats are the color attachments in order.
+		std::vector<AttachmentFormat> AttachmentFormats{};
+	};
+
+	struct ComputePipelineState
+	{
+		llrm::ShaderProgram Shader;
+
+		std::vector<ResourceLayout> Layouts;
+	};
+
+	enum class AttachmentLoadOp
+	{
+		Clear,
+		Load,
+		DontCare
+	};
+
+	enum class AttachmentStoreOp
+	{
+		Store,
+		DontCare
 	};
 
 	struct RenderGraphAttachmentDescription
@@ -227,20 +368,65 @@ namespace llrm
 		AttachmentUsage InitialUsage;
 		AttachmentUsage FinalUsage;
 		AttachmentFormat Format;
+
+		// What happens to the attachment's contents at the start and end of the render graph
+		AttachmentLoadOp LoadOp = AttachmentLoadOp::Clear;
+		AttachmentStoreOp StoreOp = AttachmentStoreOp::Store;
+		AttachmentLoadOp StencilLoadOp = AttachmentLoadOp::DontCare;
+		AttachmentStoreOp StencilStoreOp = AttachmentStoreOp::DontCare;
 	};
 
 	struct RenderPassInfo
 	{
 		std::vector<int32_t> OutputAttachments{};
+		std::vector<int32_t> InputAttachments{}; // Attachments written by an earlier pass that are read in this pass
 	};
 
 	// The depth stencil attachment is always at index ColorAttachmentCount since it's placed at the end
+	// Dependencies between passes are derived from the attachments each pass writes and reads.
 	struct RenderGraphCreateInfo
 	{
 		std::vector<RenderGraphAttachmentDescription> Attachments;
 		std::vector<RenderPassInfo> Passes;
+	};
+
+	struct TextureTransition
+	{
+		Texture Image;
+		AttachmentUsage Old;
+		AttachmentUsage New;
+		uint32_t BaseLayer = 0;
+		uint32_t LayerCount = ARRAY_LAYERS_REMAINING;
+		uint32_t BaseMip = 0;
+		uint32_t MipCount = MIP_LEVELS_REMAINING;
+
+		// The previous contents aren't needed. Old is then only used to wait for previous accesses, i.e. of another texture aliasing the same memory
+		bool bDiscard = false;
+	};
+
+	enum class BarrierBufferType : uint8_t
+	{
+		Vertex,
+		Index,
+		Storage
+	};
 
-		// TODO: Subpass dependencies?
+	// Makes the writes SrcStages made to a range of a buffer visible to DstStages, both PIPELINE_STAGE_* flags
+	struct BufferBarrier
+	{
+		void* Buffer; // A VertexBuffer, IndexBuffer or StorageBuffer depending on Type
+		BarrierBufferType Type;
+		uint32_t SrcStages;
+		uint32_t DstStages;
+		uint64_t Offset = 0;
+		uint64_t Size = BUFFER_SIZE_REMAINING;
+	};
+
+	struct MemoryRequirements
+	{
+		uint64_t Size = 0;
+		uint64_t Alignment = 0;
+		uint32_t MemoryTypeBits = 0;
 	};
 
 	struct FramebufferAttachmentDescription
@@ -299,6 +485,29 @@ namespace llrm
 		};
 	};
 
+	struct RenderingAttachment
+	{
+		TextureView View = nullptr;
+		AttachmentLoadOp LoadOp = AttachmentLoadOp::Clear;
+		AttachmentStoreOp StoreOp = AttachmentStoreOp::Store;
+		AttachmentLoadOp StencilLoadOp = AttachmentLoadOp::DontCare;
+		AttachmentStoreOp StencilStoreOp = AttachmentStoreOp::DontCare;
+		ClearValue Clear{};
+	};
+
+	/*
+	 * Attachments rendered to without a render graph or frame buffer, when Caps::bDynamicRendering is set.
+	 * Nothing is transitioned, so color attachments must be in the ColorAttachment usage and the depth stencil attachment
+	 * in the DepthStencilAttachment usage. Pipelines used with it are created with AttachmentFormats instead of a CompatibleGraph.
+	 */
+	struct RenderingInfo
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		std::vector<RenderingAttachment> ColorAttachments{};
+		RenderingAttachment DepthStencilAttachment{}; // Not used when View is null
+	};
+
 	struct RenderGraphInfo
 	{
 		uint32_t ClearValueCount = 1;
@@ -317,6 +526,28 @@ namespace llrm
 		WrapMode   UWrapMode = WrapMode::Clamp;
 		WrapMode   VWrapMode = WrapMode::Clamp;
 		WrapMode   WWrapMode = WrapMode::Clamp;
+
+		// Mip selection
+		FilterType MipFilter = FilterType::LINEAR;
+		float	   MipLodBias = 0.0f;
+		float	   MinLod = 0.0f;
+		float	   MaxLod = LOD_CLAMP_NONE;
+	};
+
+	struct CacheCounters
+	{
+		uint64_t Hits = 0; // Creations that returned an existing object
+		uint64_t Misses = 0; // Creations that created a new object
+		uint32_t Live = 0; // Distinct objects that are currently alive
+	};
+
+	struct CacheStats
+	{
+		CacheCounters Samplers;
+		CacheCounters ResourceLayouts;
+		CacheCounters RenderGraphs;
+		CacheCounters Pipelines;
+		CacheCounters ShaderModules; // Program stages with identical SPIR-V
 	};
 
 	struct Caps
@@ -324,6 +555,26 @@ namespace llrm
 		uint32_t MaxImageArrayLayers{};
 		uint32_t MaxTextureSize{};
 
+		// Whether TEXTURE_USAGE_TRANSIENT textures can be backed by lazily allocated memory (i.e. on tile based GPUs)
+		bool bLazilyAllocatedMemory{};
+
+		// Whether BeginRenderGraph can take attachments directly through a RenderingInfo
+		bool bDynamicRendering{};
+
+		// Whether BeginConditionalRendering skips draws on the GPU, otherwise it's a no-op and every draw executes
+		bool bConditionalRendering{};
+
+		// Compressed texture support
+		bool bTextureCompressionBC{};
+		bool bTextureCompressionETC2{};
+		bool bTextureCompressionASTC{};
+		std::vector<AttachmentFormat> CompressedFormats{}; // Every compressed format that can be sampled and uploaded to
+
+		// Whether VertexAttributeFormat::Int10_10_10_2Norm can be read from vertex buffers, every other vertex format always can
+		bool bPackedSNormVertexFormat{};
+
+		// Whether barriers are recorded with VK_KHR_synchronization2, which waits on and blocks the exact stages of each usage
+		bool bSynchronization2{};
 	};
 
 	inline bool IsDepthFormat(AttachmentFormat Format)
@@ -341,23 +592,187 @@ namespace llrm
 		return !IsDepthFormat(Format);
 	}
 
+	inline bool IsCompressedFormat(AttachmentFormat Format)
+	{
+		return Format >= AttachmentFormat::BC1_RGBA_UNORM && Format <= AttachmentFormat::ASTC_8x8_SRGB;
+	}
+
+	// The width and height of a block of texels in the format, which is 1x1 for uncompressed formats
+	inline void GetFormatBlockExtent(AttachmentFormat Format, uint32_t& OutBlockWidth, uint32_t& OutBlockHeight)
+	{
+		if (Format == AttachmentFormat::ASTC_8x8_UNORM || Format == AttachmentFormat::ASTC_8x8_SRGB)
+		{
+			OutBlockWidth = OutBlockHeight = 8;
+		}
+		else if (IsCompressedFormat(Format))
+		{
+			OutBlockWidth = OutBlockHeight = 4;
+		}
+		else
+		{
+			OutBlockWidth = OutBlockHeight = 1;
+		}
+	}
+
+	// The size of a single block in bytes, which is the size of a texel for uncompressed formats
+	inline uint32_t GetFormatBlockSizeBytes(AttachmentFormat Format)
+	{
+		switch (Format)
+		{
+		case AttachmentFormat::R8_UINT:
+			return 1;
+		case AttachmentFormat::RGBA16F_Float:
+			return 8;
+		case AttachmentFormat::RGBA32F_Float:
+			return 16;
+		case AttachmentFormat::BC1_RGBA_UNORM:
+		case AttachmentFormat::BC1_RGBA_SRGB:
+		case AttachmentFormat::BC4_UNORM:
+		case AttachmentFormat::BC4_SNORM:
+		case AttachmentFormat::ETC2_R8G8B8_UNORM:
+		case AttachmentFormat::ETC2_R8G8B8_SRGB:
+			return 8;
+		case AttachmentFormat::BC2_UNORM:
+		case AttachmentFormat::BC2_SRGB:
+		case AttachmentFormat::BC3_UNORM:
+		case AttachmentFormat::BC3_SRGB:
+		case AttachmentFormat::BC5_UNORM:
+		case AttachmentFormat::BC5_SNORM:
+		case AttachmentFormat::BC6H_UFLOAT:
+		case AttachmentFormat::BC6H_SFLOAT:
+		case AttachmentFormat::BC7_UNORM:
+		case AttachmentFormat::BC7_SRGB:
+		case AttachmentFormat::ETC2_R8G8B8A8_UNORM:
+		case AttachmentFormat::ETC2_R8G8B8A8_SRGB:
+		case AttachmentFormat::ASTC_4x4_UNORM:
+		case AttachmentFormat::ASTC_4x4_SRGB:
+		case AttachmentFormat::ASTC_8x8_UNORM:
+		case AttachmentFormat::ASTC_8x8_SRGB:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+
+	// Size in bytes of one tightly packed row of blocks
+	inline uint64_t CalcRowPitchBytes(AttachmentFormat Format, uint32_t Width)
+	{
+		uint32_t BlockWidth, BlockHeight;
+		GetFormatBlockExtent(Format, BlockWidth, BlockHeight);
+
+		return static_cast<uint64_t>((Width + BlockWidth - 1) / BlockWidth) * GetFormatBlockSizeBytes(Format);
+	}
+
+	// Size in bytes of a single tightly packed layer of a texture (or mip level) with the given dimensions
+	inline uint64_t CalcTextureSizeBytes(AttachmentFormat Format, uint32_t Width, uint32_t Height)
+	{
+		uint32_t BlockWidth, BlockHeight;
+		GetFormatBlockExtent(Format, BlockWidth, BlockHeight);
+
+		return CalcRowPitchBytes(Format, Width) * ((Height + BlockHeight - 1) / BlockHeight);
+	}
+
+	// Returns the number of mip levels in a full mip chain for a texture of the given size
+	inline uint32_t CalcMipLevels(uint32_t Width, uint32_t Height)
+	{
+		uint32_t Largest = Width > Height ? Width : Height;
+		uint32_t Levels = 1;
+		while (Largest > 1)
+		{
+			Largest >>= 1;
+			Levels++;
+		}
+
+		return Levels;
+	}
+
 	// An opaque pointer to a context type
 	typedef void* Context;
 
+	struct SwapChainFrame
+	{
+		GLFWwindow* Window = nullptr;
+		SwapChain Swap = nullptr; // Null for offscreen work, whose command buffers are only submitted
+		Surface Target = nullptr;
+
+		// Set by BeginFrames to the acquired swap chain image, or -1 when the window can't be rendered to this frame (e.g. it's minimized)
+		int32_t ImageIndex = -1;
+
+		// Recorded by the caller before EndFrames
+		std::vector<CommandBuffer> CommandBuffers;
+	};
+
+	enum class DeviceType
+	{
+		Discrete,
+		Integrated,
+		Virtual,
+		Cpu,
+		Other
+	};
+
+	struct DeviceScoreEntry
+	{
+		std::string Reason;
+		int32_t Points = 0;
+	};
+
+	// A device that was considered when creating the context
+	struct DeviceInfo
+	{
+		std::string Name;
+		uint32_t Index = 0; // Position in the driver's list of devices
+		uint8_t UUID[16]{};
+		uint32_t VendorId = 0;
+		uint32_t DeviceId = 0;
+		uint32_t ApiVersion = 0;
+		DeviceType Type = DeviceType::Other;
+		uint64_t DeviceLocalBytes = 0; // Size of the largest device local heap
+
+		bool bSuitable = false;
+		std::string Rejection; // Why the device can't be used, when it isn't suitable
+		int32_t Score = 0;
+		std::vector<DeviceScoreEntry> ScoreBreakdown;
+	};
+
+	struct ContextCreateInfo
+	{
+		// Don't use a window system. GLFW doesn't need to be initialized, surfaces and swap chains can't be created,
+		// and frames started with the parameterless BeginFrame render to textures instead.
+		bool bHeadless = false;
+
+		// How many frames the CPU can record ahead of the GPU. Resource sets keep a copy of their resources per frame in flight,
+		// so fewer frames lowers latency and memory use while more frames keeps the GPU busier.
+		uint32_t FramesInFlight = 3;
+
+		/*
+		 * Restricts the devices that can be picked. Either a device index, a UUID as 32 hex digits, a device type
+		 * (discrete, integrated, virtual or cpu) or part of a device name, e.g. "llvmpipe". Matching ignores case.
+		 * The LLRM_DEVICE environment variable takes precedence over this. Creating the context fails if no matching device is suitable.
+		 * Among the allowed devices, the one with the highest score is picked.
+		 */
+		std::string Device;
+	};
+
 	/*
-	 * Creates a new LLRM instance using the specified GLFW window handle.
+	 * Creates a new LLRM instance.
 	 *
-	 * TODO: In the future, allow passing in null here for offscreen rendering.
-	 *
-	 * LLRM currently relies on GLFW, but a future plan is to remove the tie to a particular windowing framework.
+	 * LLRM currently relies on GLFW unless it's headless, but a future plan is to remove the tie to a particular windowing framework.
 	 */
-	Context CreateContext();
+	Context CreateContext(const ContextCreateInfo& CreateInfo = {});
 	void DestroyContext(llrm::Context Context);
 	void SetContext(llrm::Context Context);
 
 	// Get capabilities
 	Caps GetCaps();
 
+	// The device the context picked, and every device it considered along with how each was scored
+	DeviceInfo GetDeviceInfo();
+	std::vector<DeviceInfo> GetDeviceCandidates();
+
+	// How often creating an object returned an existing one, for each kind of object that's shared
+	CacheStats GetCacheStats();
+
 	/*
 	 * Creates a surface for a particular window.
 	 *
@@ -365,46 +780,110 @@ namespace llrm
 	 */
 	Surface CreateSurface(GLFWwindow* Window);
 
-	template<VertexAttributeFormat Format>
-	uint32_t GetVertexFormatSizeBytes()
+	constexpr uint32_t GetVertexFormatSizeBytes(VertexAttributeFormat Format)
 	{
-		static constexpr bool Is4Bytes = Format == VertexAttributeFormat::Float || Format == VertexAttributeFormat::Int32;
-		static constexpr bool Is8Bytes = Format == VertexAttributeFormat::Float2;
-		static constexpr bool Is12Bytes = Format == VertexAttributeFormat::Float3;
-		static constexpr bool Is16Bytes = Format == VertexAttributeFormat::Float4;
-
-		static_assert(Is4Bytes || Is8Bytes || Is12Bytes || Is16Bytes);
-
-		if constexpr (Is4Bytes)
+		switch (Format)
+		{
+		case VertexAttributeFormat::Byte2Norm:
+		case VertexAttributeFormat::UByte2Norm:
+			return 2;
+		case VertexAttributeFormat::Float:
+		case VertexAttributeFormat::Int32:
+		case VertexAttributeFormat::Half2:
+		case VertexAttributeFormat::Byte4Norm:
+		case VertexAttributeFormat::UByte4Norm:
+		case VertexAttributeFormat::Short2Norm:
+		case VertexAttributeFormat::UShort2Norm:
+		case VertexAttributeFormat::UInt10_10_10_2Norm:
+		case VertexAttributeFormat::Int10_10_10_2Norm:
 			return 4;
-		else if constexpr (Is8Bytes)
+		case VertexAttributeFormat::Float2:
+		case VertexAttributeFormat::Half4:
+		case VertexAttributeFormat::Short4Norm:
+		case VertexAttributeFormat::UShort4Norm:
 			return 8;
-		else if constexpr (Is12Bytes)
+		case VertexAttributeFormat::Float3:
 			return 12;
-		else if constexpr (Is16Bytes)
+		case VertexAttributeFormat::Float4:
 			return 16;
-		else
-			return -1;
+		}
+
+		return 0;
 	}
 
+	template<VertexAttributeFormat Format>
+	uint32_t GetVertexFormatSizeBytes()
+	{
+		static_assert(GetVertexFormatSizeBytes(Format) > 0);
+
+		return GetVertexFormatSizeBytes(Format);
+	}
+
+	/*
+	 * Resources can be created, uploaded to and destroyed from any thread, e.g. by an asset loader running on a thread pool.
+	 * Each thread allocates command buffers and resource sets from its own pools, and queue submission is synchronized internally.
+	 * A command buffer must be recorded by the thread that created it, but it can be submitted and destroyed from any thread.
+	 */
+
 	// Create primitives
 	ShaderProgram CreateRasterProgram(const std::vector<uint32_t>& VertexShader, const std::vector<uint32_t>& FragmentShader);
-	SwapChain CreateSwapChain(Surface TargetSurface, int32_t DesiredWidth, int32_t DesiredHeight);
+	ShaderProgram CreateComputeProgram(const std::vector<uint32_t>& ComputeShader);
+
+	/*
+	 * Releases the program's reference to its shader modules, which pipelines don't need once they're created.
+	 * Pipelines can't be created from the program afterwards unless an identical pipeline is still alive, but the program still needs to be destroyed.
+	 */
+	void ReleaseShaderModules(ShaderProgram Shader);
+	SwapChain CreateSwapChain(Surface TargetSurface, int32_t DesiredWidth, int32_t DesiredHeight,
+		const std::vector<PresentMode>& PresentModes = { PresentMode::Mailbox, PresentMode::Fifo }); // In order of preference, falls back to Fifo
+	/*
+	 * Resource layouts, pipelines, render graphs and samplers are shared: creating one with the same description as a live object
+	 * returns that object. Every creation still needs its own destroy call, which releases one reference.
+	 */
 	ResourceLayout CreateResourceLayout(const ResourceLayoutCreateInfo& CreateInfo);
 	Pipeline CreatePipeline(const PipelineState& CreateInfo);
+	Pipeline CreateComputePipeline(const ComputePipelineState& CreateInfo);
 	RenderGraph CreateRenderGraph(const RenderGraphCreateInfo& CreateInfo);
 	FrameBuffer CreateFrameBuffer(const FrameBufferCreateInfo& CreateInfo);
 	VertexBuffer CreateVertexBuffer(uint64_t Size, const void* Data = nullptr);
 	IndexBuffer CreateIndexBuffer(uint64_t Size, const void* Data = nullptr);
+	StorageBuffer CreateStorageBuffer(uint64_t Size, const void* Data = nullptr, uint64_t BufferFlags = 0); // Can also hold the arguments of DispatchIndirect
+	TexelBufferView CreateTexelBufferView(StorageBuffer Buffer, AttachmentFormat Format, uint64_t Offset = 0, uint64_t Range = ~0ull); // Range defaults to the rest of the buffer
 	CommandBuffer CreateCommandBuffer(bool bOneTimeUse = false);
 	ResourceSet CreateResourceSet(const ResourceSetCreateInfo& CreateInfo);
-	Texture CreateTexture(AttachmentFormat Format, AttachmentUsage InitialUsage, uint32_t Width, uint32_t Height, uint64_t TextureFlags, uint32_t Layers, uint64_t ImageSize = 0, void* Data = nullptr);
-	TextureView CreateTextureView(Texture Image, uint8_t Flags, TextureViewType ViewType = TextureViewType::TYPE_2D, uint32_t BaseArrayLayer = 0, uint32_t LayerCount = 1);
+
+	/*
+	 * Creates a resource set that's only valid for the frame currently being recorded, e.g. for per-draw data that changes every frame.
+	 * Must be called between BeginFrame and EndFrame. Its descriptors and uniform buffers are sub-allocated from memory that's
+	 * reset once the frame has finished executing, so it doesn't need to be destroyed.
+	 */
+	ResourceSet CreateTransientResourceSet(const ResourceSetCreateInfo& CreateInfo);
+
+	/*
+	 * Creates a texture with the specified amount of mip levels. Passing zero for MipLevels allocates the full mip chain.
+	 *
+	 * If initial data is provided it's uploaded to the base mip level, and the remaining levels are generated from it on the GPU.
+	 * Compressed formats can't have their mips generated, so upload each level with WriteTexture instead.
+	 * An ImageSize of zero assumes tightly packed data for every layer.
+	 */
+	Texture CreateTexture(AttachmentFormat Format, AttachmentUsage InitialUsage, uint32_t Width, uint32_t Height, uint64_t TextureFlags, uint32_t Layers, uint64_t ImageSize = 0, void* Data = nullptr, uint32_t MipLevels = 1);
+	TextureView CreateTextureView(Texture Image, uint8_t Flags, TextureViewType ViewType = TextureViewType::TYPE_2D, uint32_t BaseArrayLayer = 0, uint32_t LayerCount = 1, uint32_t BaseMip = 0, uint32_t MipCount = MIP_LEVELS_REMAINING);
 	Sampler CreateSampler(const SamplerCreateInfo& CreateInfo);
 
+	/*
+	 * Device memory that several textures can be placed in. Textures that alias the same memory mustn't be used at the same time,
+	 * and a texture's contents are undefined after another texture in the same memory was used, so its first use must discard them.
+	 */
+	MemoryRequirements GetTextureMemoryRequirements(AttachmentFormat Format, uint32_t Width, uint32_t Height, uint64_t TextureFlags, uint32_t Layers = 1);
+	DeviceMemory AllocateDeviceMemory(const MemoryRequirements& Requirements);
+	Texture CreateAliasedTexture(AttachmentFormat Format, uint32_t Width, uint32_t Height, uint64_t TextureFlags, uint32_t Layers, DeviceMemory Memory, uint64_t Offset);
+	void FreeDeviceMemory(DeviceMemory Memory);
+
 	// Destroy primitives
 	void DestroyVertexBuffer(VertexBuffer VertexBuffer);
 	void DestroyIndexBuffer(IndexBuffer IndexBuffer);
+	void DestroyStorageBuffer(StorageBuffer StorageBuffer);
+	void DestroyTexelBufferView(TexelBufferView View);
 	void DestroyRenderGraph(RenderGraph Graph);
 	void DestroyPipeline(Pipeline Pipeline);
 	void DestroyResourceLayout(ResourceLayout Layout);
@@ -418,56 +897,237 @@ namespace llrm
 	void DestroySurface(Surface Surface);
 	void DestroyCommandBuffer(CommandBuffer CmdBuffer);
 
-	// Swap chain operations
+	// Swap chain operations. BeginFrame returns -1 when the window can't be rendered to (e.g. it's minimized), the frame isn't begun then and must not be ended.
 	int32_t BeginFrame(GLFWwindow* Window, SwapChain Swap, Surface Target);
+	int32_t BeginFrame(); // Starts an offscreen frame and returns its frame in flight index
 	void EndFrame(const std::vector<CommandBuffer> &Buffers);
+
+	/*
+	 * Renders several windows in the same frame. BeginFrames acquires an image from every swap chain, and EndFrames submits
+	 * all of the command buffers with one submission and presents every image with one present.
+	 * When no frame has an ImageIndex of at least zero afterwards, nothing was begun and EndFrames must not be called.
+	 */
+	void BeginFrames(std::vector<SwapChainFrame>& Frames);
+	void EndFrames(const std::vector<SwapChainFrame>& Frames);
     void RecreateSwapChain(SwapChain Swap, Surface Target, int32_t DesiredWidth, int32_t DesiredHeight);
 	void SubmitSwapCommandBuffer(SwapChain Target, CommandBuffer Buffer);
 	void GetSwapChainSize(SwapChain Swap, uint32_t& Width, uint32_t& Height);
 	uint32_t GetSwapChainImageCount(SwapChain Swap);
+	PresentMode GetSwapChainPresentMode(SwapChain Swap); // The mode that was selected from the preferences
+	uint32_t GetFramesInFlight();
 	Texture GetSwapChainImage(SwapChain Swap, uint32_t Index);
 	TextureView GetSwapChainImageView(SwapChain Swap, uint32_t Index);
 
 	// Vertex buffer operations
 	void UploadVertexBufferData(VertexBuffer Buffer, const void* Data, uint64_t Size);
 	void UploadIndexBufferData(IndexBuffer Buffer, const uint32_t* Data, uint64_t Size);
+	void UploadStorageBufferData(StorageBuffer Buffer, const void* Data, uint64_t Size);
+
+	/*
+	 * Returns the persistently mapped memory of a BUFFER_HOST_WRITE buffer, which is coherent and never needs to be unmapped.
+	 * Buffers with BUFFER_PER_FRAME return the slice of the current frame, and UploadStorageBufferData follows the same rules
+	 * as resource set updates: inside a frame only the current slice is written, outside of one every slice is.
+	 * Writes through the returned pointer aren't synchronized, so without BUFFER_PER_FRAME they race with frames still in flight.
+	 */
+	void* MapStorageBuffer(StorageBuffer Buffer);
 	void ResizeVertexBuffer(VertexBuffer Buffer, uint64_t NewSize);
 	void ResizeIndexBuffer(IndexBuffer Buffer, uint64_t NewSize);
 
 	// Frame buffer operations
 	void GetFrameBufferSize(FrameBuffer Fbo, uint32_t& Width, uint32_t& Height) ;
 
-	// Resource set operations
+	/*
+	 * Resource sets have a copy per frame in flight. Inside a frame only the current frame's copy is updated, outside of one
+	 * (or for uniform buffers that aren't Dynamic) every copy is, so resources that never change can be set once before rendering.
+	 */
 	void UpdateUniformBuffer(ResourceSet Resources, uint32_t BufferIndex, void* Data, uint64_t DataSize, bool Dynamic = true);
 	void UpdateTextureResource(ResourceSet Resources, std::vector<TextureView> Images, uint32_t Binding) ;
 	void UpdateSamplerResource(ResourceSet Resources, Sampler Samp, uint32_t Binding);
+	void UpdateInputAttachmentResource(ResourceSet Resources, TextureView Attachment, uint32_t Binding);
+	void UpdateStorageBufferResource(ResourceSet Resources, StorageBuffer Buffer, uint32_t Binding);
+	void UpdateStorageImageResource(ResourceSet Resources, TextureView Image, uint32_t Binding);
+	void UpdateTexelBufferResource(ResourceSet Resources, TexelBufferView View, uint32_t Binding); // Either a uniform or storage texel buffer binding
+	void UpdateDynamicBufferResource(ResourceSet Resources, StorageBuffer Buffer, uint32_t Binding, uint64_t Range); // Range is the size visible at each bound offset
 
 	void ReadTexture(Texture Tex, void* Dst, uint64_t BufferSize, AttachmentUsage PreviousUsage);
+
+	/*
+	 * Width and Height are the dimensions of the mip level being written. An ImageSize of zero assumes tightly packed data.
+	 *
+	 * RowPitch is the distance in bytes between rows of texels (rows of blocks for compressed formats), zero means tightly packed.
+	 * It has to be a whole number of texels (or blocks) and at least a packed row long, otherwise nothing is written.
+	 */
 	void WriteTexture(Texture Tex, 
 		AttachmentUsage PreviousUsage, AttachmentUsage FinalUsage, 
 		uint32_t Width, uint32_t Height, 
 		uint32_t Layer, 
-		uint64_t ImageSize = 0, void* Data = nullptr
+		uint64_t ImageSize = 0, void* Data = nullptr,
+		uint32_t MipLevel = 0,
+		uint32_t RowPitch = 0
 	);
 
 	AttachmentFormat GetTextureFormat(Texture Tex);
+	uint32_t GetTextureMipLevels(Texture Tex);
 
 	// Command buffer operations
 	void SubmitCommandBuffer(CommandBuffer Buffer, bool bWait = false, Fence WaitFence = nullptr);
 	void Reset(CommandBuffer Buf);
 	void Begin(CommandBuffer Buf);
 	void End(CommandBuffer Buf);
-	void TransitionTexture(CommandBuffer Buf, Texture Image, AttachmentUsage Old, AttachmentUsage New, uint32_t BaseLayer = 0, uint32_t LayerCount = 1);
-	void BeginRenderGraph(CommandBuffer Buf, RenderGraph Graph, FrameBuffer Target, std::vector<ClearValue> ClearValues = {});
+	void TransitionTexture(CommandBuffer Buf, Texture Image, AttachmentUsage Old, AttachmentUsage New, uint32_t BaseLayer = 0, uint32_t LayerCount = 1, uint32_t BaseMip = 0, uint32_t MipCount = MIP_LEVELS_REMAINING);
+	void TransitionTextures(CommandBuffer Buf, std::span<const TextureTransition> Transitions); // Same as PipelineBarrier without buffer barriers
+
+	/*
+	 * Fills in mip levels 1..N of a texture by successively blitting each level into the next. Every layer is processed.
+	 *
+	 * The base level must be in PreviousUsage, and the whole mip chain will be in FinalUsage afterwards.
+	 * Compressed textures are only transitioned since they can't be blitted into.
+	 */
+	void GenerateMips(CommandBuffer Buf, Texture Tex, AttachmentUsage PreviousUsage, AttachmentUsage FinalUsage);
+	void BeginRenderGraph(CommandBuffer Buf, RenderGraph Graph, FrameBuffer Target, std::span<const ClearValue> ClearValues);
+	void BeginRenderGraph(CommandBuffer Buf, const RenderingInfo& Info); // Renders to a single pass without a render graph, see RenderingInfo
 	void EndRenderGraph(CommandBuffer Buf);
+	void NextPass(CommandBuffer Buf); // Advances to the next pass of the render graph that's currently being recorded
 	void BindPipeline(CommandBuffer Buf, Pipeline PipelineObject);
-	void BindResources(CommandBuffer Buf, std::vector<ResourceSet> Resources);
+	void BindResources(CommandBuffer Buf, std::span<const ResourceSet> Resources);
+	void BindResources(CommandBuffer Buf, std::span<const ResourceSet> Resources, std::span<const uint32_t> DynamicOffsets); // One offset per dynamic binding, in set then binding order
 	void DrawVertexBuffer(CommandBuffer Buf, VertexBuffer Vbo, uint32_t VertexCount) ;
 	void DrawVertexBufferIndexed(CommandBuffer Buf, VertexBuffer Vbo, IndexBuffer Ibo, uint32_t IndexCount) ;
 	void SetViewport(CommandBuffer Buf, uint32_t X, uint32_t Y, uint32_t W, uint32_t H);
 	void SetScissor(CommandBuffer Buf, uint32_t X, uint32_t Y, uint32_t W, uint32_t H);
 
-	inline void ImmediateSubmit(std::function<void(CommandBuffer)> InFunc, Fence WaitFence = nullptr, bool bWait = false)
+	// Compute work is recorded outside of render graphs, after binding a compute pipeline
+	void Dispatch(CommandBuffer Buf, uint32_t GroupsX, uint32_t GroupsY, uint32_t GroupsZ);
+	void DispatchIndirect(CommandBuffer Buf, StorageBuffer Arguments, uint64_t Offset = 0); // Reads three uint32_t group counts at Offset
+
+	/*
+	 * Makes the writes of SrcStages (PIPELINE_STAGE_* flags) visible to DstStages, e.g. a compute shader writing a storage buffer
+	 * that a vertex shader or an indirect dispatch reads afterwards. Textures that change usage still need a transition.
+	 */
+	void PipelineBarrier(CommandBuffer Buf, uint32_t SrcStages, uint32_t DstStages);
+
+	/*
+	 * Records every texture transition and buffer barrier with a single pipeline barrier, e.g. all of the G-buffer targets at once.
+	 * Transitions between the same read-only usage are dropped since there's nothing to wait for, and nothing is recorded when
+	 * everything was dropped. Transitions between the same writable usage are kept, they wait for the previous writes.
+	 */
+	void PipelineBarrier(CommandBuffer Buf, std::span<const TextureTransition> Transitions, std::span<const BufferBarrier> Buffers = {});
+
+	/*
+	 * Occlusion queries count the samples that pass the depth test between BeginQuery and EndQuery.
+	 *
+	 * A pool has Count queries for every frame in flight, and query indices always refer to the current frame's queries.
+	 * Each frame, ResetQueries is recorded before the first query and ResolveQueries after the last one, both outside of a render graph.
+	 * Resolving copies the results into memory that's read without ever waiting on the GPU:
+	 * - GetQueryResult returns the result resolved the last time the current frame in flight was recorded, i.e. GetFramesInFlight() frames ago.
+	 *   It must be called between BeginFrame and EndFrame, since only then has the GPU finished with the current frame's results.
+	 * - BeginConditionalRendering skips the draws recorded until EndConditionalRendering when the previous frame's result was zero.
+	 * Queries that haven't been resolved yet, or weren't issued in the frame they're read from, count as visible.
+	 */
+	QueryPool CreateOcclusionQueryPool(uint32_t Count);
+	void DestroyQueryPool(QueryPool Pool);
+	void ResetQueries(CommandBuffer Buf, QueryPool Pool);
+	void BeginQuery(CommandBuffer Buf, QueryPool Pool, uint32_t Query);
+	void EndQuery(CommandBuffer Buf, QueryPool Pool, uint32_t Query);
+	void ResolveQueries(CommandBuffer Buf, QueryPool Pool);
+	uint64_t GetQueryResult(QueryPool Pool, uint32_t Query);
+	void BeginConditionalRendering(CommandBuffer Buf, QueryPool Pool, uint32_t Query);
+	void EndConditionalRendering(CommandBuffer Buf);
+
+	// The kind of object SetObjectName names, since every handle is opaque
+	enum class DebugObjectType
+	{
+		Texture,
+		TextureView,
+		Sampler,
+		VertexBuffer,
+		IndexBuffer,
+		StorageBuffer,
+		Pipeline,
+		RenderGraph,
+		FrameBuffer,
+		CommandBuffer,
+		ResourceSet
+	};
+
+	/*
+	 * Names objects and labels regions of command buffers for graphics debuggers and profilers such as RenderDoc.
+	 * Only built with LLRM_DEBUG_LABELS, otherwise these are empty inline functions. Cached objects share one name between every creator.
+	 */
+#ifdef LLRM_DEBUG_LABELS
+	void SetObjectName(DebugObjectType Type, void* Object, const char* Name);
+	void BeginLabel(CommandBuffer Buf, const char* Name, float R = 1.0f, float G = 1.0f, float B = 1.0f);
+	void EndLabel(CommandBuffer Buf);
+#else
+	inline void SetObjectName(DebugObjectType Type, void* Object, const char* Name) {}
+	inline void BeginLabel(CommandBuffer Buf, const char* Name, float R = 1.0f, float G = 1.0f, float B = 1.0f) {}
+	inline void EndLabel(CommandBuffer Buf) {}
+#endif
+
+	// Labels the commands recorded until the end of the enclosing scope, see LLRM_SCOPED_LABEL
+	struct ScopedLabel
+	{
+		ScopedLabel(CommandBuffer InBuf, const char* Name) : Buf(InBuf) { BeginLabel(Buf, Name); }
+		~ScopedLabel() { EndLabel(Buf); }
+
+		ScopedLabel(const ScopedLabel&) = delete;
+		ScopedLabel& operator=(const ScopedLabel&) = delete;
+
+		CommandBuffer Buf;
+	};
+
+	/*
+	 * Braced lists are kept on the stack instead of being copied into a vector, e.g. BindResources(Buf, { SceneSet, ObjectSet }).
+	 * Vectors and arrays convert to the span overloads directly.
+	 */
+	inline void BeginRenderGraph(CommandBuffer Buf, RenderGraph Graph, FrameBuffer Target, std::initializer_list<ClearValue> ClearValues = {})
+	{
+		BeginRenderGraph(Buf, Graph, Target, std::span<const ClearValue>(ClearValues.begin(), ClearValues.size()));
+	}
+
+	inline void BindResources(CommandBuffer Buf, std::initializer_list<ResourceSet> Resources)
+	{
+		BindResources(Buf, std::span<const ResourceSet>(Resources.begin(), Resources.size()));
+	}
+
+	inline void BindResources(CommandBuffer Buf, std::initializer_list<ResourceSet> Resources, std::initializer_list<uint32_t> DynamicOffsets)
+	{
+		BindResources(Buf, std::span<const ResourceSet>(Resources.begin(), Resources.size()), std::span<const uint32_t>(DynamicOffsets.begin(), DynamicOffsets.size()));
+	}
+
+	inline void BindResources(CommandBuffer Buf, std::span<const ResourceSet> Resources, std::initializer_list<uint32_t> DynamicOffsets)
+	{
+		BindResources(Buf, Resources, std::span<const uint32_t>(DynamicOffsets.begin(), DynamicOffsets.size()));
+	}
+
+	inline void BindResources(CommandBuffer Buf, std::initializer_list<ResourceSet> Resources, std::span<const uint32_t> DynamicOffsets)
+	{
+		BindResources(Buf, std::span<const ResourceSet>(Resources.begin(), Resources.size()), DynamicOffsets);
+	}
+
+	inline void TransitionTextures(CommandBuffer Buf, std::initializer_list<TextureTransition> Transitions)
+	{
+		TransitionTextures(Buf, std::span<const TextureTransition>(Transitions.begin(), Transitions.size()));
+	}
+
+	inline void PipelineBarrier(CommandBuffer Buf, std::initializer_list<TextureTransition> Transitions, std::initializer_list<BufferBarrier> Buffers = {})
+	{
+		PipelineBarrier(Buf, std::span<const TextureTransition>(Transitions.begin(), Transitions.size()), std::span<const BufferBarrier>(Buffers.begin(), Buffers.size()));
+	}
+
+	inline void PipelineBarrier(CommandBuffer Buf, std::span<const TextureTransition> Transitions, std::initializer_list<BufferBarrier> Buffers)
+	{
+		PipelineBarrier(Buf, Transitions, std::span<const BufferBarrier>(Buffers.begin(), Buffers.size()));
+	}
+
+	inline void PipelineBarrier(CommandBuffer Buf, std::initializer_list<TextureTransition> Transitions, std::span<const BufferBarrier> Buffers)
+	{
+		PipelineBarrier(Buf, std::span<const TextureTransition>(Transitions.begin(), Transitions.size()), Buffers);
+	}
+
+	// Takes any callable, so a lambda isn't wrapped in a std::function
+	template<typename Func>
+	void ImmediateSubmit(Func&& InFunc, Fence WaitFence = nullptr, bool bWait = false)
 	{
 		CommandBuffer NewCmd = CreateCommandBuffer(true);
 
@@ -481,8 +1141,18 @@ namespace llrm
 		DestroyCommandBuffer(NewCmd);
 	}
 
-	inline void ImmediateSubmitAndWait(std::function<void(CommandBuffer)> InFunc, Fence WaitFence = nullptr)
+	template<typename Func>
+	void ImmediateSubmitAndWait(Func&& InFunc, Fence WaitFence = nullptr)
 	{
-		ImmediateSubmit(InFunc, WaitFence, true);
+		ImmediateSubmit(std::forward<Func>(InFunc), WaitFence, true);
 	}
-};
\ No newline at end of file
+};
+
+// Labels the rest of the enclosing scope, and compiles to nothing without LLRM_DEBUG_LABELS
+#ifdef LLRM_DEBUG_LABELS
+	#define LLRM_LABEL_CONCAT_INNER(A, B) A##B
+	#define LLRM_LABEL_CONCAT(A, B) LLRM_LABEL_CONCAT_INNER(A, B)
+	#define LLRM_SCOPED_LABEL(Buf, Name) ::llrm::ScopedLabel LLRM_LABEL_CONCAT(LLRMScopedLabel, __LINE__)(Buf, Name)
+#else
+	#define LLRM_SCOPED_LABEL(Buf, Name)
+#endif
@@ -0,0 +1,1594 @@
+#include "llrm_capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace llrm
+{
+	const char CAPTURE_MAGIC[8] = { 'L', 'L', 'R', 'M', 'C', 'A', 'P', '\0' };
+	const uint32_t CAPTURE_VERSION = 3;
+
+	// Every record starts with its op and the size of the payload that follows
+	const uint64_t CAPTURE_RECORD_HEADER_SIZE = sizeof(uint16_t) + sizeof(uint32_t);
+
+	// Arguments made of other arguments are recorded field by field, the same lists are used for writing and reading them
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, ResourceLayoutCreateInfo& Info)
+	{
+		Ar(Info.ConstantBuffers, Info.Textures, Info.Samplers, Info.InputAttachments, Info.StorageBuffers, Info.StorageImages,
+			Info.UniformTexelBuffers, Info.StorageTexelBuffers, Info.DynamicUniformBuffers, Info.DynamicStorageBuffers);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, PipelineState& State)
+	{
+		Ar(State.Shader, State.CompatibleGraph, State.Layouts, State.VertexBufferStride, State.VertexAttributes, State.Primitive,
+			State.BlendSettings, State.DepthStencil, State.PassIndex, State.Winding, State.Cull, State.AttachmentFormats);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, ComputePipelineState& State)
+	{
+		Ar(State.Shader, State.Layouts);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, RenderGraphAttachmentDescription& Attachment)
+	{
+		Ar(Attachment.InitialUsage, Attachment.FinalUsage, Attachment.Format, Attachment.LoadOp, Attachment.StoreOp, Attachment.StencilLoadOp, Attachment.StencilStoreOp);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, RenderPassInfo& Pass)
+	{
+		Ar(Pass.OutputAttachments, Pass.InputAttachments);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, RenderGraphCreateInfo& Info)
+	{
+		Ar(Info.Attachments, Info.Passes);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, FrameBufferCreateInfo& Info)
+	{
+		Ar(Info.Width, Info.Height, Info.Attachments, Info.Target);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, ResourceSetCreateInfo& Info)
+	{
+		Ar(Info.Layout);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, TextureTransition& Transition)
+	{
+		Ar(Transition.Image, Transition.Old, Transition.New, Transition.BaseLayer, Transition.LayerCount, Transition.BaseMip, Transition.MipCount, Transition.bDiscard);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, BufferBarrier& Barrier)
+	{
+		Ar(Barrier.Buffer, Barrier.Type, Barrier.SrcStages, Barrier.DstStages, Barrier.Offset, Barrier.Size);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, RenderingAttachment& Attachment)
+	{
+		Ar(Attachment.View, Attachment.LoadOp, Attachment.StoreOp, Attachment.StencilLoadOp, Attachment.StencilStoreOp, Attachment.Clear);
+	}
+
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, RenderingInfo& Info)
+	{
+		Ar(Info.Width, Info.Height, Info.ColorAttachments, Info.DepthStencilAttachment);
+	}
+
+	// Windows and surfaces only exist in the captured application
+	template<typename Archive>
+	void CaptureFields(Archive& Ar, SwapChainFrame& Frame)
+	{
+		Ar(Frame.Swap, Frame.ImageIndex, Frame.CommandBuffers);
+	}
+
+	struct CaptureData
+	{
+		const uint8_t* Data;
+		uint64_t Size;
+	};
+
+	struct CaptureString
+	{
+		std::string Value;
+		bool bNull = false;
+
+		const char* Get() const { return bNull ? nullptr : Value.c_str(); }
+	};
+
+	struct CaptureReader
+	{
+		const uint8_t* Data;
+		const uint8_t* End;
+		const std::vector<void*>& Objects;
+
+		bool bMissing = false; // A handle referred to an object that doesn't exist in the replay
+		bool bOverrun = false;
+
+		void Bytes(void* Dst, uint64_t Size)
+		{
+			if (bOverrun || Size > static_cast<uint64_t>(End - Data))
+			{
+				bOverrun = true;
+				memset(Dst, 0, Size);
+				return;
+			}
+
+			memcpy(Dst, Data, Size);
+			Data += Size;
+		}
+
+		void Read(CaptureData& Blob)
+		{
+			uint8_t bPresent = 0;
+			Read(bPresent);
+			Read(Blob.Size);
+
+			Blob.Data = nullptr;
+			if (!bPresent)
+				return;
+
+			if (bOverrun || Blob.Size > static_cast<uint64_t>(End - Data))
+			{
+				bOverrun = true;
+				Blob.Size = 0;
+				return;
+			}
+
+			Blob.Data = Data;
+			Data += Blob.Size;
+		}
+
+		void Read(CaptureString& String)
+		{
+			uint32_t Length = 0;
+			Read(Length);
+
+			String.bNull = Length == ~0u;
+			if (String.bNull || bOverrun || Length > static_cast<uint64_t>(End - Data))
+			{
+				bOverrun = bOverrun || !String.bNull;
+				return;
+			}
+
+			String.Value.assign(reinterpret_cast<const char*>(Data), Length);
+			Data += Length;
+		}
+
+		template<typename T>
+		void Read(T& Value)
+		{
+			if constexpr (std::is_same_v<T, void*>)
+			{
+				uint32_t Id = 0;
+				Read(Id);
+
+				Value = Id < Objects.size() ? Objects[Id] : nullptr;
+				if (Id != 0 && !Value)
+					bMissing = true;
+			}
+			else if constexpr (std::is_same_v<T, AttachmentUsage>)
+			{
+				// Replayed swap chain images are plain textures, which can't be presented
+				Bytes(&Value, sizeof(T));
+				if (Value == AttachmentUsage::Presentation)
+					Value = AttachmentUsage::TransferSource;
+			}
+			else if constexpr (bCaptureRaw<T>)
+				Bytes(&Value, sizeof(T));
+			else
+				CaptureFields(*this, Value);
+		}
+
+		template<typename T>
+		void Read(std::vector<T>& Values)
+		{
+			uint32_t Count = 0;
+			Read(Count);
+
+			// Every element takes at least a byte, which guards against allocating for a corrupt count
+			if (Count > static_cast<uint64_t>(End - Data))
+			{
+				bOverrun = true;
+				return;
+			}
+
+			Values.resize(Count);
+			for (T& Value : Values)
+				Read(Value);
+		}
+
+		template<typename A, typename B>
+		void Read(std::pair<A, B>& Pair)
+		{
+			Read(Pair.first);
+			Read(Pair.second);
+		}
+
+		template<typename... T>
+		void operator()(T&... Values)
+		{
+			(Read(Values), ...);
+		}
+	};
+
+	// Swap chains are replayed as textures of the size and format of the captured swap chain images
+	struct ReplaySwapChain
+	{
+		struct Image
+		{
+			Texture Tex = nullptr;
+			TextureView View = nullptr;
+			uint32_t Width = 0;
+			uint32_t Height = 0;
+			AttachmentFormat Format{};
+		};
+
+		std::vector<Image> Images;
+	};
+
+	struct ReplayState
+	{
+		std::vector<void*> Objects; // Indexed by the ids of the capture, null for objects that failed or were destroyed
+		std::vector<CaptureOp> CreateOps; // The op that created each object, which decides how it's destroyed
+		std::vector<uint32_t> Creations; // Creations of each object that weren't destroyed yet, shared objects are returned by several
+		ReplayStats* Stats = nullptr;
+	};
+
+	ReplaySwapChain::Image& GetReplaySwapImage(ReplaySwapChain* Swap, uint32_t Index, uint32_t Width, uint32_t Height, AttachmentFormat Format)
+	{
+		if (Index >= Swap->Images.size())
+			Swap->Images.resize(Index + 1);
+
+		// The captured swap chain was recreated with a different size
+		ReplaySwapChain::Image& Image = Swap->Images[Index];
+		if (Image.Tex && (Image.Width != Width || Image.Height != Height || Image.Format != Format))
+		{
+			DestroyTextureView(Image.View);
+			DestroyTexture(Image.Tex);
+			Image = {};
+		}
+
+		if (!Image.Tex)
+		{
+			Image.Tex = CreateTexture(Format, AttachmentUsage::TransferSource, Width, Height, TEXTURE_USAGE_RT | TEXTURE_USAGE_SAMPLE | TEXTURE_USAGE_READ, 1);
+			Image.View = CreateTextureView(Image.Tex, COLOR_ASPECT);
+			Image.Width = Width;
+			Image.Height = Height;
+			Image.Format = Format;
+		}
+
+		return Image;
+	}
+
+	void DestroyReplaySwapChain(ReplaySwapChain* Swap)
+	{
+		for (ReplaySwapChain::Image& Image : Swap->Images)
+		{
+			if (Image.Tex)
+			{
+				DestroyTextureView(Image.View);
+				DestroyTexture(Image.Tex);
+			}
+		}
+
+		delete Swap;
+	}
+
+	// Destroys one creation of an object. Surfaces, transient resource sets and swap chain images aren't owned by the replay.
+	void DestroyReplayCreation(CaptureOp CreateOp, void* Object)
+	{
+		switch (CreateOp)
+		{
+		case CaptureOp::CreateRasterProgram:
+		case CaptureOp::CreateComputeProgram: DestroyProgram(Object); break;
+		case CaptureOp::CreateSwapChain: DestroyReplaySwapChain(static_cast<ReplaySwapChain*>(Object)); break;
+		case CaptureOp::CreateResourceLayout: DestroyResourceLayout(Object); break;
+		case CaptureOp::CreatePipeline:
+		case CaptureOp::CreateComputePipeline: DestroyPipeline(Object); break;
+		case CaptureOp::CreateRenderGraph: DestroyRenderGraph(Object); break;
+		case CaptureOp::CreateFrameBuffer: DestroyFrameBuffer(Object); break;
+		case CaptureOp::CreateVertexBuffer: DestroyVertexBuffer(Object); break;
+		case CaptureOp::CreateIndexBuffer: DestroyIndexBuffer(Object); break;
+		case CaptureOp::CreateStorageBuffer: DestroyStorageBuffer(Object); break;
+		case CaptureOp::CreateTexelBufferView: DestroyTexelBufferView(Object); break;
+		case CaptureOp::CreateCommandBuffer: DestroyCommandBuffer(Object); break;
+		case CaptureOp::CreateResourceSet: DestroyResourceSet(Object); break;
+		case CaptureOp::CreateTexture:
+		case CaptureOp::CreateAliasedTexture: DestroyTexture(Object); break;
+		case CaptureOp::CreateTextureView: DestroyTextureView(Object); break;
+		case CaptureOp::CreateSampler: DestroySampler(Object); break;
+		case CaptureOp::AllocateDeviceMemory: FreeDeviceMemory(Object); break;
+		case CaptureOp::CreateOcclusionQueryPool: DestroyQueryPool(Object); break;
+		default: break;
+		}
+	}
+
+	// Destroys one creation of the object, it's no longer referred to once every creation was destroyed
+	void ReleaseReplayObject(ReplayState& State, uint32_t Id)
+	{
+		if (State.Creations[Id] > 0)
+		{
+			DestroyReplayCreation(State.CreateOps[Id], State.Objects[Id]);
+			State.Creations[Id]--;
+		}
+
+		if (State.Creations[Id] == 0)
+			State.Objects[Id] = nullptr;
+	}
+
+	void SetReplayObject(ReplayState& State, uint32_t Id, void* Object, CaptureOp CreateOp)
+	{
+		if (Id >= State.Objects.size())
+		{
+			State.Objects.resize(Id + 1);
+			State.CreateOps.resize(Id + 1);
+			State.Creations.resize(Id + 1);
+		}
+
+		// The id is created again by the next loop over the frames, the object from the previous loop isn't referred to anymore
+		while (State.Objects[Id] && State.Objects[Id] != Object)
+			ReleaseReplayObject(State, Id);
+
+		State.Objects[Id] = Object;
+		State.CreateOps[Id] = CreateOp;
+		if (Object)
+			State.Creations[Id]++;
+	}
+
+	std::vector<CommandBuffer> GetReplayFrameBuffers(const std::vector<SwapChainFrame>& Frames)
+	{
+		std::vector<CommandBuffer> Buffers;
+		for (const SwapChainFrame& Frame : Frames)
+		{
+			if (Frame.ImageIndex < 0)
+				continue;
+
+			for (CommandBuffer Buffer : Frame.CommandBuffers)
+			{
+				if (Buffer)
+					Buffers.push_back(Buffer);
+			}
+		}
+
+		return Buffers;
+	}
+
+	// Replays one record, returns false when the record is malformed
+	bool ReplayRecord(ReplayState& State, CaptureOp Op, CaptureReader& Ar)
+	{
+		// Creations are only replayed when every object they refer to exists, and record the created object under the captured id
+		uint32_t ResultId = 0;
+		auto Create = [&](auto&& CreateFunc)
+		{
+			Ar(ResultId);
+			if (Ar.bOverrun)
+				return;
+
+			SetReplayObject(State, ResultId, Ar.bMissing ? nullptr : CreateFunc(), Op);
+		};
+
+		// Other calls are skipped when an object they refer to doesn't exist
+		auto Call = [&](auto&& CallFunc)
+		{
+			if (!Ar.bOverrun && !Ar.bMissing)
+				CallFunc();
+		};
+
+		switch (Op)
+		{
+		case CaptureOp::FramesBegin:
+			break;
+
+		case CaptureOp::CreateRasterProgram:
+		{
+			std::vector<uint32_t> Vertex, Fragment;
+			Ar(Vertex, Fragment);
+			Create([&]() { return CreateRasterProgram(Vertex, Fragment); });
+			break;
+		}
+		case CaptureOp::CreateComputeProgram:
+		{
+			std::vector<uint32_t> Compute;
+			Ar(Compute);
+			Create([&]() { return CreateComputeProgram(Compute); });
+			break;
+		}
+		case CaptureOp::CreateSurface:
+		{
+			// Surfaces are only passed back to swap chain functions, which don't use them in a replay
+			static char ReplaySurface;
+			Create([&]() -> void* { return &ReplaySurface; });
+			break;
+		}
+		case CaptureOp::CreateSwapChain:
+		{
+			Surface Target;
+			int32_t Width, Height;
+			std::vector<PresentMode> PresentModes;
+			Ar(Target, Width, Height, PresentModes);
+			Create([&]() -> void*
+			{
+				return new ReplaySwapChain;
+			});
+			break;
+		}
+		case CaptureOp::CreateResourceLayout:
+		{
+			ResourceLayoutCreateInfo Info;
+			Ar(Info);
+			Create([&]() { return CreateResourceLayout(Info); });
+			break;
+		}
+		case CaptureOp::CreatePipeline:
+		{
+			PipelineState Info;
+			Ar(Info);
+			Create([&]() { return CreatePipeline(Info); });
+			break;
+		}
+		case CaptureOp::CreateComputePipeline:
+		{
+			ComputePipelineState Info;
+			Ar(Info);
+			Create([&]() { return CreateComputePipeline(Info); });
+			break;
+		}
+		case CaptureOp::CreateRenderGraph:
+		{
+			RenderGraphCreateInfo Info;
+			Ar(Info);
+			Create([&]() { return CreateRenderGraph(Info); });
+			break;
+		}
+		case CaptureOp::CreateFrameBuffer:
+		{
+			FrameBufferCreateInfo Info;
+			Ar(Info);
+			Create([&]() { return CreateFrameBuffer(Info); });
+			break;
+		}
+		case CaptureOp::CreateVertexBuffer:
+		{
+			uint64_t Size;
+			CaptureData Data;
+			Ar(Size, Data);
+			Create([&]() { return CreateVertexBuffer(Size, Data.Data); });
+			break;
+		}
+		case CaptureOp::CreateIndexBuffer:
+		{
+			uint64_t Size;
+			CaptureData Data;
+			Ar(Size, Data);
+			Create([&]() { return CreateIndexBuffer(Size, Data.Data); });
+			break;
+		}
+		case CaptureOp::CreateStorageBuffer:
+		{
+			uint64_t Size, Flags;
+			CaptureData Data;
+			Ar(Size, Data, Flags);
+			Create([&]() { return CreateStorageBuffer(Size, Data.Data, Flags); });
+			break;
+		}
+		case CaptureOp::CreateTexelBufferView:
+		{
+			StorageBuffer Buffer;
+			AttachmentFormat Format;
+			uint64_t Offset, Range;
+			Ar(Buffer, Format, Offset, Range);
+			Create([&]() { return CreateTexelBufferView(Buffer, Format, Offset, Range); });
+			break;
+		}
+		case CaptureOp::CreateCommandBuffer:
+		{
+			bool bOneTimeUse;
+			Ar(bOneTimeUse);
+			Create([&]() { return CreateCommandBuffer(bOneTimeUse); });
+			break;
+		}
+		case CaptureOp::CreateResourceSet:
+		{
+			ResourceSetCreateInfo Info;
+			Ar(Info);
+			Create([&]() { return CreateResourceSet(Info); });
+			break;
+		}
+		case CaptureOp::CreateTransientResourceSet:
+		{
+			ResourceSetCreateInfo Info;
+			Ar(Info);
+			Create([&]() { return CreateTransientResourceSet(Info); });
+			break;
+		}
+		case CaptureOp::CreateTexture:
+		{
+			AttachmentFormat Format;
+			AttachmentUsage InitialUsage;
+			uint32_t Width, Height, Layers, MipLevels;
+			uint64_t Flags;
+			CaptureData Data;
+			Ar(Format, InitialUsage, Width, Height, Flags, Layers, Data, MipLevels);
+			Create([&]() { return CreateTexture(Format, InitialUsage, Width, Height, Flags, Layers, Data.Size, const_cast<uint8_t*>(Data.Data), MipLevels); });
+			break;
+		}
+		case CaptureOp::CreateTextureView:
+		{
+			Texture Image;
+			uint8_t Flags;
+			TextureViewType ViewType;
+			uint32_t BaseArrayLayer, LayerCount, BaseMip, MipCount;
+			Ar(Image, Flags, ViewType, BaseArrayLayer, LayerCount, BaseMip, MipCount);
+			Create([&]() { return CreateTextureView(Image, Flags, ViewType, BaseArrayLayer, LayerCount, BaseMip, MipCount); });
+			break;
+		}
+		case CaptureOp::CreateSampler:
+		{
+			SamplerCreateInfo Info;
+			Ar(Info);
+			Create([&]() { return CreateSampler(Info); });
+			break;
+		}
+		case CaptureOp::AllocateDeviceMemory:
+		{
+			MemoryRequirements Requirements;
+			Ar(Requirements);
+			Create([&]() { return AllocateDeviceMemory(Requirements); });
+			break;
+		}
+		case CaptureOp::CreateAliasedTexture:
+		{
+			AttachmentFormat Format;
+			uint32_t Width, Height, Layers;
+			uint64_t Flags, Offset;
+			DeviceMemory Memory;
+			Ar(Format, Width, Height, Flags, Layers, Memory, Offset);
+			Create([&]() { return CreateAliasedTexture(Format, Width, Height, Flags, Layers, Memory, Offset); });
+			break;
+		}
+		case CaptureOp::CreateOcclusionQueryPool:
+		{
+			uint32_t Count;
+			Ar(Count);
+			Create([&]() { return CreateOcclusionQueryPool(Count); });
+			break;
+		}
+		case CaptureOp::GetSwapChainImage:
+		case CaptureOp::GetSwapChainImageView:
+		{
+			SwapChain Swap;
+			uint32_t Index, Width, Height;
+			AttachmentFormat Format;
+			Ar(Swap, Index, Width, Height, Format);
+			Create([&]() -> void*
+			{
+				ReplaySwapChain::Image& Image = GetReplaySwapImage(static_cast<ReplaySwapChain*>(Swap), Index, Width, Height, Format);
+				return Op == CaptureOp::GetSwapChainImage ? Image.Tex : Image.View;
+			});
+			break;
+		}
+
+		case CaptureOp::DestroyVertexBuffer:
+		case CaptureOp::DestroyIndexBuffer:
+		case CaptureOp::DestroyStorageBuffer:
+		case CaptureOp::DestroyTexelBufferView:
+		case CaptureOp::DestroyRenderGraph:
+		case CaptureOp::DestroyPipeline:
+		case CaptureOp::DestroyResourceLayout:
+		case CaptureOp::DestroyResourceSet:
+		case CaptureOp::DestroyTexture:
+		case CaptureOp::DestroyTextureView:
+		case CaptureOp::DestroySampler:
+		case CaptureOp::DestroyFrameBuffer:
+		case CaptureOp::DestroyProgram:
+		case CaptureOp::DestroySwapChain:
+		case CaptureOp::DestroySurface:
+		case CaptureOp::DestroyCommandBuffer:
+		case CaptureOp::FreeDeviceMemory:
+		case CaptureOp::DestroyQueryPool:
+		{
+			uint32_t Id;
+			Ar(Id);
+			if (Id >= State.Objects.size() || !State.Objects[Id])
+			{
+				Ar.bMissing = true;
+				break;
+			}
+
+			// Shared objects are alive until every creation was destroyed, the replay's own creations keep them alive just the same
+			ReleaseReplayObject(State, Id);
+			break;
+		}
+
+		case CaptureOp::ReleaseShaderModules:
+		{
+			ShaderProgram Shader;
+			Ar(Shader);
+			Call([&]() { ReleaseShaderModules(Shader); });
+			break;
+		}
+		case CaptureOp::UploadVertexBufferData:
+		{
+			VertexBuffer Buffer;
+			CaptureData Data;
+			Ar(Buffer, Data);
+			Call([&]() { UploadVertexBufferData(Buffer, Data.Data, Data.Size); });
+			break;
+		}
+		case CaptureOp::UploadIndexBufferData:
+		{
+			IndexBuffer Buffer;
+			CaptureData Data;
+			Ar(Buffer, Data);
+			Call([&]() { UploadIndexBufferData(Buffer, reinterpret_cast<const uint32_t*>(Data.Data), Data.Size); });
+			break;
+		}
+		case CaptureOp::UploadStorageBufferData:
+		{
+			StorageBuffer Buffer;
+			CaptureData Data;
+			Ar(Buffer, Data);
+			Call([&]() { UploadStorageBufferData(Buffer, Data.Data, Data.Size); });
+			break;
+		}
+		case CaptureOp::MapStorageBuffer:
+			break;
+		case CaptureOp::ResizeVertexBuffer:
+		{
+			VertexBuffer Buffer;
+			uint64_t NewSize;
+			Ar(Buffer, NewSize);
+			Call([&]() { ResizeVertexBuffer(Buffer, NewSize); });
+			break;
+		}
+		case CaptureOp::ResizeIndexBuffer:
+		{
+			IndexBuffer Buffer;
+			uint64_t NewSize;
+			Ar(Buffer, NewSize);
+			Call([&]() { ResizeIndexBuffer(Buffer, NewSize); });
+			break;
+		}
+		case CaptureOp::UpdateUniformBuffer:
+		{
+			ResourceSet Resources;
+			uint32_t BufferIndex;
+			bool bDynamic;
+			CaptureData Data;
+			Ar(Resources, BufferIndex, bDynamic, Data);
+			Call([&]() { UpdateUniformBuffer(Resources, BufferIndex, const_cast<uint8_t*>(Data.Data), Data.Size, bDynamic); });
+			break;
+		}
+		case CaptureOp::UpdateTextureResource:
+		{
+			ResourceSet Resources;
+			uint32_t Binding;
+			std::vector<TextureView> Images;
+			Ar(Resources, Binding, Images);
+			Call([&]() { UpdateTextureResource(Resources, Images, Binding); });
+			break;
+		}
+		case CaptureOp::UpdateSamplerResource:
+		case CaptureOp::UpdateInputAttachmentResource:
+		case CaptureOp::UpdateStorageBufferResource:
+		case CaptureOp::UpdateStorageImageResource:
+		case CaptureOp::UpdateTexelBufferResource:
+		{
+			ResourceSet Resources;
+			uint32_t Binding;
+			void* Resource;
+			Ar(Resources, Binding, Resource);
+			Call([&]()
+			{
+				switch (Op)
+				{
+				case CaptureOp::UpdateSamplerResource: UpdateSamplerResource(Resources, Resource, Binding); break;
+				case CaptureOp::UpdateInputAttachmentResource: UpdateInputAttachmentResource(Resources, Resource, Binding); break;
+				case CaptureOp::UpdateStorageBufferResource: UpdateStorageBufferResource(Resources, Resource, Binding); break;
+				case CaptureOp::UpdateStorageImageResource: UpdateStorageImageResource(Resources, Resource, Binding); break;
+				default: UpdateTexelBufferResource(Resources, Resource, Binding); break;
+				}
+			});
+			break;
+		}
+		case CaptureOp::UpdateDynamicBufferResource:
+		{
+			ResourceSet Resources;
+			uint32_t Binding;
+			StorageBuffer Buffer;
+			uint64_t Range;
+			Ar(Resources, Binding, Buffer, Range);
+			Call([&]() { UpdateDynamicBufferResource(Resources, Buffer, Binding, Range); });
+			break;
+		}
+		case CaptureOp::WriteTexture:
+		{
+			Texture Tex;
+			uint32_t Layer, MipLevel, Width, Height, RowPitch;
+			AttachmentUsage PreviousUsage, FinalUsage;
+			CaptureData Data;
+			Ar(Tex, Layer, MipLevel, PreviousUsage, FinalUsage, Width, Height, RowPitch, Data);
+			Call([&]() { WriteTexture(Tex, PreviousUsage, FinalUsage, Width, Height, Layer, Data.Size, const_cast<uint8_t*>(Data.Data), MipLevel, RowPitch); });
+			break;
+		}
+		case CaptureOp::SetObjectName:
+		{
+			void* Object;
+			DebugObjectType Type;
+			CaptureString Name;
+			Ar(Object, Type, Name);
+			Call([&]() { SetObjectName(Type, Object, Name.Get()); });
+			break;
+		}
+
+		case CaptureOp::Reset:
+		case CaptureOp::Begin:
+		case CaptureOp::End:
+		case CaptureOp::EndRenderGraph:
+		case CaptureOp::NextPass:
+		case CaptureOp::EndConditionalRendering:
+		case CaptureOp::EndLabel:
+		{
+			CommandBuffer Buf;
+			Ar(Buf);
+			Call([&]()
+			{
+				switch (Op)
+				{
+				case CaptureOp::Reset: Reset(Buf); break;
+				case CaptureOp::Begin: Begin(Buf); break;
+				case CaptureOp::End: End(Buf); break;
+				case CaptureOp::EndRenderGraph: EndRenderGraph(Buf); break;
+				case CaptureOp::NextPass: NextPass(Buf); break;
+				case CaptureOp::EndConditionalRendering: EndConditionalRendering(Buf); break;
+				default: EndLabel(Buf); break;
+				}
+			});
+			break;
+		}
+		case CaptureOp::TransitionTexture:
+		{
+			CommandBuffer Buf;
+			Texture Image;
+			AttachmentUsage Old, New;
+			uint32_t BaseLayer, LayerCount, BaseMip, MipCount;
+			Ar(Buf, Image, Old, New, BaseLayer, LayerCount, BaseMip, MipCount);
+			Call([&]() { TransitionTexture(Buf, Image, Old, New, BaseLayer, LayerCount, BaseMip, MipCount); });
+			break;
+		}
+		case CaptureOp::TransitionTextures:
+		{
+			CommandBuffer Buf;
+			std::vector<TextureTransition> Transitions;
+			Ar(Buf, Transitions);
+			Call([&]() { TransitionTextures(Buf, Transitions); });
+			break;
+		}
+		case CaptureOp::GenerateMips:
+		{
+			CommandBuffer Buf;
+			Texture Tex;
+			AttachmentUsage PreviousUsage, FinalUsage;
+			Ar(Buf, Tex, PreviousUsage, FinalUsage);
+			Call([&]() { GenerateMips(Buf, Tex, PreviousUsage, FinalUsage); });
+			break;
+		}
+		case CaptureOp::BeginRenderGraph:
+		{
+			CommandBuffer Buf;
+			RenderGraph Graph;
+			FrameBuffer Target;
+			std::vector<ClearValue> ClearValues;
+			Ar(Buf, Graph, Target, ClearValues);
+			Call([&]() { BeginRenderGraph(Buf, Graph, Target, ClearValues); });
+			break;
+		}
+		case CaptureOp::BeginRendering:
+		{
+			CommandBuffer Buf;
+			RenderingInfo Info;
+			Ar(Buf, Info);
+			Call([&]() { BeginRenderGraph(Buf, Info); });
+			break;
+		}
+		case CaptureOp::BindPipeline:
+		{
+			CommandBuffer Buf;
+			Pipeline PipelineObject;
+			Ar(Buf, PipelineObject);
+			Call([&]() { BindPipeline(Buf, PipelineObject); });
+			break;
+		}
+		case CaptureOp::BindResources:
+		{
+			CommandBuffer Buf;
+			std::vector<ResourceSet> Resources;
+			Ar(Buf, Resources);
+			Call([&]() { BindResources(Buf, Resources); });
+			break;
+		}
+		case CaptureOp::BindResourcesDynamic:
+		{
+			CommandBuffer Buf;
+			std::vector<ResourceSet> Resources;
+			std::vector<uint32_t> DynamicOffsets;
+			Ar(Buf, Resources, DynamicOffsets);
+			Call([&]() { BindResources(Buf, Resources, DynamicOffsets); });
+			break;
+		}
+		case CaptureOp::DrawVertexBuffer:
+		{
+			CommandBuffer Buf;
+			VertexBuffer Vbo;
+			uint32_t VertexCount;
+			Ar(Buf, Vbo, VertexCount);
+			Call([&]() { DrawVertexBuffer(Buf, Vbo, VertexCount); });
+			break;
+		}
+		case CaptureOp::DrawVertexBufferIndexed:
+		{
+			CommandBuffer Buf;
+			VertexBuffer Vbo;
+			IndexBuffer Ibo;
+			uint32_t IndexCount;
+			Ar(Buf, Vbo, Ibo, IndexCount);
+			Call([&]() { DrawVertexBufferIndexed(Buf, Vbo, Ibo, IndexCount); });
+			break;
+		}
+		case CaptureOp::SetViewport:
+		case CaptureOp::SetScissor:
+		{
+			CommandBuffer Buf;
+			uint32_t X, Y, W, H;
+			Ar(Buf, X, Y, W, H);
+			Call([&]()
+			{
+				if (Op == CaptureOp::SetViewport)
+					SetViewport(Buf, X, Y, W, H);
+				else
+					SetScissor(Buf, X, Y, W, H);
+			});
+			break;
+		}
+		case CaptureOp::Dispatch:
+		{
+			CommandBuffer Buf;
+			uint32_t GroupsX, GroupsY, GroupsZ;
+			Ar(Buf, GroupsX, GroupsY, GroupsZ);
+			Call([&]() { Dispatch(Buf, GroupsX, GroupsY, GroupsZ); });
+			break;
+		}
+		case CaptureOp::DispatchIndirect:
+		{
+			CommandBuffer Buf;
+			StorageBuffer Arguments;
+			uint64_t Offset;
+			Ar(Buf, Arguments, Offset);
+			Call([&]() { DispatchIndirect(Buf, Arguments, Offset); });
+			break;
+		}
+		case CaptureOp::PipelineBarrier:
+		{
+			CommandBuffer Buf;
+			uint32_t SrcStages, DstStages;
+			Ar(Buf, SrcStages, DstStages);
+			Call([&]() { PipelineBarrier(Buf, SrcStages, DstStages); });
+			break;
+		}
+		case CaptureOp::PipelineBarrierBatch:
+		{
+			CommandBuffer Buf;
+			std::vector<TextureTransition> Transitions;
+			std::vector<BufferBarrier> Buffers;
+			Ar(Buf, Transitions, Buffers);
+			Call([&]() { PipelineBarrier(Buf, Transitions, Buffers); });
+			break;
+		}
+		case CaptureOp::ResetQueries:
+		case CaptureOp::ResolveQueries:
+		{
+			CommandBuffer Buf;
+			QueryPool Pool;
+			Ar(Buf, Pool);
+			Call([&]()
+			{
+				if (Op == CaptureOp::ResetQueries)
+					ResetQueries(Buf, Pool);
+				else
+					ResolveQueries(Buf, Pool);
+			});
+			break;
+		}
+		case CaptureOp::BeginQuery:
+		case CaptureOp::EndQuery:
+		case CaptureOp::BeginConditionalRendering:
+		{
+			CommandBuffer Buf;
+			QueryPool Pool;
+			uint32_t Query;
+			Ar(Buf, Pool, Query);
+			Call([&]()
+			{
+				if (Op == CaptureOp::BeginQuery)
+					BeginQuery(Buf, Pool, Query);
+				else if (Op == CaptureOp::EndQuery)
+					EndQuery(Buf, Pool, Query);
+				else
+					BeginConditionalRendering(Buf, Pool, Query);
+			});
+			break;
+		}
+		case CaptureOp::BeginLabel:
+		{
+			CommandBuffer Buf;
+			CaptureString Name;
+			float R, G, B;
+			Ar(Buf, Name, R, G, B);
+			Call([&]() { BeginLabel(Buf, Name.Get(), R, G, B); });
+			break;
+		}
+
+		case CaptureOp::BeginFrame:
+		case CaptureOp::BeginFrameOffscreen:
+		case CaptureOp::BeginFrames:
+		{
+			// Every frame is offscreen in a replay
+			BeginFrame();
+			break;
+		}
+		case CaptureOp::EndFrame:
+		{
+			std::vector<CommandBuffer> Buffers;
+			Ar(Buffers);
+			Buffers.erase(std::remove(Buffers.begin(), Buffers.end(), nullptr), Buffers.end());
+			Ar.bMissing = false;
+
+			EndFrame(Buffers);
+			State.Stats->Frames++;
+			break;
+		}
+		case CaptureOp::EndFrames:
+		{
+			std::vector<SwapChainFrame> Frames;
+			Ar(Frames);
+			Ar.bMissing = false;
+
+			EndFrame(GetReplayFrameBuffers(Frames));
+			State.Stats->Frames++;
+			break;
+		}
+		case CaptureOp::RecreateSwapChain:
+			// Replayed swap chain images are resized when they're next retrieved
+			break;
+		case CaptureOp::SubmitCommandBuffer:
+		{
+			CommandBuffer Buffer;
+			bool bWait;
+			Ar(Buffer, bWait);
+			Call([&]() { SubmitCommandBuffer(Buffer, bWait); });
+			break;
+		}
+
+		default:
+			return false;
+		}
+
+		return !Ar.bOverrun;
+	}
+
+	// Replays every record in [Data, End), stopping after the record with the op StopOp
+	bool ReplayRecords(ReplayState& State, const uint8_t*& Data, const uint8_t* End, CaptureOp StopOp)
+	{
+		while (Data < End)
+		{
+			if (static_cast<uint64_t>(End - Data) < CAPTURE_RECORD_HEADER_SIZE)
+				return false;
+
+			uint16_t Op;
+			uint32_t Size;
+			memcpy(&Op, Data, sizeof(Op));
+			memcpy(&Size, Data + sizeof(Op), sizeof(Size));
+			Data += CAPTURE_RECORD_HEADER_SIZE;
+
+			if (Op >= static_cast<uint16_t>(CaptureOp::Count) || Size > static_cast<uint64_t>(End - Data))
+				return false;
+
+			CaptureReader Reader{ Data, Data + Size, State.Objects };
+			if (!ReplayRecord(State, static_cast<CaptureOp>(Op), Reader))
+			{
+				//GLog->error("Malformed capture record");
+				return false;
+			}
+
+			if (Reader.bMissing)
+				State.Stats->SkippedCalls++;
+			else
+				State.Stats->Calls++;
+
+			Data += Size;
+
+			if (static_cast<CaptureOp>(Op) == StopOp)
+				break;
+		}
+
+		return true;
+	}
+
+	bool ReplayCapture(const char* Path, uint32_t Loops, ReplayStats& OutStats)
+	{
+		OutStats = {};
+
+		FILE* File = fopen(Path, "rb");
+		if (!File)
+		{
+			//GLog->error("Failed to open capture {}", Path);
+			return false;
+		}
+
+		std::vector<uint8_t> Contents;
+		uint8_t Chunk[64 * 1024];
+		while (size_t Read = fread(Chunk, 1, sizeof(Chunk), File))
+			Contents.insert(Contents.end(), Chunk, Chunk + Read);
+		fclose(File);
+
+		uint32_t Version = 0;
+		if (Contents.size() < sizeof(CAPTURE_MAGIC) + sizeof(Version) || memcmp(Contents.data(), CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0)
+		{
+			//GLog->error("{} isn't an llrm capture", Path);
+			return false;
+		}
+
+		memcpy(&Version, Contents.data() + sizeof(CAPTURE_MAGIC), sizeof(Version));
+		if (Version != CAPTURE_VERSION)
+		{
+			//GLog->error("Capture version {} isn't supported", Version);
+			return false;
+		}
+
+		ReplayState State;
+		State.Stats = &OutStats;
+		// Id zero is null
+		State.Objects.resize(1);
+		State.CreateOps.resize(1);
+		State.Creations.resize(1);
+
+		const uint8_t* Data = Contents.data() + sizeof(CAPTURE_MAGIC) + sizeof(Version);
+		const uint8_t* End = Contents.data() + Contents.size();
+
+		using Clock = std::chrono::steady_clock;
+
+		Clock::time_point SnapshotStart = Clock::now();
+		bool bSuccess = ReplayRecords(State, Data, End, CaptureOp::FramesBegin);
+		OutStats.SnapshotMs = std::chrono::duration<double, std::milli>(Clock::now() - SnapshotStart).count();
+
+		const uint8_t* FramesStart = Data;
+
+		Clock::time_point FramesBegin = Clock::now();
+		for (uint32_t Loop = 0; bSuccess && Loop < Loops; Loop++)
+		{
+			Data = FramesStart;
+			bSuccess = ReplayRecords(State, Data, End, CaptureOp::Count);
+		}
+		OutStats.FramesMs = std::chrono::duration<double, std::milli>(Clock::now() - FramesBegin).count();
+
+		// Objects are destroyed before the objects they were created from, which have lower ids
+		for (uint32_t Id = static_cast<uint32_t>(State.Objects.size()); Id-- > 0;)
+		{
+			while (State.Objects[Id])
+				ReleaseReplayObject(State, Id);
+		}
+
+		return bSuccess;
+	}
+}
+
+#ifdef LLRM_CAPTURE
+
+namespace llrm
+{
+	enum class CaptureOpKind
+	{
+		Marker,
+		Create,
+		Destroy,
+		State,
+		Map,
+		Command,
+		Frame
+	};
+
+	CaptureOpKind GetCaptureOpKind(CaptureOp Op)
+	{
+		if (Op == CaptureOp::FramesBegin)
+			return CaptureOpKind::Marker;
+		if (Op <= CaptureOp::GetSwapChainImageView)
+			return CaptureOpKind::Create;
+		if (Op <= CaptureOp::DestroyQueryPool)
+			return CaptureOpKind::Destroy;
+		if (Op == CaptureOp::MapStorageBuffer)
+			return CaptureOpKind::Map;
+		if (Op <= CaptureOp::SetObjectName)
+			return CaptureOpKind::State;
+		if (Op <= CaptureOp::EndLabel)
+			return CaptureOpKind::Command;
+
+		return CaptureOpKind::Frame;
+	}
+
+	// State updates that only replace part of an object's state are told apart by the bytes that follow the object's id
+	uint32_t GetCaptureStateKeySize(CaptureOp Op)
+	{
+		if (Op >= CaptureOp::UpdateUniformBuffer && Op <= CaptureOp::UpdateDynamicBufferResource)
+			return sizeof(uint32_t); // The binding or buffer index
+		if (Op == CaptureOp::WriteTexture)
+			return 2 * sizeof(uint32_t); // The layer and mip level
+
+		return 0;
+	}
+
+	struct CaptureState
+	{
+		CaptureOp Op;
+		uint64_t Key;
+		std::vector<uint8_t> Record;
+	};
+
+	struct CaptureObject
+	{
+		const void* Object = nullptr;
+		std::vector<uint8_t> Create; // The record that created the object
+		std::vector<uint32_t> References; // Objects its creation refers to
+
+		uint32_t Refs = 1; // Creations that returned this object, since some objects are shared
+		uint32_t Referenced = 0; // Tracked objects whose creation refers to this one
+		bool bTransient = false;
+
+		// Destroyed objects are kept while objects created from them are tracked, since the snapshot has to create those
+		bool bDestroyed = false;
+		CaptureOp DestroyOp{};
+
+		std::vector<CaptureState> States;
+		std::vector<uint8_t> Recording; // Commands recorded since the command buffer was last begun or reset
+
+		const void* Mapped = nullptr; // Last pointer returned by MapStorageBuffer
+		uint64_t MappedSize = 0;
+	};
+
+	struct CaptureContext
+	{
+		std::mutex Mutex;
+
+		std::unordered_map<const void*, uint32_t> Ids;
+		std::map<uint32_t, CaptureObject> Objects; // Ordered by id, which is the order objects were created in
+		uint32_t NextId = 1;
+
+		FILE* File = nullptr;
+		std::string PendingPath;
+		uint32_t FramesLeft = 0;
+	};
+
+	CaptureContext& GetCaptureContext()
+	{
+		static CaptureContext Context;
+		return Context;
+	}
+
+	std::mutex& GetCaptureMutex()
+	{
+		return GetCaptureContext().Mutex;
+	}
+
+	uint32_t& GetCaptureDepth()
+	{
+		thread_local uint32_t Depth = 0;
+		return Depth;
+	}
+
+	std::vector<uint8_t>& GetCapturePayload()
+	{
+		thread_local std::vector<uint8_t> Payload;
+		return Payload;
+	}
+
+	std::vector<uint32_t>& GetCaptureReferences()
+	{
+		thread_local std::vector<uint32_t> References;
+		return References;
+	}
+
+	void CaptureWriter::Bytes(const void* Data, uint64_t Size)
+	{
+		const uint8_t* Begin = static_cast<const uint8_t*>(Data);
+		Out.insert(Out.end(), Begin, Begin + Size);
+	}
+
+	void CaptureWriter::Handle(const void* Object)
+	{
+		uint32_t Id = 0;
+		if (Object)
+		{
+			CaptureContext& Context = GetCaptureContext();
+
+			// Objects that aren't tracked can't be replayed, e.g. ones created before the context
+			auto Found = Context.Ids.find(Object);
+			Id = Found != Context.Ids.end() ? Found->second : ~0u;
+
+			if (Found != Context.Ids.end())
+				References.push_back(Id);
+		}
+
+		Write(Id);
+	}
+
+	void CaptureWriter::Write(const char* String)
+	{
+		uint32_t Length = String ? static_cast<uint32_t>(strlen(String)) : ~0u;
+		Write(Length);
+		if (String)
+			Bytes(String, Length);
+	}
+
+	void CaptureWriter::Write(const CaptureBlob& Blob)
+	{
+		Write(static_cast<uint8_t>(Blob.Data != nullptr));
+		Write(Blob.Size);
+		if (Blob.Data)
+			Bytes(Blob.Data, Blob.Size);
+	}
+
+	void CaptureWriter::Write(const SwapChainFrame& Frame) { CaptureFields(*this, const_cast<SwapChainFrame&>(Frame)); }
+	void CaptureWriter::Write(const ResourceLayoutCreateInfo& Info) { CaptureFields(*this, const_cast<ResourceLayoutCreateInfo&>(Info)); }
+	void CaptureWriter::Write(const PipelineState& State) { CaptureFields(*this, const_cast<PipelineState&>(State)); }
+	void CaptureWriter::Write(const ComputePipelineState& State) { CaptureFields(*this, const_cast<ComputePipelineState&>(State)); }
+	void CaptureWriter::Write(const RenderGraphAttachmentDescription& Attachment) { CaptureFields(*this, const_cast<RenderGraphAttachmentDescription&>(Attachment)); }
+	void CaptureWriter::Write(const RenderPassInfo& Pass) { CaptureFields(*this, const_cast<RenderPassInfo&>(Pass)); }
+	void CaptureWriter::Write(const RenderGraphCreateInfo& Info) { CaptureFields(*this, const_cast<RenderGraphCreateInfo&>(Info)); }
+	void CaptureWriter::Write(const FrameBufferCreateInfo& Info) { CaptureFields(*this, const_cast<FrameBufferCreateInfo&>(Info)); }
+	void CaptureWriter::Write(const ResourceSetCreateInfo& Info) { CaptureFields(*this, const_cast<ResourceSetCreateInfo&>(Info)); }
+	void CaptureWriter::Write(const TextureTransition& Transition) { CaptureFields(*this, const_cast<TextureTransition&>(Transition)); }
+	void CaptureWriter::Write(const BufferBarrier& Barrier) { CaptureFields(*this, const_cast<BufferBarrier&>(Barrier)); }
+	void CaptureWriter::Write(const RenderingAttachment& Attachment) { CaptureFields(*this, const_cast<RenderingAttachment&>(Attachment)); }
+	void CaptureWriter::Write(const RenderingInfo& Info) { CaptureFields(*this, const_cast<RenderingInfo&>(Info)); }
+
+	std::vector<uint8_t> MakeCaptureRecord(CaptureOp Op, const std::vector<uint8_t>& Payload)
+	{
+		uint16_t OpValue = static_cast<uint16_t>(Op);
+		uint32_t Size = static_cast<uint32_t>(Payload.size());
+
+		std::vector<uint8_t> Record(CAPTURE_RECORD_HEADER_SIZE);
+		memcpy(Record.data(), &OpValue, sizeof(OpValue));
+		memcpy(Record.data() + sizeof(OpValue), &Size, sizeof(Size));
+		Record.insert(Record.end(), Payload.begin(), Payload.end());
+
+		return Record;
+	}
+
+	uint64_t ReadCapturePayload(const std::vector<uint8_t>& Payload, uint64_t Offset, uint32_t Size)
+	{
+		uint64_t Value = 0;
+		if (Offset + Size <= Payload.size())
+			memcpy(&Value, Payload.data() + Offset, Size);
+
+		return Value;
+	}
+
+	void WriteCaptureRecord(CaptureContext& Context, const std::vector<uint8_t>& Record)
+	{
+		fwrite(Record.data(), 1, Record.size(), Context.File);
+	}
+
+	// Stops tracking an object, along with objects that were only kept because it referred to them
+	void ReleaseCaptureObject(CaptureContext& Context, uint32_t Id)
+	{
+		auto Found = Context.Objects.find(Id);
+		if (Found == Context.Objects.end())
+			return;
+
+		std::vector<uint32_t> References = std::move(Found->second.References);
+
+		auto TrackedId = Context.Ids.find(Found->second.Object);
+		if (TrackedId != Context.Ids.end() && TrackedId->second == Id)
+			Context.Ids.erase(TrackedId);
+		Context.Objects.erase(Found);
+
+		for (uint32_t Reference : References)
+		{
+			auto Referenced = Context.Objects.find(Reference);
+			if (Referenced != Context.Objects.end() && --Referenced->second.Referenced == 0 && Referenced->second.bDestroyed)
+				ReleaseCaptureObject(Context, Reference);
+		}
+	}
+
+	// Uploads the memory of mapped buffers, which the application may have written without making any calls
+	void WriteCaptureMappedBuffers(CaptureContext& Context)
+	{
+		std::vector<uint8_t> Payload;
+		std::vector<uint32_t> References;
+
+		for (auto& [Id, Object] : Context.Objects)
+		{
+			if (!Object.Mapped || Object.bDestroyed)
+				continue;
+
+			Payload.clear();
+			CaptureWriter Writer{ Payload, References };
+			Writer(Id, CaptureBlob{ Object.Mapped, Object.MappedSize });
+
+			WriteCaptureRecord(Context, MakeCaptureRecord(CaptureOp::UploadStorageBufferData, Payload));
+		}
+	}
+
+	// The calls that recreate every tracked object as it is now
+	void WriteCaptureSnapshot(CaptureContext& Context)
+	{
+		for (auto& [Id, Object] : Context.Objects)
+		{
+			if (Object.bTransient)
+				continue;
+
+			for (uint32_t Creation = 0; Creation < std::max(Object.Refs, 1u); Creation++)
+				WriteCaptureRecord(Context, Object.Create);
+		}
+
+		for (auto& [Id, Object] : Context.Objects)
+		{
+			if (!Object.bDestroyed)
+				continue;
+
+			std::vector<uint8_t> Payload(sizeof(Id));
+			memcpy(Payload.data(), &Id, sizeof(Id));
+			WriteCaptureRecord(Context, MakeCaptureRecord(Object.DestroyOp, Payload));
+		}
+
+		for (auto& [Id, Object] : Context.Objects)
+		{
+			if (Object.bTransient || Object.bDestroyed)
+				continue;
+
+			for (const CaptureState& State : Object.States)
+				WriteCaptureRecord(Context, State.Record);
+		}
+
+		WriteCaptureMappedBuffers(Context);
+
+		for (auto& [Id, Object] : Context.Objects)
+		{
+			if (!Object.bTransient && !Object.bDestroyed && !Object.Recording.empty())
+				fwrite(Object.Recording.data(), 1, Object.Recording.size(), Context.File);
+		}
+
+		WriteCaptureRecord(Context, MakeCaptureRecord(CaptureOp::FramesBegin, {}));
+	}
+
+	void StartCapture(CaptureContext& Context)
+	{
+		Context.File = fopen(Context.PendingPath.c_str(), "wb");
+		Context.PendingPath.clear();
+
+		if (!Context.File)
+		{
+			//GLog->error("Failed to open the capture file");
+			return;
+		}
+
+		fwrite(CAPTURE_MAGIC, 1, sizeof(CAPTURE_MAGIC), Context.File);
+		fwrite(&CAPTURE_VERSION, 1, sizeof(CAPTURE_VERSION), Context.File);
+
+		WriteCaptureSnapshot(Context);
+	}
+
+	bool CaptureFrames(const char* Path, uint32_t FrameCount)
+	{
+		CaptureContext& Context = GetCaptureContext();
+		std::lock_guard<std::mutex> Lock(Context.Mutex);
+
+		if (Context.File || !Context.PendingPath.empty() || !Path || !*Path)
+			return false;
+
+		Context.PendingPath = Path;
+		Context.FramesLeft = std::max(FrameCount, 1u);
+
+		return true;
+	}
+
+	bool IsCapturing()
+	{
+		CaptureContext& Context = GetCaptureContext();
+		std::lock_guard<std::mutex> Lock(Context.Mutex);
+
+		return Context.File || !Context.PendingPath.empty();
+	}
+
+	void CaptureBeforeCall(CaptureOp Op)
+	{
+		CaptureContext& Context = GetCaptureContext();
+
+		// Mapped memory is recorded while the frame it was written for is still current
+		if (Context.File && (Op == CaptureOp::EndFrame || Op == CaptureOp::EndFrames))
+			WriteCaptureMappedBuffers(Context);
+	}
+
+	void CaptureCommit(CaptureOp Op, const void* Result)
+	{
+		CaptureContext& Context = GetCaptureContext();
+		std::vector<uint8_t>& Payload = GetCapturePayload();
+		CaptureOpKind Kind = GetCaptureOpKind(Op);
+
+		// Every op that isn't a creation or a frame starts with the object it's called on
+		uint32_t ObjectId = static_cast<uint32_t>(ReadCapturePayload(Payload, 0, sizeof(uint32_t)));
+		auto Object = Context.Objects.find(ObjectId);
+
+		std::vector<uint8_t> Record;
+		switch (Kind)
+		{
+		case CaptureOpKind::Create:
+		{
+			// Failed creations aren't recorded
+			if (!Result)
+				return;
+
+			// Shared objects are returned by several creations. Transient resource sets are new objects even when their memory is reused.
+			auto Existing = Context.Ids.find(Result);
+			bool bExisting = Existing != Context.Ids.end() && !Context.Objects[Existing->second].bTransient;
+
+			uint32_t Id = bExisting ? Existing->second : Context.NextId++;
+			Payload.insert(Payload.end(), reinterpret_cast<const uint8_t*>(&Id), reinterpret_cast<const uint8_t*>(&Id) + sizeof(Id));
+			Record = MakeCaptureRecord(Op, Payload);
+
+			if (bExisting)
+			{
+				// Swap chain images are retrieved rather than created, the last retrieval tells their current size
+				CaptureObject& Shared = Context.Objects[Id];
+				if (Op == CaptureOp::GetSwapChainImage || Op == CaptureOp::GetSwapChainImageView)
+					Shared.Create = Record;
+				else
+					Shared.Refs++;
+				break;
+			}
+
+			if (Existing != Context.Ids.end())
+				ReleaseCaptureObject(Context, Existing->second);
+
+			CaptureObject& Created = Context.Objects[Id];
+			Created.Object = Result;
+			Created.Create = Record;
+			Created.References = GetCaptureReferences();
+			Created.bTransient = Op == CaptureOp::CreateTransientResourceSet;
+			Context.Ids[Result] = Id;
+
+			for (uint32_t Reference : Created.References)
+			{
+				auto Referenced = Context.Objects.find(Reference);
+				if (Referenced != Context.Objects.end())
+					Referenced->second.Referenced++;
+			}
+			break;
+		}
+		case CaptureOpKind::Destroy:
+		{
+			Record = MakeCaptureRecord(Op, Payload);
+			if (Object == Context.Objects.end() || Object->second.bDestroyed || --Object->second.Refs > 0)
+				break;
+
+			if (Object->second.Referenced > 0)
+			{
+				CaptureObject& Destroyed = Object->second;
+				Destroyed.bDestroyed = true;
+				Destroyed.DestroyOp = Op;
+				Destroyed.States.clear();
+				Destroyed.Recording.clear();
+				Destroyed.Mapped = nullptr;
+
+				// The memory may be reused by a new object
+				Context.Ids.erase(Destroyed.Object);
+			}
+			else
+				ReleaseCaptureObject(Context, ObjectId);
+			break;
+		}
+		case CaptureOpKind::State:
+		{
+			Record = MakeCaptureRecord(Op, Payload);
+			if (Object == Context.Objects.end() || Object->second.bDestroyed)
+				break;
+
+			std::vector<CaptureState>& States = Object->second.States;
+			uint64_t Key = ReadCapturePayload(Payload, sizeof(uint32_t), GetCaptureStateKeySize(Op));
+
+			// Resizing a buffer discards its contents
+			bool bResize = Op == CaptureOp::ResizeVertexBuffer || Op == CaptureOp::ResizeIndexBuffer;
+			States.erase(std::remove_if(States.begin(), States.end(), [&](const CaptureState& State)
+			{
+				bool bUpload = State.Op == CaptureOp::UploadVertexBufferData || State.Op == CaptureOp::UploadIndexBufferData;
+				return (State.Op == Op && State.Key == Key) || (bResize && bUpload);
+			}), States.end());
+
+			States.push_back({ Op, Key, Record });
+			break;
+		}
+		case CaptureOpKind::Map:
+		{
+			if (Object != Context.Objects.end() && Result)
+			{
+				Object->second.Mapped = Result;
+				Object->second.MappedSize = ReadCapturePayload(Payload, sizeof(uint32_t), sizeof(uint64_t));
+			}
+
+			// Mapping isn't replayed, the mapped memory is uploaded instead
+			return;
+		}
+		case CaptureOpKind::Command:
+		{
+			Record = MakeCaptureRecord(Op, Payload);
+			if (Object == Context.Objects.end() || Object->second.bDestroyed)
+				break;
+
+			if (Op == CaptureOp::Begin || Op == CaptureOp::Reset)
+				Object->second.Recording.clear();
+
+			Object->second.Recording.insert(Object->second.Recording.end(), Record.begin(), Record.end());
+			break;
+		}
+		case CaptureOpKind::Frame:
+		{
+			bool bFrameStart = Op == CaptureOp::BeginFrame || Op == CaptureOp::BeginFrameOffscreen || Op == CaptureOp::BeginFrames;
+
+			if (bFrameStart)
+			{
+				// The transient resource sets of earlier frames can't be used anymore
+				std::vector<uint32_t> Transient;
+				for (auto& [Id, Tracked] : Context.Objects)
+				{
+					if (Tracked.bTransient)
+						Transient.push_back(Id);
+				}
+
+				for (uint32_t Id : Transient)
+					ReleaseCaptureObject(Context, Id);
+			}
+
+			if (bFrameStart && !Context.File && !Context.PendingPath.empty())
+				StartCapture(Context);
+
+			// Frames aren't tracked, so they're only recorded while capturing
+			if (!Context.File)
+				return;
+
+			Record = MakeCaptureRecord(Op, Payload);
+			break;
+		}
+		case CaptureOpKind::Marker:
+			return;
+		}
+
+		if (!Context.File)
+			return;
+
+		WriteCaptureRecord(Context, Record);
+
+		if ((Op == CaptureOp::EndFrame || Op == CaptureOp::EndFrames) && --Context.FramesLeft == 0)
+		{
+			fclose(Context.File);
+			Context.File = nullptr;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,316 @@
+#pragma once
+
+#include "llrm.h"
+
+#include <mutex>
+#include <type_traits>
+
+/*
+ * Captures write the llrm calls of a range of frames to a file that replays without the application, e.g. to reproduce a slow frame
+ * on another machine, or to compare backend changes against an identical workload.
+ *
+ * With LLRM_CAPTURE enabled the backend keeps track of every live object along with the calls that created and last updated it,
+ * so a capture can start at any frame. The file begins with a snapshot made of those calls, followed by every call of the captured frames
+ * including upload payloads and command recording. Writes to the memory returned by MapStorageBuffer aren't calls, so the mapped memory
+ * of every mapped buffer is recorded as an upload at the end of each captured frame.
+ */
+namespace llrm
+{
+	struct ReplayStats
+	{
+		uint32_t Frames = 0; // Frames replayed across every loop
+		uint64_t Calls = 0;
+		uint64_t SkippedCalls = 0; // Calls referencing objects that failed to replay, or that were destroyed before the capture
+		double SnapshotMs = 0.0;
+		double FramesMs = 0.0; // Every loop of the captured frames
+	};
+
+#ifdef LLRM_CAPTURE
+	// Captures FrameCount frames starting with the next BeginFrame or BeginFrames. Fails while another capture is pending or in progress.
+	bool CaptureFrames(const char* Path, uint32_t FrameCount = 1);
+	bool IsCapturing();
+#else
+	inline bool CaptureFrames(const char* Path, uint32_t FrameCount = 1) { return false; }
+	inline bool IsCapturing() { return false; }
+#endif
+
+	/*
+	 * Replays a capture with the current context, which is meant to be headless. Swap chains are replaced with textures of the same size
+	 * and format, and the Presentation usage with TransferSource. The captured frames are replayed Loops times after the snapshot,
+	 * which only repeats the same work when the frames destroy what they create.
+	 */
+	bool ReplayCapture(const char* Path, uint32_t Loops, ReplayStats& OutStats);
+
+	// Every call that's recorded, grouped by what the call does. Calls without side effects, such as getting caps, aren't.
+	enum class CaptureOp : uint16_t
+	{
+		FramesBegin, // Separates the snapshot from the captured frames
+
+		// Creation, the record ends with the id of the created object
+		CreateRasterProgram,
+		CreateComputeProgram,
+		CreateSurface,
+		CreateSwapChain,
+		CreateResourceLayout,
+		CreatePipeline,
+		CreateComputePipeline,
+		CreateRenderGraph,
+		CreateFrameBuffer,
+		CreateVertexBuffer,
+		CreateIndexBuffer,
+		CreateStorageBuffer,
+		CreateTexelBufferView,
+		CreateCommandBuffer,
+		CreateResourceSet,
+		CreateTransientResourceSet,
+		CreateTexture,
+		CreateTextureView,
+		CreateSampler,
+		AllocateDeviceMemory,
+		CreateAliasedTexture,
+		CreateOcclusionQueryPool,
+		GetSwapChainImage,
+		GetSwapChainImageView,
+
+		// Destruction
+		DestroyVertexBuffer,
+		DestroyIndexBuffer,
+		DestroyStorageBuffer,
+		DestroyTexelBufferView,
+		DestroyRenderGraph,
+		DestroyPipeline,
+		DestroyResourceLayout,
+		DestroyResourceSet,
+		DestroyTexture,
+		DestroyTextureView,
+		DestroySampler,
+		DestroyFrameBuffer,
+		DestroyProgram,
+		DestroySwapChain,
+		DestroySurface,
+		DestroyCommandBuffer,
+		FreeDeviceMemory,
+		DestroyQueryPool,
+
+		// Updates to the state of an object, which the snapshot keeps the last one of
+		ReleaseShaderModules,
+		UploadVertexBufferData,
+		UploadIndexBufferData,
+		UploadStorageBufferData,
+		MapStorageBuffer,
+		ResizeVertexBuffer,
+		ResizeIndexBuffer,
+		UpdateUniformBuffer,
+		UpdateTextureResource,
+		UpdateSamplerResource,
+		UpdateInputAttachmentResource,
+		UpdateStorageBufferResource,
+		UpdateStorageImageResource,
+		UpdateTexelBufferResource,
+		UpdateDynamicBufferResource,
+		WriteTexture,
+		SetObjectName,
+
+		// Command recording, which the snapshot keeps since the last Begin of each command buffer
+		Reset,
+		Begin,
+		End,
+		TransitionTexture,
+		TransitionTextures,
+		GenerateMips,
+		BeginRenderGraph,
+		BeginRendering,
+		EndRenderGraph,
+		NextPass,
+		BindPipeline,
+		BindResources,
+		BindResourcesDynamic,
+		DrawVertexBuffer,
+		DrawVertexBufferIndexed,
+		SetViewport,
+		SetScissor,
+		Dispatch,
+		DispatchIndirect,
+		PipelineBarrier,
+		PipelineBarrierBatch,
+		ResetQueries,
+		BeginQuery,
+		EndQuery,
+		ResolveQueries,
+		BeginConditionalRendering,
+		EndConditionalRendering,
+		BeginLabel,
+		EndLabel,
+
+		// Frames and submission, only recorded while capturing
+		BeginFrame,
+		BeginFrameOffscreen,
+		BeginFrames,
+		EndFrame,
+		EndFrames,
+		RecreateSwapChain,
+		SubmitCommandBuffer,
+
+		Count
+	};
+
+	// Memory recorded by value, e.g. the data of an upload. Null data is recorded as such.
+	struct CaptureBlob
+	{
+		const void* Data;
+		uint64_t Size;
+	};
+
+	// Arguments without handles or pointers, which are recorded as their bytes
+	template<typename T> constexpr bool bCaptureRaw = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+	template<> constexpr bool bCaptureRaw<ConstantBufferDescription> = true;
+	template<> constexpr bool bCaptureRaw<TextureSamplerDescription> = true;
+	template<> constexpr bool bCaptureRaw<StorageDescription> = true;
+	template<> constexpr bool bCaptureRaw<PipelineBlendSettings> = true;
+	template<> constexpr bool bCaptureRaw<PipelineDepthStencilSettings> = true;
+	template<> constexpr bool bCaptureRaw<MemoryRequirements> = true;
+	template<> constexpr bool bCaptureRaw<SamplerCreateInfo> = true;
+	template<> constexpr bool bCaptureRaw<ClearValue> = true;
+}
+
+#ifdef LLRM_CAPTURE
+namespace llrm
+{
+	struct CaptureWriter
+	{
+		std::vector<uint8_t>& Out;
+		std::vector<uint32_t>& References; // Objects the record refers to
+
+		void Bytes(const void* Data, uint64_t Size);
+		void Handle(const void* Object);
+
+		void Write(const char* String);
+		void Write(const CaptureBlob& Blob);
+		void Write(const SwapChainFrame& Frame);
+		void Write(const ResourceLayoutCreateInfo& Info);
+		void Write(const PipelineState& State);
+		void Write(const ComputePipelineState& State);
+		void Write(const RenderGraphAttachmentDescription& Attachment);
+		void Write(const RenderPassInfo& Pass);
+		void Write(const RenderGraphCreateInfo& Info);
+		void Write(const FrameBufferCreateInfo& Info);
+		void Write(const ResourceSetCreateInfo& Info);
+		void Write(const TextureTransition& Transition);
+		void Write(const BufferBarrier& Barrier);
+		void Write(const RenderingAttachment& Attachment);
+		void Write(const RenderingInfo& Info);
+
+		template<typename T>
+		void Write(const T& Value)
+		{
+			// Every handle is a void*, data pointers are only ever written as a CaptureBlob
+			if constexpr (std::is_same_v<T, void*>)
+				Handle(Value);
+			else
+			{
+				static_assert(bCaptureRaw<T>, "Unsupported capture argument");
+				Bytes(&Value, sizeof(T));
+			}
+		}
+
+		template<typename T>
+		void Write(const std::vector<T>& Values)
+		{
+			Write(static_cast<uint32_t>(Values.size()));
+			for (const T& Value : Values)
+				Write(Value);
+		}
+
+		// Recorded the same way as a vector, so it's read back into one
+		template<typename T>
+		void Write(const std::span<T>& Values)
+		{
+			Write(static_cast<uint32_t>(Values.size()));
+			for (const T& Value : Values)
+				Write(Value);
+		}
+
+		template<typename A, typename B>
+		void Write(const std::pair<A, B>& Pair)
+		{
+			Write(Pair.first);
+			Write(Pair.second);
+		}
+
+		template<typename... T>
+		void operator()(const T&... Values)
+		{
+			(Write(Values), ...);
+		}
+	};
+
+	std::mutex& GetCaptureMutex();
+	uint32_t& GetCaptureDepth();
+	std::vector<uint8_t>& GetCapturePayload();
+	std::vector<uint32_t>& GetCaptureReferences();
+	void CaptureBeforeCall(CaptureOp Op);
+	void CaptureCommit(CaptureOp Op, const void* Result);
+
+	/*
+	 * Records a call made through the llrm API for its lifetime. Calls the backend makes to itself while inside of one aren't recorded,
+	 * so the hook has to come before the function calls any other llrm function.
+	 */
+	class CaptureCall
+	{
+	public:
+
+		template<typename... Args>
+		CaptureCall(CaptureOp InOp, const Args&... InArgs) : Op(InOp)
+		{
+			if (GetCaptureDepth()++ > 0)
+				return;
+
+			bRecording = true;
+
+			std::lock_guard<std::mutex> Lock(GetCaptureMutex());
+			CaptureBeforeCall(Op);
+
+			std::vector<uint8_t>& Payload = GetCapturePayload();
+			std::vector<uint32_t>& References = GetCaptureReferences();
+			Payload.clear();
+			References.clear();
+
+			CaptureWriter Writer{ Payload, References };
+			Writer(InArgs...);
+		}
+
+		~CaptureCall()
+		{
+			GetCaptureDepth()--;
+
+			if (bRecording)
+			{
+				std::lock_guard<std::mutex> Lock(GetCaptureMutex());
+				CaptureCommit(Op, ResultObject);
+			}
+		}
+
+		CaptureCall(const CaptureCall&) = delete;
+		CaptureCall& operator=(const CaptureCall&) = delete;
+
+		// Creations that don't pass their result through here failed, and aren't recorded
+		template<typename T>
+		T* Result(T* Object)
+		{
+			ResultObject = Object;
+			return Object;
+		}
+
+	private:
+		CaptureOp Op;
+		bool bRecording = false;
+		const void* ResultObject = nullptr;
+	};
+}
+
+	#define LLRM_CAPTURE_CALL(...) ::llrm::CaptureCall LLRMCaptureCall(__VA_ARGS__)
+	#define LLRM_CAPTURE_RESULT(Object) LLRMCaptureCall.Result(Object)
+#else
+	#define LLRM_CAPTURE_CALL(...)
+	#define LLRM_CAPTURE_RESULT(Object) (Object)
+#endif
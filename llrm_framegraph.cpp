@@ -0,0 +1,595 @@
+#include "llrm_framegraph.h"
+#include "llrm_trace.h"
+
+#include <algorithm>
+#include <string>
+
+namespace llrm
+{
+	struct FGAccess
+	{
+		FrameGraphResource Resource;
+		AttachmentUsage Usage;
+		AttachmentUsage EndUsage;
+		bool bWrite;
+	};
+
+	struct FGPassNode
+	{
+		std::string Name;
+		std::function<void(CommandBuffer)> Execute;
+		bool bSideEffects = false;
+		std::vector<FGAccess> Accesses;
+
+		// Compile state
+		uint32_t RefCount = 0;
+		bool bCulled = false;
+	};
+
+	struct FGTextureNode
+	{
+		std::string Name;
+		FrameGraphTextureDesc Desc{};
+
+		bool bImported = false;
+		Texture Imported{};
+		AttachmentUsage ImportUsage = AttachmentUsage::Undefined;
+		AttachmentUsage FinalUsage = AttachmentUsage::Undefined;
+
+		// Compile state
+		uint32_t RefCount = 0;
+		std::vector<FrameGraphPass> Producers;
+		int32_t FirstPass = -1;
+		int32_t LastPass = -1;
+		uint64_t Flags = 0;
+		uint32_t Physical = FRAME_GRAPH_INVALID;
+
+		// Execute state
+		AttachmentUsage CurrentUsage = AttachmentUsage::Undefined;
+	};
+
+	// Memory that one or more transient textures with non-overlapping lifetimes are placed in
+	struct FGMemoryBlock
+	{
+		MemoryRequirements Requirements;
+		DeviceMemory Memory{};
+
+		// The usage the texture that last used this memory was left in, which the next texture has to wait for
+		AttachmentUsage LastUsage = AttachmentUsage::Undefined;
+	};
+
+	struct FGPhysicalTexture
+	{
+		FrameGraphTextureDesc Desc{};
+		uint64_t Flags = 0;
+		uint32_t Block = 0;
+
+		Texture Image{};
+		TextureView View{};
+	};
+
+	struct FGCachedRequirements
+	{
+		FrameGraphTextureDesc Desc;
+		uint64_t Flags;
+		MemoryRequirements Requirements;
+	};
+
+	// Transient textures and memory replaced by a new layout, which frames still in flight may be using
+	struct FGRetiredPhysical
+	{
+		std::vector<FGMemoryBlock> Blocks;
+		std::vector<FGPhysicalTexture> Physical;
+		uint32_t FramesLeft = 0; // Resets until nothing in flight can refer to them anymore
+	};
+
+	struct FrameGraphData
+	{
+		std::vector<FGPassNode> Passes;
+		std::vector<FGTextureNode> Textures;
+
+		// Kept across frames
+		std::vector<FGMemoryBlock> Blocks;
+		std::vector<FGPhysicalTexture> Physical;
+		std::vector<FGCachedRequirements> RequirementsCache;
+		std::vector<FGRetiredPhysical> Retired;
+
+		FrameGraphStats Stats;
+		bool bCompiled = false;
+	};
+
+	static bool operator==(const FrameGraphTextureDesc& A, const FrameGraphTextureDesc& B)
+	{
+		return A.Format == B.Format && A.Width == B.Width && A.Height == B.Height && A.Layers == B.Layers;
+	}
+
+	static uint64_t UsageToTextureFlags(AttachmentUsage Usage)
+	{
+		switch (Usage)
+		{
+		case AttachmentUsage::ColorAttachment:
+		case AttachmentUsage::DepthStencilAttachment:
+			return TEXTURE_USAGE_RT;
+		case AttachmentUsage::ShaderRead:
+			return TEXTURE_USAGE_SAMPLE;
+		case AttachmentUsage::ShaderReadWrite:
+			return TEXTURE_USAGE_STORAGE;
+		case AttachmentUsage::ShaderReadDepthStencil:
+			return TEXTURE_USAGE_SAMPLE | TEXTURE_USAGE_RT;
+		case AttachmentUsage::TransferSource:
+			return TEXTURE_USAGE_READ;
+		case AttachmentUsage::TransferDestination:
+			return TEXTURE_USAGE_WRITE;
+		default:
+			return 0;
+		}
+	}
+
+	// Accesses declared as Undefined are attachments of a render graph that starts from an undefined layout
+	static AttachmentUsage GetAccessUsage(const FGTextureNode& Texture, const FGAccess& Access)
+	{
+		if (Access.Usage != AttachmentUsage::Undefined)
+			return Access.Usage;
+
+		return IsColorFormat(Texture.Desc.Format) ? AttachmentUsage::ColorAttachment : AttachmentUsage::DepthStencilAttachment;
+	}
+
+	// Whether a texture that stays in the same usage between two passes still needs a barrier
+	static bool NeedsBarrierWithinUsage(AttachmentUsage Usage)
+	{
+		// Reads never conflict with each other, and render graphs synchronize their own attachments with external dependencies
+		return Usage == AttachmentUsage::TransferDestination || Usage == AttachmentUsage::ShaderReadWrite;
+	}
+
+	static MemoryRequirements GetCachedRequirements(FrameGraphData* Data, const FrameGraphTextureDesc& Desc, uint64_t Flags)
+	{
+		for (const FGCachedRequirements& Cached : Data->RequirementsCache)
+		{
+			if (Cached.Desc == Desc && Cached.Flags == Flags)
+				return Cached.Requirements;
+		}
+
+		MemoryRequirements Requirements = GetTextureMemoryRequirements(Desc.Format, Desc.Width, Desc.Height, Flags, Desc.Layers);
+		Data->RequirementsCache.push_back({ Desc, Flags, Requirements });
+
+		return Requirements;
+	}
+
+	static void DestroyPhysical(std::vector<FGPhysicalTexture>& Physical, std::vector<FGMemoryBlock>& Blocks)
+	{
+		for (FGPhysicalTexture& Texture : Physical)
+		{
+			DestroyTextureView(Texture.View);
+			DestroyTexture(Texture.Image);
+		}
+		for (FGMemoryBlock& Block : Blocks)
+			FreeDeviceMemory(Block.Memory);
+
+		Physical.clear();
+		Blocks.clear();
+	}
+
+	// The current textures are destroyed once every frame in flight that could have used them has finished
+	static void RetirePhysical(FrameGraphData* Data)
+	{
+		if (Data->Physical.empty() && Data->Blocks.empty())
+			return;
+
+		FGRetiredPhysical& Retired = Data->Retired.emplace_back();
+		Retired.Blocks = std::move(Data->Blocks);
+		Retired.Physical = std::move(Data->Physical);
+		Retired.FramesLeft = GetFramesInFlight();
+
+		Data->Blocks.clear();
+		Data->Physical.clear();
+	}
+
+	FrameGraph CreateFrameGraph()
+	{
+		return new FrameGraphData;
+	}
+
+	void DestroyFrameGraph(FrameGraph Graph)
+	{
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+
+		// Waiting on an empty submission waits for everything submitted before it, including frames that used the transient textures
+		if (!Data->Physical.empty() || !Data->Retired.empty())
+			ImmediateSubmitAndWait([](CommandBuffer) {});
+
+		DestroyPhysical(Data->Physical, Data->Blocks);
+		for (FGRetiredPhysical& Retired : Data->Retired)
+			DestroyPhysical(Retired.Physical, Retired.Blocks);
+
+		delete Data;
+	}
+
+	void FGReset(FrameGraph Graph)
+	{
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+
+		Data->Passes.clear();
+		Data->Textures.clear();
+		Data->bCompiled = false;
+
+		for (FGRetiredPhysical& Retired : Data->Retired)
+		{
+			if (--Retired.FramesLeft == 0)
+				DestroyPhysical(Retired.Physical, Retired.Blocks);
+		}
+		std::erase_if(Data->Retired, [](const FGRetiredPhysical& Retired) { return Retired.FramesLeft == 0; });
+	}
+
+	FrameGraphResource FGCreateTexture(FrameGraph Graph, const char* Name, const FrameGraphTextureDesc& Desc)
+	{
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+
+		FGTextureNode& Node = Data->Textures.emplace_back();
+		Node.Name = Name;
+		Node.Desc = Desc;
+
+		return static_cast<FrameGraphResource>(Data->Textures.size() - 1);
+	}
+
+	FrameGraphResource FGImportTexture(FrameGraph Graph, const char* Name, Texture Image, AttachmentUsage CurrentUsage, AttachmentUsage FinalUsage)
+	{
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+
+		FGTextureNode& Node = Data->Textures.emplace_back();
+		Node.Name = Name;
+		Node.bImported = true;
+		Node.Imported = Image;
+		Node.ImportUsage = CurrentUsage;
+		Node.FinalUsage = FinalUsage;
+
+		return static_cast<FrameGraphResource>(Data->Textures.size() - 1);
+	}
+
+	FrameGraphPass FGAddPass(FrameGraph Graph, const char* Name, std::function<void(CommandBuffer)> Execute, bool bSideEffects)
+	{
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+
+		FGPassNode& Node = Data->Passes.emplace_back();
+		Node.Name = Name;
+		Node.Execute = std::move(Execute);
+		Node.bSideEffects = bSideEffects;
+
+		return static_cast<FrameGraphPass>(Data->Passes.size() - 1);
+	}
+
+	void FGRead(FrameGraph Graph, FrameGraphPass Pass, FrameGraphResource Resource, AttachmentUsage Usage, AttachmentUsage EndUsage)
+	{
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+		Data->Passes[Pass].Accesses.push_back({ Resource, Usage, EndUsage == AttachmentUsage::Undefined ? Usage : EndUsage, false });
+	}
+
+	void FGWrite(FrameGraph Graph, FrameGraphPass Pass, FrameGraphResource Resource, AttachmentUsage Usage, AttachmentUsage EndUsage)
+	{
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+		Data->Passes[Pass].Accesses.push_back({ Resource, Usage, EndUsage == AttachmentUsage::Undefined ? Usage : EndUsage, true });
+	}
+
+	void FGCompile(FrameGraph Graph)
+	{
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+		if (Data->bCompiled)
+			return;
+
+		LLRM_TRACE_FUNCTION();
+
+		// Count how many passes read each texture and how many textures each pass writes
+		for (uint32_t PassIndex = 0; PassIndex < Data->Passes.size(); PassIndex++)
+		{
+			FGPassNode& Pass = Data->Passes[PassIndex];
+			Pass.RefCount = Pass.bSideEffects ? 1 : 0;
+
+			for (const FGAccess& Access : Pass.Accesses)
+			{
+				FGTextureNode& Texture = Data->Textures[Access.Resource];
+				if (Access.bWrite)
+				{
+					Pass.RefCount++;
+					Texture.Producers.push_back(PassIndex);
+				}
+				else
+				{
+					Texture.RefCount++;
+				}
+			}
+		}
+
+		// Cull passes whose outputs are never read, which may leave the textures they read unused as well
+		for (FGPassNode& Pass : Data->Passes)
+		{
+			if (Pass.RefCount > 0)
+				continue;
+
+			Pass.bCulled = true;
+			for (const FGAccess& Access : Pass.Accesses)
+				Data->Textures[Access.Resource].RefCount--; // A pass without writes only has reads
+		}
+
+		std::vector<FrameGraphResource> Unreferenced;
+		for (uint32_t TexIndex = 0; TexIndex < Data->Textures.size(); TexIndex++)
+		{
+			if (Data->Textures[TexIndex].RefCount == 0)
+				Unreferenced.push_back(TexIndex);
+		}
+
+		while (!Unreferenced.empty())
+		{
+			FGTextureNode& Texture = Data->Textures[Unreferenced.back()];
+			Unreferenced.pop_back();
+
+			for (FrameGraphPass Producer : Texture.Producers)
+			{
+				FGPassNode& Pass = Data->Passes[Producer];
+				if (Pass.RefCount == 0 || --Pass.RefCount > 0)
+					continue;
+
+				Pass.bCulled = true;
+				for (const FGAccess& Access : Pass.Accesses)
+				{
+					if (!Access.bWrite && --Data->Textures[Access.Resource].RefCount == 0)
+						Unreferenced.push_back(Access.Resource);
+				}
+			}
+		}
+
+		// Lifetimes of the textures and the usages transient textures need to be created with
+		for (uint32_t PassIndex = 0; PassIndex < Data->Passes.size(); PassIndex++)
+		{
+			const FGPassNode& Pass = Data->Passes[PassIndex];
+			if (Pass.bCulled)
+				continue;
+
+			for (const FGAccess& Access : Pass.Accesses)
+			{
+				FGTextureNode& Texture = Data->Textures[Access.Resource];
+				if (Texture.FirstPass < 0)
+					Texture.FirstPass = PassIndex;
+				Texture.LastPass = PassIndex;
+				Texture.Flags |= UsageToTextureFlags(GetAccessUsage(Texture, Access)) | UsageToTextureFlags(Access.EndUsage);
+			}
+		}
+
+		// Place transient textures into memory blocks, largest first. A texture can share a block when its lifetime doesn't overlap any texture already in it.
+		std::vector<FrameGraphResource> Transient;
+		std::vector<MemoryRequirements> Requirements(Data->Textures.size());
+		for (uint32_t TexIndex = 0; TexIndex < Data->Textures.size(); TexIndex++)
+		{
+			FGTextureNode& Texture = Data->Textures[TexIndex];
+			if (Texture.bImported || Texture.FirstPass < 0)
+				continue;
+
+			Requirements[TexIndex] = GetCachedRequirements(Data, Texture.Desc, Texture.Flags);
+			Transient.push_back(TexIndex);
+		}
+
+		std::stable_sort(Transient.begin(), Transient.end(), [&Requirements](FrameGraphResource A, FrameGraphResource B)
+		{
+			return Requirements[A].Size > Requirements[B].Size;
+		});
+
+		std::vector<MemoryRequirements> BlockRequirements;
+		std::vector<std::vector<FrameGraphResource>> BlockOccupants;
+		std::vector<FGPhysicalTexture> Physical;
+		uint64_t TransientBytes = 0;
+
+		for (FrameGraphResource TexIndex : Transient)
+		{
+			FGTextureNode& Texture = Data->Textures[TexIndex];
+			const MemoryRequirements& TexReq = Requirements[TexIndex];
+			TransientBytes += TexReq.Size;
+
+			uint32_t Block = FRAME_GRAPH_INVALID;
+			for (uint32_t BlockIndex = 0; BlockIndex < BlockRequirements.size() && Block == FRAME_GRAPH_INVALID; BlockIndex++)
+			{
+				// Blocks are sized by their first, largest texture so every later one fits at offset zero
+				if ((BlockRequirements[BlockIndex].MemoryTypeBits & TexReq.MemoryTypeBits) == 0)
+					continue;
+
+				bool bOverlaps = std::any_of(BlockOccupants[BlockIndex].begin(), BlockOccupants[BlockIndex].end(), [&](FrameGraphResource Other)
+				{
+					const FGTextureNode& OtherTex = Data->Textures[Other];
+					return Texture.FirstPass <= OtherTex.LastPass && OtherTex.FirstPass <= Texture.LastPass;
+				});
+
+				if (!bOverlaps)
+					Block = BlockIndex;
+			}
+
+			if (Block == FRAME_GRAPH_INVALID)
+			{
+				Block = static_cast<uint32_t>(BlockRequirements.size());
+				BlockRequirements.push_back(TexReq);
+				BlockOccupants.emplace_back();
+			}
+			else
+			{
+				BlockRequirements[Block].MemoryTypeBits &= TexReq.MemoryTypeBits;
+				BlockRequirements[Block].Alignment = std::max(BlockRequirements[Block].Alignment, TexReq.Alignment);
+			}
+
+			BlockOccupants[Block].push_back(TexIndex);
+
+			Texture.Physical = static_cast<uint32_t>(Physical.size());
+			Physical.push_back({ Texture.Desc, Texture.Flags, Block });
+		}
+
+		// Reuse last frame's textures and memory when the layout hasn't changed
+		bool bReuse = Physical.size() == Data->Physical.size() && BlockRequirements.size() == Data->Blocks.size();
+		for (uint32_t PhysIndex = 0; bReuse && PhysIndex < Physical.size(); PhysIndex++)
+		{
+			const FGPhysicalTexture& Old = Data->Physical[PhysIndex];
+			const FGPhysicalTexture& New = Physical[PhysIndex];
+			bReuse = Old.Desc == New.Desc && Old.Flags == New.Flags && Old.Block == New.Block;
+		}
+		for (uint32_t BlockIndex = 0; bReuse && BlockIndex < BlockRequirements.size(); BlockIndex++)
+			bReuse = Data->Blocks[BlockIndex].Requirements.Size == BlockRequirements[BlockIndex].Size;
+
+		if (!bReuse)
+		{
+			RetirePhysical(Data);
+
+			for (const MemoryRequirements& BlockReq : BlockRequirements)
+			{
+				FGMemoryBlock& NewBlock = Data->Blocks.emplace_back();
+				NewBlock.Requirements = BlockReq;
+				NewBlock.Memory = AllocateDeviceMemory(BlockReq);
+			}
+
+			for (FGPhysicalTexture& NewPhysical : Physical)
+			{
+				const FrameGraphTextureDesc& Desc = NewPhysical.Desc;
+				NewPhysical.Image = CreateAliasedTexture(Desc.Format, Desc.Width, Desc.Height, NewPhysical.Flags, Desc.Layers, Data->Blocks[NewPhysical.Block].Memory, 0);
+				NewPhysical.View = CreateTextureView(NewPhysical.Image,
+					IsColorFormat(Desc.Format) ? COLOR_ASPECT : DEPTH_ASPECT,
+					Desc.Layers > 1 ? TextureViewType::TYPE_2D_ARRAY : TextureViewType::TYPE_2D,
+					0, Desc.Layers);
+			}
+
+			Data->Physical = std::move(Physical);
+		}
+
+		uint64_t AllocatedBytes = 0;
+		for (const FGMemoryBlock& Block : Data->Blocks)
+			AllocatedBytes += Block.Requirements.Size;
+
+		Data->Stats = {};
+		Data->Stats.Passes = static_cast<uint32_t>(Data->Passes.size());
+		Data->Stats.CulledPasses = static_cast<uint32_t>(std::count_if(Data->Passes.begin(), Data->Passes.end(), [](const FGPassNode& Pass) { return Pass.bCulled; }));
+		Data->Stats.TransientTextures = static_cast<uint32_t>(Transient.size());
+		Data->Stats.MemoryBlocks = static_cast<uint32_t>(Data->Blocks.size());
+		Data->Stats.TransientBytes = TransientBytes;
+		Data->Stats.AllocatedBytes = AllocatedBytes;
+
+		Data->bCompiled = true;
+	}
+
+	void FGExecute(FrameGraph Graph, CommandBuffer Buf)
+	{
+		LLRM_TRACE_FUNCTION();
+
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+		FGCompile(Graph);
+
+		Data->Stats.Transitions = 0;
+		Data->Stats.Barriers = 0;
+
+		for (FGTextureNode& Texture : Data->Textures)
+			Texture.CurrentUsage = Texture.bImported ? Texture.ImportUsage : AttachmentUsage::Undefined;
+
+		std::vector<TextureTransition> Transitions;
+		std::vector<FrameGraphResource> Transitioned;
+		for (FGPassNode& Pass : Data->Passes)
+		{
+			if (Pass.bCulled)
+				continue;
+
+			// The label covers the pass's transitions too, so debuggers attribute its barriers to it
+			BeginLabel(Buf, Pass.Name.c_str());
+
+			Transitions.clear();
+			Transitioned.clear();
+
+			for (const FGAccess& Access : Pass.Accesses)
+			{
+				// A pass that accesses a texture more than once gets a single transition for it
+				if (std::find(Transitioned.begin(), Transitioned.end(), Access.Resource) != Transitioned.end())
+					continue;
+
+				FGTextureNode& Texture = Data->Textures[Access.Resource];
+
+				TextureTransition Transition{ FGGetTexture(Graph, Access.Resource), Texture.CurrentUsage, GetAccessUsage(Texture, Access) };
+
+				// The first use of a transient texture discards whatever the previous texture in the same memory left behind, but has to wait for it.
+				// This applies even when the pass's render graph transitions the texture itself, since its transition doesn't wait on another texture.
+				if (!Texture.bImported && Texture.CurrentUsage == AttachmentUsage::Undefined)
+				{
+					Transition.Old = Data->Blocks[Data->Physical[Texture.Physical].Block].LastUsage;
+					Transition.bDiscard = true;
+
+					if (Access.Usage == AttachmentUsage::Undefined && Transition.Old == AttachmentUsage::Undefined)
+						continue;
+				}
+				// Otherwise Undefined means the pass's render graph transitions the texture itself
+				else if (Access.Usage == AttachmentUsage::Undefined)
+				{
+					continue;
+				}
+				else if (Texture.CurrentUsage == Access.Usage && !NeedsBarrierWithinUsage(Access.Usage))
+				{
+					continue;
+				}
+
+				Transitions.push_back(Transition);
+				Transitioned.push_back(Access.Resource);
+			}
+
+			if (!Transitions.empty())
+			{
+				TransitionTextures(Buf, Transitions);
+				Data->Stats.Transitions += static_cast<uint32_t>(Transitions.size());
+				Data->Stats.Barriers++;
+			}
+
+			Pass.Execute(Buf);
+
+			EndLabel(Buf);
+
+			for (const FGAccess& Access : Pass.Accesses)
+			{
+				FGTextureNode& Texture = Data->Textures[Access.Resource];
+				Texture.CurrentUsage = Access.EndUsage;
+
+				if (!Texture.bImported)
+					Data->Blocks[Data->Physical[Texture.Physical].Block].LastUsage = Access.EndUsage;
+			}
+		}
+
+		// Leave imported textures in the usage the caller expects
+		Transitions.clear();
+		for (FGTextureNode& Texture : Data->Textures)
+		{
+			if (Texture.bImported && Texture.FinalUsage != AttachmentUsage::Undefined && Texture.CurrentUsage != Texture.FinalUsage)
+				Transitions.push_back({ Texture.Imported, Texture.CurrentUsage, Texture.FinalUsage });
+		}
+
+		if (!Transitions.empty())
+		{
+			TransitionTextures(Buf, Transitions);
+			Data->Stats.Transitions += static_cast<uint32_t>(Transitions.size());
+			Data->Stats.Barriers++;
+		}
+	}
+
+	Texture FGGetTexture(FrameGraph Graph, FrameGraphResource Resource)
+	{
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+		const FGTextureNode& Texture = Data->Textures[Resource];
+
+		if (Texture.bImported)
+			return Texture.Imported;
+		if (Texture.Physical == FRAME_GRAPH_INVALID)
+			return nullptr; // Never used, or not compiled yet
+
+		return Data->Physical[Texture.Physical].Image;
+	}
+
+	TextureView FGGetTextureView(FrameGraph Graph, FrameGraphResource Resource)
+	{
+		FrameGraphData* Data = static_cast<FrameGraphData*>(Graph);
+		const FGTextureNode& Texture = Data->Textures[Resource];
+
+		if (Texture.bImported || Texture.Physical == FRAME_GRAPH_INVALID)
+			return nullptr;
+
+		return Data->Physical[Texture.Physical].View;
+	}
+
+	FrameGraphStats FGGetStats(FrameGraph Graph)
+	{
+		return static_cast<FrameGraphData*>(Graph)->Stats;
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "llrm.h"
+
+/*
+ * A frame graph sits on top of render graphs and records a whole frame. Passes declare which textures they read and write,
+ * and the frame graph works out the transitions between them, culls passes whose results are never used
+ * and places transient textures with non-overlapping lifetimes in the same memory.
+ *
+ * A pass usually records one render graph. The usages a pass declares for its attachments should match the render graph's
+ * initial and final usages, or be AttachmentUsage::Undefined when the render graph starts from an undefined layout itself.
+ */
+namespace llrm
+{
+	typedef void* FrameGraph;
+	typedef uint32_t FrameGraphResource;
+	typedef uint32_t FrameGraphPass;
+
+	const uint32_t FRAME_GRAPH_INVALID = ~0u;
+
+	struct FrameGraphTextureDesc
+	{
+		AttachmentFormat Format;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Layers = 1;
+	};
+
+	struct FrameGraphStats
+	{
+		uint32_t Passes = 0;
+		uint32_t CulledPasses = 0;
+		uint32_t Transitions = 0; // Texture transitions recorded by the last execute
+		uint32_t Barriers = 0; // Pipeline barriers those transitions were batched into
+		uint32_t TransientTextures = 0;
+		uint32_t MemoryBlocks = 0;
+		uint64_t TransientBytes = 0; // Memory the transient textures would need without aliasing
+		uint64_t AllocatedBytes = 0; // Memory actually allocated for them
+	};
+
+	FrameGraph CreateFrameGraph();
+	void DestroyFrameGraph(FrameGraph Graph); // Waits for submitted work to finish before destroying the transient textures
+
+	/*
+	 * Clears everything declared for the previous frame, and is expected to be called once per frame. Transient textures are kept and reused
+	 * while their descriptions don't change, otherwise the old ones are destroyed GetFramesInFlight() resets later, once no frame uses them.
+	 */
+	void FGReset(FrameGraph Graph);
+
+	// A texture owned by the frame graph, its contents only live from the pass that first writes it to the pass that last reads it
+	FrameGraphResource FGCreateTexture(FrameGraph Graph, const char* Name, const FrameGraphTextureDesc& Desc);
+
+	// A texture owned by the caller. CurrentUsage is the usage it's in before the frame graph executes, FinalUsage the one it'll be left in.
+	FrameGraphResource FGImportTexture(FrameGraph Graph, const char* Name, Texture Image, AttachmentUsage CurrentUsage, AttachmentUsage FinalUsage);
+
+	/*
+	 * Passes execute in the order they're added. Passes with side effects, such as writing to a swap chain, are never culled.
+	 * Any other pass is culled when nothing reads what it writes, which includes writes to imported textures.
+	 */
+	FrameGraphPass FGAddPass(FrameGraph Graph, const char* Name, std::function<void(CommandBuffer)> Execute, bool bSideEffects = false);
+
+	// EndUsage is the usage the pass leaves the texture in, i.e. the final usage of a render graph. Defaults to Usage.
+	void FGRead(FrameGraph Graph, FrameGraphPass Pass, FrameGraphResource Resource, AttachmentUsage Usage, AttachmentUsage EndUsage = AttachmentUsage::Undefined);
+	void FGWrite(FrameGraph Graph, FrameGraphPass Pass, FrameGraphResource Resource, AttachmentUsage Usage, AttachmentUsage EndUsage = AttachmentUsage::Undefined);
+
+	// Culls passes, computes lifetimes and assigns memory to transient textures. Must be called before getting transient textures.
+	void FGCompile(FrameGraph Graph);
+	void FGExecute(FrameGraph Graph, CommandBuffer Buf);
+
+	Texture FGGetTexture(FrameGraph Graph, FrameGraphResource Resource);
+	TextureView FGGetTextureView(FrameGraph Graph, FrameGraphResource Resource); // Only available for transient textures
+	FrameGraphStats FGGetStats(FrameGraph Graph);
+}
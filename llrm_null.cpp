@@ -0,0 +1,1961 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "llrm_null.h"
+#include "llrm_trace.h"
+#include "llrm_capture.h"
+
+#ifdef LLRM_NULL
+
+NullContext GNullContext;
+NullObjectRegistry GNullObjects;
+NullCounters GNullCounters;
+
+// Alignment of host written buffer slices and aliased textures, which matches what most devices require
+constexpr uint64_t NULL_MEMORY_ALIGNMENT = 256;
+
+const char* GetNullObjectTypeName(NullObjectType Type)
+{
+	switch (Type)
+	{
+	case NullObjectType::Surface: return "surface";
+	case NullObjectType::SwapChain: return "swap chain";
+	case NullObjectType::ShaderProgram: return "shader program";
+	case NullObjectType::ResourceLayout: return "resource layout";
+	case NullObjectType::Pipeline: return "pipeline";
+	case NullObjectType::RenderGraph: return "render graph";
+	case NullObjectType::FrameBuffer: return "frame buffer";
+	case NullObjectType::VertexBuffer: return "vertex buffer";
+	case NullObjectType::IndexBuffer: return "index buffer";
+	case NullObjectType::StorageBuffer: return "storage buffer";
+	case NullObjectType::TexelBufferView: return "texel buffer view";
+	case NullObjectType::CommandBuffer: return "command buffer";
+	case NullObjectType::ResourceSet: return "resource set";
+	case NullObjectType::Texture: return "texture";
+	case NullObjectType::TextureView: return "texture view";
+	case NullObjectType::Sampler: return "sampler";
+	case NullObjectType::DeviceMemory: return "device memory";
+	case NullObjectType::QueryPool: return "query pool";
+	default: return "object";
+	}
+}
+
+void NullCount(std::atomic<uint64_t>& Counter, uint64_t Amount = 1)
+{
+	Counter.fetch_add(Amount, std::memory_order_relaxed);
+}
+
+void NullError(const char* Function, const std::string& Message)
+{
+	NullCount(GNullCounters.ValidationErrors);
+	std::cout << "[nullError]: " << Function << ": " << Message << std::endl;
+}
+
+uint64_t AlignNullSize(uint64_t Size)
+{
+	return (Size + NULL_MEMORY_ALIGNMENT - 1) / NULL_MEMORY_ALIGNMENT * NULL_MEMORY_ALIGNMENT;
+}
+
+template<typename T>
+T* RegisterNullObject(T* Object, NullObjectType Type)
+{
+	std::lock_guard<std::mutex> Lock(GNullObjects.Lock);
+	GNullObjects.Objects[Object] = Type;
+
+	return Object;
+}
+
+bool ValidateNullHandle(const void* Handle, NullObjectType Type, const char* Function)
+{
+	if (!Handle)
+	{
+		NullError(Function, std::string("null ") + GetNullObjectTypeName(Type) + " handle");
+		return false;
+	}
+
+	std::lock_guard<std::mutex> Lock(GNullObjects.Lock);
+	auto Found = GNullObjects.Objects.find(Handle);
+	if (Found == GNullObjects.Objects.end())
+	{
+		NullError(Function, std::string("the ") + GetNullObjectTypeName(Type) + " handle was never created or has been destroyed");
+		return false;
+	}
+	if (Found->second != Type)
+	{
+		NullError(Function, std::string("expected a ") + GetNullObjectTypeName(Type) + " handle but got a " + GetNullObjectTypeName(Found->second));
+		return false;
+	}
+
+	return true;
+}
+
+// Returns the object behind a handle, or null when the handle isn't a live object of that type
+template<typename T>
+T* GetNullObject(const void* Handle, NullObjectType Type, const char* Function)
+{
+	if (!ValidateNullHandle(Handle, Type, Function))
+		return nullptr;
+
+	return static_cast<T*>(const_cast<void*>(Handle));
+}
+
+// Same as GetNullObject, but the handle is no longer valid afterwards so the caller can delete the object
+template<typename T>
+T* ReleaseNullObject(const void* Handle, NullObjectType Type, const char* Function)
+{
+	if (!ValidateNullHandle(Handle, Type, Function))
+		return nullptr;
+
+	std::lock_guard<std::mutex> Lock(GNullObjects.Lock);
+	GNullObjects.Objects.erase(Handle);
+
+	return static_cast<T*>(const_cast<void*>(Handle));
+}
+
+void UnregisterNullObject(const void* Object)
+{
+	std::lock_guard<std::mutex> Lock(GNullObjects.Lock);
+	GNullObjects.Objects.erase(Object);
+}
+
+// Every recorded command goes through here, commands can only be recorded between Begin and End
+NullCommandBuffer* GetRecordingCommandBuffer(llrm::CommandBuffer Buf, const char* Function)
+{
+	NullCommandBuffer* NullCmd = GetNullObject<NullCommandBuffer>(Buf, NullObjectType::CommandBuffer, Function);
+	if (!NullCmd)
+		return nullptr;
+
+	if (NullCmd->State != NullCommandBufferState::Recording)
+	{
+		NullError(Function, "the command buffer isn't being recorded");
+		return nullptr;
+	}
+
+	NullCount(GNullCounters.Commands);
+	return NullCmd;
+}
+
+// Whether the command is recorded on the right side of BeginRenderGraph and EndRenderGraph
+bool ValidateGraphScope(const NullCommandBuffer* NullCmd, bool bInsideGraph, const char* Function)
+{
+	if (NullCmd->bInsideGraph != bInsideGraph)
+	{
+		NullError(Function, bInsideGraph ? "must be recorded inside of a render graph" : "can't be recorded inside of a render graph");
+		return false;
+	}
+
+	return true;
+}
+
+template<typename Description>
+bool HasNullBinding(const std::vector<Description>& Descriptions, uint32_t Binding)
+{
+	return std::any_of(Descriptions.begin(), Descriptions.end(), [Binding](const Description& Desc) { return Desc.Binding == Binding; });
+}
+
+bool ValidateNullBinding(uint32_t Binding, bool bHasBinding, const char* Function)
+{
+	if (!bHasBinding)
+		NullError(Function, "the resource layout has no binding " + std::to_string(Binding) + " of this kind");
+
+	return bHasBinding;
+}
+
+NullResourceSet* GetUpdatedResourceSet(llrm::ResourceSet Resources, const char* Function)
+{
+	return GetNullObject<NullResourceSet>(Resources, NullObjectType::ResourceSet, Function);
+}
+
+// Writes a host written buffer the same way the Vulkan backend does: only the current slice inside of a frame, otherwise every slice
+void WriteNullBuffer(NullBuffer* Buffer, const void* Data, uint64_t Size)
+{
+	if (Buffer->Memory.empty() || !Data)
+		return;
+
+	if (!(Buffer->Flags & llrm::BUFFER_PER_FRAME))
+	{
+		memcpy(Buffer->Memory.data(), Data, Size);
+		return;
+	}
+
+	uint32_t Slices = static_cast<uint32_t>(Buffer->Memory.size() / Buffer->SliceSize);
+	for (uint32_t Slice = 0; Slice < Slices; Slice++)
+	{
+		if (!GNullContext.bInsideFrame || Slice == GNullContext.CurrentFrame)
+			memcpy(Buffer->Memory.data() + Slice * Buffer->SliceSize, Data, Size);
+	}
+}
+
+NullBuffer* CreateNullBuffer(uint64_t Size, const void* Data, uint64_t BufferFlags)
+{
+	NullBuffer* Buffer = new NullBuffer;
+	Buffer->Size = Size;
+	Buffer->Flags = BufferFlags;
+
+	if (BufferFlags & (llrm::BUFFER_HOST_WRITE | llrm::BUFFER_PER_FRAME))
+	{
+		Buffer->SliceSize = AlignNullSize(std::max(Size, uint64_t(1)));
+		Buffer->Memory.resize(Buffer->SliceSize * (BufferFlags & llrm::BUFFER_PER_FRAME ? GNullContext.FramesInFlight : 1));
+	}
+
+	if (Data)
+	{
+		WriteNullBuffer(Buffer, Data, Size);
+		NullCount(GNullCounters.BytesUploaded, Size);
+	}
+
+	return Buffer;
+}
+
+void UploadNullBuffer(void* Buffer, NullObjectType Type, const void* Data, uint64_t Size, const char* Function)
+{
+	NullBuffer* NullBuf = GetNullObject<NullBuffer>(Buffer, Type, Function);
+	if (!NullBuf)
+		return;
+
+	if (Size > NullBuf->Size)
+	{
+		NullError(Function, "uploading " + std::to_string(Size) + " bytes to a buffer of " + std::to_string(NullBuf->Size) + " bytes");
+		return;
+	}
+
+	WriteNullBuffer(NullBuf, Data, Size);
+	NullCount(GNullCounters.BytesUploaded, Size);
+}
+
+void ResizeNullBuffer(void* Buffer, NullObjectType Type, uint64_t NewSize, const char* Function)
+{
+	if (NullBuffer* NullBuf = GetNullObject<NullBuffer>(Buffer, Type, Function))
+		NullBuf->Size = NewSize;
+}
+
+void DestroyNullBuffer(void* Buffer, NullObjectType Type, const char* Function)
+{
+	delete ReleaseNullObject<NullBuffer>(Buffer, Type, Function);
+}
+
+NullTexture* CreateNullTexture(llrm::AttachmentFormat Format, uint32_t Width, uint32_t Height, uint64_t TextureFlags, uint32_t Layers, uint32_t MipLevels, const char* Function)
+{
+	if (Width == 0 || Height == 0 || Layers == 0)
+	{
+		NullError(Function, "textures need a width, height and layer count of at least one");
+		return nullptr;
+	}
+
+	NullTexture* Tex = new NullTexture;
+	Tex->Format = Format;
+	Tex->Width = Width;
+	Tex->Height = Height;
+	Tex->Layers = Layers;
+	Tex->MipLevels = MipLevels == 0 ? llrm::CalcMipLevels(Width, Height) : MipLevels;
+	Tex->Flags = TextureFlags;
+
+	return RegisterNullObject(Tex, NullObjectType::Texture);
+}
+
+void ReleaseNullResourceLayout(NullResourceLayout* Layout)
+{
+	if (Layout && --Layout->References == 0)
+		delete Layout;
+}
+
+NullResourceSet* CreateNullResourceSet(NullResourceLayout* Layout, bool bTransient)
+{
+	Layout->References++;
+	return RegisterNullObject(new NullResourceSet{ Layout, bTransient }, NullObjectType::ResourceSet);
+}
+
+void DestroyNullResourceSet(NullResourceSet* Set)
+{
+	UnregisterNullObject(Set);
+	ReleaseNullResourceLayout(Set->Layout);
+	delete Set;
+}
+
+void ResetNullTransientFrame(uint32_t Frame)
+{
+	for (NullResourceSet* Set : GNullContext.TransientSets[Frame])
+		DestroyNullResourceSet(Set);
+	GNullContext.TransientSets[Frame].clear();
+}
+
+void ResizeNullSwapChain(NullSwapChain* Swap, int32_t DesiredWidth, int32_t DesiredHeight)
+{
+	Swap->Width = static_cast<uint32_t>(std::max(DesiredWidth, 1));
+	Swap->Height = static_cast<uint32_t>(std::max(DesiredHeight, 1));
+
+	for (NullTexture& Image : Swap->Images)
+	{
+		Image.Width = Swap->Width;
+		Image.Height = Swap->Height;
+	}
+}
+
+namespace llrm
+{
+	NullStats GetNullStats()
+	{
+		NullStats Stats;
+		Stats.Calls = GNullCounters.Calls.load(std::memory_order_relaxed);
+		Stats.Commands = GNullCounters.Commands.load(std::memory_order_relaxed);
+		Stats.Draws = GNullCounters.Draws.load(std::memory_order_relaxed);
+		Stats.Vertices = GNullCounters.Vertices.load(std::memory_order_relaxed);
+		Stats.Dispatches = GNullCounters.Dispatches.load(std::memory_order_relaxed);
+		Stats.BytesUploaded = GNullCounters.BytesUploaded.load(std::memory_order_relaxed);
+		Stats.Submits = GNullCounters.Submits.load(std::memory_order_relaxed);
+		Stats.Frames = GNullCounters.Frames.load(std::memory_order_relaxed);
+		Stats.ValidationErrors = GNullCounters.ValidationErrors.load(std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> Lock(GNullObjects.Lock);
+		Stats.LiveObjects = static_cast<uint32_t>(GNullObjects.Objects.size());
+
+		return Stats;
+	}
+
+	void ResetNullStats()
+	{
+		for (std::atomic<uint64_t>* Counter : { &GNullCounters.Calls, &GNullCounters.Commands, &GNullCounters.Draws, &GNullCounters.Vertices,
+			&GNullCounters.Dispatches, &GNullCounters.BytesUploaded, &GNullCounters.Submits, &GNullCounters.Frames, &GNullCounters.ValidationErrors })
+		{
+			Counter->store(0, std::memory_order_relaxed);
+		}
+	}
+
+	llrm::Context CreateContext(const ContextCreateInfo& ContextInfo)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullContext* Context = new NullContext;
+		Context->bHeadless = ContextInfo.bHeadless;
+		Context->FramesInFlight = std::max(ContextInfo.FramesInFlight, 1u);
+		Context->TransientSets.resize(Context->FramesInFlight);
+
+		GNullContext = *Context;
+
+		return Context;
+	}
+
+	void DestroyContext(Context Context)
+	{
+		NullCount(GNullCounters.Calls);
+
+		for (uint32_t Frame = 0; Frame < GNullContext.TransientSets.size(); Frame++)
+			ResetNullTransientFrame(Frame);
+
+		// Everything else should have been destroyed by the application
+		{
+			std::lock_guard<std::mutex> Lock(GNullObjects.Lock);
+			for (const auto& [Object, Type] : GNullObjects.Objects)
+			{
+				NullCount(GNullCounters.ValidationErrors);
+				std::cout << "[nullError]: DestroyContext: " << GetNullObjectTypeName(Type) << " " << Object << " was never destroyed" << std::endl;
+			}
+			GNullObjects.Objects.clear();
+		}
+
+		delete static_cast<NullContext*>(Context);
+	}
+
+	void SetContext(Context Context)
+	{
+		GNullContext = *static_cast<NullContext*>(Context);
+	}
+
+	Caps GetCaps()
+	{
+		NullCount(GNullCounters.Calls);
+
+		// Every optional feature is reported, so the paths that use them are measured too
+		Caps Result{};
+		Result.MaxImageArrayLayers = 2048;
+		Result.MaxTextureSize = 16384;
+		Result.bLazilyAllocatedMemory = false;
+		Result.bDynamicRendering = true;
+		Result.bConditionalRendering = true;
+		Result.bTextureCompressionBC = true;
+		Result.bTextureCompressionETC2 = true;
+		Result.bTextureCompressionASTC = true;
+
+		for (uint32_t Format = static_cast<uint32_t>(AttachmentFormat::BC1_RGBA_UNORM); Format <= static_cast<uint32_t>(AttachmentFormat::ASTC_8x8_SRGB); Format++)
+			Result.CompressedFormats.push_back(static_cast<AttachmentFormat>(Format));
+
+		Result.bPackedSNormVertexFormat = true;
+		Result.bSynchronization2 = true;
+
+		return Result;
+	}
+
+	DeviceInfo GetDeviceInfo()
+	{
+		NullCount(GNullCounters.Calls);
+
+		DeviceInfo Info;
+		Info.Name = "Null Device";
+		Info.Type = DeviceType::Cpu;
+		Info.bSuitable = true;
+
+		return Info;
+	}
+
+	std::vector<DeviceInfo> GetDeviceCandidates()
+	{
+		return { GetDeviceInfo() };
+	}
+
+	CacheStats GetCacheStats()
+	{
+		NullCount(GNullCounters.Calls);
+
+		// Nothing is shared, every creation makes a new object
+		return {};
+	}
+
+	Surface CreateSurface(GLFWwindow* Window)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateSurface);
+
+		if (GNullContext.bHeadless)
+		{
+			NullError(__func__, "surfaces can't be created by a headless context");
+			return nullptr;
+		}
+
+		// Surfaces have no state, any allocation works as a handle
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new uint8_t, NullObjectType::Surface));
+	}
+
+	void DestroySurface(Surface Surface)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroySurface, Surface);
+
+		delete ReleaseNullObject<uint8_t>(Surface, NullObjectType::Surface, __func__);
+	}
+
+	ShaderProgram CreateRasterProgram(const std::vector<uint32_t>& VertShader, const std::vector<uint32_t>& FragShader)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateRasterProgram, VertShader, FragShader);
+
+		if (VertShader.empty() || FragShader.empty())
+		{
+			NullError(__func__, "empty shader code");
+			return nullptr;
+		}
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullShaderProgram{ false }, NullObjectType::ShaderProgram));
+	}
+
+	ShaderProgram CreateComputeProgram(const std::vector<uint32_t>& ComputeShader)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateComputeProgram, ComputeShader);
+
+		if (ComputeShader.empty())
+		{
+			NullError(__func__, "empty shader code");
+			return nullptr;
+		}
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullShaderProgram{ true }, NullObjectType::ShaderProgram));
+	}
+
+	void ReleaseShaderModules(ShaderProgram Shader)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::ReleaseShaderModules, Shader);
+
+		if (NullShaderProgram* Program = GetNullObject<NullShaderProgram>(Shader, NullObjectType::ShaderProgram, __func__))
+			Program->bModulesReleased = true;
+	}
+
+	void DestroyProgram(ShaderProgram Shader)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyProgram, Shader);
+
+		delete ReleaseNullObject<NullShaderProgram>(Shader, NullObjectType::ShaderProgram, __func__);
+	}
+
+	SwapChain CreateSwapChain(Surface TargetSurface, int32_t DesiredWidth, int32_t DesiredHeight, const std::vector<PresentMode>& PresentModes)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateSwapChain, TargetSurface, DesiredWidth, DesiredHeight, PresentModes);
+
+		if (!ValidateNullHandle(TargetSurface, NullObjectType::Surface, __func__))
+			return nullptr;
+
+		// Triple buffered like most drivers, and the first preference is always available
+		NullSwapChain* Swap = new NullSwapChain;
+		Swap->PresentMode = PresentModes.empty() ? PresentMode::Fifo : PresentModes[0];
+		Swap->Images.resize(3);
+		Swap->ImageViews.resize(Swap->Images.size());
+
+		for (uint32_t Image = 0; Image < Swap->Images.size(); Image++)
+		{
+			Swap->Images[Image].Format = AttachmentFormat::B8G8R8A8_UNORM;
+			Swap->Images[Image].Flags = TEXTURE_USAGE_RT;
+			Swap->Images[Image].bSwapChainImage = true;
+			Swap->ImageViews[Image].Image = &Swap->Images[Image];
+
+			RegisterNullObject(&Swap->Images[Image], NullObjectType::Texture);
+			RegisterNullObject(&Swap->ImageViews[Image], NullObjectType::TextureView);
+		}
+
+		ResizeNullSwapChain(Swap, DesiredWidth, DesiredHeight);
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(Swap, NullObjectType::SwapChain));
+	}
+
+	void DestroySwapChain(SwapChain Swap)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroySwapChain, Swap);
+
+		NullSwapChain* NullSwap = ReleaseNullObject<NullSwapChain>(Swap, NullObjectType::SwapChain, __func__);
+		if (!NullSwap)
+			return;
+
+		for (uint32_t Image = 0; Image < NullSwap->Images.size(); Image++)
+		{
+			UnregisterNullObject(&NullSwap->Images[Image]);
+			UnregisterNullObject(&NullSwap->ImageViews[Image]);
+		}
+
+		delete NullSwap;
+	}
+
+	void RecreateSwapChain(SwapChain Swap, Surface Target, int32_t DesiredWidth, int32_t DesiredHeight)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::RecreateSwapChain, Swap, DesiredWidth, DesiredHeight);
+
+		// Images are resized in place, so their handles stay valid
+		if (NullSwapChain* NullSwap = GetNullObject<NullSwapChain>(Swap, NullObjectType::SwapChain, __func__))
+			ResizeNullSwapChain(NullSwap, DesiredWidth, DesiredHeight);
+	}
+
+	void GetSwapChainSize(SwapChain Swap, uint32_t& Width, uint32_t& Height)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullSwapChain* NullSwap = GetNullObject<NullSwapChain>(Swap, NullObjectType::SwapChain, __func__);
+		Width = NullSwap ? NullSwap->Width : 0;
+		Height = NullSwap ? NullSwap->Height : 0;
+	}
+
+	uint32_t GetSwapChainImageCount(SwapChain Swap)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullSwapChain* NullSwap = GetNullObject<NullSwapChain>(Swap, NullObjectType::SwapChain, __func__);
+		return NullSwap ? static_cast<uint32_t>(NullSwap->Images.size()) : 0;
+	}
+
+	PresentMode GetSwapChainPresentMode(SwapChain Swap)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullSwapChain* NullSwap = GetNullObject<NullSwapChain>(Swap, NullObjectType::SwapChain, __func__);
+		return NullSwap ? NullSwap->PresentMode : PresentMode::Fifo;
+	}
+
+	uint32_t GetFramesInFlight()
+	{
+		return GNullContext.FramesInFlight;
+	}
+
+	Texture GetSwapChainImage(SwapChain Swap, uint32_t Index)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullSwapChain* NullSwap = GetNullObject<NullSwapChain>(Swap, NullObjectType::SwapChain, __func__);
+		if (!NullSwap || Index >= NullSwap->Images.size())
+		{
+			if (NullSwap)
+				NullError(__func__, "swap chain image index out of range");
+			return nullptr;
+		}
+
+		LLRM_CAPTURE_CALL(CaptureOp::GetSwapChainImage, Swap, Index, NullSwap->Width, NullSwap->Height, NullSwap->Images[Index].Format);
+
+		return LLRM_CAPTURE_RESULT(&NullSwap->Images[Index]);
+	}
+
+	TextureView GetSwapChainImageView(SwapChain Swap, uint32_t Index)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullSwapChain* NullSwap = GetNullObject<NullSwapChain>(Swap, NullObjectType::SwapChain, __func__);
+		if (!NullSwap || Index >= NullSwap->ImageViews.size())
+		{
+			if (NullSwap)
+				NullError(__func__, "swap chain image index out of range");
+			return nullptr;
+		}
+
+		LLRM_CAPTURE_CALL(CaptureOp::GetSwapChainImageView, Swap, Index, NullSwap->Width, NullSwap->Height, NullSwap->Images[Index].Format);
+
+		return LLRM_CAPTURE_RESULT(&NullSwap->ImageViews[Index]);
+	}
+
+	ResourceLayout CreateResourceLayout(const ResourceLayoutCreateInfo& CreateInfo)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateResourceLayout, CreateInfo);
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullResourceLayout{ CreateInfo }, NullObjectType::ResourceLayout));
+	}
+
+	void DestroyResourceLayout(ResourceLayout Layout)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyResourceLayout, Layout);
+
+		ReleaseNullResourceLayout(ReleaseNullObject<NullResourceLayout>(Layout, NullObjectType::ResourceLayout, __func__));
+	}
+
+	Pipeline CreatePipeline(const PipelineState& CreateInfo)
+	{
+		LLRM_TRACE_FUNCTION();
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreatePipeline, CreateInfo);
+
+		NullShaderProgram* Program = GetNullObject<NullShaderProgram>(CreateInfo.Shader, NullObjectType::ShaderProgram, __func__);
+		if (!Program)
+			return nullptr;
+
+		if (Program->bCompute || Program->bModulesReleased)
+		{
+			NullError(__func__, Program->bCompute ? "the shader program is a compute program" : "the shader program's modules were released");
+			return nullptr;
+		}
+
+		if (CreateInfo.CompatibleGraph)
+		{
+			NullRenderGraph* Graph = GetNullObject<NullRenderGraph>(CreateInfo.CompatibleGraph, NullObjectType::RenderGraph, __func__);
+			if (!Graph)
+				return nullptr;
+
+			if (CreateInfo.PassIndex >= Graph->PassCount)
+			{
+				NullError(__func__, "pass index " + std::to_string(CreateInfo.PassIndex) + " is outside of the render graph");
+				return nullptr;
+			}
+		}
+		else if (CreateInfo.AttachmentFormats.empty())
+		{
+			NullError(__func__, "pipelines need either a compatible render graph or attachment formats");
+			return nullptr;
+		}
+
+		for (ResourceLayout Layout : CreateInfo.Layouts)
+		{
+			if (!ValidateNullHandle(Layout, NullObjectType::ResourceLayout, __func__))
+				return nullptr;
+		}
+
+		for (const std::pair<VertexAttributeFormat, uint32_t>& Attribute : CreateInfo.VertexAttributes)
+		{
+			uint32_t Size = GetVertexFormatSizeBytes(Attribute.first);
+			if (Size == 0 || Attribute.second + Size > CreateInfo.VertexBufferStride)
+			{
+				NullError(__func__, "a vertex attribute at offset " + std::to_string(Attribute.second) + " doesn't fit in the vertex stride");
+				return nullptr;
+			}
+		}
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullPipeline{ false }, NullObjectType::Pipeline));
+	}
+
+	Pipeline CreateComputePipeline(const ComputePipelineState& CreateInfo)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateComputePipeline, CreateInfo);
+
+		NullShaderProgram* Program = GetNullObject<NullShaderProgram>(CreateInfo.Shader, NullObjectType::ShaderProgram, __func__);
+		if (!Program)
+			return nullptr;
+
+		if (!Program->bCompute || Program->bModulesReleased)
+		{
+			NullError(__func__, !Program->bCompute ? "the shader program isn't a compute program" : "the shader program's modules were released");
+			return nullptr;
+		}
+
+		for (ResourceLayout Layout : CreateInfo.Layouts)
+		{
+			if (!ValidateNullHandle(Layout, NullObjectType::ResourceLayout, __func__))
+				return nullptr;
+		}
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullPipeline{ true }, NullObjectType::Pipeline));
+	}
+
+	void DestroyPipeline(Pipeline Pipeline)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyPipeline, Pipeline);
+
+		delete ReleaseNullObject<NullPipeline>(Pipeline, NullObjectType::Pipeline, __func__);
+	}
+
+	RenderGraph CreateRenderGraph(const RenderGraphCreateInfo& CreateInfo)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateRenderGraph, CreateInfo);
+
+		if (CreateInfo.Passes.empty())
+		{
+			NullError(__func__, "render graphs need at least one pass");
+			return nullptr;
+		}
+
+		for (const RenderPassInfo& Pass : CreateInfo.Passes)
+		{
+			for (const std::vector<int32_t>* Attachments : { &Pass.OutputAttachments, &Pass.InputAttachments })
+			{
+				for (int32_t Attachment : *Attachments)
+				{
+					if (Attachment < 0 || Attachment >= static_cast<int32_t>(CreateInfo.Attachments.size()))
+					{
+						NullError(__func__, "pass refers to attachment " + std::to_string(Attachment) + " which doesn't exist");
+						return nullptr;
+					}
+				}
+			}
+		}
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullRenderGraph{ static_cast<uint32_t>(CreateInfo.Passes.size()) }, NullObjectType::RenderGraph));
+	}
+
+	void DestroyRenderGraph(RenderGraph Graph)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyRenderGraph, Graph);
+
+		delete ReleaseNullObject<NullRenderGraph>(Graph, NullObjectType::RenderGraph, __func__);
+	}
+
+	FrameBuffer CreateFrameBuffer(const FrameBufferCreateInfo& CreateInfo)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateFrameBuffer, CreateInfo);
+
+		if (!ValidateNullHandle(CreateInfo.Target, NullObjectType::RenderGraph, __func__))
+			return nullptr;
+
+		for (TextureView Attachment : CreateInfo.Attachments)
+		{
+			if (!ValidateNullHandle(Attachment, NullObjectType::TextureView, __func__))
+				return nullptr;
+		}
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullFrameBuffer{ CreateInfo.Width, CreateInfo.Height }, NullObjectType::FrameBuffer));
+	}
+
+	void DestroyFrameBuffer(FrameBuffer FrameBuffer)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyFrameBuffer, FrameBuffer);
+
+		delete ReleaseNullObject<NullFrameBuffer>(FrameBuffer, NullObjectType::FrameBuffer, __func__);
+	}
+
+	void GetFrameBufferSize(FrameBuffer Fbo, uint32_t& Width, uint32_t& Height)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullFrameBuffer* NullFbo = GetNullObject<NullFrameBuffer>(Fbo, NullObjectType::FrameBuffer, __func__);
+		Width = NullFbo ? NullFbo->Width : 0;
+		Height = NullFbo ? NullFbo->Height : 0;
+	}
+
+	VertexBuffer CreateVertexBuffer(uint64_t Size, const void* Data)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateVertexBuffer, Size, CaptureBlob{ Data, Size });
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(CreateNullBuffer(Size, Data, 0), NullObjectType::VertexBuffer));
+	}
+
+	IndexBuffer CreateIndexBuffer(uint64_t Size, const void* Data)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateIndexBuffer, Size, CaptureBlob{ Data, Size });
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(CreateNullBuffer(Size, Data, 0), NullObjectType::IndexBuffer));
+	}
+
+	StorageBuffer CreateStorageBuffer(uint64_t Size, const void* Data, uint64_t BufferFlags)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateStorageBuffer, Size, CaptureBlob{ Data, Size }, BufferFlags);
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(CreateNullBuffer(Size, Data, BufferFlags), NullObjectType::StorageBuffer));
+	}
+
+	TexelBufferView CreateTexelBufferView(StorageBuffer Buffer, AttachmentFormat Format, uint64_t Offset, uint64_t Range)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateTexelBufferView, Buffer, Format, Offset, Range);
+
+		NullBuffer* NullBuf = GetNullObject<NullBuffer>(Buffer, NullObjectType::StorageBuffer, __func__);
+		if (!NullBuf)
+			return nullptr;
+
+		if (Offset >= NullBuf->Size || (Range != ~0ull && Offset + Range > NullBuf->Size))
+		{
+			NullError(__func__, "the view is outside of the buffer");
+			return nullptr;
+		}
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullTexelBufferView{ NullBuf }, NullObjectType::TexelBufferView));
+	}
+
+	void DestroyVertexBuffer(VertexBuffer VertexBuffer)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyVertexBuffer, VertexBuffer);
+
+		DestroyNullBuffer(VertexBuffer, NullObjectType::VertexBuffer, __func__);
+	}
+
+	void DestroyIndexBuffer(IndexBuffer IndexBuffer)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyIndexBuffer, IndexBuffer);
+
+		DestroyNullBuffer(IndexBuffer, NullObjectType::IndexBuffer, __func__);
+	}
+
+	void DestroyStorageBuffer(StorageBuffer StorageBuffer)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyStorageBuffer, StorageBuffer);
+
+		DestroyNullBuffer(StorageBuffer, NullObjectType::StorageBuffer, __func__);
+	}
+
+	void DestroyTexelBufferView(TexelBufferView View)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyTexelBufferView, View);
+
+		delete ReleaseNullObject<NullTexelBufferView>(View, NullObjectType::TexelBufferView, __func__);
+	}
+
+	void UploadVertexBufferData(VertexBuffer Buffer, const void* Data, uint64_t Size)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UploadVertexBufferData, Buffer, CaptureBlob{ Data, Size });
+
+		UploadNullBuffer(Buffer, NullObjectType::VertexBuffer, Data, Size, __func__);
+	}
+
+	void UploadIndexBufferData(IndexBuffer Buffer, const uint32_t* Data, uint64_t Size)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UploadIndexBufferData, Buffer, CaptureBlob{ Data, Size });
+
+		UploadNullBuffer(Buffer, NullObjectType::IndexBuffer, Data, Size, __func__);
+	}
+
+	void UploadStorageBufferData(StorageBuffer Buffer, const void* Data, uint64_t Size)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UploadStorageBufferData, Buffer, CaptureBlob{ Data, Size });
+
+		UploadNullBuffer(Buffer, NullObjectType::StorageBuffer, Data, Size, __func__);
+	}
+
+	void* MapStorageBuffer(StorageBuffer Buffer)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullBuffer* NullBuf = GetNullObject<NullBuffer>(Buffer, NullObjectType::StorageBuffer, __func__);
+		if (!NullBuf)
+			return nullptr;
+
+		if (NullBuf->Memory.empty())
+		{
+			NullError(__func__, "only BUFFER_HOST_WRITE buffers can be mapped");
+			return nullptr;
+		}
+
+		LLRM_CAPTURE_CALL(CaptureOp::MapStorageBuffer, Buffer, NullBuf->Size);
+
+		uint64_t Slice = NullBuf->Flags & BUFFER_PER_FRAME ? GNullContext.CurrentFrame : 0;
+		return LLRM_CAPTURE_RESULT(static_cast<void*>(NullBuf->Memory.data() + Slice * NullBuf->SliceSize));
+	}
+
+	void ResizeVertexBuffer(VertexBuffer Buffer, uint64_t NewSize)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::ResizeVertexBuffer, Buffer, NewSize);
+
+		ResizeNullBuffer(Buffer, NullObjectType::VertexBuffer, NewSize, __func__);
+	}
+
+	void ResizeIndexBuffer(IndexBuffer Buffer, uint64_t NewSize)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::ResizeIndexBuffer, Buffer, NewSize);
+
+		ResizeNullBuffer(Buffer, NullObjectType::IndexBuffer, NewSize, __func__);
+	}
+
+	CommandBuffer CreateCommandBuffer(bool bOneTimeUse)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateCommandBuffer, bOneTimeUse);
+
+		NullCommandBuffer* NullCmd = new NullCommandBuffer;
+		NullCmd->bOneTimeUse = bOneTimeUse;
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(NullCmd, NullObjectType::CommandBuffer));
+	}
+
+	void DestroyCommandBuffer(CommandBuffer CmdBuffer)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyCommandBuffer, CmdBuffer);
+
+		delete ReleaseNullObject<NullCommandBuffer>(CmdBuffer, NullObjectType::CommandBuffer, __func__);
+	}
+
+	ResourceSet CreateResourceSet(const ResourceSetCreateInfo& CreateInfo)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateResourceSet, CreateInfo);
+
+		NullResourceLayout* Layout = GetNullObject<NullResourceLayout>(CreateInfo.Layout, NullObjectType::ResourceLayout, __func__);
+		if (!Layout)
+			return nullptr;
+
+		return LLRM_CAPTURE_RESULT(CreateNullResourceSet(Layout, false));
+	}
+
+	ResourceSet CreateTransientResourceSet(const ResourceSetCreateInfo& CreateInfo)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateTransientResourceSet, CreateInfo);
+
+		if (!GNullContext.bInsideFrame)
+		{
+			NullError(__func__, "transient resource sets can only be created between BeginFrame and EndFrame");
+			return nullptr;
+		}
+
+		NullResourceLayout* Layout = GetNullObject<NullResourceLayout>(CreateInfo.Layout, NullObjectType::ResourceLayout, __func__);
+		if (!Layout)
+			return nullptr;
+
+		NullResourceSet* Set = CreateNullResourceSet(Layout, true);
+		GNullContext.TransientSets[GNullContext.CurrentFrame].push_back(Set);
+
+		return LLRM_CAPTURE_RESULT(Set);
+	}
+
+	void DestroyResourceSet(ResourceSet Resources)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyResourceSet, Resources);
+
+		NullResourceSet* Set = GetNullObject<NullResourceSet>(Resources, NullObjectType::ResourceSet, __func__);
+		if (!Set)
+			return;
+
+		if (Set->bTransient)
+		{
+			NullError(__func__, "transient resource sets are freed with their frame and can't be destroyed");
+			return;
+		}
+
+		DestroyNullResourceSet(Set);
+	}
+
+	Texture CreateTexture(AttachmentFormat Format, AttachmentUsage InitialUsage, uint32_t Width, uint32_t Height, uint64_t Flags, uint32_t Layers, uint64_t ImageSize, void* Data, uint32_t MipLevels)
+	{
+		NullCount(GNullCounters.Calls);
+
+		if (ImageSize == 0)
+			ImageSize = CalcTextureSizeBytes(Format, Width, Height) * Layers;
+
+		LLRM_CAPTURE_CALL(CaptureOp::CreateTexture, Format, InitialUsage, Width, Height, Flags, Layers, CaptureBlob{ Data, ImageSize }, MipLevels);
+
+		NullTexture* Tex = CreateNullTexture(Format, Width, Height, Flags, Layers, MipLevels, __func__);
+		if (Tex && Data)
+			NullCount(GNullCounters.BytesUploaded, ImageSize);
+
+		return LLRM_CAPTURE_RESULT(Tex);
+	}
+
+	TextureView CreateTextureView(Texture Image, uint8_t Flags, TextureViewType ViewType, uint32_t BaseArrayLayer, uint32_t LayerCount, uint32_t BaseMip, uint32_t MipCount)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateTextureView, Image, Flags, ViewType, BaseArrayLayer, LayerCount, BaseMip, MipCount);
+
+		NullTexture* Tex = GetNullObject<NullTexture>(Image, NullObjectType::Texture, __func__);
+		if (!Tex)
+			return nullptr;
+
+		uint32_t ViewLayers = LayerCount == ARRAY_LAYERS_REMAINING ? Tex->Layers - std::min(BaseArrayLayer, Tex->Layers) : LayerCount;
+		if (BaseArrayLayer + ViewLayers > Tex->Layers || BaseMip >= Tex->MipLevels || (MipCount != MIP_LEVELS_REMAINING && BaseMip + MipCount > Tex->MipLevels))
+		{
+			NullError(__func__, "the view is outside of the texture's layers or mip levels");
+			return nullptr;
+		}
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullTextureView{ Tex }, NullObjectType::TextureView));
+	}
+
+	void DestroyTexture(Texture Image)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyTexture, Image);
+
+		NullTexture* Tex = GetNullObject<NullTexture>(Image, NullObjectType::Texture, __func__);
+		if (!Tex)
+			return;
+
+		if (Tex->bSwapChainImage)
+		{
+			NullError(__func__, "swap chain images are destroyed with their swap chain");
+			return;
+		}
+
+		UnregisterNullObject(Tex);
+		delete Tex;
+	}
+
+	void DestroyTextureView(TextureView ImageView)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyTextureView, ImageView);
+
+		NullTextureView* View = GetNullObject<NullTextureView>(ImageView, NullObjectType::TextureView, __func__);
+		if (!View)
+			return;
+
+		if (View->Image->bSwapChainImage)
+		{
+			NullError(__func__, "swap chain image views are destroyed with their swap chain");
+			return;
+		}
+
+		UnregisterNullObject(View);
+		delete View;
+	}
+
+	AttachmentFormat GetTextureFormat(Texture Tex)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullTexture* NullTex = GetNullObject<NullTexture>(Tex, NullObjectType::Texture, __func__);
+		return NullTex ? NullTex->Format : AttachmentFormat::B8G8R8A8_UNORM;
+	}
+
+	uint32_t GetTextureMipLevels(Texture Tex)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullTexture* NullTex = GetNullObject<NullTexture>(Tex, NullObjectType::Texture, __func__);
+		return NullTex ? NullTex->MipLevels : 0;
+	}
+
+	void WriteTexture(Texture Tex, AttachmentUsage PreviousUsage, AttachmentUsage FinalUsage, uint32_t Width, uint32_t Height, uint32_t Layer, uint64_t ImageSize, void* Data, uint32_t MipLevel, uint32_t RowPitch)
+	{
+		NullCount(GNullCounters.Calls);
+
+		NullTexture* NullTex = GetNullObject<NullTexture>(Tex, NullObjectType::Texture, __func__);
+		if (!NullTex)
+			return;
+
+		uint32_t BlockWidth, BlockHeight;
+		GetFormatBlockExtent(NullTex->Format, BlockWidth, BlockHeight);
+
+		if (ImageSize == 0)
+			ImageSize = RowPitch ? static_cast<uint64_t>(RowPitch) * ((Height + BlockHeight - 1) / BlockHeight) : CalcTextureSizeBytes(NullTex->Format, Width, Height);
+
+		LLRM_CAPTURE_CALL(CaptureOp::WriteTexture, Tex, Layer, MipLevel, PreviousUsage, FinalUsage, Width, Height, RowPitch, CaptureBlob{ Data, ImageSize });
+
+		if (Layer >= NullTex->Layers || MipLevel >= NullTex->MipLevels)
+		{
+			NullError(__func__, "the layer or mip level is outside of the texture");
+			return;
+		}
+
+		if (RowPitch > 0 && (RowPitch % GetFormatBlockSizeBytes(NullTex->Format) != 0 || RowPitch < CalcRowPitchBytes(NullTex->Format, Width)))
+		{
+			NullError(__func__, "the row pitch must be a whole number of blocks and at least as long as a row of the image");
+			return;
+		}
+
+		NullCount(GNullCounters.BytesUploaded, ImageSize);
+	}
+
+	void ReadTexture(Texture Tex, void* Dst, uint64_t BufferSize, AttachmentUsage PreviousUsage)
+	{
+		NullCount(GNullCounters.Calls);
+
+		if (!ValidateNullHandle(Tex, NullObjectType::Texture, __func__))
+			return;
+
+		// Nothing was ever rendered
+		if (Dst)
+			memset(Dst, 0, BufferSize);
+	}
+
+	Sampler CreateSampler(const SamplerCreateInfo& CreateInfo)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateSampler, CreateInfo);
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullSampler{ CreateInfo }, NullObjectType::Sampler));
+	}
+
+	void DestroySampler(Sampler Samp)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroySampler, Samp);
+
+		delete ReleaseNullObject<NullSampler>(Samp, NullObjectType::Sampler, __func__);
+	}
+
+	MemoryRequirements GetTextureMemoryRequirements(AttachmentFormat Format, uint32_t Width, uint32_t Height, uint64_t TextureFlags, uint32_t Layers)
+	{
+		NullCount(GNullCounters.Calls);
+
+		MemoryRequirements Requirements;
+		Requirements.Size = AlignNullSize(CalcTextureSizeBytes(Format, Width, Height) * Layers);
+		Requirements.Alignment = NULL_MEMORY_ALIGNMENT;
+		Requirements.MemoryTypeBits = 1;
+
+		return Requirements;
+	}
+
+	DeviceMemory AllocateDeviceMemory(const MemoryRequirements& Requirements)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::AllocateDeviceMemory, Requirements);
+
+		if (Requirements.Size == 0)
+		{
+			NullError(__func__, "allocating zero bytes");
+			return nullptr;
+		}
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullDeviceMemory{ Requirements.Size }, NullObjectType::DeviceMemory));
+	}
+
+	Texture CreateAliasedTexture(AttachmentFormat Format, uint32_t Width, uint32_t Height, uint64_t Flags, uint32_t Layers, DeviceMemory Memory, uint64_t Offset)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateAliasedTexture, Format, Width, Height, Flags, Layers, Memory, Offset);
+
+		NullDeviceMemory* NullMemory = GetNullObject<NullDeviceMemory>(Memory, NullObjectType::DeviceMemory, __func__);
+		if (!NullMemory)
+			return nullptr;
+
+		uint64_t Size = AlignNullSize(CalcTextureSizeBytes(Format, Width, Height) * Layers);
+		if (Offset % NULL_MEMORY_ALIGNMENT != 0 || Offset + Size > NullMemory->Size)
+		{
+			NullError(__func__, "the texture doesn't fit in the memory at offset " + std::to_string(Offset));
+			return nullptr;
+		}
+
+		return LLRM_CAPTURE_RESULT(CreateNullTexture(Format, Width, Height, Flags, Layers, 1, __func__));
+	}
+
+	void FreeDeviceMemory(DeviceMemory Memory)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::FreeDeviceMemory, Memory);
+
+		delete ReleaseNullObject<NullDeviceMemory>(Memory, NullObjectType::DeviceMemory, __func__);
+	}
+
+	void UpdateUniformBuffer(ResourceSet Resources, uint32_t BufferIndex, void* Data, uint64_t DataSize, bool Dynamic)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateUniformBuffer, Resources, BufferIndex, Dynamic, CaptureBlob{ Data, DataSize });
+
+		NullResourceSet* Set = GetUpdatedResourceSet(Resources, __func__);
+		if (!Set)
+			return;
+
+		const std::vector<ConstantBufferDescription>& ConstantBuffers = Set->Layout->Info.ConstantBuffers;
+		if (BufferIndex >= ConstantBuffers.size())
+		{
+			NullError(__func__, "the resource layout has no constant buffer " + std::to_string(BufferIndex));
+			return;
+		}
+		if (DataSize > ConstantBuffers[BufferIndex].BufferSize)
+		{
+			NullError(__func__, "writing " + std::to_string(DataSize) + " bytes to a constant buffer of " + std::to_string(ConstantBuffers[BufferIndex].BufferSize) + " bytes");
+			return;
+		}
+
+		NullCount(GNullCounters.BytesUploaded, DataSize);
+	}
+
+	void UpdateTextureResource(ResourceSet Resources, std::vector<TextureView> Images, uint32_t Binding)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateTextureResource, Resources, Binding, Images);
+
+		NullResourceSet* Set = GetUpdatedResourceSet(Resources, __func__);
+		if (!Set || !ValidateNullBinding(Binding, HasNullBinding(Set->Layout->Info.Textures, Binding), __func__))
+			return;
+
+		for (TextureView Image : Images)
+		{
+			if (!ValidateNullHandle(Image, NullObjectType::TextureView, __func__))
+				return;
+		}
+	}
+
+	void UpdateSamplerResource(ResourceSet Resources, Sampler Samp, uint32_t Binding)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateSamplerResource, Resources, Binding, Samp);
+
+		NullResourceSet* Set = GetUpdatedResourceSet(Resources, __func__);
+		if (Set && ValidateNullBinding(Binding, HasNullBinding(Set->Layout->Info.Samplers, Binding), __func__))
+			ValidateNullHandle(Samp, NullObjectType::Sampler, __func__);
+	}
+
+	void UpdateInputAttachmentResource(ResourceSet Resources, TextureView Attachment, uint32_t Binding)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateInputAttachmentResource, Resources, Binding, Attachment);
+
+		NullResourceSet* Set = GetUpdatedResourceSet(Resources, __func__);
+		if (Set && ValidateNullBinding(Binding, HasNullBinding(Set->Layout->Info.InputAttachments, Binding), __func__))
+			ValidateNullHandle(Attachment, NullObjectType::TextureView, __func__);
+	}
+
+	void UpdateStorageBufferResource(ResourceSet Resources, StorageBuffer Buffer, uint32_t Binding)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateStorageBufferResource, Resources, Binding, Buffer);
+
+		NullResourceSet* Set = GetUpdatedResourceSet(Resources, __func__);
+		if (Set && ValidateNullBinding(Binding, HasNullBinding(Set->Layout->Info.StorageBuffers, Binding), __func__))
+			ValidateNullHandle(Buffer, NullObjectType::StorageBuffer, __func__);
+	}
+
+	void UpdateStorageImageResource(ResourceSet Resources, TextureView Image, uint32_t Binding)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateStorageImageResource, Resources, Binding, Image);
+
+		NullResourceSet* Set = GetUpdatedResourceSet(Resources, __func__);
+		if (Set && ValidateNullBinding(Binding, HasNullBinding(Set->Layout->Info.StorageImages, Binding), __func__))
+			ValidateNullHandle(Image, NullObjectType::TextureView, __func__);
+	}
+
+	void UpdateTexelBufferResource(ResourceSet Resources, TexelBufferView View, uint32_t Binding)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateTexelBufferResource, Resources, Binding, View);
+
+		NullResourceSet* Set = GetUpdatedResourceSet(Resources, __func__);
+		if (!Set)
+			return;
+
+		bool bHasBinding = HasNullBinding(Set->Layout->Info.UniformTexelBuffers, Binding) || HasNullBinding(Set->Layout->Info.StorageTexelBuffers, Binding);
+		if (ValidateNullBinding(Binding, bHasBinding, __func__))
+			ValidateNullHandle(View, NullObjectType::TexelBufferView, __func__);
+	}
+
+	void UpdateDynamicBufferResource(ResourceSet Resources, StorageBuffer Buffer, uint32_t Binding, uint64_t Range)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateDynamicBufferResource, Resources, Binding, Buffer, Range);
+
+		NullResourceSet* Set = GetUpdatedResourceSet(Resources, __func__);
+		if (!Set)
+			return;
+
+		bool bHasBinding = HasNullBinding(Set->Layout->Info.DynamicUniformBuffers, Binding) || HasNullBinding(Set->Layout->Info.DynamicStorageBuffers, Binding);
+		if (!ValidateNullBinding(Binding, bHasBinding, __func__))
+			return;
+
+		NullBuffer* NullBuf = GetNullObject<NullBuffer>(Buffer, NullObjectType::StorageBuffer, __func__);
+		if (NullBuf && Range > NullBuf->Size)
+			NullError(__func__, "the range is larger than the buffer");
+	}
+
+	void BeginFrames(std::vector<SwapChainFrame>& Frames)
+	{
+		LLRM_TRACE_FUNCTION();
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::BeginFrames, Frames);
+
+		if (GNullContext.bInsideFrame)
+			NullError(__func__, "the previous frame wasn't ended");
+
+		GNullContext.bInsideFrame = true;
+
+		ResetNullTransientFrame(GNullContext.CurrentFrame);
+
+		for (SwapChainFrame& Frame : Frames)
+		{
+			NullSwapChain* NullSwap = Frame.Swap ? GetNullObject<NullSwapChain>(Frame.Swap, NullObjectType::SwapChain, __func__) : nullptr;
+			if (NullSwap)
+			{
+				Frame.ImageIndex = static_cast<int32_t>(NullSwap->NextImage);
+				NullSwap->NextImage = (NullSwap->NextImage + 1) % NullSwap->Images.size();
+			}
+			else
+				Frame.ImageIndex = Frame.Swap ? -1 : 0; // Offscreen work is always submitted
+		}
+
+		// Nothing can be rendered this frame, so it isn't begun and the caller won't end it
+		if (std::none_of(Frames.begin(), Frames.end(), [](const SwapChainFrame& Frame) { return Frame.ImageIndex >= 0; }))
+		{
+			GNullContext.bInsideFrame = false;
+			GNullContext.BegunFrames.clear();
+		}
+	}
+
+	int32_t BeginFrame(GLFWwindow* Window, llrm::SwapChain Swap, llrm::Surface Target)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::BeginFrame, Swap);
+
+		GNullContext.BegunFrames.assign(1, SwapChainFrame{ Window, Swap, Target });
+		BeginFrames(GNullContext.BegunFrames);
+
+		return GNullContext.BegunFrames.empty() ? -1 : GNullContext.BegunFrames[0].ImageIndex;
+	}
+
+	int32_t BeginFrame()
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::BeginFrameOffscreen);
+
+		GNullContext.BegunFrames.assign(1, SwapChainFrame{});
+		BeginFrames(GNullContext.BegunFrames);
+
+		return static_cast<int32_t>(GNullContext.CurrentFrame);
+	}
+
+	void EndFrames(const std::vector<SwapChainFrame>& Frames)
+	{
+		LLRM_TRACE_FUNCTION();
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::EndFrames, Frames);
+
+		if (!GNullContext.bInsideFrame)
+			NullError(__func__, "no frame was begun");
+
+		GNullContext.bInsideFrame = false;
+
+		for (const SwapChainFrame& Frame : Frames)
+		{
+			// Windows that couldn't acquire an image aren't rendered to this frame
+			if (Frame.ImageIndex < 0)
+				continue;
+
+			for (CommandBuffer Buffer : Frame.CommandBuffers)
+			{
+				NullCommandBuffer* NullCmd = GetNullObject<NullCommandBuffer>(Buffer, NullObjectType::CommandBuffer, __func__);
+				if (NullCmd && NullCmd->State != NullCommandBufferState::Executable)
+					NullError(__func__, "submitting a command buffer that hasn't been ended");
+			}
+
+			NullCount(GNullCounters.Submits, Frame.CommandBuffers.size());
+		}
+
+		NullCount(GNullCounters.Frames);
+
+		// Advance the current frame
+		GNullContext.CurrentFrame = (GNullContext.CurrentFrame + 1) % GNullContext.FramesInFlight;
+	}
+
+	void EndFrame(const std::vector<CommandBuffer>& Buffers)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::EndFrame, Buffers);
+
+		std::vector<SwapChainFrame> Frames = std::move(GNullContext.BegunFrames);
+		GNullContext.BegunFrames.clear();
+
+		if (!Frames.empty())
+			Frames[0].CommandBuffers = Buffers;
+
+		EndFrames(Frames);
+	}
+
+	void SubmitCommandBuffer(CommandBuffer Buffer, bool bWait, Fence WaitFence)
+	{
+		LLRM_TRACE_FUNCTION();
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::SubmitCommandBuffer, Buffer, bWait);
+
+		NullCommandBuffer* NullCmd = GetNullObject<NullCommandBuffer>(Buffer, NullObjectType::CommandBuffer, __func__);
+		if (!NullCmd)
+			return;
+
+		if (NullCmd->State != NullCommandBufferState::Executable)
+		{
+			NullError(__func__, "submitting a command buffer that hasn't been ended");
+			return;
+		}
+
+		NullCount(GNullCounters.Submits);
+	}
+
+	void SubmitSwapCommandBuffer(SwapChain Target, CommandBuffer Buffer)
+	{
+		NullCount(GNullCounters.Calls);
+
+		if (ValidateNullHandle(Target, NullObjectType::SwapChain, __func__))
+			SubmitCommandBuffer(Buffer);
+	}
+
+	void Reset(CommandBuffer Buf)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::Reset, Buf);
+
+		if (NullCommandBuffer* NullCmd = GetNullObject<NullCommandBuffer>(Buf, NullObjectType::CommandBuffer, __func__))
+			*NullCmd = NullCommandBuffer{ NullCmd->bOneTimeUse };
+	}
+
+	void Begin(CommandBuffer Buf)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::Begin, Buf);
+
+		NullCommandBuffer* NullCmd = GetNullObject<NullCommandBuffer>(Buf, NullObjectType::CommandBuffer, __func__);
+		if (!NullCmd)
+			return;
+
+		if (NullCmd->State == NullCommandBufferState::Recording)
+		{
+			NullError(__func__, "the command buffer is already being recorded");
+			return;
+		}
+
+		// Beginning implicitly resets the command buffer
+		*NullCmd = NullCommandBuffer{ NullCmd->bOneTimeUse, NullCommandBufferState::Recording };
+	}
+
+	void End(CommandBuffer Buf)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::End, Buf);
+
+		NullCommandBuffer* NullCmd = GetNullObject<NullCommandBuffer>(Buf, NullObjectType::CommandBuffer, __func__);
+		if (!NullCmd)
+			return;
+
+		if (NullCmd->State != NullCommandBufferState::Recording)
+			NullError(__func__, "the command buffer isn't being recorded");
+		else if (NullCmd->bInsideGraph)
+			NullError(__func__, "a render graph is still being recorded");
+		else if (NullCmd->bConditional)
+			NullError(__func__, "conditional rendering wasn't ended");
+		else if (NullCmd->LabelDepth > 0)
+			NullError(__func__, std::to_string(NullCmd->LabelDepth) + " label(s) weren't ended");
+
+		NullCmd->State = NullCommandBufferState::Executable;
+	}
+
+	void TransitionTexture(CommandBuffer Buf, Texture Image, AttachmentUsage Old, AttachmentUsage New, uint32_t BaseLayer, uint32_t LayerCount, uint32_t BaseMip, uint32_t MipCount)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::TransitionTexture, Buf, Image, Old, New, BaseLayer, LayerCount, BaseMip, MipCount);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (NullCmd && ValidateGraphScope(NullCmd, false, __func__))
+			ValidateNullHandle(Image, NullObjectType::Texture, __func__);
+	}
+
+	void TransitionTextures(CommandBuffer Buf, std::span<const TextureTransition> Transitions)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::TransitionTextures, Buf, Transitions);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd || !ValidateGraphScope(NullCmd, false, __func__))
+			return;
+
+		for (const TextureTransition& Transition : Transitions)
+		{
+			if (!ValidateNullHandle(Transition.Image, NullObjectType::Texture, __func__))
+				return;
+		}
+	}
+
+	void GenerateMips(CommandBuffer Buf, Texture Tex, AttachmentUsage PreviousUsage, AttachmentUsage FinalUsage)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::GenerateMips, Buf, Tex, PreviousUsage, FinalUsage);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (NullCmd && ValidateGraphScope(NullCmd, false, __func__))
+			ValidateNullHandle(Tex, NullObjectType::Texture, __func__);
+	}
+
+	void BeginRenderGraph(CommandBuffer Buf, RenderGraph Graph, FrameBuffer Target, std::span<const ClearValue> ClearValues)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::BeginRenderGraph, Buf, Graph, Target, ClearValues);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd || !ValidateGraphScope(NullCmd, false, __func__))
+			return;
+
+		NullRenderGraph* NullGraph = GetNullObject<NullRenderGraph>(Graph, NullObjectType::RenderGraph, __func__);
+		if (!NullGraph || !ValidateNullHandle(Target, NullObjectType::FrameBuffer, __func__))
+			return;
+
+		NullCmd->bInsideGraph = true;
+		NullCmd->PassIndex = 0;
+		NullCmd->PassCount = NullGraph->PassCount;
+	}
+
+	void BeginRenderGraph(CommandBuffer Buf, const RenderingInfo& Info)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::BeginRendering, Buf, Info);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd || !ValidateGraphScope(NullCmd, false, __func__))
+			return;
+
+		for (const RenderingAttachment& Attachment : Info.ColorAttachments)
+		{
+			if (!ValidateNullHandle(Attachment.View, NullObjectType::TextureView, __func__))
+				return;
+		}
+		if (Info.DepthStencilAttachment.View && !ValidateNullHandle(Info.DepthStencilAttachment.View, NullObjectType::TextureView, __func__))
+			return;
+
+		NullCmd->bInsideGraph = true;
+		NullCmd->PassIndex = 0;
+		NullCmd->PassCount = 1;
+	}
+
+	void EndRenderGraph(CommandBuffer Buf)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::EndRenderGraph, Buf);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (NullCmd && ValidateGraphScope(NullCmd, true, __func__))
+			NullCmd->bInsideGraph = false;
+	}
+
+	void NextPass(CommandBuffer Buf)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::NextPass, Buf);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd || !ValidateGraphScope(NullCmd, true, __func__))
+			return;
+
+		if (NullCmd->PassIndex + 1 >= NullCmd->PassCount)
+		{
+			NullError(__func__, "the render graph has no more passes");
+			return;
+		}
+
+		NullCmd->PassIndex++;
+	}
+
+	void BindPipeline(CommandBuffer Buf, Pipeline PipelineObject)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::BindPipeline, Buf, PipelineObject);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd)
+			return;
+
+		if (NullPipeline* Bound = GetNullObject<NullPipeline>(PipelineObject, NullObjectType::Pipeline, __func__))
+			NullCmd->BoundPipeline = Bound;
+	}
+
+	void BindResources(CommandBuffer Buf, std::span<const ResourceSet> Resources, std::span<const uint32_t> DynamicOffsets)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::BindResourcesDynamic, Buf, Resources, DynamicOffsets);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd)
+			return;
+
+		if (!NullCmd->BoundPipeline)
+		{
+			NullError(__func__, "no pipeline is bound");
+			return;
+		}
+
+		size_t DynamicBindings = 0;
+		for (ResourceSet Resource : Resources)
+		{
+			NullResourceSet* Set = GetNullObject<NullResourceSet>(Resource, NullObjectType::ResourceSet, __func__);
+			if (!Set)
+				return;
+
+			DynamicBindings += Set->Layout->Info.DynamicUniformBuffers.size() + Set->Layout->Info.DynamicStorageBuffers.size();
+		}
+
+		if (DynamicOffsets.size() != DynamicBindings)
+			NullError(__func__, std::to_string(DynamicOffsets.size()) + " dynamic offsets for " + std::to_string(DynamicBindings) + " dynamic bindings");
+	}
+
+	void BindResources(CommandBuffer Buf, std::span<const ResourceSet> Resources)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::BindResources, Buf, Resources);
+
+		BindResources(Buf, Resources, {});
+	}
+
+	void DrawVertexBuffer(CommandBuffer Buf, VertexBuffer Vbo, uint32_t VertexCount)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DrawVertexBuffer, Buf, Vbo, VertexCount);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd || !ValidateGraphScope(NullCmd, true, __func__) || !ValidateNullHandle(Vbo, NullObjectType::VertexBuffer, __func__))
+			return;
+
+		if (!NullCmd->BoundPipeline || NullCmd->BoundPipeline->bCompute)
+		{
+			NullError(__func__, "no graphics pipeline is bound");
+			return;
+		}
+
+		NullCount(GNullCounters.Draws);
+		NullCount(GNullCounters.Vertices, VertexCount);
+	}
+
+	void DrawVertexBufferIndexed(CommandBuffer Buf, VertexBuffer Vbo, IndexBuffer Ibo, uint32_t IndexCount)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DrawVertexBufferIndexed, Buf, Vbo, Ibo, IndexCount);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd || !ValidateGraphScope(NullCmd, true, __func__) || !ValidateNullHandle(Vbo, NullObjectType::VertexBuffer, __func__))
+			return;
+
+		NullBuffer* NullIbo = GetNullObject<NullBuffer>(Ibo, NullObjectType::IndexBuffer, __func__);
+		if (!NullIbo)
+			return;
+
+		if (!NullCmd->BoundPipeline || NullCmd->BoundPipeline->bCompute)
+		{
+			NullError(__func__, "no graphics pipeline is bound");
+			return;
+		}
+		if (IndexCount * sizeof(uint32_t) > NullIbo->Size)
+		{
+			NullError(__func__, "drawing " + std::to_string(IndexCount) + " indices from a buffer of " + std::to_string(NullIbo->Size) + " bytes");
+			return;
+		}
+
+		NullCount(GNullCounters.Draws);
+		NullCount(GNullCounters.Vertices, IndexCount);
+	}
+
+	void SetViewport(CommandBuffer Buf, uint32_t X, uint32_t Y, uint32_t W, uint32_t H)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::SetViewport, Buf, X, Y, W, H);
+
+		GetRecordingCommandBuffer(Buf, __func__);
+	}
+
+	void SetScissor(CommandBuffer Buf, uint32_t X, uint32_t Y, uint32_t W, uint32_t H)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::SetScissor, Buf, X, Y, W, H);
+
+		GetRecordingCommandBuffer(Buf, __func__);
+	}
+
+	// Compute work has to be recorded outside of a render graph with a compute pipeline bound
+	NullCommandBuffer* GetDispatchCommandBuffer(CommandBuffer Buf, const char* Function)
+	{
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, Function);
+		if (!NullCmd || !ValidateGraphScope(NullCmd, false, Function))
+			return nullptr;
+
+		if (!NullCmd->BoundPipeline || !NullCmd->BoundPipeline->bCompute)
+		{
+			NullError(Function, "no compute pipeline is bound");
+			return nullptr;
+		}
+
+		return NullCmd;
+	}
+
+	void Dispatch(CommandBuffer Buf, uint32_t GroupsX, uint32_t GroupsY, uint32_t GroupsZ)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::Dispatch, Buf, GroupsX, GroupsY, GroupsZ);
+
+		if (GetDispatchCommandBuffer(Buf, __func__))
+			NullCount(GNullCounters.Dispatches);
+	}
+
+	void DispatchIndirect(CommandBuffer Buf, StorageBuffer Arguments, uint64_t Offset)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DispatchIndirect, Buf, Arguments, Offset);
+
+		if (!GetDispatchCommandBuffer(Buf, __func__))
+			return;
+
+		NullBuffer* NullArgs = GetNullObject<NullBuffer>(Arguments, NullObjectType::StorageBuffer, __func__);
+		if (!NullArgs)
+			return;
+
+		if (Offset + 3 * sizeof(uint32_t) > NullArgs->Size)
+		{
+			NullError(__func__, "the arguments are outside of the buffer");
+			return;
+		}
+
+		NullCount(GNullCounters.Dispatches);
+	}
+
+	void PipelineBarrier(CommandBuffer Buf, uint32_t SrcStages, uint32_t DstStages)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::PipelineBarrier, Buf, SrcStages, DstStages);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (NullCmd)
+			ValidateGraphScope(NullCmd, false, __func__);
+	}
+
+	void PipelineBarrier(CommandBuffer Buf, std::span<const TextureTransition> Transitions, std::span<const BufferBarrier> Buffers)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::PipelineBarrierBatch, Buf, Transitions, Buffers);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd || !ValidateGraphScope(NullCmd, false, __func__))
+			return;
+
+		for (const TextureTransition& Transition : Transitions)
+		{
+			if (!ValidateNullHandle(Transition.Image, NullObjectType::Texture, __func__))
+				return;
+			if (Transition.New == AttachmentUsage::Undefined)
+			{
+				NullError(__func__, "textures can't be transitioned to undefined");
+				return;
+			}
+		}
+
+		for (const BufferBarrier& Barrier : Buffers)
+		{
+			NullObjectType Type = Barrier.Type == BarrierBufferType::Vertex ? NullObjectType::VertexBuffer :
+				Barrier.Type == BarrierBufferType::Index ? NullObjectType::IndexBuffer : NullObjectType::StorageBuffer;
+
+			NullBuffer* NullBuf = GetNullObject<NullBuffer>(Barrier.Buffer, Type, __func__);
+			if (!NullBuf)
+				return;
+
+			bool bInside = Barrier.Offset <= NullBuf->Size && (Barrier.Size == BUFFER_SIZE_REMAINING || Barrier.Size <= NullBuf->Size - Barrier.Offset);
+			if (!bInside)
+			{
+				NullError(__func__, "the barrier range is outside of the buffer");
+				return;
+			}
+		}
+	}
+
+	QueryPool CreateOcclusionQueryPool(uint32_t Count)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateOcclusionQueryPool, Count);
+
+		if (Count == 0)
+		{
+			NullError(__func__, "query pools need at least one query");
+			return nullptr;
+		}
+
+		return LLRM_CAPTURE_RESULT(RegisterNullObject(new NullQueryPool{ Count }, NullObjectType::QueryPool));
+	}
+
+	void DestroyQueryPool(QueryPool Pool)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyQueryPool, Pool);
+
+		delete ReleaseNullObject<NullQueryPool>(Pool, NullObjectType::QueryPool, __func__);
+	}
+
+	// Queries are reset and resolved outside of render graphs
+	void RecordNullQueryPoolCommand(CommandBuffer Buf, QueryPool Pool, const char* Function)
+	{
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, Function);
+		if (NullCmd && ValidateGraphScope(NullCmd, false, Function))
+			ValidateNullHandle(Pool, NullObjectType::QueryPool, Function);
+	}
+
+	bool ValidateNullQuery(QueryPool Pool, uint32_t Query, const char* Function)
+	{
+		NullQueryPool* NullPool = GetNullObject<NullQueryPool>(Pool, NullObjectType::QueryPool, Function);
+		if (!NullPool)
+			return false;
+
+		if (Query >= NullPool->Count)
+		{
+			NullError(Function, "query " + std::to_string(Query) + " is outside of a pool of " + std::to_string(NullPool->Count));
+			return false;
+		}
+
+		return true;
+	}
+
+	void ResetQueries(CommandBuffer Buf, QueryPool Pool)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::ResetQueries, Buf, Pool);
+
+		RecordNullQueryPoolCommand(Buf, Pool, __func__);
+	}
+
+	void ResolveQueries(CommandBuffer Buf, QueryPool Pool)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::ResolveQueries, Buf, Pool);
+
+		RecordNullQueryPoolCommand(Buf, Pool, __func__);
+	}
+
+	void BeginQuery(CommandBuffer Buf, QueryPool Pool, uint32_t Query)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::BeginQuery, Buf, Pool, Query);
+
+		if (GetRecordingCommandBuffer(Buf, __func__))
+			ValidateNullQuery(Pool, Query, __func__);
+	}
+
+	void EndQuery(CommandBuffer Buf, QueryPool Pool, uint32_t Query)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::EndQuery, Buf, Pool, Query);
+
+		if (GetRecordingCommandBuffer(Buf, __func__))
+			ValidateNullQuery(Pool, Query, __func__);
+	}
+
+	uint64_t GetQueryResult(QueryPool Pool, uint32_t Query)
+	{
+		NullCount(GNullCounters.Calls);
+
+		if (!GNullContext.bInsideFrame)
+			NullError(__func__, "query results can only be read between BeginFrame and EndFrame");
+
+		// Nothing is ever occluded, which is what unresolved queries report as well
+		ValidateNullQuery(Pool, Query, __func__);
+		return 1;
+	}
+
+	void BeginConditionalRendering(CommandBuffer Buf, QueryPool Pool, uint32_t Query)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::BeginConditionalRendering, Buf, Pool, Query);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd || !ValidateNullQuery(Pool, Query, __func__))
+			return;
+
+		if (NullCmd->bConditional)
+		{
+			NullError(__func__, "conditional rendering can't be nested");
+			return;
+		}
+
+		NullCmd->bConditional = true;
+	}
+
+	void EndConditionalRendering(CommandBuffer Buf)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::EndConditionalRendering, Buf);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd)
+			return;
+
+		if (!NullCmd->bConditional)
+			NullError(__func__, "conditional rendering wasn't begun");
+
+		NullCmd->bConditional = false;
+	}
+
+#ifdef LLRM_DEBUG_LABELS
+	NullObjectType DebugObjectTypeToNull(DebugObjectType Type)
+	{
+		switch (Type)
+		{
+		case DebugObjectType::Texture: return NullObjectType::Texture;
+		case DebugObjectType::TextureView: return NullObjectType::TextureView;
+		case DebugObjectType::Sampler: return NullObjectType::Sampler;
+		case DebugObjectType::VertexBuffer: return NullObjectType::VertexBuffer;
+		case DebugObjectType::IndexBuffer: return NullObjectType::IndexBuffer;
+		case DebugObjectType::StorageBuffer: return NullObjectType::StorageBuffer;
+		case DebugObjectType::Pipeline: return NullObjectType::Pipeline;
+		case DebugObjectType::RenderGraph: return NullObjectType::RenderGraph;
+		case DebugObjectType::FrameBuffer: return NullObjectType::FrameBuffer;
+		case DebugObjectType::CommandBuffer: return NullObjectType::CommandBuffer;
+		case DebugObjectType::ResourceSet: return NullObjectType::ResourceSet;
+		default: return NullObjectType::Texture;
+		}
+	}
+
+	void SetObjectName(DebugObjectType Type, void* Object, const char* Name)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::SetObjectName, Object, Type, Name);
+
+		if (Object)
+			ValidateNullHandle(Object, DebugObjectTypeToNull(Type), __func__);
+	}
+
+	void BeginLabel(CommandBuffer Buf, const char* Name, float R, float G, float B)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::BeginLabel, Buf, Name, R, G, B);
+
+		if (NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__))
+			NullCmd->LabelDepth++;
+	}
+
+	void EndLabel(CommandBuffer Buf)
+	{
+		NullCount(GNullCounters.Calls);
+		LLRM_CAPTURE_CALL(CaptureOp::EndLabel, Buf);
+
+		NullCommandBuffer* NullCmd = GetRecordingCommandBuffer(Buf, __func__);
+		if (!NullCmd)
+			return;
+
+		if (NullCmd->LabelDepth == 0)
+		{
+			NullError(__func__, "no label was begun");
+			return;
+		}
+
+		NullCmd->LabelDepth--;
+	}
+#endif
+}
+
+#endif
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "llrm.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * The null backend implements the whole API without a GPU. Every call validates the handles it's given, counts what it would have done
+ * and returns immediately, so an application linked against it only spends time in its own code, e.g. to measure the CPU cost of
+ * building a frame apart from the driver's, or to test rendering code on a machine without a Vulkan driver.
+ *
+ * Misuse is reported the same way validation layers report it, and counted in NullStats::ValidationErrors.
+ */
+namespace llrm
+{
+	struct NullStats
+	{
+		uint64_t Calls = 0; // Every API call
+		uint64_t Commands = 0; // Commands recorded into command buffers
+		uint64_t Draws = 0;
+		uint64_t Vertices = 0; // Vertices and indices drawn
+		uint64_t Dispatches = 0;
+		uint64_t BytesUploaded = 0; // Buffer, uniform and texture data passed to creations, uploads and updates
+		uint64_t Submits = 0; // Command buffers submitted, including through EndFrame
+		uint64_t Frames = 0;
+		uint64_t ValidationErrors = 0;
+		uint32_t LiveObjects = 0; // Not reset by ResetNullStats
+	};
+
+	NullStats GetNullStats();
+	void ResetNullStats();
+}
+
+enum class NullObjectType : uint8_t
+{
+	Surface,
+	SwapChain,
+	ShaderProgram,
+	ResourceLayout,
+	Pipeline,
+	RenderGraph,
+	FrameBuffer,
+	VertexBuffer,
+	IndexBuffer,
+	StorageBuffer,
+	TexelBufferView,
+	CommandBuffer,
+	ResourceSet,
+	Texture,
+	TextureView,
+	Sampler,
+	DeviceMemory,
+	QueryPool
+};
+
+struct NullShaderProgram
+{
+	bool bCompute = false;
+	bool bModulesReleased = false;
+};
+
+struct NullTexture
+{
+	llrm::AttachmentFormat Format{};
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t Layers = 1;
+	uint32_t MipLevels = 1;
+	uint64_t Flags = 0;
+	bool bSwapChainImage = false; // Owned by a swap chain, so it can't be destroyed on its own
+};
+
+struct NullTextureView
+{
+	NullTexture* Image = nullptr;
+};
+
+struct NullSwapChain
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	llrm::PresentMode PresentMode = llrm::PresentMode::Fifo;
+
+	std::vector<NullTexture> Images;
+	std::vector<NullTextureView> ImageViews;
+	uint32_t NextImage = 0; // Images are acquired in order
+};
+
+struct NullBuffer
+{
+	uint64_t Size = 0;
+	uint64_t Flags = 0;
+
+	// Host written buffers are backed by memory, since the application writes to what MapStorageBuffer returns
+	std::vector<uint8_t> Memory;
+	uint64_t SliceSize = 0;
+};
+
+struct NullTexelBufferView
+{
+	NullBuffer* Buffer = nullptr;
+};
+
+struct NullRenderGraph
+{
+	uint32_t PassCount = 0;
+};
+
+struct NullFrameBuffer
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+};
+
+struct NullResourceLayout
+{
+	llrm::ResourceLayoutCreateInfo Info;
+
+	// Sets keep their layout alive, since the application may destroy the layout before the sets made from it
+	std::atomic<uint32_t> References = 1;
+};
+
+struct NullResourceSet
+{
+	NullResourceLayout* Layout = nullptr;
+	bool bTransient = false;
+};
+
+struct NullPipeline
+{
+	bool bCompute = false;
+};
+
+struct NullSampler
+{
+	llrm::SamplerCreateInfo Info;
+};
+
+struct NullDeviceMemory
+{
+	uint64_t Size = 0;
+};
+
+struct NullQueryPool
+{
+	uint32_t Count = 0;
+};
+
+enum class NullCommandBufferState : uint8_t
+{
+	Initial,
+	Recording,
+	Executable
+};
+
+struct NullCommandBuffer
+{
+	bool bOneTimeUse = false;
+	NullCommandBufferState State = NullCommandBufferState::Initial;
+
+	// What's being recorded, which decides the commands that are allowed
+	bool bInsideGraph = false;
+	uint32_t PassIndex = 0;
+	uint32_t PassCount = 0;
+	NullPipeline* BoundPipeline = nullptr;
+	uint32_t LabelDepth = 0;
+	bool bConditional = false;
+};
+
+struct NullContext
+{
+	bool bHeadless = false;
+	uint32_t FramesInFlight = 3;
+	uint32_t CurrentFrame = 0;
+	bool bInsideFrame = false;
+
+	// The frames started by BeginFrame, which EndFrame ends
+	std::vector<llrm::SwapChainFrame> BegunFrames;
+
+	// Transient resource sets created during each frame in flight, destroyed when that frame is begun again
+	std::vector<std::vector<NullResourceSet*>> TransientSets;
+};
+
+/*
+ * Every live object along with its type, which is how handles are validated. Handles that aren't in here were never created or were already destroyed.
+ */
+struct NullObjectRegistry
+{
+	std::mutex Lock;
+	std::unordered_map<const void*, NullObjectType> Objects;
+};
+
+struct NullCounters
+{
+	std::atomic<uint64_t> Calls = 0;
+	std::atomic<uint64_t> Commands = 0;
+	std::atomic<uint64_t> Draws = 0;
+	std::atomic<uint64_t> Vertices = 0;
+	std::atomic<uint64_t> Dispatches = 0;
+	std::atomic<uint64_t> BytesUploaded = 0;
+	std::atomic<uint64_t> Submits = 0;
+	std::atomic<uint64_t> Frames = 0;
+	std::atomic<uint64_t> ValidationErrors = 0;
+};
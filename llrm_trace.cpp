@@ -0,0 +1,146 @@
+#include "llrm_trace.h"
+
+#ifdef LLRM_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace llrm
+{
+	struct TraceEvent
+	{
+		const char* Name;
+		uint64_t Begin;
+		uint64_t End;
+	};
+
+	struct TraceRing
+	{
+		std::vector<TraceEvent> Events = std::vector<TraceEvent>(TRACE_RING_SIZE);
+		std::atomic<uint64_t> Written{0}; // Total zones written, the next one goes to Written % TRACE_RING_SIZE
+		uint32_t ThreadId = 0;
+		std::string ThreadName;
+	};
+
+	// Rings are shared with the registry so the zones of threads that have exited can still be exported
+	std::mutex GTraceMutex;
+	std::vector<std::shared_ptr<TraceRing>> GTraceRings;
+
+	TraceRing& GetThreadRing()
+	{
+		thread_local std::shared_ptr<TraceRing> Ring;
+		if (!Ring)
+		{
+			Ring = std::make_shared<TraceRing>();
+
+			std::lock_guard<std::mutex> Lock(GTraceMutex);
+			Ring->ThreadId = static_cast<uint32_t>(GTraceRings.size());
+			GTraceRings.push_back(Ring);
+		}
+
+		return *Ring;
+	}
+
+	uint64_t TraceNow()
+	{
+		static const std::chrono::steady_clock::time_point Epoch = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch).count();
+	}
+
+	void TraceRecord(const char* Name, uint64_t Begin, uint64_t End)
+	{
+		TraceRing& Ring = GetThreadRing();
+
+		uint64_t Index = Ring.Written.load(std::memory_order_relaxed);
+		Ring.Events[Index % TRACE_RING_SIZE] = { Name, Begin, End };
+		Ring.Written.store(Index + 1, std::memory_order_release);
+	}
+
+	void TraceSetThreadName(const char* Name)
+	{
+		TraceRing& Ring = GetThreadRing();
+
+		std::lock_guard<std::mutex> Lock(GTraceMutex);
+		Ring.ThreadName = Name;
+	}
+
+	void TraceClear()
+	{
+		std::lock_guard<std::mutex> Lock(GTraceMutex);
+		for (const std::shared_ptr<TraceRing>& Ring : GTraceRings)
+			Ring->Written.store(0, std::memory_order_release);
+	}
+
+	void WriteJsonString(FILE* File, const char* String)
+	{
+		fputc('"', File);
+		for (const char* Char = String; *Char; Char++)
+		{
+			if (*Char == '"' || *Char == '\\')
+				fputc('\\', File);
+
+			// Control characters can't appear in JSON strings
+			if (static_cast<unsigned char>(*Char) < 0x20)
+				fputc(' ', File);
+			else
+				fputc(*Char, File);
+		}
+		fputc('"', File);
+	}
+
+	bool TraceExportChrome(const char* Path)
+	{
+		FILE* File = fopen(Path, "wb");
+		if (!File)
+		{
+			//GLog->error("Failed to open {} for writing the trace", Path);
+			return false;
+		}
+
+		std::lock_guard<std::mutex> Lock(GTraceMutex);
+
+		fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", File);
+
+		bool bFirst = true;
+		for (const std::shared_ptr<TraceRing>& Ring : GTraceRings)
+		{
+			if (!Ring->ThreadName.empty())
+			{
+				fprintf(File, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", bFirst ? "" : ",", Ring->ThreadId);
+				WriteJsonString(File, Ring->ThreadName.c_str());
+				fputs("}}", File);
+				bFirst = false;
+			}
+
+			// Only the last TRACE_RING_SIZE zones are still in the ring
+			uint64_t Written = Ring->Written.load(std::memory_order_acquire);
+			uint64_t First = Written > TRACE_RING_SIZE ? Written - TRACE_RING_SIZE : 0;
+
+			for (uint64_t Index = First; Index < Written; Index++)
+			{
+				const TraceEvent& Event = Ring->Events[Index % TRACE_RING_SIZE];
+
+				// Complete events are in microseconds, keeping the nanoseconds as decimals
+				fprintf(File, "%s\n{\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,\"name\":",
+					bFirst ? "" : ",",
+					Ring->ThreadId,
+					static_cast<unsigned long long>(Event.Begin / 1000), static_cast<unsigned long long>(Event.Begin % 1000),
+					static_cast<unsigned long long>((Event.End - Event.Begin) / 1000), static_cast<unsigned long long>((Event.End - Event.Begin) % 1000));
+				WriteJsonString(File, Event.Name);
+				fputc('}', File);
+				bFirst = false;
+			}
+		}
+
+		fputs("\n]}\n", File);
+
+		return fclose(File) == 0;
+	}
+}
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * A CPU profiler made of scoped zones. Each thread records the zones it closes into its own ring buffer, so recording never locks
+ * and old zones are overwritten once a thread's ring is full. Timestamps are in nanoseconds since the first zone of the process.
+ *
+ * The recorded zones can be exported in the Chrome trace_event format, which opens in Perfetto or chrome://tracing.
+ * Zones are only recorded with LLRM_TRACE enabled, otherwise every macro expands to nothing and the functions do nothing.
+ */
+namespace llrm
+{
+	// Zones each thread keeps before overwriting its oldest ones
+	const uint32_t TRACE_RING_SIZE = 1u << 16;
+
+#ifdef LLRM_TRACE
+	uint64_t TraceNow();
+
+	// Name must outlive the trace, which string literals and __func__ do
+	void TraceRecord(const char* Name, uint64_t Begin, uint64_t End);
+
+	// Names the calling thread in exported traces
+	void TraceSetThreadName(const char* Name);
+
+	// Drops the zones recorded so far by every thread
+	void TraceClear();
+
+	// Should be called while no other thread is recording, e.g. between frames, or zones being written may be exported half written
+	bool TraceExportChrome(const char* Path);
+#else
+	inline uint64_t TraceNow() { return 0; }
+	inline void TraceRecord(const char* Name, uint64_t Begin, uint64_t End) {}
+	inline void TraceSetThreadName(const char* Name) {}
+	inline void TraceClear() {}
+	inline bool TraceExportChrome(const char* Path) { return false; }
+#endif
+
+	// Records the time between its construction and the end of the enclosing scope, see LLRM_TRACE_ZONE
+	struct TraceZone
+	{
+		TraceZone(const char* InName) : Name(InName), Begin(TraceNow()) {}
+		~TraceZone() { TraceRecord(Name, Begin, TraceNow()); }
+
+		TraceZone(const TraceZone&) = delete;
+		TraceZone& operator=(const TraceZone&) = delete;
+
+	private:
+		const char* Name;
+		uint64_t Begin;
+	};
+}
+
+#ifdef LLRM_TRACE
+	#define LLRM_TRACE_CONCAT_INNER(A, B) A##B
+	#define LLRM_TRACE_CONCAT(A, B) LLRM_TRACE_CONCAT_INNER(A, B)
+	#define LLRM_TRACE_ZONE(Name) ::llrm::TraceZone LLRM_TRACE_CONCAT(LLRMTraceZone, __LINE__)(Name)
+	#define LLRM_TRACE_FUNCTION() LLRM_TRACE_ZONE(__func__)
+#else
+	#define LLRM_TRACE_ZONE(Name)
+	#define LLRM_TRACE_FUNCTION()
+#endif
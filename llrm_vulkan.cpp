@@ -1,14 +1,22 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
 
-#include "llrm_vulkan.h"
+#include "llrm_trace.h"
+#include "llrm_capture.h"
+#include <type_traits>
 #include <unordered_set>
 #include <vector>
 
 #ifdef LLRM_VULKAN
 
+#include "llrm_vulkan.h"
+
 // LLRM uses glfw for now, move away from this to become independent from the windowing framework.
 #include "GLFW/glfw3.h"
 
@@ -22,6 +30,12 @@
 	constexpr bool bEnableValidation = false;
 #endif
 
+#ifdef LLRM_DEBUG_LABELS
+	constexpr bool bEnableDebugLabels = true;
+#else
+	constexpr bool bEnableDebugLabels = false;
+#endif
+
 #if LLRM_VULKAN_MOLTENVK
 	constexpr bool bUsingMoltenVK = true;
 #else
@@ -32,11 +46,11 @@
 // Vulkan backend helper functions
 // //////////////////////////////////////////
 
-void GetInstanceExtensions(std::vector<const char*>& OutExt)
+void GetInstanceExtensions(std::vector<const char*>& OutExt, bool bHeadless)
 {
-	// Get GLFW extensions
+	// Get GLFW extensions, a headless instance doesn't need any surface extensions
 	uint32_t GLFWExtensionCount = 0;
-	const char** GLFWExtensions = glfwGetRequiredInstanceExtensions(&GLFWExtensionCount);
+	const char** GLFWExtensions = bHeadless ? nullptr : glfwGetRequiredInstanceExtensions(&GLFWExtensionCount);
 
 	if (GLFWExtensions)
 	{
@@ -123,28 +137,6 @@ bool CheckSupportedValidationLayers(const std::vector<const char*> RequiredValid
 	return bAllValidationLayersSupported;
 }
 
-/**
- * Calculates a suitability score for a particular device.
- */
-uint32_t CalcPhysicalDeviceScore(const VkPhysicalDevice& PhysicalDevice)
-{
-	uint32_t DeviceScore = 0;
-
-	VkPhysicalDeviceProperties DeviceProperties;
-	vkGetPhysicalDeviceProperties(PhysicalDevice, &DeviceProperties);
-
-	VkPhysicalDeviceFeatures DeviceFeatures;
-	vkGetPhysicalDeviceFeatures(PhysicalDevice, &DeviceFeatures);
-
-	// Discrete GPUs get precedence
-	if (DeviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
-	{
-		DeviceScore += 1000;
-	}
-
-	return DeviceScore;
-}
-
 bool CheckSupportedPhysicalDeviceExtensions(const VkPhysicalDevice& PhysicalDevice, const std::vector<const char*> RequiredDeviceExtensions)
 {
 	uint32_t ExtensionCount;
@@ -180,12 +172,240 @@ bool CheckSupportedPhysicalDeviceExtensions(const VkPhysicalDevice& PhysicalDevi
 	return true;
 }
 
+std::unordered_set<std::string> GetPhysicalDeviceExtensions(const VkPhysicalDevice& PhysicalDevice)
+{
+	uint32_t ExtensionCount;
+	vkEnumerateDeviceExtensionProperties(PhysicalDevice, nullptr, &ExtensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> AvailableExtensions(ExtensionCount);
+	vkEnumerateDeviceExtensionProperties(PhysicalDevice, nullptr, &ExtensionCount, AvailableExtensions.data());
+
+	std::unordered_set<std::string> Result;
+	for (const auto& SupportedExtension : AvailableExtensions)
+		Result.insert(SupportedExtension.extensionName);
+
+	return Result;
+}
+
+void AddDeviceScore(llrm::DeviceInfo& Info, int32_t Points, const char* Reason)
+{
+	Info.Score += Points;
+	Info.ScoreBreakdown.push_back({ Reason, Points });
+}
+
+/**
+ * Fills in the description of a device and scores how well suited it is. Devices missing anything LLRM requires are marked unsuitable.
+ *
+ * The score favors dedicated hardware first, then optional features LLRM can make use of, then queue layout, memory and limits.
+ */
+llrm::DeviceInfo DescribePhysicalDevice(
+	const VkInstance& Instance,
+	const VkPhysicalDevice& PhysicalDevice,
+	uint32_t DeviceIndex,
+	const std::vector<const char*>& RequiredDeviceExtensions,
+	bool bHeadless,
+	uint32_t& OutGraphicsQueueFam,
+	uint32_t& OutPresentQueueFam
+)
+{
+	llrm::DeviceInfo Info{};
+	Info.Index = DeviceIndex;
+
+	VkPhysicalDeviceIDProperties IdProperties{};
+	IdProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 DeviceProperties2{};
+	DeviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	DeviceProperties2.pNext = &IdProperties;
+	vkGetPhysicalDeviceProperties2(PhysicalDevice, &DeviceProperties2);
+
+	const VkPhysicalDeviceProperties& DeviceProperties = DeviceProperties2.properties;
+	Info.Name = DeviceProperties.deviceName;
+	Info.VendorId = DeviceProperties.vendorID;
+	Info.DeviceId = DeviceProperties.deviceID;
+	Info.ApiVersion = DeviceProperties.apiVersion;
+	std::copy(std::begin(IdProperties.deviceUUID), std::end(IdProperties.deviceUUID), Info.UUID);
+
+	switch (DeviceProperties.deviceType)
+	{
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: Info.Type = llrm::DeviceType::Discrete; break;
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: Info.Type = llrm::DeviceType::Integrated; break;
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: Info.Type = llrm::DeviceType::Virtual; break;
+	case VK_PHYSICAL_DEVICE_TYPE_CPU: Info.Type = llrm::DeviceType::Cpu; break;
+	default: Info.Type = llrm::DeviceType::Other; break;
+	}
+
+	// Requirements
+	std::unordered_set<std::string> Extensions = GetPhysicalDeviceExtensions(PhysicalDevice);
+	for (const char* RequiredExtension : RequiredDeviceExtensions)
+	{
+		if (!Extensions.contains(RequiredExtension))
+		{
+			Info.bSuitable = false;
+			Info.Rejection = std::string("Missing required extension ") + RequiredExtension;
+			return Info;
+		}
+	}
+
+	VkPhysicalDeviceFeatures PDFeatures{};
+	vkGetPhysicalDeviceFeatures(PhysicalDevice, &PDFeatures);
+	if (PDFeatures.independentBlend != VK_TRUE)
+	{
+		Info.bSuitable = false;
+		Info.Rejection = "Missing independentBlend feature";
+		return Info;
+	}
+
+	int32_t GraphicsQueueFam = -1;
+	int32_t PresentQueueFam = -1;
+	bool bDedicatedCompute = false;
+	bool bDedicatedTransfer = false;
+	{
+		uint32_t QueueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(PhysicalDevice, &QueueFamilyCount, nullptr);
+
+		std::vector<VkQueueFamilyProperties> QueueFamProperties(QueueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(PhysicalDevice, &QueueFamilyCount, QueueFamProperties.data());
+		for (uint32_t QueueFamIndex = 0; QueueFamIndex < QueueFamilyCount; QueueFamIndex++)
+		{
+			const auto& QueueFamProps = QueueFamProperties[QueueFamIndex];
+			bool bGraphics = (QueueFamProps.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (QueueFamProps.queueFlags & VK_QUEUE_COMPUTE_BIT);
+			bool bPresent = bHeadless || glfwGetPhysicalDevicePresentationSupport(Instance, PhysicalDevice, QueueFamIndex) == GLFW_TRUE;
+
+			// Compute work is recorded alongside graphics work, so the family must support both.
+			// A family that can present as well is preferred, so images don't need to change queue ownership.
+			if (bGraphics && (GraphicsQueueFam < 0 || (bPresent && GraphicsQueueFam != PresentQueueFam)))
+				GraphicsQueueFam = static_cast<int32_t>(QueueFamIndex);
+
+			if (bPresent && (PresentQueueFam < 0 || (bGraphics && GraphicsQueueFam == static_cast<int32_t>(QueueFamIndex))))
+				PresentQueueFam = static_cast<int32_t>(QueueFamIndex);
+
+			if (!(QueueFamProps.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (QueueFamProps.queueFlags & VK_QUEUE_COMPUTE_BIT))
+				bDedicatedCompute = true;
+			if (!(QueueFamProps.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && (QueueFamProps.queueFlags & VK_QUEUE_TRANSFER_BIT))
+				bDedicatedTransfer = true;
+		}
+	}
+
+	if (GraphicsQueueFam < 0 || PresentQueueFam < 0)
+	{
+		Info.bSuitable = false;
+		Info.Rejection = GraphicsQueueFam < 0 ? "No queue family supports graphics and compute" : "No queue family can present";
+		return Info;
+	}
+
+	OutGraphicsQueueFam = static_cast<uint32_t>(GraphicsQueueFam);
+	OutPresentQueueFam = static_cast<uint32_t>(PresentQueueFam);
+	Info.bSuitable = true;
+
+	// Dedicated hardware is preferred over everything else, and software rasterizers are the last resort
+	switch (Info.Type)
+	{
+	case llrm::DeviceType::Discrete: AddDeviceScore(Info, 10000, "Discrete GPU"); break;
+	case llrm::DeviceType::Integrated: AddDeviceScore(Info, 5000, "Integrated GPU"); break;
+	case llrm::DeviceType::Virtual: AddDeviceScore(Info, 2000, "Virtual GPU"); break;
+	default: break;
+	}
+
+	// Optional features, which are either core in the device's Vulkan version or available as extensions
+	bool bVulkan12 = DeviceProperties.apiVersion >= VK_API_VERSION_1_2;
+	bool bVulkan13 = DeviceProperties.apiVersion >= VK_API_VERSION_1_3;
+	if (bVulkan13 || Extensions.contains(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+		AddDeviceScore(Info, 400, "Dynamic rendering");
+	if (bVulkan12 || Extensions.contains(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+		AddDeviceScore(Info, 200, "Descriptor indexing");
+	if (bVulkan12 || Extensions.contains(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+		AddDeviceScore(Info, 200, "Timeline semaphores");
+	if (Extensions.contains(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+		AddDeviceScore(Info, 100, "Memory budget");
+
+	// Queues
+	if (GraphicsQueueFam == PresentQueueFam)
+		AddDeviceScore(Info, 100, "Graphics and presentation share a queue family");
+	if (bDedicatedCompute)
+		AddDeviceScore(Info, 50, "Dedicated compute queue family");
+	if (bDedicatedTransfer)
+		AddDeviceScore(Info, 50, "Dedicated transfer queue family");
+
+	// Memory, the largest device local heap counts for up to 32 GiB
+	VkPhysicalDeviceMemoryProperties MemProperties;
+	vkGetPhysicalDeviceMemoryProperties(PhysicalDevice, &MemProperties);
+	for (uint32_t Heap = 0; Heap < MemProperties.memoryHeapCount; Heap++)
+	{
+		if (MemProperties.memoryHeaps[Heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+			Info.DeviceLocalBytes = std::max<uint64_t>(Info.DeviceLocalBytes, MemProperties.memoryHeaps[Heap].size);
+	}
+	AddDeviceScore(Info, static_cast<int32_t>(std::min<uint64_t>(Info.DeviceLocalBytes >> 30, 32)) * 25, "Device local memory (25 per GiB)");
+
+	// Limits
+	AddDeviceScore(Info, static_cast<int32_t>(std::min<uint32_t>(DeviceProperties.limits.maxImageDimension2D / 1024, 32)) * 5, "Max texture size (5 per 1024 texels)");
+	AddDeviceScore(Info, static_cast<int32_t>(std::min<uint32_t>(DeviceProperties.limits.maxImageArrayLayers / 256, 16)) * 5, "Max array layers (5 per 256 layers)");
+
+	return Info;
+}
+
+/**
+ * Whether a device matches a selection string, which is either the device's index, its UUID as 32 hex digits (dashes are ignored),
+ * a device type (discrete, integrated, virtual or cpu) or part of its name. Comparisons ignore case.
+ */
+bool DeviceMatchesSelection(const llrm::DeviceInfo& Info, const std::string& Selection)
+{
+	std::string Lower;
+	std::string Hex;
+	for (char Character : Selection)
+	{
+		Lower.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(Character))));
+		if (Character != '-')
+			Hex.push_back(Lower.back());
+	}
+
+	// Checked before the index, since a UUID can be made of decimal digits only
+	if (Hex.size() == 32 && std::all_of(Hex.begin(), Hex.end(), [](char Character) { return std::isxdigit(static_cast<unsigned char>(Character)); }))
+	{
+		static const char* HexDigits = "0123456789abcdef";
+
+		std::string UUID;
+		for (uint8_t Byte : Info.UUID)
+		{
+			UUID.push_back(HexDigits[Byte >> 4]);
+			UUID.push_back(HexDigits[Byte & 0xF]);
+		}
+
+		return UUID == Hex;
+	}
+
+	if (!Lower.empty() && std::all_of(Lower.begin(), Lower.end(), [](char Character) { return std::isdigit(static_cast<unsigned char>(Character)); }))
+	{
+		uint32_t Index = 0;
+		const std::from_chars_result Parsed = std::from_chars(Lower.data(), Lower.data() + Lower.size(), Index);
+		return Parsed.ec == std::errc() && Index == Info.Index;
+	}
+
+	if ((Lower == "discrete" && Info.Type == llrm::DeviceType::Discrete) || (Lower == "integrated" && Info.Type == llrm::DeviceType::Integrated) ||
+		(Lower == "virtual" && Info.Type == llrm::DeviceType::Virtual) || (Lower == "cpu" && Info.Type == llrm::DeviceType::Cpu))
+		return true;
+
+	std::string Name;
+	for (char Character : Info.Name)
+		Name.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(Character))));
+
+	return Name.find(Lower) != std::string::npos;
+}
+
+/**
+ * Picks the suitable device with the highest score. When a selection is given, only devices matching it are considered,
+ * and no device is picked if none of them are suitable.
+ */
 bool PickPhysicalDevice(
 	const VkInstance& Instance,
 	std::vector<const char*> RequiredDeviceExtensions,
+	const std::string& Selection,
 	VkPhysicalDevice& OutDevice,
 	uint32_t& OutGraphicsQueueFamilyIndex,
-	uint32_t& OutPresentQueueFamilyIndex
+	uint32_t& OutPresentQueueFamilyIndex,
+	bool bHeadless,
+	std::vector<llrm::DeviceInfo>& OutCandidates,
+	int32_t& OutSelected
 )
 {
 	uint32_t DeviceCount = 0;
@@ -200,79 +420,33 @@ bool PickPhysicalDevice(
 	std::vector<VkPhysicalDevice> PhysicalDevices(DeviceCount);
 	vkEnumeratePhysicalDevices(Instance, &DeviceCount, PhysicalDevices.data());
 
-	int32_t MaxDeviceIndex = -1;
-	uint32_t MaxDeviceGraphicsQueueFam = 0;
-	uint32_t MaxDevicePresentQueueFam = 0;
-	uint32_t MaxDeviceScore = 0;
+	OutCandidates.clear();
+	OutSelected = -1;
 	for (uint32_t CurDeviceIndex = 0; CurDeviceIndex < PhysicalDevices.size(); CurDeviceIndex++)
 	{
-		const auto& PhysicalDevice = PhysicalDevices[CurDeviceIndex];
-
-		// Determine if graphics card has a queue family that supports the graphics queue bit
-		int32_t GraphicsQueueFam = -1;
-		int32_t PresentQueueFam = -1;
-		bool bSupportsExtensions = CheckSupportedPhysicalDeviceExtensions(PhysicalDevice, RequiredDeviceExtensions); // Determine if device supports required extensions
-		bool bSupportsSurface = true;
-		{
-			uint32_t QueueFamilyCount = 0;
-			vkGetPhysicalDeviceQueueFamilyProperties(PhysicalDevice, &QueueFamilyCount, nullptr);
-
-			std::vector<VkQueueFamilyProperties> QueueFamProperties(QueueFamilyCount);
-			vkGetPhysicalDeviceQueueFamilyProperties(PhysicalDevice, &QueueFamilyCount, QueueFamProperties.data());
-			for (uint32_t QueueFamIndex = 0; QueueFamIndex < QueueFamilyCount; QueueFamIndex++)
-			{
-				// Check if this queue family supports graphics rendering. Save result if so.
-				const auto& QueueFamProps = QueueFamProperties[QueueFamIndex];
-				if (QueueFamProps.queueFlags & VK_QUEUE_GRAPHICS_BIT)
-				{
-					GraphicsQueueFam = static_cast<int32_t>(QueueFamIndex);
-				}
-
-				// Check if this queue family supports presentation to the created surface. If so, save this result.
-				if(glfwGetPhysicalDevicePresentationSupport(Instance, PhysicalDevice, QueueFamIndex) == GLFW_TRUE)
-				{
-					PresentQueueFam = static_cast<int32_t>(QueueFamIndex);
-				}
-			}
-		}
+		uint32_t GraphicsQueueFam = 0;
+		uint32_t PresentQueueFam = 0;
+		llrm::DeviceInfo Info = DescribePhysicalDevice(Instance, PhysicalDevices[CurDeviceIndex], CurDeviceIndex, RequiredDeviceExtensions, bHeadless, GraphicsQueueFam, PresentQueueFam);
 
-		bool bSupportsFeatures = true;
+		if (Info.bSuitable && !Selection.empty() && !DeviceMatchesSelection(Info, Selection))
 		{
-			VkPhysicalDeviceFeatures PDFeatures{};
-			vkGetPhysicalDeviceFeatures(PhysicalDevice, &PDFeatures);
-
-			if (PDFeatures.independentBlend != VK_TRUE)
-			{
-				bSupportsFeatures = false;
-			}
+			Info.bSuitable = false;
+			Info.Rejection = "Doesn't match the device selection \"" + Selection + "\"";
 		}
 
-		// Check that the device meets all of the requirements before considering it for scoring
-		if (bSupportsFeatures && bSupportsExtensions && bSupportsSurface && GraphicsQueueFam >= 0 && PresentQueueFam >= 0)
+		// The first device wins ties, so the choice is stable
+		if (Info.bSuitable && (OutSelected < 0 || Info.Score > OutCandidates[OutSelected].Score))
 		{
-			uint32_t DeviceScore = CalcPhysicalDeviceScore(PhysicalDevice);
-			if (DeviceScore >= MaxDeviceScore)
-			{
-				MaxDeviceScore = DeviceScore;
-				MaxDeviceGraphicsQueueFam = GraphicsQueueFam;
-				MaxDevicePresentQueueFam = PresentQueueFam;
-				MaxDeviceIndex = CurDeviceIndex;
-			}
+			OutSelected = static_cast<int32_t>(CurDeviceIndex);
+			OutDevice = PhysicalDevices[CurDeviceIndex];
+			OutGraphicsQueueFamilyIndex = GraphicsQueueFam;
+			OutPresentQueueFamilyIndex = PresentQueueFam;
 		}
 
+		OutCandidates.push_back(Info);
 	}
 
-	if (MaxDeviceIndex >= 0)
-	{
-		OutDevice = PhysicalDevices[MaxDeviceIndex];
-		OutGraphicsQueueFamilyIndex = MaxDeviceGraphicsQueueFam;
-		OutPresentQueueFamilyIndex = MaxDevicePresentQueueFam;
-		return true;
-	}
-	else
-	{
-		return false;
-	}
+	return OutSelected >= 0;
 }
 
 // Vulkan debug callback
@@ -368,18 +542,178 @@ namespace llrm
 {
 	VulkanContext GVulkanContext;
 
-	llrm::Context CreateContext()
+	std::mutex GQueueMutex;
+
+	// Guards the main command pool, since any thread may upload to a vertex, index or storage buffer
+	std::mutex GMainCommandPoolMutex;
+
+	// The pools of every thread that has created command buffers or resource sets
+	std::mutex GThreadPoolsMutex;
+	std::vector<VulkanThreadPools*> GThreadPools;
+
+	// Bumped when the context is destroyed, so threads know their cached pools are gone
+	std::atomic<uint32_t> GThreadPoolsGeneration = 0;
+
+	// Objects created from identical descriptions are shared through these
+	VulkanObjectCache<VulkanSampler> GSamplerCache;
+	VulkanObjectCache<VulkanResourceLayout> GResourceLayoutCache;
+	VulkanObjectCache<VulkanRenderGraph> GRenderGraphCache;
+	VulkanObjectCache<VulkanPipeline> GPipelineCache;
+	VulkanObjectCache<VulkanShaderModule> GShaderModuleCache;
+
+	// Ids for the objects pipelines are keyed on
+	std::atomic<uint64_t> GNextObjectId = 1;
+
+	// Builds a cache key out of individual fields, so the padding of description structs never ends up in a key
+	struct CacheKey
+	{
+		std::string Bytes;
+
+		template<typename T>
+		CacheKey& operator<<(const T& Value)
+		{
+			static_assert(std::is_scalar_v<T>);
+			Bytes.append(reinterpret_cast<const char*>(&Value), sizeof(T));
+			return *this;
+		}
+	};
+
+	VkFormat AttachmentFormatToVkFormat(AttachmentFormat Format);
+
+	void WaitQueueIdle()
+	{
+		std::lock_guard<std::mutex> QueueLock(GQueueMutex);
+		vkQueueWaitIdle(GVulkanContext.GraphicsQueue);
+	}
+
+	void WaitDeviceIdle()
+	{
+		std::lock_guard<std::mutex> QueueLock(GQueueMutex);
+		vkDeviceWaitIdle(GVulkanContext.Device);
+	}
+
+	// Waits for every submitted frame, unlike WaitDeviceIdle this leaves other queue work (such as staging copies) running
+	void WaitFramesInFlight()
+	{
+		LLRM_TRACE_ZONE("Wait Frames In Flight");
+		vkWaitForFences(GVulkanContext.Device, static_cast<uint32_t>(GVulkanContext.FrameFences.size()), GVulkanContext.FrameFences.data(), VK_TRUE, UINT64_MAX);
+	}
+
+	// Every type gets room for one descriptor per set, or for MaxSets sets of SetSizes when a binding array needs more
+	bool CreateVkDescriptorPool(VkDevice Device, uint32_t MaxSets, bool bFreeSets, VkDescriptorPool& OutPool, const std::vector<VkDescriptorPoolSize>& SetSizes = {})
+	{
+		VkDescriptorPoolSize PoolSizes[] =
+		{
+			{ VK_DESCRIPTOR_TYPE_SAMPLER, MaxSets },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MaxSets },
+			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, MaxSets },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MaxSets },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, MaxSets },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, MaxSets },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MaxSets },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MaxSets },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, MaxSets },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, MaxSets },
+			{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, MaxSets }
+		};
+
+		for (const VkDescriptorPoolSize& SetSize : SetSizes)
+		{
+			for (VkDescriptorPoolSize& PoolSize : PoolSizes)
+			{
+				if (PoolSize.type == SetSize.type)
+					PoolSize.descriptorCount = std::max(PoolSize.descriptorCount, SetSize.descriptorCount * MaxSets);
+			}
+		}
+
+		VkDescriptorPoolCreateInfo DscPoolCreateInfo{};
+		DscPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		DscPoolCreateInfo.maxSets = MaxSets;
+		DscPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(std::size(PoolSizes));
+		DscPoolCreateInfo.pPoolSizes = PoolSizes;
+		DscPoolCreateInfo.flags = bFreeSets ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+
+		return vkCreateDescriptorPool(Device, &DscPoolCreateInfo, nullptr, &OutPool) == VK_SUCCESS;
+	}
+
+	// Gets the pools of the calling thread, creating them the first time the thread needs them
+	VulkanThreadPools* GetThreadPools()
+	{
+		thread_local VulkanThreadPools* ThreadPools = nullptr;
+		thread_local uint32_t ThreadPoolsGeneration = 0;
+
+		if (ThreadPools && ThreadPoolsGeneration == GThreadPoolsGeneration)
+			return ThreadPools;
+
+		VulkanThreadPools* NewPools = new VulkanThreadPools;
+		NewPools->Owner = std::this_thread::get_id();
+
+		VkCommandPoolCreateInfo CmdPoolCreateInfo{};
+		CmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		CmdPoolCreateInfo.queueFamilyIndex = GVulkanContext.GraphicsQueueFamIndex;
+		CmdPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		if (vkCreateCommandPool(GVulkanContext.Device, &CmdPoolCreateInfo, nullptr, &NewPools->CommandPool) != VK_SUCCESS)
+		{
+			//GLog->critical("Failed to create thread command pool");
+			delete NewPools;
+			return nullptr;
+		}
+
+		// Descriptor pools are created once resource sets need them
+		NewPools->TransientFrames.resize(GVulkanContext.FramesInFlight);
+
+		{
+			std::lock_guard<std::mutex> RegistryLock(GThreadPoolsMutex);
+			GThreadPools.push_back(NewPools);
+		}
+
+		ThreadPools = NewPools;
+		ThreadPoolsGeneration = GThreadPoolsGeneration;
+
+		return NewPools;
+	}
+
+	// Releases everything transient resource sets allocated the last time a frame in flight was recorded, on every thread
+	void ResetTransientFrame(uint32_t FrameIndex)
+	{
+		std::lock_guard<std::mutex> RegistryLock(GThreadPoolsMutex);
+		for (VulkanThreadPools* Pools : GThreadPools)
+		{
+			std::lock_guard<std::mutex> PoolLock(Pools->Lock);
+			VulkanTransientFrame& Frame = Pools->TransientFrames[FrameIndex];
+
+			for (uint32_t PoolIndex = 0; PoolIndex < Frame.DscPools.size() && PoolIndex <= Frame.CurrentDscPool; PoolIndex++)
+				vkResetDescriptorPool(GVulkanContext.Device, Frame.DscPools[PoolIndex], 0);
+
+			Frame.CurrentDscPool = 0;
+			Frame.CurrentUniformBlock = 0;
+			Frame.UniformOffset = 0;
+			Frame.UsedSets = 0;
+		}
+	}
+
+	llrm::Context CreateContext(const ContextCreateInfo& ContextInfo)
 	{
 		VulkanContext* VkContext = new ::VulkanContext;
+		VkContext->bHeadless = ContextInfo.bHeadless;
+		VkContext->FramesInFlight = std::max(ContextInfo.FramesInFlight, 1u);
 
 		// Check that all needed instance extenstions are supported
-		GetInstanceExtensions(VkContext->InstanceExtensions);
+		GetInstanceExtensions(VkContext->InstanceExtensions, VkContext->bHeadless);
 		if (!CheckSupportedInstanceExtensions(VkContext->InstanceExtensions))
 		{
 			delete VkContext;
 			return nullptr;
 		}
 
+		// Validation already enables debug utils. Otherwise names and labels are best effort, and skipped when nothing provides the extension.
+		if constexpr (bEnableDebugLabels && !bEnableValidation)
+		{
+			if (CheckSupportedInstanceExtensions({ VK_EXT_DEBUG_UTILS_EXTENSION_NAME }))
+				VkContext->InstanceExtensions.emplace_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		}
+
 		// Check that all needed validation layers are supported
 		if constexpr (bEnableValidation)
 		{
@@ -446,23 +780,40 @@ namespace llrm
 			}
 		}
 
+		if constexpr (bEnableDebugLabels)
+		{
+			VkContext->SetDebugUtilsObjectName = (PFN_vkSetDebugUtilsObjectNameEXT)vkGetInstanceProcAddr(VkContext->Instance, "vkSetDebugUtilsObjectNameEXT");
+			VkContext->CmdBeginDebugUtilsLabel = (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(VkContext->Instance, "vkCmdBeginDebugUtilsLabelEXT");
+			VkContext->CmdEndDebugUtilsLabel = (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(VkContext->Instance, "vkCmdEndDebugUtilsLabelEXT");
+		}
 
-		std::vector<const char*> RequiredDeviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+		std::vector<const char*> RequiredDeviceExtensions;
+		if (!VkContext->bHeadless)
+			RequiredDeviceExtensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
 #ifdef HOST_PLATFORM_OSX
 		// MoltenVK needs this extension
 		RequiredDeviceExtensions.emplace_back("VK_KHR_portability_subset");
 #endif
 
+		// The environment takes precedence, so a device can be pinned without rebuilding the application, e.g. a software rasterizer on CI
+		std::string DeviceSelection = ContextInfo.Device;
+		if (const char* EnvSelection = std::getenv("LLRM_DEVICE"); EnvSelection && *EnvSelection)
+			DeviceSelection = EnvSelection;
+
 		// Find the best physical device for our application
 		if (!PickPhysicalDevice(
 			VkContext->Instance,
 			RequiredDeviceExtensions,
+			DeviceSelection,
 			VkContext->PhysicalDevice,
-			VkContext->GraphicsQueueFamIndex, VkContext->PresentQueueFamIndex)
+			VkContext->GraphicsQueueFamIndex, VkContext->PresentQueueFamIndex,
+			VkContext->bHeadless,
+			VkContext->DeviceCandidates, VkContext->SelectedDevice)
 		)
 		{
-			//GLog->critical("No eligable GPUs found. GPU must have queue families supporting graphics and presentation and have the required extensions.");
+			//GLog->critical("No eligable GPUs found. GPU must have queue families supporting graphics and presentation, have the required extensions and match the device selection.");
 			return nullptr;
 		}
 
@@ -485,9 +836,88 @@ namespace llrm
 			QueueCreateInfos.push_back(UniqueQueueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures SupportedFeatures{};
+		vkGetPhysicalDeviceFeatures(VkContext->PhysicalDevice, &SupportedFeatures);
+
 		VkPhysicalDeviceFeatures UsedDeviceFeatures{};
 		UsedDeviceFeatures.independentBlend = VK_TRUE;
 
+		// Compressed texture families are optional, enable whichever the device has
+		UsedDeviceFeatures.textureCompressionBC = SupportedFeatures.textureCompressionBC;
+		UsedDeviceFeatures.textureCompressionETC2 = SupportedFeatures.textureCompressionETC2;
+		UsedDeviceFeatures.textureCompressionASTC_LDR = SupportedFeatures.textureCompressionASTC_LDR;
+
+		VkContext->EnabledFeatures = UsedDeviceFeatures;
+
+		// Dynamic rendering is optional, render graphs and frame buffers are used without it
+		VkPhysicalDeviceDynamicRenderingFeaturesKHR DynamicRenderingFeatures{};
+		DynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+		if (CheckSupportedPhysicalDeviceExtensions(VkContext->PhysicalDevice, { VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME }))
+		{
+			VkPhysicalDeviceFeatures2 SupportedFeatures2{};
+			SupportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			SupportedFeatures2.pNext = &DynamicRenderingFeatures;
+			vkGetPhysicalDeviceFeatures2(VkContext->PhysicalDevice, &SupportedFeatures2);
+		}
+
+		if (DynamicRenderingFeatures.dynamicRendering == VK_TRUE)
+		{
+			RequiredDeviceExtensions.emplace_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+			VkContext->bDynamicRendering = true;
+		}
+
+		// Conditional rendering is optional too, occlusion query results can still be read back without it
+		VkPhysicalDeviceConditionalRenderingFeaturesEXT ConditionalRenderingFeatures{};
+		ConditionalRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_CONDITIONAL_RENDERING_FEATURES_EXT;
+		if (CheckSupportedPhysicalDeviceExtensions(VkContext->PhysicalDevice, { VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME }))
+		{
+			VkPhysicalDeviceFeatures2 SupportedFeatures2{};
+			SupportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			SupportedFeatures2.pNext = &ConditionalRenderingFeatures;
+			vkGetPhysicalDeviceFeatures2(VkContext->PhysicalDevice, &SupportedFeatures2);
+		}
+
+		if (ConditionalRenderingFeatures.conditionalRendering == VK_TRUE)
+		{
+			RequiredDeviceExtensions.emplace_back(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+			VkContext->bConditionalRendering = true;
+		}
+
+		// Synchronization2 is optional, barriers fall back to the coarser stage masks of vkCmdPipelineBarrier
+		VkPhysicalDeviceSynchronization2FeaturesKHR Synchronization2Features{};
+		Synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+		if (CheckSupportedPhysicalDeviceExtensions(VkContext->PhysicalDevice, { VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME }))
+		{
+			VkPhysicalDeviceFeatures2 SupportedFeatures2{};
+			SupportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			SupportedFeatures2.pNext = &Synchronization2Features;
+			vkGetPhysicalDeviceFeatures2(VkContext->PhysicalDevice, &SupportedFeatures2);
+		}
+
+		if (Synchronization2Features.synchronization2 == VK_TRUE)
+		{
+			RequiredDeviceExtensions.emplace_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+			VkContext->bSynchronization2 = true;
+		}
+
+		// Chain the feature structures of the enabled extensions
+		void* EnabledFeatureChain = nullptr;
+		if (VkContext->bDynamicRendering)
+		{
+			DynamicRenderingFeatures.pNext = EnabledFeatureChain;
+			EnabledFeatureChain = &DynamicRenderingFeatures;
+		}
+		if (VkContext->bConditionalRendering)
+		{
+			ConditionalRenderingFeatures.pNext = EnabledFeatureChain;
+			EnabledFeatureChain = &ConditionalRenderingFeatures;
+		}
+		if (VkContext->bSynchronization2)
+		{
+			Synchronization2Features.pNext = EnabledFeatureChain;
+			EnabledFeatureChain = &Synchronization2Features;
+		}
+
 		VkDeviceCreateInfo DeviceCreateInfo{};
 		DeviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		DeviceCreateInfo.pQueueCreateInfos = QueueCreateInfos.data();
@@ -497,6 +927,7 @@ namespace llrm
 		DeviceCreateInfo.ppEnabledLayerNames = VkContext->ValidationLayers.data();
 		DeviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(RequiredDeviceExtensions.size());
 		DeviceCreateInfo.ppEnabledExtensionNames = RequiredDeviceExtensions.data();
+		DeviceCreateInfo.pNext = EnabledFeatureChain;
 
 		if (vkCreateDevice(VkContext->PhysicalDevice, &DeviceCreateInfo, nullptr, &VkContext->Device) != VK_SUCCESS)
 		{
@@ -507,6 +938,31 @@ namespace llrm
 		vkGetDeviceQueue(VkContext->Device, VkContext->GraphicsQueueFamIndex, 0, &VkContext->GraphicsQueue);
 		vkGetDeviceQueue(VkContext->Device, VkContext->PresentQueueFamIndex, 0, &VkContext->PresentQueue);
 
+		if (VkContext->bDynamicRendering)
+		{
+			VkContext->CmdBeginRendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(VkContext->Device, "vkCmdBeginRenderingKHR");
+			VkContext->CmdEndRendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(VkContext->Device, "vkCmdEndRenderingKHR");
+			VkContext->bDynamicRendering = VkContext->CmdBeginRendering && VkContext->CmdEndRendering;
+		}
+
+		if (VkContext->bConditionalRendering)
+		{
+			VkContext->CmdBeginConditionalRendering = (PFN_vkCmdBeginConditionalRenderingEXT)vkGetDeviceProcAddr(VkContext->Device, "vkCmdBeginConditionalRenderingEXT");
+			VkContext->CmdEndConditionalRendering = (PFN_vkCmdEndConditionalRenderingEXT)vkGetDeviceProcAddr(VkContext->Device, "vkCmdEndConditionalRenderingEXT");
+			VkContext->bConditionalRendering = VkContext->CmdBeginConditionalRendering && VkContext->CmdEndConditionalRendering;
+		}
+
+		if (VkContext->bSynchronization2)
+		{
+			VkContext->CmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(VkContext->Device, "vkCmdPipelineBarrier2KHR");
+			VkContext->bSynchronization2 = VkContext->CmdPipelineBarrier2 != nullptr;
+		}
+
+		VkContext->UniformBufferAlignment = std::max<uint64_t>(DeviceProperties.limits.minUniformBufferOffsetAlignment, 1);
+		VkContext->BufferSliceAlignment = std::max<uint64_t>({ VkContext->UniformBufferAlignment,
+			DeviceProperties.limits.minStorageBufferOffsetAlignment,
+			DeviceProperties.limits.minTexelBufferOffsetAlignment });
+
 		// Create the primary command pool
 		VkCommandPoolCreateInfo CmdPoolCreateInfo{};
 		CmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -520,33 +976,25 @@ namespace llrm
 		}
 
 		// Give ImGui an oversized descriptor pool
-		VkDescriptorPoolSize PoolSizes[] =
+		if (!CreateVkDescriptorPool(VkContext->Device, 10000, true, VkContext->MainDscPool))
 		{
-			{ VK_DESCRIPTOR_TYPE_SAMPLER, 10000 },
-			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 10000 },
-			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 10000 },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 10000 },
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 10000 },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 10000 },
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10000 },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 10000 },
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 10000 },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 10000 },
-			{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 10000 }
-		};
+			//GLog->critical("Failed to create primary descriptor pool");
+			return nullptr;
+		}
 
-		// Create primary descriptor pool
-		VkDescriptorPoolCreateInfo DscPoolCreateInfo{};
-		DscPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		DscPoolCreateInfo.maxSets = 10000;
-		DscPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(std::size(PoolSizes));
-		DscPoolCreateInfo.pPoolSizes = PoolSizes;
-		DscPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		// Frame fences start signaled, since no frame is in flight yet
+		VkFenceCreateInfo FenceCreate{};
+		FenceCreate.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		FenceCreate.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		if (vkCreateDescriptorPool(VkContext->Device, &DscPoolCreateInfo, nullptr, &VkContext->MainDscPool) != VK_SUCCESS)
+		VkContext->FrameFences.resize(VkContext->FramesInFlight, VK_NULL_HANDLE);
+		for (VkFence& FrameFence : VkContext->FrameFences)
 		{
-			//GLog->critical("Failed to create primary descriptor pool");
-			return nullptr;
+			if (vkCreateFence(VkContext->Device, &FenceCreate, nullptr, &FrameFence) != VK_SUCCESS)
+			{
+				//GLog->critical("Failed to create frame fence");
+				return nullptr;
+			}
 		}
 
 		GVulkanContext = *VkContext;
@@ -572,13 +1020,56 @@ namespace llrm
 			}*/
 		}
 
-		// Cleanup primary descriptor pool
-		vkDestroyDescriptorPool(VkContext->Device, VkContext->MainDscPool, nullptr);
+		vkDeviceWaitIdle(VkContext->Device);
 
-		// Cleanup primary command pool
-		vkDestroyCommandPool(VkContext->Device, VkContext->MainCommandPool, nullptr);
+		for (VkFence FrameFence : VkContext->FrameFences)
+			vkDestroyFence(VkContext->Device, FrameFence, nullptr);
 
-		// Cleanup logical device
+		// Cleanup the pools of every thread, which frees all of the command buffers and resource sets allocated from them
+		{
+			std::lock_guard<std::mutex> RegistryLock(GThreadPoolsMutex);
+			for (VulkanThreadPools* Pools : GThreadPools)
+			{
+				for (VkDescriptorPool DscPool : Pools->DscPools)
+					vkDestroyDescriptorPool(VkContext->Device, DscPool, nullptr);
+
+				for (VulkanTransientFrame& Frame : Pools->TransientFrames)
+				{
+					for (VkDescriptorPool DscPool : Frame.DscPools)
+						vkDestroyDescriptorPool(VkContext->Device, DscPool, nullptr);
+
+					for (const VulkanUniformBlock& Block : Frame.UniformBlocks)
+					{
+						vkDestroyBuffer(VkContext->Device, Block.Buffer, nullptr);
+						vkFreeMemory(VkContext->Device, Block.Memory, nullptr);
+					}
+
+					for (VulkanResourceSet* Set : Frame.Sets)
+						delete Set;
+				}
+
+				vkDestroyCommandPool(VkContext->Device, Pools->CommandPool, nullptr);
+				delete Pools;
+			}
+
+			GThreadPools.clear();
+			GThreadPoolsGeneration++;
+		}
+
+		// Shared objects that are still referenced belong to the device being destroyed
+		GSamplerCache.Clear();
+		GResourceLayoutCache.Clear();
+		GRenderGraphCache.Clear();
+		GPipelineCache.Clear();
+		GShaderModuleCache.Clear();
+
+		// Cleanup primary descriptor pool
+		vkDestroyDescriptorPool(VkContext->Device, VkContext->MainDscPool, nullptr);
+
+		// Cleanup primary command pool
+		vkDestroyCommandPool(VkContext->Device, VkContext->MainCommandPool, nullptr);
+
+		// Cleanup logical device
 		vkDestroyDevice(VkContext->Device, nullptr);
 
 		// Destroy debug messenger if validation is enabled
@@ -611,13 +1102,79 @@ namespace llrm
 
 			Result.MaxImageArrayLayers = Limits.maxImageArrayLayers;
 			Result.MaxTextureSize = Limits.maxImageDimension2D;
+
+			VkPhysicalDeviceMemoryProperties MemProperties;
+			vkGetPhysicalDeviceMemoryProperties(GVulkanContext.PhysicalDevice, &MemProperties);
+			for (uint32_t MemTypeIndex = 0; MemTypeIndex < MemProperties.memoryTypeCount; MemTypeIndex++)
+			{
+				if (MemProperties.memoryTypes[MemTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+					Result.bLazilyAllocatedMemory = true;
+			}
+
+			Result.bDynamicRendering = GVulkanContext.bDynamicRendering;
+			Result.bConditionalRendering = GVulkanContext.bConditionalRendering;
+			Result.bSynchronization2 = GVulkanContext.bSynchronization2;
+
+			Result.bTextureCompressionBC = GVulkanContext.EnabledFeatures.textureCompressionBC;
+			Result.bTextureCompressionETC2 = GVulkanContext.EnabledFeatures.textureCompressionETC2;
+			Result.bTextureCompressionASTC = GVulkanContext.EnabledFeatures.textureCompressionASTC_LDR;
+
+			// A compressed format is only usable if it can be sampled and uploaded to
+			const VkFormatFeatureFlags RequiredFeatures = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+			for (uint32_t Format = static_cast<uint32_t>(AttachmentFormat::BC1_RGBA_UNORM); Format <= static_cast<uint32_t>(AttachmentFormat::ASTC_8x8_SRGB); Format++)
+			{
+				AttachmentFormat Compressed = static_cast<AttachmentFormat>(Format);
+
+				VkFormatProperties FormatProps{};
+				vkGetPhysicalDeviceFormatProperties(GVulkanContext.PhysicalDevice, AttachmentFormatToVkFormat(Compressed), &FormatProps);
+
+				if ((FormatProps.optimalTilingFeatures & RequiredFeatures) == RequiredFeatures)
+					Result.CompressedFormats.push_back(Compressed);
+			}
+
+			VkFormatProperties PackedProps{};
+			vkGetPhysicalDeviceFormatProperties(GVulkanContext.PhysicalDevice, VK_FORMAT_A2B10G10R10_SNORM_PACK32, &PackedProps);
+			Result.bPackedSNormVertexFormat = (PackedProps.bufferFeatures & VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT) != 0;
 		}
 
 		return Result;
 	}
 
+	DeviceInfo GetDeviceInfo()
+	{
+		if (GVulkanContext.SelectedDevice < 0)
+			return {};
+
+		return GVulkanContext.DeviceCandidates[GVulkanContext.SelectedDevice];
+	}
+
+	std::vector<DeviceInfo> GetDeviceCandidates()
+	{
+		return GVulkanContext.DeviceCandidates;
+	}
+
+	CacheStats GetCacheStats()
+	{
+		CacheStats Result;
+		Result.Samplers = GSamplerCache.GetCounters();
+		Result.ResourceLayouts = GResourceLayoutCache.GetCounters();
+		Result.RenderGraphs = GRenderGraphCache.GetCounters();
+		Result.Pipelines = GPipelineCache.GetCounters();
+		Result.ShaderModules = GShaderModuleCache.GetCounters();
+
+		return Result;
+	}
+
 	Surface CreateSurface(GLFWwindow* Window)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateSurface);
+
+		if (GVulkanContext.bHeadless)
+		{
+			//GLog->error("Can't create a surface with a headless context");
+			return nullptr;
+		}
+
 		VulkanSurface* NewSurface = new VulkanSurface;
 
 		if (glfwCreateWindowSurface(GVulkanContext.Instance, Window, nullptr, &NewSurface->VkSurface) != VK_SUCCESS)
@@ -630,14 +1187,16 @@ namespace llrm
 
 		RECORD_RESOURCE_ALLOC(NewSurface)
 
-		return NewSurface;
+		return LLRM_CAPTURE_RESULT(NewSurface);
 	}
 
 	void DestroySurface(Surface Surface)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroySurface, Surface);
+
 		VulkanSurface* VkSurface = static_cast<VulkanSurface*>(Surface);
 
-		vkDeviceWaitIdle(GVulkanContext.Device);
+		WaitDeviceIdle();
 
 		// Cleanup primary surface
 		vkDestroySurfaceKHR(GVulkanContext.Instance, VkSurface->VkSurface, nullptr);
@@ -647,10 +1206,58 @@ namespace llrm
 		delete VkSurface;
 	}
 
-	void VkCmdBuffer(CommandBuffer Cmd, std::function<void(VkCommandBuffer&)> Inner)
+	// A template so recording a command doesn't wrap the lambda in a std::function, which can allocate
+	template<typename Func>
+	void VkCmdBuffer(CommandBuffer Cmd, Func&& Inner)
 	{
 		VulkanCommandBuffer* VkCmd = static_cast<VulkanCommandBuffer*>(Cmd);
 		Inner(VkCmd->CmdBuffer);
+	}
+
+	/*
+	 * An array that keeps its first N elements inline and only allocates past them, for the Vulkan structures built while recording.
+	 * Elements are value initialized.
+	 */
+	template<typename T, size_t N>
+	class InlineArray
+	{
+	public:
+
+		InlineArray() = default;
+		explicit InlineArray(size_t InitialSize) { resize(InitialSize); }
+
+		InlineArray(const InlineArray&) = delete;
+		InlineArray& operator=(const InlineArray&) = delete;
+
+		void resize(size_t NewSize)
+		{
+			if (NewSize > N && Overflow.empty())
+				Overflow.assign(Inline, Inline + Count);
+			if (!Overflow.empty() || NewSize > N)
+				Overflow.resize(NewSize);
+			else
+				std::fill(Inline + std::min(Count, NewSize), Inline + NewSize, T{});
+
+			Count = NewSize;
+		}
+
+		T& emplace_back()
+		{
+			resize(Count + 1);
+			return data()[Count - 1];
+		}
+
+		void pop_back() { resize(Count - 1); }
+
+		T* data() { return Overflow.empty() ? Inline : Overflow.data(); }
+		size_t size() const { return Count; }
+		bool empty() const { return Count == 0; }
+		T& operator[](size_t Index) { return data()[Index]; }
+
+	private:
+		T Inline[N]{};
+		std::vector<T> Overflow;
+		size_t Count = 0;
 	};
 
 	VkImageViewType AttachmentViewTypeToVk(TextureViewType Type)
@@ -689,6 +1296,50 @@ namespace llrm
 			return VK_FORMAT_R32G32B32A32_SFLOAT;
 		case AttachmentFormat::R8_UINT:
 			return VK_FORMAT_R8_UINT;
+		case AttachmentFormat::BC1_RGBA_UNORM:
+			return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case AttachmentFormat::BC1_RGBA_SRGB:
+			return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		case AttachmentFormat::BC2_UNORM:
+			return VK_FORMAT_BC2_UNORM_BLOCK;
+		case AttachmentFormat::BC2_SRGB:
+			return VK_FORMAT_BC2_SRGB_BLOCK;
+		case AttachmentFormat::BC3_UNORM:
+			return VK_FORMAT_BC3_UNORM_BLOCK;
+		case AttachmentFormat::BC3_SRGB:
+			return VK_FORMAT_BC3_SRGB_BLOCK;
+		case AttachmentFormat::BC4_UNORM:
+			return VK_FORMAT_BC4_UNORM_BLOCK;
+		case AttachmentFormat::BC4_SNORM:
+			return VK_FORMAT_BC4_SNORM_BLOCK;
+		case AttachmentFormat::BC5_UNORM:
+			return VK_FORMAT_BC5_UNORM_BLOCK;
+		case AttachmentFormat::BC5_SNORM:
+			return VK_FORMAT_BC5_SNORM_BLOCK;
+		case AttachmentFormat::BC6H_UFLOAT:
+			return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+		case AttachmentFormat::BC6H_SFLOAT:
+			return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+		case AttachmentFormat::BC7_UNORM:
+			return VK_FORMAT_BC7_UNORM_BLOCK;
+		case AttachmentFormat::BC7_SRGB:
+			return VK_FORMAT_BC7_SRGB_BLOCK;
+		case AttachmentFormat::ETC2_R8G8B8_UNORM:
+			return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+		case AttachmentFormat::ETC2_R8G8B8_SRGB:
+			return VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK;
+		case AttachmentFormat::ETC2_R8G8B8A8_UNORM:
+			return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+		case AttachmentFormat::ETC2_R8G8B8A8_SRGB:
+			return VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK;
+		case AttachmentFormat::ASTC_4x4_UNORM:
+			return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+		case AttachmentFormat::ASTC_4x4_SRGB:
+			return VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
+		case AttachmentFormat::ASTC_8x8_UNORM:
+			return VK_FORMAT_ASTC_8x8_UNORM_BLOCK;
+		case AttachmentFormat::ASTC_8x8_SRGB:
+			return VK_FORMAT_ASTC_8x8_SRGB_BLOCK;
 		case AttachmentFormat::D24_UNORM_S8_UINT:
 			VkFormat DepthStencilFormat = VK_FORMAT_D24_UNORM_S8_UINT;
 			VkFormatProperties FormatProps;
@@ -743,6 +1394,8 @@ namespace llrm
 			return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		case AttachmentUsage::ShaderReadDepthStencil:
 			return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		case AttachmentUsage::ShaderReadWrite:
+			return VK_IMAGE_LAYOUT_GENERAL; // Storage images must be in the general layout
 		case AttachmentUsage::Undefined:
 			return VK_IMAGE_LAYOUT_UNDEFINED;
 		default:
@@ -750,6 +1403,34 @@ namespace llrm
 		}
 	}
 
+	VkAttachmentLoadOp LoadOpToVkLoadOp(AttachmentLoadOp Op)
+	{
+		switch (Op)
+		{
+		case AttachmentLoadOp::Clear:
+			return VK_ATTACHMENT_LOAD_OP_CLEAR;
+		case AttachmentLoadOp::Load:
+			return VK_ATTACHMENT_LOAD_OP_LOAD;
+		case AttachmentLoadOp::DontCare:
+			return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		}
+
+		return VK_ATTACHMENT_LOAD_OP_CLEAR;
+	}
+
+	VkAttachmentStoreOp StoreOpToVkStoreOp(AttachmentStoreOp Op)
+	{
+		switch (Op)
+		{
+		case AttachmentStoreOp::Store:
+			return VK_ATTACHMENT_STORE_OP_STORE;
+		case AttachmentStoreOp::DontCare:
+			return VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		}
+
+		return VK_ATTACHMENT_STORE_OP_STORE;
+	}
+
 	VkBlendOp BlendOpToVkBlend(BlendOperation Operator)
 	{
 		switch (Operator)
@@ -765,6 +1446,31 @@ namespace llrm
 		return VK_BLEND_OP_ADD;
 	}
 
+	VkCompareOp CompareOpToVkCompareOp(CompareOp Op)
+	{
+		switch (Op)
+		{
+		case CompareOp::Never:
+			return VK_COMPARE_OP_NEVER;
+		case CompareOp::Less:
+			return VK_COMPARE_OP_LESS;
+		case CompareOp::Equal:
+			return VK_COMPARE_OP_EQUAL;
+		case CompareOp::LessOrEqual:
+			return VK_COMPARE_OP_LESS_OR_EQUAL;
+		case CompareOp::Greater:
+			return VK_COMPARE_OP_GREATER;
+		case CompareOp::NotEqual:
+			return VK_COMPARE_OP_NOT_EQUAL;
+		case CompareOp::GreaterOrEqual:
+			return VK_COMPARE_OP_GREATER_OR_EQUAL;
+		case CompareOp::Always:
+			return VK_COMPARE_OP_ALWAYS;
+		}
+
+		return VK_COMPARE_OP_LESS;
+	}
+
 	VkFilter FilterToVkFilter(FilterType Filter)
 	{
 		switch (Filter)
@@ -854,6 +1560,8 @@ namespace llrm
 			ViewportHeight = VkCmd->CurrentSwapChain->SwapChainExtent.height;
 		else if (VkCmd->CurrentFbo)
 			ViewportHeight = VkCmd->CurrentFbo->AttachmentHeight;
+		else if (VkCmd->bDynamicRendering)
+			ViewportHeight = VkCmd->RenderingHeight;
 		//else
 		//	GLog->error("Invalid swap chain");
 
@@ -900,6 +1608,8 @@ namespace llrm
 
 	void Reset(CommandBuffer Buf)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::Reset, Buf);
+
 		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
 			vkResetCommandBuffer(CmdBuffer, 0);
@@ -908,6 +1618,8 @@ namespace llrm
 
 	void Begin(CommandBuffer Buf)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::Begin, Buf);
+
 		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
 			VulkanCommandBuffer* VkCmd = static_cast<VulkanCommandBuffer*>(Buf);
@@ -924,99 +1636,118 @@ namespace llrm
 		});
 	}
 
-	void TransitionCmd(VkCommandBuffer Buf, 
-		VkImage Img, 
-		VkImageAspectFlags AspectFlags, 
-		AttachmentUsage Old, 
-		AttachmentUsage New, 
+	// Gets how an image is accessed while it's in a particular usage, as either the source or destination of a transition
+	bool GetUsageAccess(AttachmentUsage Usage, bool bSource, VkAccessFlags& Access, VkPipelineStageFlags& Stages)
+	{
+		switch (Usage)
+		{
+		case AttachmentUsage::Undefined:
+			if (!bSource)
+				return false; // Can't transition to undefined
+			Access = 0;
+			Stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			return true;
+		case AttachmentUsage::Presentation:
+			// The presentation engine synchronizes with semaphores, so there's nothing to make available or visible
+			Access = 0;
+			Stages = bSource ? VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			return true;
+		case AttachmentUsage::ColorAttachment:
+			Access = bSource ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			Stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			return true;
+		case AttachmentUsage::DepthStencilAttachment:
+			Access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+			Stages = bSource ? VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT : VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			return true;
+		case AttachmentUsage::ShaderReadDepthStencil:
+			Access = bSource ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT : VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+			Stages = bSource ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT : VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			return true;
+		case AttachmentUsage::ShaderRead:
+			Access = VK_ACCESS_SHADER_READ_BIT;
+			Stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			return true;
+		case AttachmentUsage::ShaderReadWrite:
+			Access = bSource ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			Stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			return true;
+		case AttachmentUsage::TransferDestination:
+			Access = VK_ACCESS_TRANSFER_WRITE_BIT;
+			Stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			return true;
+		case AttachmentUsage::TransferSource:
+			Access = VK_ACCESS_TRANSFER_READ_BIT;
+			Stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Read-only usages have no writes to wait for, so keeping one is a no-op. Writable usages still wait for the previous writes.
+	bool IsRedundantTransition(AttachmentUsage Old, AttachmentUsage New, bool bDiscard)
+	{
+		if (Old != New || bDiscard)
+			return false;
+
+		return Old == AttachmentUsage::ShaderRead || Old == AttachmentUsage::ShaderReadDepthStencil ||
+			Old == AttachmentUsage::TransferSource || Old == AttachmentUsage::Presentation;
+	}
+
+	bool FillTransitionBarrier(VkImageMemoryBarrier& ImageMemBarrier,
+		VkPipelineStageFlags& SourceStage,
+		VkPipelineStageFlags& DstStage,
+		VkImage Img,
+		VkImageAspectFlags AspectFlags,
+		AttachmentUsage Old,
+		AttachmentUsage New,
 		uint32_t BaseLayer,
-		uint32_t LayerCount
+		uint32_t LayerCount,
+		uint32_t BaseMip,
+		uint32_t MipCount,
+		bool bDiscard
 	)
 	{
-		VkImageMemoryBarrier ImageMemBarrier{};
+		ImageMemBarrier = {};
 		ImageMemBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		ImageMemBarrier.oldLayout = AttachmentUsageToVkLayout(Old);
+		ImageMemBarrier.oldLayout = bDiscard ? VK_IMAGE_LAYOUT_UNDEFINED : AttachmentUsageToVkLayout(Old);
 		ImageMemBarrier.newLayout = AttachmentUsageToVkLayout(New);
 		ImageMemBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED; // Don't currently support queue family transfer
 		ImageMemBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		ImageMemBarrier.image = Img;
 		ImageMemBarrier.subresourceRange.aspectMask = AspectFlags;
-		ImageMemBarrier.subresourceRange.baseMipLevel = 0;
-		ImageMemBarrier.subresourceRange.levelCount = 1;
+		ImageMemBarrier.subresourceRange.baseMipLevel = BaseMip;
+		ImageMemBarrier.subresourceRange.levelCount = MipCount; // MIP_LEVELS_REMAINING matches VK_REMAINING_MIP_LEVELS
 		ImageMemBarrier.subresourceRange.baseArrayLayer = BaseLayer;
-		ImageMemBarrier.subresourceRange.layerCount = LayerCount;
-
-		VkPipelineStageFlags SourceStage;
-		VkPipelineStageFlags DstStage;
+		ImageMemBarrier.subresourceRange.layerCount = LayerCount; // ARRAY_LAYERS_REMAINING matches VK_REMAINING_ARRAY_LAYERS
 
-		// Here's the hard part. We have to specify possible masks/stages for image layout transitions, so below are the most common ones.
-
-		if (Old == AttachmentUsage::Undefined)
-		{
-			ImageMemBarrier.srcAccessMask = 0;
-			SourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-		}
-		else if (Old == AttachmentUsage::ShaderRead)
-		{
-			ImageMemBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			SourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		}
-		else if (Old == AttachmentUsage::DepthStencilAttachment)
-		{
-			ImageMemBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-			SourceStage = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-		}
-		else if (Old == AttachmentUsage::ShaderReadDepthStencil)
-		{
-			ImageMemBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-			SourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		}
-		else if (Old == AttachmentUsage::TransferDestination)
-		{
-			ImageMemBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			SourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		else if (Old == AttachmentUsage::TransferSource)
-		{
-			ImageMemBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-			SourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		else
+		if (!GetUsageAccess(Old, true, ImageMemBarrier.srcAccessMask, SourceStage) || !GetUsageAccess(New, false, ImageMemBarrier.dstAccessMask, DstStage))
 		{
 			//GLog->critical("Vulkan image layout transition not supported");
-			return;
+			return false;
 		}
 
-		if (New == AttachmentUsage::ColorAttachment)
-		{
-			ImageMemBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			DstStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		}
-		else if (New == AttachmentUsage::DepthStencilAttachment)
-		{
-			ImageMemBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-			DstStage = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-		}
-		else if (New == AttachmentUsage::ShaderRead)
-		{
-			ImageMemBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			DstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		}
-		else if (New == AttachmentUsage::TransferDestination)
-		{
-			ImageMemBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			DstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		else if (New == AttachmentUsage::TransferSource)
-		{
-			ImageMemBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-			DstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		else
-		{
-			//GLog->critical("Vulkan image layout transition not supported");
+		return true;
+	}
+
+	void TransitionCmd(VkCommandBuffer Buf, 
+		VkImage Img, 
+		VkImageAspectFlags AspectFlags, 
+		AttachmentUsage Old, 
+		AttachmentUsage New, 
+		uint32_t BaseLayer,
+		uint32_t LayerCount,
+		uint32_t BaseMip = 0,
+		uint32_t MipCount = MIP_LEVELS_REMAINING
+	)
+	{
+		VkImageMemoryBarrier ImageMemBarrier;
+		VkPipelineStageFlags SourceStage;
+		VkPipelineStageFlags DstStage;
+
+		if (!FillTransitionBarrier(ImageMemBarrier, SourceStage, DstStage, Img, AspectFlags, Old, New, BaseLayer, LayerCount, BaseMip, MipCount, false))
 			return;
-		}
 
 		vkCmdPipelineBarrier
 		(
@@ -1030,38 +1761,124 @@ namespace llrm
 		);
 	}
 
+	VkImageAspectFlags GetImageAspectFlags(AttachmentFormat Format)
+	{
+		VkImageAspectFlags Flags = 0;
+		if (IsColorFormat(Format))
+			Flags |= VK_IMAGE_ASPECT_COLOR_BIT;
+		if (IsDepthFormat(Format))
+			Flags |= VK_IMAGE_ASPECT_DEPTH_BIT;
+		if (IsStencilFormat(Format))
+			Flags |= VK_IMAGE_ASPECT_STENCIL_BIT;
+
+		return Flags;
+	}
+
 	void TransitionTexture(CommandBuffer Buf, Texture Image, AttachmentUsage Old,
-		AttachmentUsage New, uint32_t BaseLayer, uint32_t LayerCount)
+		AttachmentUsage New, uint32_t BaseLayer, uint32_t LayerCount, uint32_t BaseMip, uint32_t MipCount)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::TransitionTexture, Buf, Image, Old, New, BaseLayer, LayerCount, BaseMip, MipCount);
+
+		if (IsRedundantTransition(Old, New, false))
+			return;
+
 		VulkanTexture* VkTexture = static_cast<VulkanTexture*>(Image);
 
 		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
-			VkImageAspectFlags Flags = 0;
-			if (IsColorFormat(VkTexture->TextureFormat))
-				Flags |= VK_IMAGE_ASPECT_COLOR_BIT;
-			if (IsDepthFormat(VkTexture->TextureFormat))
-				Flags |= VK_IMAGE_ASPECT_DEPTH_BIT;
-			if (IsStencilFormat(VkTexture->TextureFormat))
-				Flags |= VK_IMAGE_ASPECT_STENCIL_BIT;
+			VkImageAspectFlags Flags = GetImageAspectFlags(VkTexture->TextureFormat);
+
+			TransitionCmd(CmdBuffer, VkTexture->TextureImage, Flags, Old, New, BaseLayer, LayerCount, BaseMip, MipCount);
+		});
+	}
+
+	void TransitionTextures(CommandBuffer Buf, std::span<const TextureTransition> Transitions)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::TransitionTextures, Buf, Transitions);
+
+		PipelineBarrier(Buf, Transitions, {});
+	}
+
+	void GenerateMips(CommandBuffer Buf, Texture Tex, AttachmentUsage PreviousUsage, AttachmentUsage FinalUsage)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::GenerateMips, Buf, Tex, PreviousUsage, FinalUsage);
+
+		VulkanTexture* VkTexture = static_cast<VulkanTexture*>(Tex);
+		VkImageAspectFlags Aspect = GetImageAspectFlags(VkTexture->TextureFormat);
+
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
+		{
+			if(VkTexture->MipLevels <= 1 || IsCompressedFormat(VkTexture->TextureFormat))
+			{
+				if(PreviousUsage != FinalUsage)
+					TransitionCmd(CmdBuffer, VkTexture->TextureImage, Aspect, PreviousUsage, FinalUsage, 0, VkTexture->Layers, 0, MIP_LEVELS_REMAINING);
+				return;
+			}
+
+			// Linear filtering during blits is an optional format feature, fall back to nearest if it's missing
+			VkFormatProperties FormatProps{};
+			vkGetPhysicalDeviceFormatProperties(GVulkanContext.PhysicalDevice, AttachmentFormatToVkFormat(VkTexture->TextureFormat), &FormatProps);
+			VkFilter BlitFilter = (FormatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+			// The base level is the first blit source, the rest of the chain is overwritten so its contents can be discarded
+			TransitionCmd(CmdBuffer, VkTexture->TextureImage, Aspect, PreviousUsage, AttachmentUsage::TransferSource, 0, VkTexture->Layers, 0, 1);
+			TransitionCmd(CmdBuffer, VkTexture->TextureImage, Aspect, AttachmentUsage::Undefined, AttachmentUsage::TransferDestination, 0, VkTexture->Layers, 1, MIP_LEVELS_REMAINING);
 
-			TransitionCmd(CmdBuffer, VkTexture->TextureImage, Flags, Old, New, BaseLayer, LayerCount);
+			int32_t MipWidth = static_cast<int32_t>(VkTexture->Width);
+			int32_t MipHeight = static_cast<int32_t>(VkTexture->Height);
+			for(uint32_t Mip = 1; Mip < VkTexture->MipLevels; Mip++)
+			{
+				int32_t NextWidth = MipWidth > 1 ? MipWidth / 2 : 1;
+				int32_t NextHeight = MipHeight > 1 ? MipHeight / 2 : 1;
+
+				VkImageBlit Blit{};
+				Blit.srcSubresource.aspectMask = Aspect;
+				Blit.srcSubresource.mipLevel = Mip - 1;
+				Blit.srcSubresource.baseArrayLayer = 0;
+				Blit.srcSubresource.layerCount = VkTexture->Layers;
+				Blit.srcOffsets[0] = { 0, 0, 0 };
+				Blit.srcOffsets[1] = { MipWidth, MipHeight, 1 };
+				Blit.dstSubresource.aspectMask = Aspect;
+				Blit.dstSubresource.mipLevel = Mip;
+				Blit.dstSubresource.baseArrayLayer = 0;
+				Blit.dstSubresource.layerCount = VkTexture->Layers;
+				Blit.dstOffsets[0] = { 0, 0, 0 };
+				Blit.dstOffsets[1] = { NextWidth, NextHeight, 1 };
+
+				vkCmdBlitImage(CmdBuffer,
+					VkTexture->TextureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					VkTexture->TextureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					1, &Blit,
+					BlitFilter
+				);
+
+				// This level becomes the source of the next blit
+				TransitionCmd(CmdBuffer, VkTexture->TextureImage, Aspect, AttachmentUsage::TransferDestination, AttachmentUsage::TransferSource, 0, VkTexture->Layers, Mip, 1);
+
+				MipWidth = NextWidth;
+				MipHeight = NextHeight;
+			}
+
+			// The whole chain is now a transfer source
+			TransitionCmd(CmdBuffer, VkTexture->TextureImage, Aspect, AttachmentUsage::TransferSource, FinalUsage, 0, VkTexture->Layers);
 		});
 	}
 
 	void End(CommandBuffer Buf)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::End, Buf);
+
 		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
 			vkEndCommandBuffer(CmdBuffer);
 		});
 	}
 
-	void GetVkClearValues(std::vector<ClearValue> ClearValues, std::vector<VkClearValue>& OutVkValues)
+	void GetVkClearValues(std::span<const ClearValue> ClearValues, VkClearValue* OutVkValues)
 	{
 		for (uint32_t ClearValueIndex = 0; ClearValueIndex < ClearValues.size(); ClearValueIndex++)
 		{
-			ClearValue& CV = ClearValues[ClearValueIndex];
+			const ClearValue& CV = ClearValues[ClearValueIndex];
 			VkClearValue ClearValue{};
 			if (CV.Clear == ClearType::Float)
 			{
@@ -1079,8 +1896,10 @@ namespace llrm
 		}
 	}
 	
-	void BeginRenderGraph(CommandBuffer Buf, RenderGraph Graph, FrameBuffer Target, std::vector<ClearValue> ClearValues)
+	void BeginRenderGraph(CommandBuffer Buf, RenderGraph Graph, FrameBuffer Target, std::span<const ClearValue> ClearValues)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::BeginRenderGraph, Buf, Graph, Target, ClearValues);
+
 		VulkanRenderGraph* VkRg = static_cast<VulkanRenderGraph*>(Graph);
 		VulkanFrameBuffer* VkFbo = static_cast<VulkanFrameBuffer*>(Target);
 		VulkanCommandBuffer* VkCmd = static_cast<VulkanCommandBuffer*>(Buf);
@@ -1096,8 +1915,8 @@ namespace llrm
 			RpBeginInfo.renderArea.offset = { 0, 0 };
 			RpBeginInfo.renderArea.extent = { VkFbo->AttachmentWidth, VkFbo->AttachmentHeight };
 
-			std::vector<VkClearValue> VkValues(ClearValues.size());
-			GetVkClearValues(ClearValues, VkValues);
+			InlineArray<VkClearValue, MAX_OUTPUT_COLORS + 1> VkValues(ClearValues.size());
+			GetVkClearValues(ClearValues, VkValues.data());
 
 			RpBeginInfo.clearValueCount = static_cast<uint32_t>(VkValues.size());
 			RpBeginInfo.pClearValues = VkValues.data();
@@ -1106,21 +1925,91 @@ namespace llrm
 		});
 	}
 
+	void FillRenderingAttachment(const RenderingAttachment& Attachment, VkImageLayout Layout, bool bStencil, VkRenderingAttachmentInfoKHR& OutInfo)
+	{
+		OutInfo = {};
+		OutInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+		OutInfo.imageView = static_cast<VulkanTextureView*>(Attachment.View)->ImageView;
+		OutInfo.imageLayout = Layout;
+		OutInfo.resolveMode = VK_RESOLVE_MODE_NONE;
+		OutInfo.loadOp = LoadOpToVkLoadOp(bStencil ? Attachment.StencilLoadOp : Attachment.LoadOp);
+		OutInfo.storeOp = StoreOpToVkStoreOp(bStencil ? Attachment.StencilStoreOp : Attachment.StoreOp);
+
+		GetVkClearValues({ &Attachment.Clear, 1 }, &OutInfo.clearValue);
+	}
+
+	void BeginRenderGraph(CommandBuffer Buf, const RenderingInfo& Info)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::BeginRendering, Buf, Info);
+
+		VulkanCommandBuffer* VkCmd = static_cast<VulkanCommandBuffer*>(Buf);
+
+		VkCmd->bDynamicRendering = true;
+		VkCmd->RenderingHeight = Info.Height;
+
+		InlineArray<VkRenderingAttachmentInfoKHR, MAX_OUTPUT_COLORS> ColorAttachments(Info.ColorAttachments.size());
+		for (uint32_t Attachment = 0; Attachment < Info.ColorAttachments.size(); Attachment++)
+			FillRenderingAttachment(Info.ColorAttachments[Attachment], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, false, ColorAttachments[Attachment]);
+
+		// The only depth format has a stencil aspect too, so the same view is used for both
+		VkRenderingAttachmentInfoKHR DepthAttachment{};
+		VkRenderingAttachmentInfoKHR StencilAttachment{};
+		bool bDepthStencil = Info.DepthStencilAttachment.View != nullptr;
+		if (bDepthStencil)
+		{
+			FillRenderingAttachment(Info.DepthStencilAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, false, DepthAttachment);
+			FillRenderingAttachment(Info.DepthStencilAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true, StencilAttachment);
+		}
+
+		VkRenderingInfoKHR RenderingBeginInfo{};
+		RenderingBeginInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		RenderingBeginInfo.renderArea.offset = { 0, 0 };
+		RenderingBeginInfo.renderArea.extent = { Info.Width, Info.Height };
+		RenderingBeginInfo.layerCount = 1;
+		RenderingBeginInfo.colorAttachmentCount = static_cast<uint32_t>(ColorAttachments.size());
+		RenderingBeginInfo.pColorAttachments = ColorAttachments.data();
+		RenderingBeginInfo.pDepthAttachment = bDepthStencil ? &DepthAttachment : nullptr;
+		RenderingBeginInfo.pStencilAttachment = bDepthStencil ? &StencilAttachment : nullptr;
+
+		GVulkanContext.CmdBeginRendering(VkCmd->CmdBuffer, &RenderingBeginInfo);
+	}
+
 	void EndRenderGraph(CommandBuffer Buf)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::EndRenderGraph, Buf);
+
 		VulkanCommandBuffer* VkCmd = static_cast<VulkanCommandBuffer*>(Buf);
 
 		VkCmd->CurrentSwapChain = nullptr;
 		VkCmd->CurrentFbo = nullptr;
 
+		if (VkCmd->bDynamicRendering)
+		{
+			VkCmd->bDynamicRendering = false;
+			GVulkanContext.CmdEndRendering(VkCmd->CmdBuffer);
+			return;
+		}
+
 		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
 			vkCmdEndRenderPass(CmdBuffer);
 		});
 	}
 
+	void NextPass(CommandBuffer Buf)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::NextPass, Buf);
+
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
+		{
+			vkCmdNextSubpass(CmdBuffer, VK_SUBPASS_CONTENTS_INLINE);
+		});
+	}
+
 	void BindPipeline(CommandBuffer Buf, Pipeline PipelineObject)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::BindPipeline, Buf, PipelineObject);
+
 		VulkanCommandBuffer* VkCmd = static_cast<VulkanCommandBuffer*>(Buf);
 		VulkanPipeline* VkPipeline = reinterpret_cast<VulkanPipeline*>(PipelineObject);
 
@@ -1129,35 +2018,46 @@ namespace llrm
 
 		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
-			vkCmdBindPipeline(CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, VkPipeline->Pipeline);
+			vkCmdBindPipeline(CmdBuffer, VkPipeline->BindPoint, VkPipeline->Pipeline);
 		});
 	}
 
-	void BindResources(CommandBuffer Buf, std::vector<ResourceSet> Resources)
+	void BindResources(CommandBuffer Buf, std::span<const ResourceSet> Resources)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::BindResources, Buf, Resources);
+
+		BindResources(Buf, Resources, {});
+	}
+
+	void BindResources(CommandBuffer Buf, std::span<const ResourceSet> Resources, std::span<const uint32_t> DynamicOffsets)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::BindResourcesDynamic, Buf, Resources, DynamicOffsets);
+
 		VulkanCommandBuffer* VkCmd = static_cast<VulkanCommandBuffer*>(Buf);
 
-		uint32_t CurrentFrame = GVulkanContext.CurrentSwapChain->CurrentFrame;
+		uint32_t CurrentFrame = GVulkanContext.CurrentFrame;
 
-		std::vector<VkDescriptorSet> BoundSets(Resources.size());
+		InlineArray<VkDescriptorSet, 8> BoundSets(Resources.size());
 		for(uint32_t ResourceIndex = 0; ResourceIndex < Resources.size(); ResourceIndex++)
 		{
 			VulkanResourceSet* VkRes = reinterpret_cast<VulkanResourceSet*>(Resources[ResourceIndex]);
-			BoundSets[ResourceIndex] = VkRes->DescriptorSets[CurrentFrame];
+			BoundSets[ResourceIndex] = VkRes->DescriptorSets[VkRes->bTransient ? 0 : CurrentFrame];
 		}
 
 		vkCmdBindDescriptorSets
 		(
 			VkCmd->CmdBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			VkCmd->BoundPipeline->BindPoint,
 			VkCmd->BoundPipeline->PipelineLayout,
-			0, BoundSets.size(), BoundSets.data(),
-			0, nullptr
+			0, static_cast<uint32_t>(BoundSets.size()), BoundSets.data(),
+			static_cast<uint32_t>(DynamicOffsets.size()), DynamicOffsets.data()
 		);
 	}
 
 	void DrawVertexBuffer(CommandBuffer Buf, VertexBuffer Vbo, uint32_t VertexCount)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::DrawVertexBuffer, Buf, Vbo, VertexCount);
+
 		VulkanVertexBuffer* VulkanVbo = static_cast<VulkanVertexBuffer*>(Vbo);
 
 		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
@@ -1179,6 +2079,8 @@ namespace llrm
 
 	void DrawVertexBufferIndexed(CommandBuffer Buf, VertexBuffer Vbo, IndexBuffer Ibo, uint32_t IndexCount)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::DrawVertexBufferIndexed, Buf, Vbo, Ibo, IndexCount);
+
 		VulkanVertexBuffer* VulkanVbo = static_cast<VulkanVertexBuffer*>(Vbo);
 		VulkanIndexBuffer* VulkanIbo = static_cast<VulkanIndexBuffer*>(Ibo);
 
@@ -1202,1582 +2104,3609 @@ namespace llrm
 		});
 	}
 
-	void SetViewport(CommandBuffer Buf, uint32_t X, uint32_t Y, uint32_t W, uint32_t H)
+	void Dispatch(CommandBuffer Buf, uint32_t GroupsX, uint32_t GroupsY, uint32_t GroupsZ)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::Dispatch, Buf, GroupsX, GroupsY, GroupsZ);
+
 		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
-			VkViewport Viewport;
-			Viewport.x = static_cast<float>(X);
-			Viewport.y = static_cast<float>(GetCurrentViewportHeight(Buf) - Y);
-			Viewport.width = static_cast<float>(W);
-			Viewport.height = static_cast<float>(-1.0f * H); // Flip Vulkan viewport
-			Viewport.minDepth = 0.0f;
-			Viewport.maxDepth = 1.0f;
-
-			vkCmdSetViewport(CmdBuffer, 0, 1, &Viewport);
+			vkCmdDispatch(CmdBuffer, GroupsX, GroupsY, GroupsZ);
 		});
 	}
 
-	void SetScissor(CommandBuffer Buf, uint32_t X, uint32_t Y, uint32_t W, uint32_t H)
+	void DispatchIndirect(CommandBuffer Buf, StorageBuffer Arguments, uint64_t Offset)
 	{
-		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
-		{
-			uint32_t ScissorY = std::max(GetCurrentViewportHeight(Buf) - (Y + H), static_cast<uint32_t>(0));
+		LLRM_CAPTURE_CALL(CaptureOp::DispatchIndirect, Buf, Arguments, Offset);
 
-			VkRect2D Scissor;
-			Scissor.offset.x = static_cast<int32_t>(X);
-			Scissor.offset.y = ScissorY; // Flip on Y
-			Scissor.extent.width = static_cast<uint32_t>(W);
-			Scissor.extent.height = static_cast<uint32_t>(H);
+		VulkanStorageBuffer* VkArgs = static_cast<VulkanStorageBuffer*>(Arguments);
 
-			vkCmdSetScissor(CmdBuffer, 0, 1, &Scissor);
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
+		{
+			vkCmdDispatchIndirect(CmdBuffer, VkArgs->DeviceStorageBuffer, Offset);
 		});
 	}
 
-	bool CreateShaderModule(const std::vector<uint32_t>& SpvCode, VkShaderModule& OutShaderModule)
+	void GetStageAccess(uint32_t Stages, bool bSource, VkAccessFlags& OutAccess, VkPipelineStageFlags& OutStages)
 	{
-		VkShaderModuleCreateInfo CreateInfo{};
-		CreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		CreateInfo.codeSize = SpvCode.size() * sizeof(uint32_t);
-		CreateInfo.pCode = SpvCode.data();
+		OutAccess = 0;
+		OutStages = 0;
 
-		VkShaderModule ShaderModule;
-		if (vkCreateShaderModule(GVulkanContext.Device, &CreateInfo, nullptr, &ShaderModule) != VK_SUCCESS)
+		// Sources only need to make their writes available, destinations need them visible to every kind of access
+		if (Stages & PIPELINE_STAGE_INDIRECT)
 		{
-			return false;
+			OutStages |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+			OutAccess |= bSource ? 0 : VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
 		}
-
-		OutShaderModule = ShaderModule;
-
-		return true;
-	}
-
-	ShaderProgram CreateRasterProgram(const std::vector<uint32_t>& VertShader, const std::vector<uint32_t>& FragShader)
-	{
-		VulkanShader* Result = new VulkanShader;
-
-		std::vector<VkShaderModule> ShaderModules;
-
-		// Create vertex shader
-		if (!CreateShaderModule(VertShader, Result->VertexModule))
+		if (Stages & PIPELINE_STAGE_VERTEX_INPUT)
 		{
-			//GLog->critical("Failed to create shader module");
-
-			delete Result;
-			return nullptr;
+			OutStages |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+			OutAccess |= bSource ? 0 : VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
 		}
-		else
+		if (Stages & PIPELINE_STAGE_VERTEX_SHADER)
 		{
-			ShaderModules.push_back(Result->VertexModule);
-			Result->bHasVertexShader = true;
+			OutStages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+			OutAccess |= bSource ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_UNIFORM_READ_BIT;
 		}
-
-		// Create fragment shader
-		if (!CreateShaderModule(FragShader, Result->FragmentModule))
+		if (Stages & PIPELINE_STAGE_FRAGMENT_SHADER)
 		{
-			//GLog->critical("Failed to create shader module");
-
-			delete Result;
-			return nullptr;
+			OutStages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			OutAccess |= bSource ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_UNIFORM_READ_BIT;
 		}
-		else
+		if (Stages & PIPELINE_STAGE_COLOR_ATTACHMENT)
+		{
+			OutStages |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			OutAccess |= bSource ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		}
+		if (Stages & PIPELINE_STAGE_COMPUTE_SHADER)
 		{
-			ShaderModules.push_back(Result->FragmentModule);
-			Result->bHasFragmentShader = true;
+			OutStages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			OutAccess |= bSource ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+		}
+		if (Stages & PIPELINE_STAGE_TRANSFER)
+		{
+			OutStages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+			OutAccess |= bSource ? VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
 		}
 
-		RECORD_RESOURCE_ALLOC(Result);
-		return Result;
+		if (OutStages == 0)
+			OutStages = bSource ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
 	}
 
-	/*ShaderProgram CreateShader(const ShaderCreateInfo* ProgramData)
+	void PipelineBarrier(CommandBuffer Buf, uint32_t SrcStages, uint32_t DstStages)
 	{
-		// Get the Spv data
-		HlslToSpvResult SpvResult;
-		if (!HlslToSpv(ProgramData, SpvResult))
+		LLRM_CAPTURE_CALL(CaptureOp::PipelineBarrier, Buf, SrcStages, DstStages);
+
+		VkMemoryBarrier Barrier{};
+		Barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+		VkPipelineStageFlags SrcVkStages, DstVkStages;
+		GetStageAccess(SrcStages, true, Barrier.srcAccessMask, SrcVkStages);
+		GetStageAccess(DstStages, false, Barrier.dstAccessMask, DstVkStages);
+
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
-			GLog->error("Failed to produce spv for Vulkan shader module");
-			return nullptr;
+			vkCmdPipelineBarrier(CmdBuffer,
+				SrcVkStages, DstVkStages,
+				0,
+				1, &Barrier,
+				0, nullptr,
+				0, nullptr
+			);
+		});
+	}
+
+	// The exact stages and accesses of a usage for synchronization2. Reads have nothing to make available, so sources only wait for them.
+	bool GetUsageAccess2(AttachmentUsage Usage, bool bSource, VkAccessFlags2KHR& Access, VkPipelineStageFlags2KHR& Stages)
+	{
+		const VkPipelineStageFlags2KHR ShaderStages = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+		const VkPipelineStageFlags2KHR FragmentTestStages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+
+		switch (Usage)
+		{
+		case AttachmentUsage::Undefined:
+			if (!bSource)
+				return false; // Can't transition to undefined
+			Access = VK_ACCESS_2_NONE_KHR;
+			Stages = VK_PIPELINE_STAGE_2_NONE_KHR;
+			return true;
+		case AttachmentUsage::Presentation:
+			// The presentation engine synchronizes with semaphores, acquiring waits for them at the color attachment output stage
+			Access = VK_ACCESS_2_NONE_KHR;
+			Stages = bSource ? VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR : VK_PIPELINE_STAGE_2_NONE_KHR;
+			return true;
+		case AttachmentUsage::ColorAttachment:
+			Access = bSource ? VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR : VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR;
+			Stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+			return true;
+		case AttachmentUsage::DepthStencilAttachment:
+			Access = bSource ? VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR : VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+			Stages = bSource ? VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR : FragmentTestStages;
+			return true;
+		case AttachmentUsage::ShaderReadDepthStencil:
+			Access = bSource ? VK_ACCESS_2_NONE_KHR : VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR;
+			Stages = FragmentTestStages | ShaderStages;
+			return true;
+		case AttachmentUsage::ShaderRead:
+			Access = bSource ? VK_ACCESS_2_NONE_KHR : VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR;
+			Stages = ShaderStages;
+			return true;
+		case AttachmentUsage::ShaderReadWrite:
+			Access = bSource ? VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR : VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+			Stages = ShaderStages;
+			return true;
+		case AttachmentUsage::TransferDestination:
+			// Uploads copy, mips are blitted and queries are cleared
+			Access = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+			Stages = VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_BLIT_BIT_KHR | VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+			return true;
+		case AttachmentUsage::TransferSource:
+			Access = bSource ? VK_ACCESS_2_NONE_KHR : VK_ACCESS_2_TRANSFER_READ_BIT_KHR;
+			Stages = VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_BLIT_BIT_KHR;
+			return true;
+		default:
+			return false;
 		}
+	}
 
-		std::vector<VkPipelineShaderStageCreateInfo> PipelineShaderStages;
-		std::vector<VkShaderModule> ShaderModules;
+	// Like GetStageAccess, but narrowed to how the type of buffer can be accessed in each stage
+	void GetBufferStageAccess2(uint32_t Stages, BarrierBufferType Type, bool bSource, VkAccessFlags2KHR& OutAccess, VkPipelineStageFlags2KHR& OutStages)
+	{
+		OutAccess = VK_ACCESS_2_NONE_KHR;
+		OutStages = VK_PIPELINE_STAGE_2_NONE_KHR;
 
-		VulkanShader* Result = new VulkanShader;
+		const VkAccessFlags2KHR ShaderAccess = bSource ? VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR :
+			VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR | VK_ACCESS_2_UNIFORM_READ_BIT_KHR;
 
-		// Create vertex shader
-		if (ProgramData->VertexShaderVirtual)
+		if (Stages & PIPELINE_STAGE_INDIRECT)
 		{
-			if (!CreateShaderModule(SpvResult.VertexSpv, Result->VertexModule))
+			OutStages |= VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR;
+			OutAccess |= bSource ? VK_ACCESS_2_NONE_KHR : VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR;
+		}
+		if (Stages & PIPELINE_STAGE_VERTEX_INPUT)
+		{
+			if (Type != BarrierBufferType::Index)
 			{
-				//GLog->critical("Failed to create shader module");
-
-				delete Result;
-				return nullptr;
+				OutStages |= VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT_KHR;
+				OutAccess |= bSource ? VK_ACCESS_2_NONE_KHR : VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT_KHR;
 			}
-			else
+			if (Type != BarrierBufferType::Vertex)
 			{
-				ShaderModules.push_back(Result->VertexModule);
-				Result->bHasVertexShader = true;
+				OutStages |= VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT_KHR;
+				OutAccess |= bSource ? VK_ACCESS_2_NONE_KHR : VK_ACCESS_2_INDEX_READ_BIT_KHR;
 			}
 		}
-
-		// Create fragment shader
-		if (ProgramData->FragmentShaderVirtual)
+		if (Stages & PIPELINE_STAGE_VERTEX_SHADER)
 		{
-			if (!CreateShaderModule(SpvResult.FragmentSpv, Result->FragmentModule))
-			{
-				//GLog->critical("Failed to create shader module");
+			OutStages |= VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR;
+			OutAccess |= ShaderAccess;
+		}
+		if (Stages & PIPELINE_STAGE_FRAGMENT_SHADER)
+		{
+			OutStages |= VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR;
+			OutAccess |= ShaderAccess;
+		}
+		if (Stages & PIPELINE_STAGE_COLOR_ATTACHMENT)
+		{
+			OutStages |= VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+			OutAccess |= bSource ? VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR : VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR;
+		}
+		if (Stages & PIPELINE_STAGE_COMPUTE_SHADER)
+		{
+			OutStages |= VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+			OutAccess |= ShaderAccess;
+		}
+		if (Stages & PIPELINE_STAGE_TRANSFER)
+		{
+			// Buffers are only ever copied to and from, or filled
+			OutStages |= VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+			OutAccess |= bSource ? VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR : VK_ACCESS_2_TRANSFER_READ_BIT_KHR | VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+		}
+	}
 
-				delete Result;
-				return nullptr;
-			}
-			else
+	VkBuffer GetBarrierBuffer(const BufferBarrier& Barrier)
+	{
+		switch (Barrier.Type)
+		{
+		case BarrierBufferType::Vertex:
+			return static_cast<VulkanVertexBuffer*>(Barrier.Buffer)->DeviceVertexBuffer;
+		case BarrierBufferType::Index:
+			return static_cast<VulkanIndexBuffer*>(Barrier.Buffer)->DeviceIndexBuffer;
+		case BarrierBufferType::Storage:
+			return static_cast<VulkanStorageBuffer*>(Barrier.Buffer)->DeviceStorageBuffer;
+		default:
+			return VK_NULL_HANDLE;
+		}
+	}
+
+	void RecordBarriers2(VkCommandBuffer CmdBuffer, std::span<const TextureTransition> Transitions, std::span<const BufferBarrier> Buffers)
+	{
+		InlineArray<VkImageMemoryBarrier2KHR, 16> ImageBarriers;
+		InlineArray<VkBufferMemoryBarrier2KHR, 8> BufferBarriers;
+
+		for (const TextureTransition& Transition : Transitions)
+		{
+			if (IsRedundantTransition(Transition.Old, Transition.New, Transition.bDiscard))
+				continue;
+
+			VulkanTexture* VkTexture = static_cast<VulkanTexture*>(Transition.Image);
+
+			VkImageMemoryBarrier2KHR& Barrier = ImageBarriers.emplace_back();
+			Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+			Barrier.oldLayout = Transition.bDiscard ? VK_IMAGE_LAYOUT_UNDEFINED : AttachmentUsageToVkLayout(Transition.Old);
+			Barrier.newLayout = AttachmentUsageToVkLayout(Transition.New);
+			Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			Barrier.image = VkTexture->TextureImage;
+			Barrier.subresourceRange.aspectMask = GetImageAspectFlags(VkTexture->TextureFormat);
+			Barrier.subresourceRange.baseMipLevel = Transition.BaseMip;
+			Barrier.subresourceRange.levelCount = Transition.MipCount;
+			Barrier.subresourceRange.baseArrayLayer = Transition.BaseLayer;
+			Barrier.subresourceRange.layerCount = Transition.LayerCount;
+
+			if (!GetUsageAccess2(Transition.Old, true, Barrier.srcAccessMask, Barrier.srcStageMask) ||
+				!GetUsageAccess2(Transition.New, false, Barrier.dstAccessMask, Barrier.dstStageMask))
 			{
-				ShaderModules.push_back(Result->FragmentModule);
-				Result->bHasFragmentShader = true;
+				//GLog->critical("Vulkan image layout transition not supported");
+				ImageBarriers.pop_back();
 			}
 		}
 
-		RECORD_RESOURCE_ALLOC(Result);
+		for (const BufferBarrier& Buffer : Buffers)
+		{
+			VkBufferMemoryBarrier2KHR& Barrier = BufferBarriers.emplace_back();
+			Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+			Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			Barrier.buffer = GetBarrierBuffer(Buffer);
+			Barrier.offset = Buffer.Offset;
+			Barrier.size = Buffer.Size; // BUFFER_SIZE_REMAINING matches VK_WHOLE_SIZE
+			GetBufferStageAccess2(Buffer.SrcStages, Buffer.Type, true, Barrier.srcAccessMask, Barrier.srcStageMask);
+			GetBufferStageAccess2(Buffer.DstStages, Buffer.Type, false, Barrier.dstAccessMask, Barrier.dstStageMask);
+		}
 
-		return Result;
-	}*/
+		if (ImageBarriers.empty() && BufferBarriers.empty())
+			return;
 
-	/**
-	 * Queries the physical device for the optimal swap chain settings.
-	 *
-	 */
-	void QuerySwapChainOptimalSettings(
-		int32_t DesiredSwapChainWidth,
-		int32_t DesiredSwapChainHeight,
-		const VkSurfaceKHR& TargetSurface,
-		VkExtent2D& OutOptimalSwapChainExtent,
-		VkSurfaceFormatKHR& OutOptimalSwapChainSurfaceFormat,
-		VkPresentModeKHR& OutOptimalSwapChainPresentMode,
-		VkSurfaceCapabilitiesKHR& OutSurfaceCapabilities,
-		uint32_t& OutImageCount
-	)
+		VkDependencyInfoKHR DependencyInfo{};
+		DependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		DependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(BufferBarriers.size());
+		DependencyInfo.pBufferMemoryBarriers = BufferBarriers.data();
+		DependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(ImageBarriers.size());
+		DependencyInfo.pImageMemoryBarriers = ImageBarriers.data();
+
+		GVulkanContext.CmdPipelineBarrier2(CmdBuffer, &DependencyInfo);
+	}
+
+	void RecordBarriers(VkCommandBuffer CmdBuffer, std::span<const TextureTransition> Transitions, std::span<const BufferBarrier> Buffers)
 	{
-		std::vector<VkSurfaceFormatKHR> SupportedFormats;
-		std::vector<VkPresentModeKHR> SupportedPresentModes;
-		uint32_t SurfaceFormatCount;
-		uint32_t PresentModeCount;
+		InlineArray<VkImageMemoryBarrier, 16> ImageBarriers;
+		InlineArray<VkBufferMemoryBarrier, 8> BufferBarriers;
 
-		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(GVulkanContext.PhysicalDevice, TargetSurface, &OutSurfaceCapabilities); // Get surface capabilities
-		vkGetPhysicalDeviceSurfaceFormatsKHR(GVulkanContext.PhysicalDevice, TargetSurface, &SurfaceFormatCount, nullptr); // Get count of surface formats
-		vkGetPhysicalDeviceSurfacePresentModesKHR(GVulkanContext.PhysicalDevice, TargetSurface, &PresentModeCount, nullptr); // Get count of present formats
+		// Every barrier shares the union of the stages
+		VkPipelineStageFlags SourceStages = 0;
+		VkPipelineStageFlags DstStages = 0;
 
-		if (SurfaceFormatCount > 0 && PresentModeCount > 0)
+		for (const TextureTransition& Transition : Transitions)
 		{
-			// Get the surface formats and present modes
-			SupportedFormats.resize(SurfaceFormatCount);
-			SupportedPresentModes.resize(PresentModeCount);
-			vkGetPhysicalDeviceSurfaceFormatsKHR(GVulkanContext.PhysicalDevice, TargetSurface, &SurfaceFormatCount, SupportedFormats.data());
-			vkGetPhysicalDeviceSurfacePresentModesKHR(GVulkanContext.PhysicalDevice, TargetSurface, &PresentModeCount, SupportedPresentModes.data());
-
-			// Find the optimal extent
-			{
-				if (OutSurfaceCapabilities.currentExtent.width != UINT32_MAX)
-				{
-					// The optimal extent is already specified, so we need to match it.
-					OutOptimalSwapChainExtent = OutSurfaceCapabilities.currentExtent;
-				}
-				else
-				{
-					OutOptimalSwapChainExtent.width = std::clamp(static_cast<uint32_t>(DesiredSwapChainWidth), OutSurfaceCapabilities.minImageExtent.width, OutSurfaceCapabilities.maxImageExtent.width);
-					OutOptimalSwapChainExtent.height = std::clamp(static_cast<uint32_t>(DesiredSwapChainHeight), OutSurfaceCapabilities.minImageExtent.height, OutSurfaceCapabilities.maxImageExtent.height);
-				}
-			}
+			if (IsRedundantTransition(Transition.Old, Transition.New, Transition.bDiscard))
+				continue;
 
-			// Give ourselves one more image than the min image count. Make sure this doesn't exceed the max image count (zero means no max)
-			OutImageCount = OutSurfaceCapabilities.minImageCount + 1;
-			if (OutSurfaceCapabilities.maxImageCount > 0 && OutImageCount > OutSurfaceCapabilities.maxImageCount)
-				OutImageCount = OutImageCount > OutSurfaceCapabilities.maxImageCount;
+			VulkanTexture* VkTexture = static_cast<VulkanTexture*>(Transition.Image);
 
-			// Find the optimal surface format
+			VkImageMemoryBarrier Barrier;
+			VkPipelineStageFlags SourceStage, DstStage;
+			if (!FillTransitionBarrier(Barrier, SourceStage, DstStage,
+				VkTexture->TextureImage, GetImageAspectFlags(VkTexture->TextureFormat),
+				Transition.Old, Transition.New,
+				Transition.BaseLayer, Transition.LayerCount, Transition.BaseMip, Transition.MipCount,
+				Transition.bDiscard))
 			{
-				// Rank desired vulkan swap chain formats, lower number means higher priority
-				static std::vector<std::tuple<VkFormat, VkColorSpaceKHR, uint8_t>> FormatRanks = {
-					{VK_FORMAT_R16G16B16A16_SFLOAT, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR, 1},
-					{VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR, 0}
-				};
-
-				// This is technically slow at O(N^2), but only happens once and this simplifies the code since we don't have to write a hash specialization.
-				static auto FindFormatRank = [](VkFormat Format, VkColorSpaceKHR ColorSpace) -> int16_t
-				{
-					for (auto Tup : FormatRanks)
-						if (std::get<0>(Tup) == Format && std::get<1>(Tup) == ColorSpace)
-							return std::get<2>(Tup);
-					return -1;
-				};
+				continue;
+			}
 
-				// Default to first available surface format
-				OutOptimalSwapChainSurfaceFormat = SupportedFormats[0];
-				for (const auto& SupportedFormat : SupportedFormats)
-				{
-					auto SupportedFormatRank = FindFormatRank(SupportedFormat.format, SupportedFormat.colorSpace);
-					auto CurFormatRank = FindFormatRank(OutOptimalSwapChainSurfaceFormat.format, OutOptimalSwapChainSurfaceFormat.colorSpace);
+			ImageBarriers.emplace_back() = Barrier;
+			SourceStages |= SourceStage;
+			DstStages |= DstStage;
+		}
 
-					if (SupportedFormatRank >= 0 && (CurFormatRank < 0 || SupportedFormatRank < CurFormatRank))
-						OutOptimalSwapChainSurfaceFormat = SupportedFormat;
-				}
-			}
+		for (const BufferBarrier& Buffer : Buffers)
+		{
+			VkBufferMemoryBarrier& Barrier = BufferBarriers.emplace_back();
+			Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			Barrier.buffer = GetBarrierBuffer(Buffer);
+			Barrier.offset = Buffer.Offset;
+			Barrier.size = Buffer.Size;
+
+			VkPipelineStageFlags SourceStage, DstStage;
+			GetStageAccess(Buffer.SrcStages, true, Barrier.srcAccessMask, SourceStage);
+			GetStageAccess(Buffer.DstStages, false, Barrier.dstAccessMask, DstStage);
+			SourceStages |= SourceStage;
+			DstStages |= DstStage;
+		}
 
-			// Find the optimal presentation mode
-			// TODO: Do more research here. Do we want to prioritize mailbox mode? That seems like it may use more energy than FIFO.
-			{
-				static std::unordered_map<VkPresentModeKHR, uint32_t> PresentModeOrder = {
-					{VK_PRESENT_MODE_FIFO_KHR, 1},
-					{VK_PRESENT_MODE_MAILBOX_KHR, 0}
-				};
+		if (ImageBarriers.empty() && BufferBarriers.empty())
+			return;
 
-				// Default to present mode FIFO since that is the only one guaranteed to be present
-				OutOptimalSwapChainPresentMode = VK_PRESENT_MODE_FIFO_KHR;
-				uint32_t BestOrder = std::numeric_limits<uint32_t>::max();
+		vkCmdPipelineBarrier
+		(
+			CmdBuffer,
+			SourceStages, DstStages,
+			0,
+			0, nullptr,
+			static_cast<uint32_t>(BufferBarriers.size()), BufferBarriers.data(),
+			static_cast<uint32_t>(ImageBarriers.size()), ImageBarriers.data()
+		);
+	}
 
-				// Present mailbox present mode
-				for (const auto& SupportedPresentMode : SupportedPresentModes)
-				{
-					if (PresentModeOrder.contains(SupportedPresentMode))
-					{
-						uint32_t Order = PresentModeOrder[SupportedPresentMode];
-						if (Order < BestOrder)
-						{
-							OutOptimalSwapChainPresentMode = SupportedPresentMode;
-							BestOrder = Order;
-						}
-					}
-				}
-			}
+	void PipelineBarrier(CommandBuffer Buf, std::span<const TextureTransition> Transitions, std::span<const BufferBarrier> Buffers)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::PipelineBarrierBatch, Buf, Transitions, Buffers);
 
-		}
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
+		{
+			if (GVulkanContext.bSynchronization2)
+				RecordBarriers2(CmdBuffer, Transitions, Buffers);
+			else
+				RecordBarriers(CmdBuffer, Transitions, Buffers);
+		});
 	}
 
-	bool CreateVkSwapChain(VulkanSwapChain* Dst, Surface TargetSurface, int32_t DesiredWidth, int32_t DesiredHeight)
+	QueryPool CreateOcclusionQueryPool(uint32_t Count)
 	{
-		VulkanSurface* VkSurface = static_cast<VulkanSurface*>(TargetSurface);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateOcclusionQueryPool, Count);
 
-		// Query optimal swap chain settings for current surface
-		VkExtent2D OptimalExtent;
-		VkSurfaceFormatKHR OptimalFormat;
-		VkPresentModeKHR OptimalPresentMode;
-		VkSurfaceCapabilitiesKHR SurfaceCapabilities;
-		uint32_t OptimalImageCount;
-		QuerySwapChainOptimalSettings(DesiredWidth, DesiredHeight, VkSurface->VkSurface,
-			OptimalExtent, OptimalFormat, OptimalPresentMode, SurfaceCapabilities, OptimalImageCount);
+		const uint32_t FramesInFlight = GVulkanContext.FramesInFlight;
 
-		// This needs to be declared in case the queue families are different
-		uint32_t QueueFamilyIndices[] = { GVulkanContext.GraphicsQueueFamIndex, GVulkanContext.PresentQueueFamIndex };
+		VulkanQueryPool* Result = new VulkanQueryPool;
+		Result->Count = Count;
+		Result->Issued.assign(FramesInFlight, std::vector<bool>(Count, false));
 
-		VkSwapchainCreateInfoKHR CreateInfo{};
-		CreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-		CreateInfo.surface = VkSurface->VkSurface;
-		CreateInfo.minImageCount = OptimalImageCount;
-		CreateInfo.imageFormat = OptimalFormat.format;
-		CreateInfo.imageColorSpace = OptimalFormat.colorSpace;
-		CreateInfo.imageExtent = OptimalExtent;
-		CreateInfo.imageArrayLayers = 1; // TODO: This would be 2 for VR
-		CreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; // TODO: This will need to be changed in some instances (e.g. post processing)
-		CreateInfo.preTransform = SurfaceCapabilities.currentTransform; // I don't think we ever want to use this
-		CreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR; // This is how you blend with other windows
-		CreateInfo.presentMode = OptimalPresentMode;
-		CreateInfo.clipped = VK_TRUE; // This would need to be false if we cared about clipped pixels (obscured by a window for example)
-		CreateInfo.oldSwapchain = VK_NULL_HANDLE;
+		VkQueryPoolCreateInfo PoolInfo{};
+		PoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		PoolInfo.queryType = VK_QUERY_TYPE_OCCLUSION;
+		PoolInfo.queryCount = Count * FramesInFlight;
 
-		// Make things simple: Use concurrent sharing if queue families are different
-		if (GVulkanContext.GraphicsQueueFamIndex != GVulkanContext.PresentQueueFamIndex)
+		if (vkCreateQueryPool(GVulkanContext.Device, &PoolInfo, nullptr, &Result->Pool) != VK_SUCCESS)
 		{
-			CreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-			CreateInfo.queueFamilyIndexCount = 2;
-			CreateInfo.pQueueFamilyIndices = QueueFamilyIndices;
+			//GLog->critical("Failed to create occlusion query pool");
+			delete Result;
+			return nullptr;
 		}
-		else
+
+		VkBufferUsageFlags ResultUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		if (GVulkanContext.bConditionalRendering)
+			ResultUsage |= VK_BUFFER_USAGE_CONDITIONAL_RENDERING_BIT_EXT;
+
+		bool bSuccess = CreateBuffer(sizeof(uint32_t) * Count * FramesInFlight, ResultUsage,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			Result->ResultBuffer, Result->ResultMemory);
+
+		if (!bSuccess || vkMapMemory(GVulkanContext.Device, Result->ResultMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&Result->Results)) != VK_SUCCESS)
 		{
-			CreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-			CreateInfo.queueFamilyIndexCount = 0;
-			CreateInfo.pQueueFamilyIndices = nullptr;
+			//GLog->critical("Failed to create occlusion query result buffer");
+			vkFreeMemory(GVulkanContext.Device, Result->ResultMemory, nullptr);
+			vkDestroyBuffer(GVulkanContext.Device, Result->ResultBuffer, nullptr);
+			vkDestroyQueryPool(GVulkanContext.Device, Result->Pool, nullptr);
+			delete Result;
+			return nullptr;
 		}
 
-		// Also store the optimal settings for later reference
-		Dst->ImageFormat = VkFormatToAttachmentFormat(OptimalFormat.format);
-		Dst->PresentMode = OptimalPresentMode;
-		Dst->SwapChainExtent = OptimalExtent;
+		// Nothing has been resolved yet, so every query counts as visible
+		std::fill(Result->Results, Result->Results + Count * FramesInFlight, 1u);
 
-		if (vkCreateSwapchainKHR(GVulkanContext.Device, &CreateInfo, nullptr, &Dst->SwapChain) != VK_SUCCESS)
-		{
-			//GLog->critical("Failed to create a Vulkan swap chain");
-			return false;
-		}
-
-		return true;
+		RECORD_RESOURCE_ALLOC(Result)
+		return LLRM_CAPTURE_RESULT(Result);
 	}
 
-	bool CreateVkSwapChainImageViews(VulkanSwapChain* Dst)
+	void DestroyQueryPool(QueryPool Pool)
 	{
-		// Retrieve the swap chain images
-		uint32_t ImageCount{};
-		vkGetSwapchainImagesKHR(GVulkanContext.Device, Dst->SwapChain, &ImageCount, nullptr);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyQueryPool, Pool);
 
-		// Allocate space for images
-		std::vector<VkImage> Images(ImageCount);
+		VulkanQueryPool* VkPool = static_cast<VulkanQueryPool*>(Pool);
+		REMOVE_RESOURCE_ALLOC(VkPool)
 
-		// Get the actual swap chain images
-		vkGetSwapchainImagesKHR(GVulkanContext.Device, Dst->SwapChain, &ImageCount, Images.data());
+		WaitDeviceIdle();
 
-		// Get the images and create the image views
-		Dst->Images.resize(ImageCount);
-		Dst->ImageViews.resize(ImageCount);
+		vkUnmapMemory(GVulkanContext.Device, VkPool->ResultMemory);
+		vkFreeMemory(GVulkanContext.Device, VkPool->ResultMemory, nullptr);
+		vkDestroyBuffer(GVulkanContext.Device, VkPool->ResultBuffer, nullptr);
+		vkDestroyQueryPool(GVulkanContext.Device, VkPool->Pool, nullptr);
 
-		for (uint32_t ImageIndex = 0; ImageIndex < ImageCount; ImageIndex++)
-		{
-			Dst->Images[ImageIndex].TextureImage = Images[ImageIndex];
-			Dst->Images[ImageIndex].TextureFormat = Dst->ImageFormat;
+		delete VkPool;
+	}
 
-			VkImageViewCreateInfo ImageViewCreateInfo{};
-			ImageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			ImageViewCreateInfo.image = Images[ImageIndex];
-			ImageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-			ImageViewCreateInfo.format = AttachmentFormatToVkFormat(Dst->ImageFormat);
-			ImageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-			ImageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-			ImageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-			ImageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-			ImageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			ImageViewCreateInfo.subresourceRange.baseMipLevel = 0;
-			ImageViewCreateInfo.subresourceRange.levelCount = 1;
-			ImageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
-			ImageViewCreateInfo.subresourceRange.layerCount = 1;
+	void ResetQueries(CommandBuffer Buf, QueryPool Pool)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::ResetQueries, Buf, Pool);
 
-			if (vkCreateImageView(GVulkanContext.Device, &ImageViewCreateInfo, nullptr, &Dst->ImageViews[ImageIndex].ImageView) != VK_SUCCESS)
-			{
-				//GLog->error("Failed to create image view for swap chain");
+		VulkanQueryPool* VkPool = static_cast<VulkanQueryPool*>(Pool);
+		const uint32_t Frame = GVulkanContext.CurrentFrame;
 
-				// Error in creation
-				return false;
-			}
-		}
+		std::fill(VkPool->Issued[Frame].begin(), VkPool->Issued[Frame].end(), false);
 
-		return true;
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
+		{
+			vkCmdResetQueryPool(CmdBuffer, VkPool->Pool, Frame * VkPool->Count, VkPool->Count);
+		});
 	}
 
-	void DestroyVkSwapChain(VulkanSwapChain* VkSwap)
+	void BeginQuery(CommandBuffer Buf, QueryPool Pool, uint32_t Query)
 	{
-		vkDestroySwapchainKHR(GVulkanContext.Device, VkSwap->SwapChain, nullptr);
+		LLRM_CAPTURE_CALL(CaptureOp::BeginQuery, Buf, Pool, Query);
+
+		VulkanQueryPool* VkPool = static_cast<VulkanQueryPool*>(Pool);
+		const uint32_t Frame = GVulkanContext.CurrentFrame;
+
+		VkPool->Issued[Frame][Query] = true;
+
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
+		{
+			vkCmdBeginQuery(CmdBuffer, VkPool->Pool, Frame * VkPool->Count + Query, 0);
+		});
 	}
 
-	void DestroyVkSwapChainImageViews(VulkanSwapChain* VkSwap)
+	void EndQuery(CommandBuffer Buf, QueryPool Pool, uint32_t Query)
 	{
-		// Clean up framebuffers and image views
-		for (uint32_t SwapChainImage = 0; SwapChainImage < VkSwap->Images.size(); SwapChainImage++)
+		LLRM_CAPTURE_CALL(CaptureOp::EndQuery, Buf, Pool, Query);
+
+		VulkanQueryPool* VkPool = static_cast<VulkanQueryPool*>(Pool);
+		const uint32_t Frame = GVulkanContext.CurrentFrame;
+
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
-			vkDestroyImageView(GVulkanContext.Device, VkSwap->ImageViews[SwapChainImage].ImageView, nullptr);
-		}
+			vkCmdEndQuery(CmdBuffer, VkPool->Pool, Frame * VkPool->Count + Query);
+		});
 	}
 
-	SwapChain CreateSwapChain(Surface TargetSurface, int32_t DesiredWidth,
-		int32_t DesiredHeight)
+	void ResolveQueries(CommandBuffer Buf, QueryPool Pool)
 	{
-		VulkanSwapChain* Result = new VulkanSwapChain;
+		LLRM_CAPTURE_CALL(CaptureOp::ResolveQueries, Buf, Pool);
 
-		// Create swap chain resources
-		if (!CreateVkSwapChain(Result, TargetSurface, DesiredWidth, DesiredHeight))
-		{
-			return nullptr;
-		}
+		VulkanQueryPool* VkPool = static_cast<VulkanQueryPool*>(Pool);
+		const uint32_t Frame = GVulkanContext.CurrentFrame;
+		const std::vector<bool>& Issued = VkPool->Issued[Frame];
 
-		if (!CreateVkSwapChainImageViews(Result))
+		// Results are read by the host once the frame's fence is signaled, and by the conditional rendering of the next frame
+		VkPipelineStageFlags ReadStages = VK_PIPELINE_STAGE_HOST_BIT;
+		VkAccessFlags ReadAccess = VK_ACCESS_HOST_READ_BIT;
+		if (GVulkanContext.bConditionalRendering)
 		{
-			return nullptr;
+			ReadStages |= VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT;
+			ReadAccess |= VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT;
 		}
 
-		// Create n frames in flight for this swap chain. This only needs to be done at creation, hence there isn't another function for it.
-		for (uint32_t FrameInFlight = 0; FrameInFlight < MAX_FRAMES_IN_FLIGHT; FrameInFlight++)
+		VkBufferMemoryBarrier Barrier{};
+		Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		Barrier.buffer = VkPool->ResultBuffer;
+		Barrier.offset = sizeof(uint32_t) * Frame * VkPool->Count;
+		Barrier.size = sizeof(uint32_t) * VkPool->Count;
+
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
-			VkSemaphore ImageAvailableSem, PresentSem;
-			VkFence InFlightFence;
+			// Frames that are still in flight may be reading these results for conditional rendering
+			Barrier.srcAccessMask = 0;
+			Barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(CmdBuffer,
+				GVulkanContext.bConditionalRendering ? VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 0, nullptr, 1, &Barrier, 0, nullptr);
 
-			// Create semaphore for frame in flight
-			VkSemaphoreCreateInfo SemCreate{};
-			SemCreate.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-			if (vkCreateSemaphore(GVulkanContext.Device, &SemCreate, nullptr, &ImageAvailableSem) != VK_SUCCESS ||
-				vkCreateSemaphore(GVulkanContext.Device, &SemCreate, nullptr, &PresentSem) != VK_SUCCESS)
+			// Copy runs of issued queries, waiting on the GPU until they're available. Queries that weren't issued count as visible.
+			for (uint32_t First = 0; First < VkPool->Count;)
 			{
-				//GLog->critical("Failed to create semaphores for swap chain");
+				uint32_t Last = First;
+				while (Last < VkPool->Count && Issued[Last] == Issued[First])
+					Last++;
 
-				delete Result;
-				return nullptr;
-			}
+				VkDeviceSize RunOffset = Barrier.offset + sizeof(uint32_t) * First;
+				if (Issued[First])
+				{
+					vkCmdCopyQueryPoolResults(CmdBuffer, VkPool->Pool, Frame * VkPool->Count + First, Last - First,
+						VkPool->ResultBuffer, RunOffset, sizeof(uint32_t), VK_QUERY_RESULT_WAIT_BIT);
+				}
+				else
+				{
+					vkCmdFillBuffer(CmdBuffer, VkPool->ResultBuffer, RunOffset, sizeof(uint32_t) * (Last - First), 1u);
+				}
 
-			VkFenceCreateInfo FenceCreate{};
-			FenceCreate.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-			FenceCreate.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-			if (vkCreateFence(GVulkanContext.Device, &FenceCreate, nullptr, &InFlightFence) != VK_SUCCESS)
-			{
-				//GLog->critical("Failed to create fence for swap chain");
-				return nullptr;
+				First = Last;
 			}
 
-			Result->FramesInFlight.emplace_back(ImageAvailableSem, PresentSem, InFlightFence);
-		}
+			Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			Barrier.dstAccessMask = ReadAccess;
+			vkCmdPipelineBarrier(CmdBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, ReadStages,
+				0, 0, nullptr, 1, &Barrier, 0, nullptr);
+		});
+	}
 
-		// Resize image fences to as many swap chain images that we have. Also, start them all at the null handle.
-		Result->ImageFences.resize(Result->Images.size(), VK_NULL_HANDLE);
+	uint64_t GetQueryResult(QueryPool Pool, uint32_t Query)
+	{
+		VulkanQueryPool* VkPool = static_cast<VulkanQueryPool*>(Pool);
 
-		RECORD_RESOURCE_ALLOC(Result)
+		// Outside of a frame the results may still be written by a resolve in flight, so report visible like an unresolved query
+		if (!GVulkanContext.bInsideFrame)
+		{
+			//GLog->critical("Query results can only be read between BeginFrame and EndFrame");
+			return 1;
+		}
 
-		return Result;
+		// BeginFrames waited on the current frame's fence, so whatever it resolved last time is complete
+		return VkPool->Results[GVulkanContext.CurrentFrame * VkPool->Count + Query];
 	}
 
-	void DestroySwapChain(SwapChain Swap)
+	void BeginConditionalRendering(CommandBuffer Buf, QueryPool Pool, uint32_t Query)
 	{
-		vkDeviceWaitIdle(GVulkanContext.Device);
-
-		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
+		LLRM_CAPTURE_CALL(CaptureOp::BeginConditionalRendering, Buf, Pool, Query);
 
-		// Destroy volatile swap chain resources
-		DestroyVkSwapChainImageViews(VkSwap);
-		DestroyVkSwapChain(VkSwap);
+		if (!GVulkanContext.bConditionalRendering)
+			return;
 
-		// Destroy frames in flight
-		for (const auto& FrameInFlight : VkSwap->FramesInFlight)
-		{
-			vkDestroySemaphore(GVulkanContext.Device, FrameInFlight.ImageAvailableSemaphore, nullptr);
-			vkDestroySemaphore(GVulkanContext.Device, FrameInFlight.RenderingFinishedSemaphore, nullptr);
-			vkDestroyFence(GVulkanContext.Device, FrameInFlight.InFlightFence, nullptr);
-		}
+		VulkanQueryPool* VkPool = static_cast<VulkanQueryPool*>(Pool);
+		const uint32_t PreviousFrame = (GVulkanContext.CurrentFrame + GVulkanContext.FramesInFlight - 1) % GVulkanContext.FramesInFlight;
 
-		REMOVE_RESOURCE_ALLOC(VkSwap)
+		VkConditionalRenderingBeginInfoEXT ConditionalInfo{};
+		ConditionalInfo.sType = VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT;
+		ConditionalInfo.buffer = VkPool->ResultBuffer;
+		ConditionalInfo.offset = sizeof(uint32_t) * (PreviousFrame * VkPool->Count + Query);
 
-		// Free swap chain memory
-		delete VkSwap;
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
+		{
+			GVulkanContext.CmdBeginConditionalRendering(CmdBuffer, &ConditionalInfo);
+		});
 	}
 
-	void SubmitCommandBuffer(CommandBuffer Buffer, bool bWait, Fence WaitFence)
+	void EndConditionalRendering(CommandBuffer Buf)
 	{
-		VulkanCommandBuffer* VkCmd = static_cast<VulkanCommandBuffer*>(Buffer);
-
-		VkSubmitInfo SubmitInfo{};
-		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		SubmitInfo.commandBufferCount = 1;
-		SubmitInfo.pCommandBuffers = &VkCmd->CmdBuffer;
+		LLRM_CAPTURE_CALL(CaptureOp::EndConditionalRendering, Buf);
 
-		if (vkQueueSubmit(GVulkanContext.GraphicsQueue, 1, &SubmitInfo, WaitFence ? static_cast<VkFence>(WaitFence) : VK_NULL_HANDLE) != VK_SUCCESS)
-		{
-			//GLog->critical("Failed to submit vulkan command buffers to graphics queue");
-		}
+		if (!GVulkanContext.bConditionalRendering)
+			return;
 
-		if (bWait)
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
-			vkQueueWaitIdle(GVulkanContext.GraphicsQueue);
-		}
+			GVulkanContext.CmdEndConditionalRendering(CmdBuffer);
+		});
 	}
 
-	int32_t BeginFrame(GLFWwindow* Window, llrm::SwapChain Swap, llrm::Surface Target)
+#ifdef LLRM_DEBUG_LABELS
+	void SetVkObjectName(VkObjectType Type, uint64_t Handle, const char* Name)
 	{
-		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
-
-		GVulkanContext.CurrentSwapChain = VkSwap;
-		GVulkanContext.CurrentSurface = Target;
-		GVulkanContext.CurrentWindow = Window;
+		if (!GVulkanContext.SetDebugUtilsObjectName || !Handle)
+			return;
 
-		VkSwap->bInsideFrame = true;
+		VkDebugUtilsObjectNameInfoEXT NameInfo{};
+		NameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+		NameInfo.objectType = Type;
+		NameInfo.objectHandle = Handle;
+		NameInfo.pObjectName = Name;
 
-		int32_t Width, Height;
-		glfwGetFramebufferSize(Window, &Width, &Height);
+		GVulkanContext.SetDebugUtilsObjectName(GVulkanContext.Device, &NameInfo);
+	}
 
-		if (Width == 0 || Height == 0)
-		{
-			vkDeviceWaitIdle(GVulkanContext.Device);
-			return -1;
-		}
+	void SetObjectName(DebugObjectType Type, void* Object, const char* Name)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::SetObjectName, Object, Type, Name);
 
-		// Acquire image, this is the swapchain image index that we will be rendering command buffers for + presenting to this frame.
-		VkResult ImageAcquireResult = vkAcquireNextImageKHR(GVulkanContext.Device, VkSwap->SwapChain, UINT64_MAX,
-			VkSwap->FramesInFlight[VkSwap->CurrentFrame].ImageAvailableSemaphore, VK_NULL_HANDLE, &VkSwap->AcquiredImageIndex);
+		if (!Object)
+			return;
 
-		// Vulkan swap chain needs to re-created immediately
-		if (ImageAcquireResult == VK_ERROR_OUT_OF_DATE_KHR)
-		{
-			RecreateSwapChain(Swap, Target, Width, Height);
+		switch (Type)
+		{
+		case DebugObjectType::Texture:
+			SetVkObjectName(VK_OBJECT_TYPE_IMAGE, (uint64_t)static_cast<VulkanTexture*>(Object)->TextureImage, Name);
+			break;
+		case DebugObjectType::TextureView:
+			SetVkObjectName(VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t)static_cast<VulkanTextureView*>(Object)->ImageView, Name);
+			break;
+		case DebugObjectType::Sampler:
+			SetVkObjectName(VK_OBJECT_TYPE_SAMPLER, (uint64_t)static_cast<VulkanSampler*>(Object)->Sampler, Name);
+			break;
+		case DebugObjectType::VertexBuffer:
+			SetVkObjectName(VK_OBJECT_TYPE_BUFFER, (uint64_t)static_cast<VulkanVertexBuffer*>(Object)->DeviceVertexBuffer, Name);
+			break;
+		case DebugObjectType::IndexBuffer:
+			SetVkObjectName(VK_OBJECT_TYPE_BUFFER, (uint64_t)static_cast<VulkanIndexBuffer*>(Object)->DeviceIndexBuffer, Name);
+			break;
+		case DebugObjectType::StorageBuffer:
+			SetVkObjectName(VK_OBJECT_TYPE_BUFFER, (uint64_t)static_cast<VulkanStorageBuffer*>(Object)->DeviceStorageBuffer, Name);
+			break;
+		case DebugObjectType::Pipeline:
+			SetVkObjectName(VK_OBJECT_TYPE_PIPELINE, (uint64_t)static_cast<VulkanPipeline*>(Object)->Pipeline, Name);
+			break;
+		case DebugObjectType::RenderGraph:
+			SetVkObjectName(VK_OBJECT_TYPE_RENDER_PASS, (uint64_t)static_cast<VulkanRenderGraph*>(Object)->RenderPass, Name);
+			break;
+		case DebugObjectType::FrameBuffer:
+			SetVkObjectName(VK_OBJECT_TYPE_FRAMEBUFFER, (uint64_t)static_cast<VulkanFrameBuffer*>(Object)->VulkanFbo, Name);
+			break;
+		case DebugObjectType::CommandBuffer:
+			SetVkObjectName(VK_OBJECT_TYPE_COMMAND_BUFFER, (uint64_t)static_cast<VulkanCommandBuffer*>(Object)->CmdBuffer, Name);
+			break;
+		case DebugObjectType::ResourceSet:
+			for (VkDescriptorSet Set : static_cast<VulkanResourceSet*>(Object)->DescriptorSets)
+				SetVkObjectName(VK_OBJECT_TYPE_DESCRIPTOR_SET, (uint64_t)Set, Name);
+			break;
 		}
+	}
 
-		// Previous frame using this image
-		if (VkSwap->ImageFences[VkSwap->AcquiredImageIndex] != VK_NULL_HANDLE)
-		{
-			// Wait for the previous frame to complete execution of vkQueueSubmit
-			// This is necessary because it's possible the command buffer submitted is still being used on the GPU, 
-			vkWaitForFences(GVulkanContext.Device, 1, &VkSwap->ImageFences[VkSwap->AcquiredImageIndex], VK_TRUE, UINT64_MAX);
-		}
+	void BeginLabel(CommandBuffer Buf, const char* Name, float R, float G, float B)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::BeginLabel, Buf, Name, R, G, B);
 
-		// Mark new image as being used by this "frame in flight"
-		VkSwap->ImageFences[VkSwap->AcquiredImageIndex] = VkSwap->FramesInFlight[VkSwap->CurrentFrame].InFlightFence;
+		if (!GVulkanContext.CmdBeginDebugUtilsLabel)
+			return;
+
+		VkDebugUtilsLabelEXT Label{};
+		Label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+		Label.pLabelName = Name;
+		Label.color[0] = R;
+		Label.color[1] = G;
+		Label.color[2] = B;
+		Label.color[3] = 1.0f;
 
-		return VkSwap->AcquiredImageIndex;
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
+		{
+			GVulkanContext.CmdBeginDebugUtilsLabel(CmdBuffer, &Label);
+		});
 	}
 
-	void EndFrame(const std::vector<CommandBuffer>& Buffers)
+	void EndLabel(CommandBuffer Buf)
 	{
-		GVulkanContext.CurrentSwapChain->bInsideFrame = false;
+		LLRM_CAPTURE_CALL(CaptureOp::EndLabel, Buf);
 
-		int32_t Width, Height;
-		glfwGetFramebufferSize(GVulkanContext.CurrentWindow, &Width, &Height);
+		if (!GVulkanContext.CmdEndDebugUtilsLabel)
+			return;
 
-		// Detect minimization
-		if (Width == 0 || Height == 0)
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
-			vkDeviceWaitIdle(GVulkanContext.Device);
-			return;
-		}
+			GVulkanContext.CmdEndDebugUtilsLabel(CmdBuffer);
+		});
+	}
+#endif
 
-		// Reset the fence that we're waiting on
-		vkResetFences(GVulkanContext.Device, 1, &GVulkanContext.CurrentSwapChain->FramesInFlight[GVulkanContext.CurrentSwapChain->CurrentFrame].InFlightFence);
+	void SetViewport(CommandBuffer Buf, uint32_t X, uint32_t Y, uint32_t W, uint32_t H)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::SetViewport, Buf, X, Y, W, H);
+
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
+		{
+			VkViewport Viewport;
+			Viewport.x = static_cast<float>(X);
+			Viewport.y = static_cast<float>(GetCurrentViewportHeight(Buf) - Y);
+			Viewport.width = static_cast<float>(W);
+			Viewport.height = static_cast<float>(-1.0f * H); // Flip Vulkan viewport
+			Viewport.minDepth = 0.0f;
+			Viewport.maxDepth = 1.0f;
 
-		std::vector<VkCommandBuffer> VkBuffers(Buffers.size());
-		for (uint32_t Buffer = 0; Buffer < Buffers.size(); Buffer++)
-			VkBuffers[Buffer] = (static_cast<VulkanCommandBuffer*>(Buffers[Buffer]))->CmdBuffer;
+			vkCmdSetViewport(CmdBuffer, 0, 1, &Viewport);
+		});
+	}
 
-		// Submit our command buffers for this frame
-		VkPipelineStageFlags WaitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		VkSubmitInfo QueueSubmit{};
-		QueueSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		QueueSubmit.waitSemaphoreCount = 1;
-		QueueSubmit.pWaitSemaphores = &GVulkanContext.CurrentSwapChain->FramesInFlight[GVulkanContext.CurrentSwapChain->CurrentFrame].ImageAvailableSemaphore;
-		QueueSubmit.pWaitDstStageMask = WaitStages;
-		QueueSubmit.commandBufferCount = static_cast<uint32_t>(VkBuffers.size());
-		QueueSubmit.pCommandBuffers = VkBuffers.data();
-		QueueSubmit.signalSemaphoreCount = 1;
-		QueueSubmit.pSignalSemaphores = &GVulkanContext.CurrentSwapChain->FramesInFlight[GVulkanContext.CurrentSwapChain->CurrentFrame].RenderingFinishedSemaphore; // Signal when rendering is finished
+	void SetScissor(CommandBuffer Buf, uint32_t X, uint32_t Y, uint32_t W, uint32_t H)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::SetScissor, Buf, X, Y, W, H);
 
-		// Notify the in flight fence once the execution of this vkQueueSubmit is complete
-		if (vkQueueSubmit(GVulkanContext.GraphicsQueue, static_cast<uint32_t>(VkBuffers.size()), &QueueSubmit, GVulkanContext.CurrentSwapChain->FramesInFlight[GVulkanContext.CurrentSwapChain->CurrentFrame].InFlightFence) != VK_SUCCESS)
+		VkCmdBuffer(Buf, [&](VkCommandBuffer& CmdBuffer)
 		{
-			//GLog->critical("Failed to submit vulkan command buffers to graphics queue");
-		}
+			uint32_t ScissorY = std::max(GetCurrentViewportHeight(Buf) - (Y + H), static_cast<uint32_t>(0));
+
+			VkRect2D Scissor;
+			Scissor.offset.x = static_cast<int32_t>(X);
+			Scissor.offset.y = ScissorY; // Flip on Y
+			Scissor.extent.width = static_cast<uint32_t>(W);
+			Scissor.extent.height = static_cast<uint32_t>(H);
 
-		// Present the rendered images
-		VkPresentInfoKHR PresentInfo{};
-		PresentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-		PresentInfo.waitSemaphoreCount = 1;
-		PresentInfo.pWaitSemaphores = &GVulkanContext.CurrentSwapChain->FramesInFlight[GVulkanContext.CurrentSwapChain->CurrentFrame].RenderingFinishedSemaphore; // Wait for rendering to complete before presenting
-		PresentInfo.swapchainCount = 1;
-		PresentInfo.pSwapchains = &GVulkanContext.CurrentSwapChain->SwapChain;
-		PresentInfo.pImageIndices = &GVulkanContext.CurrentSwapChain->AcquiredImageIndex;
-		PresentInfo.pResults = nullptr;
+			vkCmdSetScissor(CmdBuffer, 0, 1, &Scissor);
+		});
+	}
 
-		// Present the rendered image
-		VkResult PresentResult = vkQueuePresentKHR(GVulkanContext.GraphicsQueue, &PresentInfo);
+	bool CreateShaderModule(const std::vector<uint32_t>& SpvCode, VkShaderModule& OutShaderModule)
+	{
+		VkShaderModuleCreateInfo CreateInfo{};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		CreateInfo.codeSize = SpvCode.size() * sizeof(uint32_t);
+		CreateInfo.pCode = SpvCode.data();
 
-		if (PresentResult == VK_ERROR_OUT_OF_DATE_KHR || PresentResult == VK_SUBOPTIMAL_KHR)
+		VkShaderModule ShaderModule;
+		if (vkCreateShaderModule(GVulkanContext.Device, &CreateInfo, nullptr, &ShaderModule) != VK_SUCCESS)
 		{
-			RecreateSwapChain(GVulkanContext.CurrentSwapChain, GVulkanContext.CurrentSurface, Width, Height);
+			return false;
 		}
 
-		// Advance the current frame
-		GVulkanContext.CurrentSwapChain->CurrentFrame = (GVulkanContext.CurrentSwapChain->CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		OutShaderModule = ShaderModule;
 
-		GVulkanContext.CurrentSwapChain = nullptr;
-		GVulkanContext.CurrentSurface = nullptr;
-		GVulkanContext.CurrentWindow = nullptr;
+		return true;
 	}
 
-	void GetSwapChainSize(SwapChain Swap, uint32_t& Width, uint32_t& Height)
+	void DestroyVkShaderModule(VulkanShaderModule* Module)
 	{
-		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
-		Width = VkSwap->SwapChainExtent.width;
-		Height = VkSwap->SwapChainExtent.height;
-	}
+		vkDestroyShaderModule(GVulkanContext.Device, Module->Module, nullptr);
 
-	uint32_t GetSwapChainImageCount(SwapChain Swap)
-	{
-		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
-		return VkSwap->Images.size();
+		delete Module;
 	}
 
-	Texture GetSwapChainImage(SwapChain Swap, uint32_t Index)
+	// Stages are keyed on their whole SPIR-V, so identical stages of different programs share a module and different ones never collide
+	VulkanShaderModule* AcquireShaderModule(const std::vector<uint32_t>& SpvCode)
 	{
-		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
-		return &VkSwap->Images[Index];
+		CacheKey Key;
+		Key.Bytes.assign(reinterpret_cast<const char*>(SpvCode.data()), SpvCode.size() * sizeof(uint32_t));
+
+		if (VulkanShaderModule* Cached = GShaderModuleCache.Acquire(Key.Bytes))
+			return Cached;
+
+		VulkanShaderModule* Result = new VulkanShaderModule;
+		if (!CreateShaderModule(SpvCode, Result->Module))
+		{
+			delete Result;
+			return nullptr;
+		}
+
+		return GShaderModuleCache.Insert(Key.Bytes, Result, &DestroyVkShaderModule);
 	}
 
-	TextureView GetSwapChainImageView(SwapChain Swap, uint32_t Index)
+	void ReleaseShaderModule(VulkanShaderModule* Module)
 	{
-		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
-		return &VkSwap->ImageViews[Index];
+		if (Module && GShaderModuleCache.Release(Module))
+			DestroyVkShaderModule(Module);
 	}
 
-	void RecreateSwapChain(SwapChain Swap, Surface Target, int32_t DesiredWidth, int32_t DesiredHeight)
+	ShaderProgram CreateRasterProgram(const std::vector<uint32_t>& VertShader, const std::vector<uint32_t>& FragShader)
 	{
-		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
-		vkDeviceWaitIdle(GVulkanContext.Device);
-
-		// Re-create the needed resources
-		DestroyVkSwapChainImageViews(VkSwap);
-		DestroyVkSwapChain(VkSwap);
-
-		CreateVkSwapChain(VkSwap, Target, DesiredWidth, DesiredHeight);
-		CreateVkSwapChainImageViews(VkSwap);
-	}
-
-	void GetFrameBufferSize(FrameBuffer Fbo, uint32_t& Width, uint32_t& Height)
-	{
-		VulkanFrameBuffer* VkFbo = static_cast<VulkanFrameBuffer*>(Fbo);
-
-		Width = VkFbo->AttachmentWidth;
-		Height = VkFbo->AttachmentHeight;
-	}
+		LLRM_CAPTURE_CALL(CaptureOp::CreateRasterProgram, VertShader, FragShader);
 
-	void UpdateUniformBuffer(ResourceSet Resources, uint32_t BufferIndex, void* Data, uint64_t DataSize, bool Dynamic)
-	{
-		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+		VulkanShader* Result = new VulkanShader;
+		Result->Id = GNextObjectId++;
 
-		std::vector<uint32_t> UpdateIndicies{};
-		if (Dynamic)
+		// Create vertex shader
+		Result->VertexModule = AcquireShaderModule(VertShader);
+		if (!Result->VertexModule)
 		{
-			VulkanSwapChain* VkSwap = GVulkanContext.CurrentSwapChain;
-			if (!VkSwap->bInsideFrame)
-			{
-				//GLog->critical("Must update constant buffer within the limits of a swap chain frame");
-				return;
-			}
-			UpdateIndicies.push_back(VkSwap->CurrentFrame);
+			//GLog->critical("Failed to create shader module");
+
+			delete Result;
+			return nullptr;
 		}
-		else
-			for (uint32_t Index = 0; Index < MAX_FRAMES_IN_FLIGHT; Index++) // Probably called once at beginning of program, update all buffers
-				UpdateIndicies.push_back(Index);
+		Result->bHasVertexShader = true;
 
-		for(uint32_t Index : UpdateIndicies)
+		// Create fragment shader
+		Result->FragmentModule = AcquireShaderModule(FragShader);
+		if (!Result->FragmentModule)
 		{
-			VkDeviceMemory& Mem = VkRes->ConstantBuffers[BufferIndex].Memory[Index];
-
-			// Data is guaranteed available since this frame is guaranteed to have previous operations complete by cpu fence in BeginFrame
-			void* MappedData;
-			vkMapMemory(GVulkanContext.Device, Mem, 0, DataSize, 0, &MappedData);
-			{
-				std::memcpy(MappedData, Data, DataSize);
-			}
-			vkUnmapMemory(GVulkanContext.Device, Mem); // Memory is host-coherent, so no flush necessary
-
-			// Update descriptor set memory
-			const auto& ConstBuf = VkRes->ConstantBuffers[BufferIndex];
-
-			VkDescriptorBufferInfo BufInfo{};
-			BufInfo.buffer = ConstBuf.Buffers[Index];
-			BufInfo.offset = 0;
-			BufInfo.range = DataSize;
-
-			VkWriteDescriptorSet BufferWrite{};
-			BufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			BufferWrite.dstSet = VkRes->DescriptorSets[Index];
-			BufferWrite.dstBinding = ConstBuf.Binding;
-			BufferWrite.dstArrayElement = 0; // TODO: support multiple array elements
-			BufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			BufferWrite.descriptorCount = 1;
-			BufferWrite.pBufferInfo = &BufInfo;
-			BufferWrite.pImageInfo = nullptr;
-			BufferWrite.pTexelBufferView = nullptr;
+			//GLog->critical("Failed to create shader module");
 
-			vkUpdateDescriptorSets(GVulkanContext.Device, 1, &BufferWrite, 0, nullptr);
+			ReleaseShaderModule(Result->VertexModule);
+			delete Result;
+			return nullptr;
 		}
+		Result->bHasFragmentShader = true;
 
+		RECORD_RESOURCE_ALLOC(Result);
+		return LLRM_CAPTURE_RESULT(Result);
 	}
 
-	void UpdateTextureResource(ResourceSet Resources, std::vector<TextureView> Images, uint32_t Binding)
+	ShaderProgram CreateComputeProgram(const std::vector<uint32_t>& ComputeShader)
 	{
-		VulkanSwapChain* VkSwap = GVulkanContext.CurrentSwapChain;
-		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateComputeProgram, ComputeShader);
 
-		VkWriteDescriptorSet* Writes = new VkWriteDescriptorSet[Images.size()];
-		VkDescriptorImageInfo* ImageInfos = new VkDescriptorImageInfo[Images.size()];
-		uint32_t CurrentImage = VkSwap->AcquiredImageIndex;
+		VulkanShader* Result = new VulkanShader;
+		Result->Id = GNextObjectId++;
 
-		for (uint32_t ArrayImage = 0; ArrayImage < Images.size(); ArrayImage++)
+		Result->ComputeModule = AcquireShaderModule(ComputeShader);
+		if (!Result->ComputeModule)
 		{
-			VulkanTextureView* VkTex = static_cast<VulkanTextureView*>(Images[ArrayImage]);
-
-			VkDescriptorImageInfo& ImageInfo = ImageInfos[ArrayImage];
-			VkWriteDescriptorSet& ImageWrite = Writes[ArrayImage];
-
-			ImageInfo = {};
-			ImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			ImageInfo.imageView = VkTex->ImageView;
-			ImageInfo.sampler = nullptr;
+			//GLog->critical("Failed to create shader module");
 
-			ImageWrite = {};
-			ImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			ImageWrite.dstSet = VkRes->DescriptorSets[CurrentImage];
-			ImageWrite.dstBinding = Binding;
-			ImageWrite.dstArrayElement = ArrayImage;
-			ImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-			ImageWrite.descriptorCount = 1;
-			ImageWrite.pBufferInfo = nullptr;
-			ImageWrite.pImageInfo = &ImageInfo;
-			ImageWrite.pTexelBufferView = nullptr;
+			delete Result;
+			return nullptr;
 		}
 
-		vkUpdateDescriptorSets(GVulkanContext.Device, Images.size(), Writes, 0, nullptr);
+		Result->bHasComputeShader = true;
 
-		delete[] Writes;
-		delete[] ImageInfos;
+		RECORD_RESOURCE_ALLOC(Result);
+		return LLRM_CAPTURE_RESULT(Result);
 	}
 
-	void UpdateSamplerResource(ResourceSet Resources, Sampler Samp, uint32_t Binding)
+	void ReleaseShaderModules(ShaderProgram Shader)
 	{
-		VulkanSwapChain* VkSwap = GVulkanContext.CurrentSwapChain;
-		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
-		VulkanSampler* VkSamp = static_cast<VulkanSampler*>(Samp);
-
-		uint32_t CurrentImage = VkSwap->AcquiredImageIndex;
+		LLRM_CAPTURE_CALL(CaptureOp::ReleaseShaderModules, Shader);
 
-		VkDescriptorImageInfo ImageInfo{};
-		ImageInfo.imageView = nullptr;
-		ImageInfo.sampler = VkSamp->Sampler;
+		VulkanShader* VkShader = static_cast<VulkanShader*>(Shader);
+		if (VkShader->bModulesReleased)
+			return;
 
-		VkWriteDescriptorSet ImageWrite{};
-		ImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		ImageWrite.dstSet = VkRes->DescriptorSets[CurrentImage];
-		ImageWrite.dstBinding = Binding;
-		ImageWrite.dstArrayElement = 0;
-		ImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-		ImageWrite.descriptorCount = 1;
-		ImageWrite.pBufferInfo = nullptr;
-		ImageWrite.pImageInfo = &ImageInfo;
-		ImageWrite.pTexelBufferView = nullptr;
+		// Pipelines keep what they need from the modules, so this doesn't need to wait for the GPU
+		ReleaseShaderModule(VkShader->VertexModule);
+		ReleaseShaderModule(VkShader->FragmentModule);
+		ReleaseShaderModule(VkShader->ComputeModule);
 
-		vkUpdateDescriptorSets(GVulkanContext.Device, 1, &ImageWrite, 0, nullptr);
+		VkShader->VertexModule = nullptr;
+		VkShader->FragmentModule = nullptr;
+		VkShader->ComputeModule = nullptr;
+		VkShader->bModulesReleased = true;
 	}
 
-	void SynchronizedUploadBufferData(VkFence StagingFence, uint64_t Size, const void* Data,
-	                                  VkCommandBuffer StagingCommandBuffer,
-	                                  VkDeviceMemory StagingMemory, VkBuffer StagingBuffer,
-	                                  VkBuffer DeviceBuffer,
-	                                  VkAccessFlagBits SrcAccess, VkAccessFlagBits DstAccess,
-	                                  VkPipelineStageFlagBits SrcStage, VkPipelineStageFlagBits DstStage)
+	/*ShaderProgram CreateShader(const ShaderCreateInfo* ProgramData)
 	{
-
-		// Wait for previous staging transfer operation to complete
-		vkWaitForFences(GVulkanContext.Device, 1, &StagingFence, VK_TRUE, UINT64_MAX);
-		vkResetFences(GVulkanContext.Device, 1, &StagingFence);
-
-		// Now we can safely write to host-visible staging buffer memory
-		void* MappedData = nullptr;
-		vkMapMemory(GVulkanContext.Device, StagingMemory, 0, Size, 0, &MappedData);
+		// Get the Spv data
+		HlslToSpvResult SpvResult;
+		if (!HlslToSpv(ProgramData, SpvResult))
 		{
-			std::memcpy(MappedData, Data, Size);
+			GLog->error("Failed to produce spv for Vulkan shader module");
+			return nullptr;
 		}
-		vkUnmapMemory(GVulkanContext.Device, StagingMemory);
-
-		VkCommandBufferBeginInfo BeginInfo{};
-		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		BeginInfo.pInheritanceInfo = nullptr;
-		BeginInfo.flags = 0;
 
-		vkResetCommandBuffer(StagingCommandBuffer, 0);
-		vkBeginCommandBuffer(StagingCommandBuffer, &BeginInfo);
-		{
-			VkBufferMemoryBarrier PreBarrier{};
-			PreBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-			PreBarrier.buffer = DeviceBuffer;
-			PreBarrier.size = Size;
-			PreBarrier.offset = 0;
-			PreBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			PreBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			PreBarrier.srcAccessMask = SrcAccess;
-			PreBarrier.dstAccessMask = DstAccess;
+		std::vector<VkPipelineShaderStageCreateInfo> PipelineShaderStages;
+		std::vector<VkShaderModule> ShaderModules;
 
-			// After this barrier we're good to write to the device buffer
-			vkCmdPipelineBarrier(StagingCommandBuffer,
-				SrcStage, DstStage,
-				0,
-				0, nullptr,
-				1, &PreBarrier,
-				0, nullptr
-			);
+		VulkanShader* Result = new VulkanShader;
+		Result->Id = GNextObjectId++;
 
-			VkBufferCopy CopyRegion{};
-			CopyRegion.srcOffset = 0;
-			CopyRegion.dstOffset = 0;
-			CopyRegion.size = Size;
-			vkCmdCopyBuffer(StagingCommandBuffer, StagingBuffer, DeviceBuffer, 1, &CopyRegion);
+		// Create vertex shader
+		if (ProgramData->VertexShaderVirtual)
+		{
+			if (!CreateShaderModule(SpvResult.VertexSpv, Result->VertexModule))
+			{
+				//GLog->critical("Failed to create shader module");
 
-			VkBufferMemoryBarrier PostBarrier{};
-			PostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-			PostBarrier.buffer = DeviceBuffer;
-			PostBarrier.size = Size;
-			PostBarrier.offset = 0;
-			PostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			PostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			PostBarrier.srcAccessMask = DstAccess;
-			PostBarrier.dstAccessMask = SrcAccess;
+				delete Result;
+				return nullptr;
+			}
+			else
+			{
+				ShaderModules.push_back(Result->VertexModule);
+				Result->bHasVertexShader = true;
+			}
+		}
 
-			// After this barrier, the vertex shader is good to read from the device buffer
-			vkCmdPipelineBarrier(StagingCommandBuffer,
-				DstStage, SrcStage,
-				0,
-				0, nullptr,
-				1, &PostBarrier,
-				0, nullptr
-			);
+		// Create fragment shader
+		if (ProgramData->FragmentShaderVirtual)
+		{
+			if (!CreateShaderModule(SpvResult.FragmentSpv, Result->FragmentModule))
+			{
+				//GLog->critical("Failed to create shader module");
 
+				delete Result;
+				return nullptr;
+			}
+			else
+			{
+				ShaderModules.push_back(Result->FragmentModule);
+				Result->bHasFragmentShader = true;
+			}
 		}
-		vkEndCommandBuffer(StagingCommandBuffer);
 
-		// TODO: Is there a performance benefit to submitting to a separate transfer queue?
-		VkSubmitInfo QueueSubmit{};
-		QueueSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		QueueSubmit.commandBufferCount = 1;
-		QueueSubmit.pCommandBuffers = &StagingCommandBuffer;
+		RECORD_RESOURCE_ALLOC(Result);
 
-		// Pass in a fence. This will prevent us from creating a RAW (read-after-write) hazard in the pipeline.
-		vkQueueSubmit(GVulkanContext.GraphicsQueue, 1, &QueueSubmit, StagingFence);
-	}
+		return Result;
+	}*/
 
-	void UploadVertexBufferData(VertexBuffer Buffer, const void* Data, uint64_t Size)
+	VkPresentModeKHR PresentModeToVkPresentMode(PresentMode Mode)
 	{
-		VulkanVertexBuffer* VulkanVbo = static_cast<VulkanVertexBuffer*>(Buffer);
-
-		SynchronizedUploadBufferData(VulkanVbo->VertexStagingCompleteFence, Size, Data,
-			VulkanVbo->VertexStagingCommandBuffer,
-			VulkanVbo->StagingVertexBufferMemory, VulkanVbo->StagingVertexBuffer,
-			VulkanVbo->DeviceVertexBuffer,
-			VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
-			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		switch (Mode)
+		{
+		case PresentMode::Fifo:
+			return VK_PRESENT_MODE_FIFO_KHR;
+		case PresentMode::FifoRelaxed:
+			return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+		case PresentMode::Mailbox:
+			return VK_PRESENT_MODE_MAILBOX_KHR;
+		case PresentMode::Immediate:
+			return VK_PRESENT_MODE_IMMEDIATE_KHR;
+		}
 
+		return VK_PRESENT_MODE_FIFO_KHR;
 	}
 
-	void UploadIndexBufferData(IndexBuffer Buffer, const uint32_t* Data, uint64_t Size)
+	PresentMode VkPresentModeToPresentMode(VkPresentModeKHR Mode)
 	{
-		VulkanIndexBuffer* VulkanIbo = static_cast<VulkanIndexBuffer*>(Buffer);
-
-		SynchronizedUploadBufferData(VulkanIbo->IndexStagingCompleteFence, Size, Data,
-			VulkanIbo->IndexStagingCommandBuffer,
-			VulkanIbo->StagingIndexBufferMemory, VulkanIbo->StagingIndexBuffer,
-			VulkanIbo->DeviceIndexBuffer,
-			VK_ACCESS_INDEX_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
-			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		switch (Mode)
+		{
+		case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+			return PresentMode::FifoRelaxed;
+		case VK_PRESENT_MODE_MAILBOX_KHR:
+			return PresentMode::Mailbox;
+		case VK_PRESENT_MODE_IMMEDIATE_KHR:
+			return PresentMode::Immediate;
+		default:
+			return PresentMode::Fifo;
+		}
 	}
 
-	void ResizeVertexBuffer(VertexBuffer Buffer, uint64_t NewSize)
+	/**
+	 * Queries the physical device for the optimal swap chain settings.
+	 *
+	 */
+	void QuerySwapChainOptimalSettings(
+		int32_t DesiredSwapChainWidth,
+		int32_t DesiredSwapChainHeight,
+		const VkSurfaceKHR& TargetSurface,
+		VkExtent2D& OutOptimalSwapChainExtent,
+		VkSurfaceFormatKHR& OutOptimalSwapChainSurfaceFormat,
+		VkPresentModeKHR& OutOptimalSwapChainPresentMode,
+		VkSurfaceCapabilitiesKHR& OutSurfaceCapabilities,
+		uint32_t& OutImageCount,
+		const std::vector<PresentMode>& PresentModePreferences
+	)
 	{
-		// Delete old resources
-		VulkanVertexBuffer* VulkanVbo = static_cast<VulkanVertexBuffer*>(Buffer);
+		std::vector<VkSurfaceFormatKHR> SupportedFormats;
+		std::vector<VkPresentModeKHR> SupportedPresentModes;
+		uint32_t SurfaceFormatCount;
+		uint32_t PresentModeCount;
 
-		// Force queue idle
-		vkQueueWaitIdle(GVulkanContext.GraphicsQueue);
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(GVulkanContext.PhysicalDevice, TargetSurface, &OutSurfaceCapabilities); // Get surface capabilities
+		vkGetPhysicalDeviceSurfaceFormatsKHR(GVulkanContext.PhysicalDevice, TargetSurface, &SurfaceFormatCount, nullptr); // Get count of surface formats
+		vkGetPhysicalDeviceSurfacePresentModesKHR(GVulkanContext.PhysicalDevice, TargetSurface, &PresentModeCount, nullptr); // Get count of present formats
 
-		vkFreeMemory(GVulkanContext.Device, VulkanVbo->DeviceVertexBufferMemory, nullptr);
-		vkFreeMemory(GVulkanContext.Device, VulkanVbo->StagingVertexBufferMemory, nullptr);
-		vkDestroyBuffer(GVulkanContext.Device, VulkanVbo->DeviceVertexBuffer, nullptr);
-		vkDestroyBuffer(GVulkanContext.Device, VulkanVbo->StagingVertexBuffer, nullptr);
+		if (SurfaceFormatCount > 0 && PresentModeCount > 0)
+		{
+			// Get the surface formats and present modes
+			SupportedFormats.resize(SurfaceFormatCount);
+			SupportedPresentModes.resize(PresentModeCount);
+			vkGetPhysicalDeviceSurfaceFormatsKHR(GVulkanContext.PhysicalDevice, TargetSurface, &SurfaceFormatCount, SupportedFormats.data());
+			vkGetPhysicalDeviceSurfacePresentModesKHR(GVulkanContext.PhysicalDevice, TargetSurface, &PresentModeCount, SupportedPresentModes.data());
 
-		// Re-allocate buffer resources using the same flags that were used to create it
-		CreateBuffer(NewSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-			VulkanVbo->StagingVertexBuffer, VulkanVbo->StagingVertexBufferMemory
-		);
+			// Find the optimal extent
+			{
+				if (OutSurfaceCapabilities.currentExtent.width != UINT32_MAX)
+				{
+					// The optimal extent is already specified, so we need to match it.
+					OutOptimalSwapChainExtent = OutSurfaceCapabilities.currentExtent;
+				}
+				else
+				{
+					OutOptimalSwapChainExtent.width = std::clamp(static_cast<uint32_t>(DesiredSwapChainWidth), OutSurfaceCapabilities.minImageExtent.width, OutSurfaceCapabilities.maxImageExtent.width);
+					OutOptimalSwapChainExtent.height = std::clamp(static_cast<uint32_t>(DesiredSwapChainHeight), OutSurfaceCapabilities.minImageExtent.height, OutSurfaceCapabilities.maxImageExtent.height);
+				}
+			}
 
-		CreateBuffer(NewSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			VulkanVbo->DeviceVertexBuffer, VulkanVbo->DeviceVertexBufferMemory
-		);
+			// Give ourselves one more image than the min image count. Make sure this doesn't exceed the max image count (zero means no max)
+			OutImageCount = OutSurfaceCapabilities.minImageCount + 1;
+			if (OutSurfaceCapabilities.maxImageCount > 0 && OutImageCount > OutSurfaceCapabilities.maxImageCount)
+				OutImageCount = OutSurfaceCapabilities.maxImageCount;
+
+			// Find the optimal surface format
+			{
+				// Rank desired vulkan swap chain formats, lower number means higher priority
+				static std::vector<std::tuple<VkFormat, VkColorSpaceKHR, uint8_t>> FormatRanks = {
+					{VK_FORMAT_R16G16B16A16_SFLOAT, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR, 1},
+					{VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR, 0}
+				};
+
+				// This is technically slow at O(N^2), but only happens once and this simplifies the code since we don't have to write a hash specialization.
+				static auto FindFormatRank = [](VkFormat Format, VkColorSpaceKHR ColorSpace) -> int16_t
+				{
+					for (auto Tup : FormatRanks)
+						if (std::get<0>(Tup) == Format && std::get<1>(Tup) == ColorSpace)
+							return std::get<2>(Tup);
+					return -1;
+				};
+
+				// Default to first available surface format
+				OutOptimalSwapChainSurfaceFormat = SupportedFormats[0];
+				for (const auto& SupportedFormat : SupportedFormats)
+				{
+					auto SupportedFormatRank = FindFormatRank(SupportedFormat.format, SupportedFormat.colorSpace);
+					auto CurFormatRank = FindFormatRank(OutOptimalSwapChainSurfaceFormat.format, OutOptimalSwapChainSurfaceFormat.colorSpace);
+
+					if (SupportedFormatRank >= 0 && (CurFormatRank < 0 || SupportedFormatRank < CurFormatRank))
+						OutOptimalSwapChainSurfaceFormat = SupportedFormat;
+				}
+			}
+
+			// Pick the first preferred presentation mode that's supported
+			{
+				// Default to present mode FIFO since that is the only one guaranteed to be present
+				OutOptimalSwapChainPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+
+				for (PresentMode Preferred : PresentModePreferences)
+				{
+					VkPresentModeKHR VkPreferred = PresentModeToVkPresentMode(Preferred);
+					if (std::find(SupportedPresentModes.begin(), SupportedPresentModes.end(), VkPreferred) != SupportedPresentModes.end())
+					{
+						OutOptimalSwapChainPresentMode = VkPreferred;
+						break;
+					}
+				}
+			}
+
+		}
 	}
 
-	void ResizeIndexBuffer(IndexBuffer Buffer, uint64_t NewSize)
+	bool CreateVkSwapChain(VulkanSwapChain* Dst, Surface TargetSurface, int32_t DesiredWidth, int32_t DesiredHeight)
 	{
-		// Delete old resources
-		VulkanIndexBuffer* VulkanIbo = static_cast<VulkanIndexBuffer*>(Buffer);
+		VulkanSurface* VkSurface = static_cast<VulkanSurface*>(TargetSurface);
 
-		// Force queue idle
-		vkQueueWaitIdle(GVulkanContext.GraphicsQueue);
+		// Query optimal swap chain settings for current surface
+		VkExtent2D OptimalExtent;
+		VkSurfaceFormatKHR OptimalFormat;
+		VkPresentModeKHR OptimalPresentMode;
+		VkSurfaceCapabilitiesKHR SurfaceCapabilities;
+		uint32_t OptimalImageCount;
+		QuerySwapChainOptimalSettings(DesiredWidth, DesiredHeight, VkSurface->VkSurface,
+			OptimalExtent, OptimalFormat, OptimalPresentMode, SurfaceCapabilities, OptimalImageCount, Dst->PresentModePreferences);
 
-		vkFreeMemory(GVulkanContext.Device, VulkanIbo->DeviceIndexBufferMemory, nullptr);
-		vkFreeMemory(GVulkanContext.Device, VulkanIbo->StagingIndexBufferMemory, nullptr);
-		vkDestroyBuffer(GVulkanContext.Device, VulkanIbo->DeviceIndexBuffer, nullptr);
-		vkDestroyBuffer(GVulkanContext.Device, VulkanIbo->StagingIndexBuffer, nullptr);
+		// This needs to be declared in case the queue families are different
+		uint32_t QueueFamilyIndices[] = { GVulkanContext.GraphicsQueueFamIndex, GVulkanContext.PresentQueueFamIndex };
 
-		CreateBuffer(NewSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-			VulkanIbo->StagingIndexBuffer, VulkanIbo->StagingIndexBufferMemory
-		);
+		VkSwapchainCreateInfoKHR CreateInfo{};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+		CreateInfo.surface = VkSurface->VkSurface;
+		CreateInfo.minImageCount = OptimalImageCount;
+		CreateInfo.imageFormat = OptimalFormat.format;
+		CreateInfo.imageColorSpace = OptimalFormat.colorSpace;
+		CreateInfo.imageExtent = OptimalExtent;
+		CreateInfo.imageArrayLayers = 1; // TODO: This would be 2 for VR
+		CreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; // TODO: This will need to be changed in some instances (e.g. post processing)
+		CreateInfo.preTransform = SurfaceCapabilities.currentTransform; // I don't think we ever want to use this
+		CreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR; // This is how you blend with other windows
+		CreateInfo.presentMode = OptimalPresentMode;
+		CreateInfo.clipped = VK_TRUE; // This would need to be false if we cared about clipped pixels (obscured by a window for example)
+		CreateInfo.oldSwapchain = VK_NULL_HANDLE;
 
-		// Create device index buffer. Because we will be copying the staging buffer to the device buffer, we need to make it eligible for transfer.
-		CreateBuffer(NewSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			VulkanIbo->DeviceIndexBuffer, VulkanIbo->DeviceIndexBufferMemory
-		);
+		// Make things simple: Use concurrent sharing if queue families are different
+		if (GVulkanContext.GraphicsQueueFamIndex != GVulkanContext.PresentQueueFamIndex)
+		{
+			CreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+			CreateInfo.queueFamilyIndexCount = 2;
+			CreateInfo.pQueueFamilyIndices = QueueFamilyIndices;
+		}
+		else
+		{
+			CreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			CreateInfo.queueFamilyIndexCount = 0;
+			CreateInfo.pQueueFamilyIndices = nullptr;
+		}
+
+		// Also store the optimal settings for later reference
+		Dst->ImageFormat = VkFormatToAttachmentFormat(OptimalFormat.format);
+		Dst->PresentMode = OptimalPresentMode;
+		Dst->SwapChainExtent = OptimalExtent;
+
+		if (vkCreateSwapchainKHR(GVulkanContext.Device, &CreateInfo, nullptr, &Dst->SwapChain) != VK_SUCCESS)
+		{
+			//GLog->critical("Failed to create a Vulkan swap chain");
+			return false;
+		}
+
+		return true;
 	}
 
-	void WriteTexture(Texture Tex,
-		AttachmentUsage PreviousUsage, AttachmentUsage FinalUsage,
-		uint32_t Width, uint32_t Height,
-		uint32_t Layer,
-		uint64_t ImageSize, void* Data
-	)
+	bool CreateVkSwapChainImageViews(VulkanSwapChain* Dst)
 	{
-		VulkanTexture* Result = reinterpret_cast<VulkanTexture*>(Tex);
+		// Retrieve the swap chain images
+		uint32_t ImageCount{};
+		vkGetSwapchainImagesKHR(GVulkanContext.Device, Dst->SwapChain, &ImageCount, nullptr);
 
-		if(!Result->StagingBuffer)
+		// Allocate space for images
+		std::vector<VkImage> Images(ImageCount);
+
+		// Get the actual swap chain images
+		vkGetSwapchainImagesKHR(GVulkanContext.Device, Dst->SwapChain, &ImageCount, Images.data());
+
+		// Get the images and create the image views
+		Dst->Images.resize(ImageCount);
+		Dst->ImageViews.resize(ImageCount);
+
+		for (uint32_t ImageIndex = 0; ImageIndex < ImageCount; ImageIndex++)
 		{
-			CreateBuffer
-			(
-				ImageSize,
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				Result->StagingBuffer, Result->StagingBufferMemory
-			);
+			Dst->Images[ImageIndex].TextureImage = Images[ImageIndex];
+			Dst->Images[ImageIndex].TextureFormat = Dst->ImageFormat;
+
+			VkImageViewCreateInfo ImageViewCreateInfo{};
+			ImageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			ImageViewCreateInfo.image = Images[ImageIndex];
+			ImageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			ImageViewCreateInfo.format = AttachmentFormatToVkFormat(Dst->ImageFormat);
+			ImageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+			ImageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+			ImageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+			ImageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+			ImageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			ImageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+			ImageViewCreateInfo.subresourceRange.levelCount = 1;
+			ImageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+			ImageViewCreateInfo.subresourceRange.layerCount = 1;
+
+			if (vkCreateImageView(GVulkanContext.Device, &ImageViewCreateInfo, nullptr, &Dst->ImageViews[ImageIndex].ImageView) != VK_SUCCESS)
+			{
+				//GLog->error("Failed to create image view for swap chain");
+
+				// Error in creation
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void DestroyVkSwapChain(VulkanSwapChain* VkSwap)
+	{
+		vkDestroySwapchainKHR(GVulkanContext.Device, VkSwap->SwapChain, nullptr);
+	}
+
+	void DestroyVkSwapChainImageViews(VulkanSwapChain* VkSwap)
+	{
+		// Clean up framebuffers and image views
+		for (uint32_t SwapChainImage = 0; SwapChainImage < VkSwap->Images.size(); SwapChainImage++)
+		{
+			vkDestroyImageView(GVulkanContext.Device, VkSwap->ImageViews[SwapChainImage].ImageView, nullptr);
+		}
+	}
+
+	SwapChain CreateSwapChain(Surface TargetSurface, int32_t DesiredWidth,
+		int32_t DesiredHeight, const std::vector<PresentMode>& PresentModes)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateSwapChain, TargetSurface, DesiredWidth, DesiredHeight, PresentModes);
+
+		VulkanSwapChain* Result = new VulkanSwapChain;
+		Result->PresentModePreferences = PresentModes;
+
+		// Create swap chain resources
+		if (!CreateVkSwapChain(Result, TargetSurface, DesiredWidth, DesiredHeight))
+		{
+			return nullptr;
+		}
+
+		if (!CreateVkSwapChainImageViews(Result))
+		{
+			return nullptr;
 		}
 
-		void* MappedData;
-		vkMapMemory(GVulkanContext.Device, Result->StagingBufferMemory, 0, ImageSize, 0, &MappedData);
+		// Create n frames in flight for this swap chain. This only needs to be done at creation, hence there isn't another function for it.
+		for (uint32_t FrameInFlight = 0; FrameInFlight < GVulkanContext.FramesInFlight; FrameInFlight++)
+		{
+			VkSemaphore ImageAvailableSem, PresentSem;
+
+			// Create semaphore for frame in flight
+			VkSemaphoreCreateInfo SemCreate{};
+			SemCreate.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			if (vkCreateSemaphore(GVulkanContext.Device, &SemCreate, nullptr, &ImageAvailableSem) != VK_SUCCESS ||
+				vkCreateSemaphore(GVulkanContext.Device, &SemCreate, nullptr, &PresentSem) != VK_SUCCESS)
+			{
+				//GLog->critical("Failed to create semaphores for swap chain");
+
+				delete Result;
+				return nullptr;
+			}
+
+			Result->FramesInFlight.emplace_back(ImageAvailableSem, PresentSem);
+		}
+
+		// Resize image fences to as many swap chain images that we have. Also, start them all at the null handle.
+		Result->ImageFences.resize(Result->Images.size(), VK_NULL_HANDLE);
+
+		RECORD_RESOURCE_ALLOC(Result)
+
+		return LLRM_CAPTURE_RESULT(Result);
+	}
+
+	void DestroySwapChain(SwapChain Swap)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroySwapChain, Swap);
+
+		WaitDeviceIdle();
+
+		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
+
+		// Destroy volatile swap chain resources
+		DestroyVkSwapChainImageViews(VkSwap);
+		DestroyVkSwapChain(VkSwap);
+
+		// Destroy frames in flight
+		for (const auto& FrameInFlight : VkSwap->FramesInFlight)
+		{
+			vkDestroySemaphore(GVulkanContext.Device, FrameInFlight.ImageAvailableSemaphore, nullptr);
+			vkDestroySemaphore(GVulkanContext.Device, FrameInFlight.RenderingFinishedSemaphore, nullptr);
+		}
+
+		REMOVE_RESOURCE_ALLOC(VkSwap)
+
+		// Free swap chain memory
+		delete VkSwap;
+	}
+
+	void SubmitCommandBuffer(CommandBuffer Buffer, bool bWait, Fence WaitFence)
+	{
+		LLRM_TRACE_FUNCTION();
+		LLRM_CAPTURE_CALL(CaptureOp::SubmitCommandBuffer, Buffer, bWait);
+
+		VulkanCommandBuffer* VkCmd = static_cast<VulkanCommandBuffer*>(Buffer);
+
+		VkSubmitInfo SubmitInfo{};
+		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SubmitInfo.commandBufferCount = 1;
+		SubmitInfo.pCommandBuffers = &VkCmd->CmdBuffer;
+
+		std::lock_guard<std::mutex> QueueLock(GQueueMutex);
+
+		if (vkQueueSubmit(GVulkanContext.GraphicsQueue, 1, &SubmitInfo, WaitFence ? static_cast<VkFence>(WaitFence) : VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			//GLog->critical("Failed to submit vulkan command buffers to graphics queue");
+		}
+
+		if (bWait)
+		{
+			LLRM_TRACE_ZONE("Wait Queue Idle");
+			vkQueueWaitIdle(GVulkanContext.GraphicsQueue);
+		}
+	}
+
+	int32_t AcquireSwapChainImage(GLFWwindow* Window, SwapChain Swap, Surface Target)
+	{
+		LLRM_TRACE_FUNCTION();
+
+		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
+
+		int32_t Width, Height;
+		glfwGetFramebufferSize(Window, &Width, &Height);
+
+		if (Width == 0 || Height == 0)
+		{
+			WaitDeviceIdle();
+			return -1;
+		}
+
+		// Acquire image, this is the swapchain image index that we will be rendering command buffers for + presenting to this frame.
+		VkResult ImageAcquireResult = vkAcquireNextImageKHR(GVulkanContext.Device, VkSwap->SwapChain, UINT64_MAX,
+			VkSwap->FramesInFlight[GVulkanContext.CurrentFrame].ImageAvailableSemaphore, VK_NULL_HANDLE, &VkSwap->AcquiredImageIndex);
+
+		// Vulkan swap chain needs to re-created immediately, nothing was acquired so skip this window for a frame
+		if (ImageAcquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			RecreateSwapChain(Swap, Target, Width, Height);
+			return -1;
+		}
+
+		// Previous frame using this image
+		if (VkSwap->ImageFences[VkSwap->AcquiredImageIndex] != VK_NULL_HANDLE)
+		{
+			// Wait for the previous frame to complete execution of vkQueueSubmit
+			// This is necessary because it's possible the command buffer submitted is still being used on the GPU, 
+			LLRM_TRACE_ZONE("Wait Image Fence");
+			vkWaitForFences(GVulkanContext.Device, 1, &VkSwap->ImageFences[VkSwap->AcquiredImageIndex], VK_TRUE, UINT64_MAX);
+		}
+
+		// Mark new image as being used by this "frame in flight"
+		VkSwap->ImageFences[VkSwap->AcquiredImageIndex] = GVulkanContext.FrameFences[GVulkanContext.CurrentFrame];
+
+		return static_cast<int32_t>(VkSwap->AcquiredImageIndex);
+	}
+
+	void BeginFrames(std::vector<SwapChainFrame>& Frames)
+	{
+		LLRM_TRACE_FUNCTION();
+		LLRM_CAPTURE_CALL(CaptureOp::BeginFrames, Frames);
+
+		// Wait until the GPU is done with the resources of this frame in flight, since they're about to be updated
+		{
+			LLRM_TRACE_ZONE("Wait Frame Fence");
+			vkWaitForFences(GVulkanContext.Device, 1, &GVulkanContext.FrameFences[GVulkanContext.CurrentFrame], VK_TRUE, UINT64_MAX);
+		}
+		GVulkanContext.bInsideFrame = true;
+
+		ResetTransientFrame(GVulkanContext.CurrentFrame);
+
+		for (SwapChainFrame& Frame : Frames)
+		{
+			if (Frame.Swap)
+				Frame.ImageIndex = AcquireSwapChainImage(Frame.Window, Frame.Swap, Frame.Target);
+			else
+				Frame.ImageIndex = 0; // Offscreen work is always submitted
+		}
+
+		// Nothing can be rendered this frame, so it isn't begun and the caller won't end it
+		if (std::none_of(Frames.begin(), Frames.end(), [](const SwapChainFrame& Frame) { return Frame.ImageIndex >= 0; }))
+		{
+			GVulkanContext.bInsideFrame = false;
+			GVulkanContext.BegunFrames.clear();
+		}
+	}
+
+	int32_t BeginFrame(GLFWwindow* Window, llrm::SwapChain Swap, llrm::Surface Target)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::BeginFrame, Swap);
+
+		GVulkanContext.BegunFrames.assign(1, SwapChainFrame{ Window, Swap, Target });
+		BeginFrames(GVulkanContext.BegunFrames);
+
+		return GVulkanContext.BegunFrames.empty() ? -1 : GVulkanContext.BegunFrames[0].ImageIndex;
+	}
+
+	int32_t BeginFrame()
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::BeginFrameOffscreen);
+
+		GVulkanContext.BegunFrames.assign(1, SwapChainFrame{});
+		BeginFrames(GVulkanContext.BegunFrames);
+
+		return static_cast<int32_t>(GVulkanContext.CurrentFrame);
+	}
+
+	void EndFrames(const std::vector<SwapChainFrame>& Frames)
+	{
+		LLRM_TRACE_FUNCTION();
+		LLRM_CAPTURE_CALL(CaptureOp::EndFrames, Frames);
+
+		GVulkanContext.bInsideFrame = false;
+
+		std::vector<VkCommandBuffer> VkBuffers;
+		std::vector<VkSemaphore> WaitSemaphores;
+		std::vector<VkPipelineStageFlags> WaitStages;
+		std::vector<VkSemaphore> SignalSemaphores;
+		std::vector<VkSwapchainKHR> PresentSwapChains;
+		std::vector<uint32_t> PresentImages;
+		std::vector<const SwapChainFrame*> PresentFrames;
+
+		for (const SwapChainFrame& Frame : Frames)
+		{
+			// Windows that couldn't acquire an image aren't rendered to this frame
+			if (Frame.ImageIndex < 0)
+				continue;
+
+			for (CommandBuffer Buffer : Frame.CommandBuffers)
+				VkBuffers.push_back(static_cast<VulkanCommandBuffer*>(Buffer)->CmdBuffer);
+
+			if (!Frame.Swap)
+				continue;
+
+			VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Frame.Swap);
+			const VulkanFrame& FrameSync = VkSwap->FramesInFlight[GVulkanContext.CurrentFrame];
+
+			WaitSemaphores.push_back(FrameSync.ImageAvailableSemaphore);
+			WaitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+			SignalSemaphores.push_back(FrameSync.RenderingFinishedSemaphore); // Signal when rendering is finished
+
+			PresentSwapChains.push_back(VkSwap->SwapChain);
+			PresentImages.push_back(static_cast<uint32_t>(Frame.ImageIndex));
+			PresentFrames.push_back(&Frame);
+		}
+
+		// Reset the fence that we're waiting on
+		VkFence& FrameFence = GVulkanContext.FrameFences[GVulkanContext.CurrentFrame];
+		vkResetFences(GVulkanContext.Device, 1, &FrameFence);
+
+		// Submit the command buffers of every window at once. This happens even when nothing is presented so the frame's fence is signaled.
+		VkSubmitInfo QueueSubmit{};
+		QueueSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		QueueSubmit.waitSemaphoreCount = static_cast<uint32_t>(WaitSemaphores.size());
+		QueueSubmit.pWaitSemaphores = WaitSemaphores.data();
+		QueueSubmit.pWaitDstStageMask = WaitStages.data();
+		QueueSubmit.commandBufferCount = static_cast<uint32_t>(VkBuffers.size());
+		QueueSubmit.pCommandBuffers = VkBuffers.data();
+		QueueSubmit.signalSemaphoreCount = static_cast<uint32_t>(SignalSemaphores.size());
+		QueueSubmit.pSignalSemaphores = SignalSemaphores.data();
+
+		std::unique_lock<std::mutex> QueueLock(GQueueMutex);
+
+		// Notify the in flight fence once the execution of this vkQueueSubmit is complete
+		{
+			LLRM_TRACE_ZONE("Queue Submit");
+			if (vkQueueSubmit(GVulkanContext.GraphicsQueue, 1, &QueueSubmit, FrameFence) != VK_SUCCESS)
+			{
+				//GLog->critical("Failed to submit vulkan command buffers to graphics queue");
+			}
+		}
+
+		if (!PresentSwapChains.empty())
+		{
+			std::vector<VkResult> PresentResults(PresentSwapChains.size());
+
+			// Present every rendered image at once
+			VkPresentInfoKHR PresentInfo{};
+			PresentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+			PresentInfo.waitSemaphoreCount = static_cast<uint32_t>(SignalSemaphores.size());
+			PresentInfo.pWaitSemaphores = SignalSemaphores.data(); // Wait for rendering to complete before presenting
+			PresentInfo.swapchainCount = static_cast<uint32_t>(PresentSwapChains.size());
+			PresentInfo.pSwapchains = PresentSwapChains.data();
+			PresentInfo.pImageIndices = PresentImages.data();
+			PresentInfo.pResults = PresentResults.data();
+
+			{
+				LLRM_TRACE_ZONE("Queue Present");
+				vkQueuePresentKHR(GVulkanContext.PresentQueue, &PresentInfo);
+			}
+			QueueLock.unlock();
+
+			for (uint32_t Presented = 0; Presented < PresentFrames.size(); Presented++)
+			{
+				if (PresentResults[Presented] == VK_ERROR_OUT_OF_DATE_KHR || PresentResults[Presented] == VK_SUBOPTIMAL_KHR)
+				{
+					const SwapChainFrame* Frame = PresentFrames[Presented];
+
+					int32_t Width, Height;
+					glfwGetFramebufferSize(Frame->Window, &Width, &Height);
+					RecreateSwapChain(Frame->Swap, Frame->Target, Width, Height);
+				}
+			}
+		}
+
+		// Advance the current frame
+		GVulkanContext.CurrentFrame = (GVulkanContext.CurrentFrame + 1) % GVulkanContext.FramesInFlight;
+	}
+
+	void EndFrame(const std::vector<CommandBuffer>& Buffers)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::EndFrame, Buffers);
+
+		std::vector<SwapChainFrame> Frames = std::move(GVulkanContext.BegunFrames);
+		GVulkanContext.BegunFrames.clear();
+
+		if (!Frames.empty())
+			Frames[0].CommandBuffers = Buffers;
+
+		EndFrames(Frames);
+	}
+
+	void GetSwapChainSize(SwapChain Swap, uint32_t& Width, uint32_t& Height)
+	{
+		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
+		Width = VkSwap->SwapChainExtent.width;
+		Height = VkSwap->SwapChainExtent.height;
+	}
+
+	PresentMode GetSwapChainPresentMode(SwapChain Swap)
+	{
+		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
+		return VkPresentModeToPresentMode(VkSwap->PresentMode);
+	}
+
+	uint32_t GetFramesInFlight()
+	{
+		return GVulkanContext.FramesInFlight;
+	}
+
+	uint32_t GetSwapChainImageCount(SwapChain Swap)
+	{
+		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
+		return VkSwap->Images.size();
+	}
+
+	Texture GetSwapChainImage(SwapChain Swap, uint32_t Index)
+	{
+		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
+		LLRM_CAPTURE_CALL(CaptureOp::GetSwapChainImage, Swap, Index, VkSwap->SwapChainExtent.width, VkSwap->SwapChainExtent.height, VkSwap->ImageFormat);
+
+		return LLRM_CAPTURE_RESULT(&VkSwap->Images[Index]);
+	}
+
+	TextureView GetSwapChainImageView(SwapChain Swap, uint32_t Index)
+	{
+		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
+		LLRM_CAPTURE_CALL(CaptureOp::GetSwapChainImageView, Swap, Index, VkSwap->SwapChainExtent.width, VkSwap->SwapChainExtent.height, VkSwap->ImageFormat);
+
+		return LLRM_CAPTURE_RESULT(&VkSwap->ImageViews[Index]);
+	}
+
+	void RecreateSwapChain(SwapChain Swap, Surface Target, int32_t DesiredWidth, int32_t DesiredHeight)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::RecreateSwapChain, Swap, DesiredWidth, DesiredHeight);
+
+		VulkanSwapChain* VkSwap = static_cast<VulkanSwapChain*>(Swap);
+		WaitDeviceIdle();
+
+		// Re-create the needed resources
+		DestroyVkSwapChainImageViews(VkSwap);
+		DestroyVkSwapChain(VkSwap);
+
+		CreateVkSwapChain(VkSwap, Target, DesiredWidth, DesiredHeight);
+		CreateVkSwapChainImageViews(VkSwap);
+	}
+
+	void GetFrameBufferSize(FrameBuffer Fbo, uint32_t& Width, uint32_t& Height)
+	{
+		VulkanFrameBuffer* VkFbo = static_cast<VulkanFrameBuffer*>(Fbo);
+
+		Width = VkFbo->AttachmentWidth;
+		Height = VkFbo->AttachmentHeight;
+	}
+
+	// Where the slice of a frame starts, which is always the start of the buffer unless it has one slice per frame in flight
+	uint64_t GetBufferSliceOffset(const VulkanStorageBuffer* VkSbo, uint32_t Frame)
+	{
+		return (VkSbo->Flags & BUFFER_PER_FRAME) ? VkSbo->SliceSize * Frame : 0;
+	}
+
+	// Texel and dynamic buffer bindings come in a uniform and a storage flavour, the layout of the set tells which one a binding is
+	void CopyUniformBufferBindings(const std::vector<StorageDescription>& Bindings, std::vector<uint32_t>& OutBindings)
+	{
+		OutBindings.clear();
+		for (const StorageDescription& Desc : Bindings)
+			OutBindings.push_back(Desc.Binding);
+	}
+
+	VkDescriptorType GetBufferBindingType(const VulkanResourceSet* Set, uint32_t Binding, bool bDynamic)
+	{
+		const std::vector<uint32_t>& UniformBindings = bDynamic ? Set->DynamicUniformBufferBindings : Set->UniformTexelBufferBindings;
+		if (std::find(UniformBindings.begin(), UniformBindings.end(), Binding) != UniformBindings.end())
+			return bDynamic ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+
+		return bDynamic ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+	}
+
+	// Inside a frame only the current frame's resources are safe to update. Outside of one every frame's are updated.
+	void GetUpdatedFrames(const VulkanResourceSet* VkRes, bool bDynamic, uint32_t& OutFirstFrame, uint32_t& OutFrameCount)
+	{
+		// Transient resource sets only have the descriptor set of the frame they were created in
+		if (VkRes->bTransient)
+		{
+			OutFirstFrame = 0;
+			OutFrameCount = 1;
+		}
+		else if (bDynamic && GVulkanContext.bInsideFrame)
+		{
+			OutFirstFrame = GVulkanContext.CurrentFrame;
+			OutFrameCount = 1;
+		}
+		else
+		{
+			OutFirstFrame = 0;
+			OutFrameCount = GVulkanContext.FramesInFlight;
+		}
+	}
+
+	void UpdateUniformBuffer(ResourceSet Resources, uint32_t BufferIndex, void* Data, uint64_t DataSize, bool Dynamic)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateUniformBuffer, Resources, BufferIndex, Dynamic, CaptureBlob{ Data, DataSize });
+
+		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+
+		uint32_t FirstFrame, FrameCount;
+		GetUpdatedFrames(VkRes, Dynamic, FirstFrame, FrameCount);
+
+		for(uint32_t Index = FirstFrame; Index < FirstFrame + FrameCount; Index++)
+		{
+			const auto& ConstBuf = VkRes->ConstantBuffers[BufferIndex];
+
+			// Data is guaranteed available since this frame is guaranteed to have previous operations complete by cpu fence in BeginFrame
+			if (VkRes->bTransient)
+			{
+				std::memcpy(ConstBuf.Mapped, Data, DataSize);
+			}
+			else
+			{
+				VkDeviceMemory Mem = ConstBuf.Memory[Index];
+
+				void* MappedData;
+				vkMapMemory(GVulkanContext.Device, Mem, 0, DataSize, 0, &MappedData);
+				{
+					std::memcpy(MappedData, Data, DataSize);
+				}
+				vkUnmapMemory(GVulkanContext.Device, Mem); // Memory is host-coherent, so no flush necessary
+			}
+
+			// Update descriptor set memory
+			VkDescriptorBufferInfo BufInfo{};
+			BufInfo.buffer = ConstBuf.Buffers[Index];
+			BufInfo.offset = ConstBuf.Offset;
+			BufInfo.range = DataSize;
+
+			VkWriteDescriptorSet BufferWrite{};
+			BufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			BufferWrite.dstSet = VkRes->DescriptorSets[Index];
+			BufferWrite.dstBinding = ConstBuf.Binding;
+			BufferWrite.dstArrayElement = 0; // TODO: support multiple array elements
+			BufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			BufferWrite.descriptorCount = 1;
+			BufferWrite.pBufferInfo = &BufInfo;
+			BufferWrite.pImageInfo = nullptr;
+			BufferWrite.pTexelBufferView = nullptr;
+
+			vkUpdateDescriptorSets(GVulkanContext.Device, 1, &BufferWrite, 0, nullptr);
+		}
+
+	}
+
+	void UpdateTextureResource(ResourceSet Resources, std::vector<TextureView> Images, uint32_t Binding)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateTextureResource, Resources, Binding, Images);
+
+		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+
+		VkWriteDescriptorSet* Writes = new VkWriteDescriptorSet[Images.size()];
+		VkDescriptorImageInfo* ImageInfos = new VkDescriptorImageInfo[Images.size()];
+
+		uint32_t FirstFrame, FrameCount;
+		GetUpdatedFrames(VkRes, true, FirstFrame, FrameCount);
+
+		for (uint32_t ArrayImage = 0; ArrayImage < Images.size(); ArrayImage++)
+		{
+			VulkanTextureView* VkTex = static_cast<VulkanTextureView*>(Images[ArrayImage]);
+
+			VkDescriptorImageInfo& ImageInfo = ImageInfos[ArrayImage];
+			VkWriteDescriptorSet& ImageWrite = Writes[ArrayImage];
+
+			ImageInfo = {};
+			ImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			ImageInfo.imageView = VkTex->ImageView;
+			ImageInfo.sampler = nullptr;
+
+			ImageWrite = {};
+			ImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			ImageWrite.dstBinding = Binding;
+			ImageWrite.dstArrayElement = ArrayImage;
+			ImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			ImageWrite.descriptorCount = 1;
+			ImageWrite.pBufferInfo = nullptr;
+			ImageWrite.pImageInfo = &ImageInfo;
+			ImageWrite.pTexelBufferView = nullptr;
+		}
+
+		for (uint32_t Frame = FirstFrame; Frame < FirstFrame + FrameCount; Frame++)
+		{
+			for (uint32_t ArrayImage = 0; ArrayImage < Images.size(); ArrayImage++)
+				Writes[ArrayImage].dstSet = VkRes->DescriptorSets[Frame];
+
+			vkUpdateDescriptorSets(GVulkanContext.Device, Images.size(), Writes, 0, nullptr);
+		}
+
+		delete[] Writes;
+		delete[] ImageInfos;
+	}
+
+	void UpdateInputAttachmentResource(ResourceSet Resources, TextureView Attachment, uint32_t Binding)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateInputAttachmentResource, Resources, Binding, Attachment);
+
+		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+		VulkanTextureView* VkView = static_cast<VulkanTextureView*>(Attachment);
+
+		uint32_t FirstFrame, FrameCount;
+		GetUpdatedFrames(VkRes, true, FirstFrame, FrameCount);
+
+		// Must match the layout the render graph references the input attachment with
+		VkDescriptorImageInfo ImageInfo{};
+		ImageInfo.imageLayout = VkView->bDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		ImageInfo.imageView = VkView->ImageView;
+		ImageInfo.sampler = nullptr;
+
+		VkWriteDescriptorSet ImageWrite{};
+		ImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		ImageWrite.dstBinding = Binding;
+		ImageWrite.dstArrayElement = 0;
+		ImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		ImageWrite.descriptorCount = 1;
+		ImageWrite.pBufferInfo = nullptr;
+		ImageWrite.pImageInfo = &ImageInfo;
+		ImageWrite.pTexelBufferView = nullptr;
+
+		for (uint32_t Frame = FirstFrame; Frame < FirstFrame + FrameCount; Frame++)
+		{
+			ImageWrite.dstSet = VkRes->DescriptorSets[Frame];
+			vkUpdateDescriptorSets(GVulkanContext.Device, 1, &ImageWrite, 0, nullptr);
+		}
+	}
+
+	void UpdateStorageBufferResource(ResourceSet Resources, StorageBuffer Buffer, uint32_t Binding)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateStorageBufferResource, Resources, Binding, Buffer);
+
+		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+		VulkanStorageBuffer* VkSbo = static_cast<VulkanStorageBuffer*>(Buffer);
+
+		uint32_t FirstFrame, FrameCount;
+		GetUpdatedFrames(VkRes, true, FirstFrame, FrameCount);
+
+		VkDescriptorBufferInfo BufferInfo{};
+		BufferInfo.buffer = VkSbo->DeviceStorageBuffer;
+		BufferInfo.range = (VkSbo->Flags & BUFFER_PER_FRAME) ? VkSbo->Size : VK_WHOLE_SIZE;
+
+		VkWriteDescriptorSet BufferWrite{};
+		BufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		BufferWrite.dstBinding = Binding;
+		BufferWrite.dstArrayElement = 0;
+		BufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		BufferWrite.descriptorCount = 1;
+		BufferWrite.pBufferInfo = &BufferInfo;
+		BufferWrite.pImageInfo = nullptr;
+		BufferWrite.pTexelBufferView = nullptr;
+
+		for (uint32_t Frame = FirstFrame; Frame < FirstFrame + FrameCount; Frame++)
+		{
+			BufferInfo.offset = GetBufferSliceOffset(VkSbo, VkRes->bTransient ? GVulkanContext.CurrentFrame : Frame);
+			BufferWrite.dstSet = VkRes->DescriptorSets[Frame];
+			vkUpdateDescriptorSets(GVulkanContext.Device, 1, &BufferWrite, 0, nullptr);
+		}
+	}
+
+	void UpdateTexelBufferResource(ResourceSet Resources, TexelBufferView View, uint32_t Binding)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateTexelBufferResource, Resources, Binding, View);
+
+		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+		VulkanTexelBufferView* VkView = static_cast<VulkanTexelBufferView*>(View);
+
+		uint32_t FirstFrame, FrameCount;
+		GetUpdatedFrames(VkRes, true, FirstFrame, FrameCount);
+
+		VkWriteDescriptorSet TexelWrite{};
+		TexelWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		TexelWrite.dstBinding = Binding;
+		TexelWrite.dstArrayElement = 0;
+		TexelWrite.descriptorType = GetBufferBindingType(VkRes, Binding, false);
+		TexelWrite.descriptorCount = 1;
+		TexelWrite.pBufferInfo = nullptr;
+		TexelWrite.pImageInfo = nullptr;
+
+		for (uint32_t Frame = FirstFrame; Frame < FirstFrame + FrameCount; Frame++)
+		{
+			uint32_t Slice = VkRes->bTransient ? GVulkanContext.CurrentFrame : Frame;
+			TexelWrite.pTexelBufferView = &VkView->Views[VkView->Views.size() > 1 ? Slice : 0];
+			TexelWrite.dstSet = VkRes->DescriptorSets[Frame];
+			vkUpdateDescriptorSets(GVulkanContext.Device, 1, &TexelWrite, 0, nullptr);
+		}
+	}
+
+	void UpdateDynamicBufferResource(ResourceSet Resources, StorageBuffer Buffer, uint32_t Binding, uint64_t Range)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateDynamicBufferResource, Resources, Binding, Buffer, Range);
+
+		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+		VulkanStorageBuffer* VkSbo = static_cast<VulkanStorageBuffer*>(Buffer);
+
+		uint32_t FirstFrame, FrameCount;
+		GetUpdatedFrames(VkRes, true, FirstFrame, FrameCount);
+
+		VkDescriptorBufferInfo BufferInfo{};
+		BufferInfo.buffer = VkSbo->DeviceStorageBuffer;
+		BufferInfo.range = Range;
+
+		VkWriteDescriptorSet BufferWrite{};
+		BufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		BufferWrite.dstBinding = Binding;
+		BufferWrite.dstArrayElement = 0;
+		BufferWrite.descriptorType = GetBufferBindingType(VkRes, Binding, true);
+		BufferWrite.descriptorCount = 1;
+		BufferWrite.pBufferInfo = &BufferInfo;
+		BufferWrite.pImageInfo = nullptr;
+		BufferWrite.pTexelBufferView = nullptr;
+
+		// The offsets given when binding are relative to the slice of the frame
+		for (uint32_t Frame = FirstFrame; Frame < FirstFrame + FrameCount; Frame++)
+		{
+			BufferInfo.offset = GetBufferSliceOffset(VkSbo, VkRes->bTransient ? GVulkanContext.CurrentFrame : Frame);
+			BufferWrite.dstSet = VkRes->DescriptorSets[Frame];
+			vkUpdateDescriptorSets(GVulkanContext.Device, 1, &BufferWrite, 0, nullptr);
+		}
+	}
+
+	void UpdateStorageImageResource(ResourceSet Resources, TextureView Image, uint32_t Binding)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateStorageImageResource, Resources, Binding, Image);
+
+		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+		VulkanTextureView* VkView = static_cast<VulkanTextureView*>(Image);
+
+		uint32_t FirstFrame, FrameCount;
+		GetUpdatedFrames(VkRes, true, FirstFrame, FrameCount);
+
+		VkDescriptorImageInfo ImageInfo{};
+		ImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL; // Matches AttachmentUsage::ShaderReadWrite
+		ImageInfo.imageView = VkView->ImageView;
+		ImageInfo.sampler = nullptr;
+
+		VkWriteDescriptorSet ImageWrite{};
+		ImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		ImageWrite.dstBinding = Binding;
+		ImageWrite.dstArrayElement = 0;
+		ImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		ImageWrite.descriptorCount = 1;
+		ImageWrite.pBufferInfo = nullptr;
+		ImageWrite.pImageInfo = &ImageInfo;
+		ImageWrite.pTexelBufferView = nullptr;
+
+		for (uint32_t Frame = FirstFrame; Frame < FirstFrame + FrameCount; Frame++)
+		{
+			ImageWrite.dstSet = VkRes->DescriptorSets[Frame];
+			vkUpdateDescriptorSets(GVulkanContext.Device, 1, &ImageWrite, 0, nullptr);
+		}
+	}
+
+	void UpdateSamplerResource(ResourceSet Resources, Sampler Samp, uint32_t Binding)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UpdateSamplerResource, Resources, Binding, Samp);
+
+		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+		VulkanSampler* VkSamp = static_cast<VulkanSampler*>(Samp);
+
+		uint32_t FirstFrame, FrameCount;
+		GetUpdatedFrames(VkRes, true, FirstFrame, FrameCount);
+
+		VkDescriptorImageInfo ImageInfo{};
+		ImageInfo.imageView = nullptr;
+		ImageInfo.sampler = VkSamp->Sampler;
+
+		VkWriteDescriptorSet ImageWrite{};
+		ImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		ImageWrite.dstBinding = Binding;
+		ImageWrite.dstArrayElement = 0;
+		ImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+		ImageWrite.descriptorCount = 1;
+		ImageWrite.pBufferInfo = nullptr;
+		ImageWrite.pImageInfo = &ImageInfo;
+		ImageWrite.pTexelBufferView = nullptr;
+
+		for (uint32_t Frame = FirstFrame; Frame < FirstFrame + FrameCount; Frame++)
+		{
+			ImageWrite.dstSet = VkRes->DescriptorSets[Frame];
+			vkUpdateDescriptorSets(GVulkanContext.Device, 1, &ImageWrite, 0, nullptr);
+		}
+	}
+
+	void SynchronizedUploadBufferData(VkFence StagingFence, uint64_t Size, const void* Data,
+	                                  VkCommandBuffer StagingCommandBuffer,
+	                                  VkDeviceMemory StagingMemory, VkBuffer StagingBuffer,
+	                                  VkBuffer DeviceBuffer,
+	                                  VkAccessFlags SrcAccess, VkAccessFlags DstAccess,
+	                                  VkPipelineStageFlags SrcStage, VkPipelineStageFlags DstStage)
+	{
+
+		// Wait for previous staging transfer operation to complete
+		vkWaitForFences(GVulkanContext.Device, 1, &StagingFence, VK_TRUE, UINT64_MAX);
+		vkResetFences(GVulkanContext.Device, 1, &StagingFence);
+
+		// Now we can safely write to host-visible staging buffer memory
+		void* MappedData = nullptr;
+		vkMapMemory(GVulkanContext.Device, StagingMemory, 0, Size, 0, &MappedData);
+		{
+			std::memcpy(MappedData, Data, Size);
+		}
+		vkUnmapMemory(GVulkanContext.Device, StagingMemory);
+
+		VkCommandBufferBeginInfo BeginInfo{};
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.pInheritanceInfo = nullptr;
+		BeginInfo.flags = 0;
+
+		// Staging command buffers are all allocated from the main pool, which is only used by one thread at a time
+		std::lock_guard<std::mutex> PoolLock(GMainCommandPoolMutex);
+
+		vkResetCommandBuffer(StagingCommandBuffer, 0);
+		vkBeginCommandBuffer(StagingCommandBuffer, &BeginInfo);
+		{
+			VkBufferMemoryBarrier PreBarrier{};
+			PreBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			PreBarrier.buffer = DeviceBuffer;
+			PreBarrier.size = Size;
+			PreBarrier.offset = 0;
+			PreBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			PreBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			PreBarrier.srcAccessMask = SrcAccess;
+			PreBarrier.dstAccessMask = DstAccess;
+
+			// After this barrier we're good to write to the device buffer
+			vkCmdPipelineBarrier(StagingCommandBuffer,
+				SrcStage, DstStage,
+				0,
+				0, nullptr,
+				1, &PreBarrier,
+				0, nullptr
+			);
+
+			VkBufferCopy CopyRegion{};
+			CopyRegion.srcOffset = 0;
+			CopyRegion.dstOffset = 0;
+			CopyRegion.size = Size;
+			vkCmdCopyBuffer(StagingCommandBuffer, StagingBuffer, DeviceBuffer, 1, &CopyRegion);
+
+			VkBufferMemoryBarrier PostBarrier{};
+			PostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			PostBarrier.buffer = DeviceBuffer;
+			PostBarrier.size = Size;
+			PostBarrier.offset = 0;
+			PostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			PostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			PostBarrier.srcAccessMask = DstAccess;
+			PostBarrier.dstAccessMask = SrcAccess;
+
+			// After this barrier, the vertex shader is good to read from the device buffer
+			vkCmdPipelineBarrier(StagingCommandBuffer,
+				DstStage, SrcStage,
+				0,
+				0, nullptr,
+				1, &PostBarrier,
+				0, nullptr
+			);
+
+		}
+		vkEndCommandBuffer(StagingCommandBuffer);
+
+		// TODO: Is there a performance benefit to submitting to a separate transfer queue?
+		VkSubmitInfo QueueSubmit{};
+		QueueSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		QueueSubmit.commandBufferCount = 1;
+		QueueSubmit.pCommandBuffers = &StagingCommandBuffer;
+
+		// Pass in a fence. This will prevent us from creating a RAW (read-after-write) hazard in the pipeline.
+		std::lock_guard<std::mutex> QueueLock(GQueueMutex);
+		vkQueueSubmit(GVulkanContext.GraphicsQueue, 1, &QueueSubmit, StagingFence);
+	}
+
+	void UploadVertexBufferData(VertexBuffer Buffer, const void* Data, uint64_t Size)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UploadVertexBufferData, Buffer, CaptureBlob{ Data, Size });
+
+		VulkanVertexBuffer* VulkanVbo = static_cast<VulkanVertexBuffer*>(Buffer);
+
+		SynchronizedUploadBufferData(VulkanVbo->VertexStagingCompleteFence, Size, Data,
+			VulkanVbo->VertexStagingCommandBuffer,
+			VulkanVbo->StagingVertexBufferMemory, VulkanVbo->StagingVertexBuffer,
+			VulkanVbo->DeviceVertexBuffer,
+			VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	}
+
+	void UploadIndexBufferData(IndexBuffer Buffer, const uint32_t* Data, uint64_t Size)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UploadIndexBufferData, Buffer, CaptureBlob{ Data, Size });
+
+		VulkanIndexBuffer* VulkanIbo = static_cast<VulkanIndexBuffer*>(Buffer);
+
+		SynchronizedUploadBufferData(VulkanIbo->IndexStagingCompleteFence, Size, Data,
+			VulkanIbo->IndexStagingCommandBuffer,
+			VulkanIbo->StagingIndexBufferMemory, VulkanIbo->StagingIndexBuffer,
+			VulkanIbo->DeviceIndexBuffer,
+			VK_ACCESS_INDEX_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	}
+
+	void* MapStorageBuffer(StorageBuffer Buffer)
+	{
+		VulkanStorageBuffer* VulkanSbo = static_cast<VulkanStorageBuffer*>(Buffer);
+		LLRM_CAPTURE_CALL(CaptureOp::MapStorageBuffer, Buffer, VulkanSbo->Size);
+
+		if (!VulkanSbo->Mapped)
+		{
+			//GLog->critical("Only storage buffers created with BUFFER_HOST_WRITE can be mapped");
+			return nullptr;
+		}
+
+		return LLRM_CAPTURE_RESULT(VulkanSbo->Mapped + GetBufferSliceOffset(VulkanSbo, GVulkanContext.CurrentFrame));
+	}
+
+	void UploadStorageBufferData(StorageBuffer Buffer, const void* Data, uint64_t Size)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::UploadStorageBufferData, Buffer, CaptureBlob{ Data, Size });
+
+		VulkanStorageBuffer* VulkanSbo = static_cast<VulkanStorageBuffer*>(Buffer);
+
+		// Host written memory is coherent, so a copy is all an upload takes
+		if (VulkanSbo->Mapped)
+		{
+			if (!(VulkanSbo->Flags & BUFFER_PER_FRAME))
+			{
+				// Only one copy of the data exists, so frames still in flight have to finish reading it first
+				WaitFramesInFlight();
+				memcpy(VulkanSbo->Mapped, Data, Size);
+			}
+			else if (GVulkanContext.bInsideFrame)
+				memcpy(VulkanSbo->Mapped + GetBufferSliceOffset(VulkanSbo, GVulkanContext.CurrentFrame), Data, Size);
+			else
+			{
+				for (uint32_t Frame = 0; Frame < GVulkanContext.FramesInFlight; Frame++)
+					memcpy(VulkanSbo->Mapped + GetBufferSliceOffset(VulkanSbo, Frame), Data, Size);
+			}
+
+			return;
+		}
+
+		// Storage buffers can be accessed by any shader stage, and read as indirect arguments
+		SynchronizedUploadBufferData(VulkanSbo->StorageStagingCompleteFence, Size, Data,
+			VulkanSbo->StorageStagingCommandBuffer,
+			VulkanSbo->StagingStorageBufferMemory, VulkanSbo->StagingStorageBuffer,
+			VulkanSbo->DeviceStorageBuffer,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	}
+
+	void ResizeVertexBuffer(VertexBuffer Buffer, uint64_t NewSize)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::ResizeVertexBuffer, Buffer, NewSize);
+
+		// Delete old resources
+		VulkanVertexBuffer* VulkanVbo = static_cast<VulkanVertexBuffer*>(Buffer);
+
+		// Force queue idle
+		WaitQueueIdle();
+
+		vkFreeMemory(GVulkanContext.Device, VulkanVbo->DeviceVertexBufferMemory, nullptr);
+		vkFreeMemory(GVulkanContext.Device, VulkanVbo->StagingVertexBufferMemory, nullptr);
+		vkDestroyBuffer(GVulkanContext.Device, VulkanVbo->DeviceVertexBuffer, nullptr);
+		vkDestroyBuffer(GVulkanContext.Device, VulkanVbo->StagingVertexBuffer, nullptr);
+
+		// Re-allocate buffer resources using the same flags that were used to create it
+		CreateBuffer(NewSize,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+			VulkanVbo->StagingVertexBuffer, VulkanVbo->StagingVertexBufferMemory
+		);
+
+		CreateBuffer(NewSize,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VulkanVbo->DeviceVertexBuffer, VulkanVbo->DeviceVertexBufferMemory
+		);
+	}
+
+	void ResizeIndexBuffer(IndexBuffer Buffer, uint64_t NewSize)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::ResizeIndexBuffer, Buffer, NewSize);
+
+		// Delete old resources
+		VulkanIndexBuffer* VulkanIbo = static_cast<VulkanIndexBuffer*>(Buffer);
+
+		// Force queue idle
+		WaitQueueIdle();
+
+		vkFreeMemory(GVulkanContext.Device, VulkanIbo->DeviceIndexBufferMemory, nullptr);
+		vkFreeMemory(GVulkanContext.Device, VulkanIbo->StagingIndexBufferMemory, nullptr);
+		vkDestroyBuffer(GVulkanContext.Device, VulkanIbo->DeviceIndexBuffer, nullptr);
+		vkDestroyBuffer(GVulkanContext.Device, VulkanIbo->StagingIndexBuffer, nullptr);
+
+		CreateBuffer(NewSize,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+			VulkanIbo->StagingIndexBuffer, VulkanIbo->StagingIndexBufferMemory
+		);
+
+		// Create device index buffer. Because we will be copying the staging buffer to the device buffer, we need to make it eligible for transfer.
+		CreateBuffer(NewSize,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VulkanIbo->DeviceIndexBuffer, VulkanIbo->DeviceIndexBufferMemory
+		);
+	}
+
+	void WriteTexture(Texture Tex,
+		AttachmentUsage PreviousUsage, AttachmentUsage FinalUsage,
+		uint32_t Width, uint32_t Height,
+		uint32_t Layer,
+		uint64_t ImageSize, void* Data,
+		uint32_t MipLevel,
+		uint32_t RowPitch
+	)
+	{
+		VulkanTexture* Result = reinterpret_cast<VulkanTexture*>(Tex);
+
+		uint32_t BlockWidth, BlockHeight;
+		GetFormatBlockExtent(Result->TextureFormat, BlockWidth, BlockHeight);
+
+		if (ImageSize == 0)
+		{
+			uint64_t PackedSize = CalcTextureSizeBytes(Result->TextureFormat, Width, Height);
+			uint64_t RowCount = (Height + BlockHeight - 1) / BlockHeight;
+			ImageSize = RowPitch > 0 ? RowPitch * RowCount : PackedSize;
+		}
+
+		LLRM_CAPTURE_CALL(CaptureOp::WriteTexture, Tex, Layer, MipLevel, PreviousUsage, FinalUsage, Width, Height, RowPitch, CaptureBlob{ Data, ImageSize });
+
+		// Vulkan describes the row pitch in texels, which has to be a whole number of blocks
+		uint32_t RowLength = 0;
+		if (RowPitch > 0)
+		{
+			if (RowPitch % GetFormatBlockSizeBytes(Result->TextureFormat) != 0 || RowPitch < CalcRowPitchBytes(Result->TextureFormat, Width))
+			{
+				//GLog->critical("Texture row pitch must be a whole number of blocks and at least as long as a row of the image");
+				return;
+			}
+
+			RowLength = RowPitch / GetFormatBlockSizeBytes(Result->TextureFormat) * BlockWidth;
+		}
+
+		// The staging buffer is sized by the first write, which may have been a smaller mip level
+		if(Result->StagingBuffer && Result->StagingBufferSize < ImageSize)
+		{
+			vkFreeMemory(GVulkanContext.Device, Result->StagingBufferMemory, nullptr);
+			vkDestroyBuffer(GVulkanContext.Device, Result->StagingBuffer, nullptr);
+			Result->StagingBuffer = VK_NULL_HANDLE;
+			Result->StagingBufferMemory = VK_NULL_HANDLE;
+		}
+
+		if(!Result->StagingBuffer)
+		{
+			Result->StagingBufferSize = ImageSize;
+			CreateBuffer
+			(
+				ImageSize,
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				Result->StagingBuffer, Result->StagingBufferMemory
+			);
+		}
+
+		void* MappedData;
+		vkMapMemory(GVulkanContext.Device, Result->StagingBufferMemory, 0, ImageSize, 0, &MappedData);
+		{
+			std::memcpy(MappedData, Data, ImageSize);
+		}
+		vkUnmapMemory(GVulkanContext.Device, Result->StagingBufferMemory);
+
+		ImmediateSubmit([&](CommandBuffer Buf)
+		{
+			TransitionTexture(Buf, Result, PreviousUsage, AttachmentUsage::TransferDestination, Layer, 1, MipLevel, 1);
+		});
+
+		ImmediateSubmit([&](CommandBuffer Buf)
+		{
+			VkCmdBuffer(Buf, [&](VkCommandBuffer Buf)
+			{
+				VkBufferImageCopy ImageCopy{};
+				ImageCopy.bufferOffset = 0;
+				ImageCopy.bufferRowLength = RowLength;
+				ImageCopy.bufferImageHeight = 0;
+
+				ImageCopy.imageSubresource.aspectMask = IsColorFormat(Result->TextureFormat) ? VK_IMAGE_ASPECT_COLOR_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+				ImageCopy.imageSubresource.mipLevel = MipLevel;
+				ImageCopy.imageSubresource.baseArrayLayer = Layer;
+				ImageCopy.imageSubresource.layerCount = 1;
+
+				ImageCopy.imageOffset = { 0, 0, 0 };
+				ImageCopy.imageExtent = { Width, Height, 1 };
+
+				// Copy buffer data to image
+				vkCmdCopyBufferToImage
+				(
+					Buf,
+					Result->StagingBuffer,
+					Result->TextureImage,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					1,
+					&ImageCopy
+				);
+			});
+		});
+
+		// Transition image to be shader read optimal
+		ImmediateSubmit([&](CommandBuffer Buf)
+		{
+			TransitionTexture(Buf, Result, AttachmentUsage::TransferDestination, FinalUsage, Layer, 1, MipLevel, 1);
+		});
+	}
+
+	void ReadTexture(Texture Tex, void* Dst, uint64_t BufferSize, AttachmentUsage PreviousUsage)
+	{
+		WaitDeviceIdle();
+
+		VulkanTexture* VkTex = static_cast<VulkanTexture*>(Tex); 
+
+		VkBuffer StagingBuffer;
+		VkDeviceMemory StagingBufferMemory;
+		CreateBuffer
+		(
+			BufferSize,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			StagingBuffer, StagingBufferMemory
+		);
+
+		// Transition image to transfer src from its previous usage
+		ImmediateSubmitAndWait([&](CommandBuffer Dst)
+		{
+			TransitionTexture(Dst, Tex, PreviousUsage, AttachmentUsage::TransferSource);
+		});
+
+		ImmediateSubmitAndWait([&](CommandBuffer Dst)
+		{
+			VkCmdBuffer(Dst, [&](VkCommandBuffer Buf)
+			{
+				VkBufferImageCopy ImageCopy{};
+				ImageCopy.bufferOffset = 0;
+				ImageCopy.bufferRowLength = 0;
+				ImageCopy.bufferImageHeight = 0;
+
+				ImageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				ImageCopy.imageSubresource.mipLevel = 0;
+				ImageCopy.imageSubresource.baseArrayLayer = 0;
+				ImageCopy.imageSubresource.layerCount = 1;
+
+				ImageCopy.imageOffset = { 0, 0, 0 };
+				ImageCopy.imageExtent = { VkTex->Width, VkTex->Height, 1 };
+
+				// Copy image data to buffer
+				vkCmdCopyImageToBuffer(Buf,
+					VkTex->TextureImage,
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					StagingBuffer,
+					1,
+					&ImageCopy
+				);
+			});
+		});
+
+		void* MappedData;
+		vkMapMemory(GVulkanContext.Device, StagingBufferMemory, 0, BufferSize, 0, &MappedData);
+		{
+			std::memcpy(Dst, MappedData, BufferSize);
+		}
+		vkUnmapMemory(GVulkanContext.Device, StagingBufferMemory);
+
+		// Transition image back
+		ImmediateSubmitAndWait([&](CommandBuffer Dst)
+		{
+			TransitionTexture(Dst, Tex, AttachmentUsage::TransferSource, PreviousUsage);
+		});
+
+		// TODO: optimize this, we should have a staging buffer set aside already and a flag TEXTURE_USAGE_CPU_READ
+		vkFreeMemory(GVulkanContext.Device, StagingBufferMemory, nullptr);
+		vkDestroyBuffer(GVulkanContext.Device, StagingBuffer, nullptr);
+	}
+
+	AttachmentFormat GetTextureFormat(Texture Tex)
+	{
+		VulkanTexture* VkTex = static_cast<VulkanTexture*>(Tex);
+		return VkTex->TextureFormat;
+	}
+
+	uint32_t GetTextureMipLevels(Texture Tex)
+	{
+		VulkanTexture* VkTex = static_cast<VulkanTexture*>(Tex);
+		return VkTex->MipLevels;
+	}
+
+	VkShaderStageFlags ShaderStageToVkStage(ShaderStage Stage)
+	{
+		switch (Stage)
+		{
+		case ShaderStage::Vertex:
+			return VK_SHADER_STAGE_VERTEX_BIT;
+		case ShaderStage::Fragment:
+			return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case ShaderStage::Compute:
+			return VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		return VK_SHADER_STAGE_VERTEX_BIT;
+	}
+
+	void DestroyVkResourceLayout(VulkanResourceLayout* VkLayout)
+	{
+		vkDestroyDescriptorSetLayout(GVulkanContext.Device, VkLayout->VkLayout, nullptr);
+
+		REMOVE_RESOURCE_ALLOC(VkLayout)
+
+		delete VkLayout;
+	}
+
+	ResourceLayout CreateResourceLayout(const ResourceLayoutCreateInfo& CreateInfo)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateResourceLayout, CreateInfo);
+
+		CacheKey Key;
+		Key << CreateInfo.ConstantBuffers.size();
+		for (const ConstantBufferDescription& Desc : CreateInfo.ConstantBuffers)
+			Key << Desc.Binding << Desc.StageUsedAt << Desc.BufferSize << Desc.Count;
+		for (const std::vector<TextureSamplerDescription>* Descs : { &CreateInfo.Textures, &CreateInfo.Samplers, &CreateInfo.InputAttachments })
+		{
+			Key << Descs->size();
+			for (const TextureSamplerDescription& Desc : *Descs)
+				Key << Desc.Binding << Desc.StageUsedAt << Desc.Count;
+		}
+		for (const std::vector<StorageDescription>* Descs : { &CreateInfo.StorageBuffers, &CreateInfo.StorageImages,
+			&CreateInfo.UniformTexelBuffers, &CreateInfo.StorageTexelBuffers, &CreateInfo.DynamicUniformBuffers, &CreateInfo.DynamicStorageBuffers })
+		{
+			Key << Descs->size();
+			for (const StorageDescription& Desc : *Descs)
+				Key << Desc.Binding << Desc.StageUsedAt << Desc.Count;
+		}
+
+		if (VulkanResourceLayout* Cached = GResourceLayoutCache.Acquire(Key.Bytes))
+			return LLRM_CAPTURE_RESULT(Cached);
+
+		VulkanResourceLayout* Result = new VulkanResourceLayout;
+		Result->Id = GNextObjectId++;
+
+		std::vector<VkDescriptorSetLayoutBinding> LayoutBindings;
+		for (uint32_t LayoutBindingIndex = 0; LayoutBindingIndex < CreateInfo.ConstantBuffers.size(); LayoutBindingIndex++)
+		{
+			VkDescriptorSetLayoutBinding LayoutBinding{};
+			LayoutBinding.binding = CreateInfo.ConstantBuffers[LayoutBindingIndex].Binding;
+			LayoutBinding.descriptorCount = CreateInfo.ConstantBuffers[LayoutBindingIndex].Count;
+			LayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			LayoutBinding.pImmutableSamplers = nullptr;
+			LayoutBinding.stageFlags = ShaderStageToVkStage(CreateInfo.ConstantBuffers[LayoutBindingIndex].StageUsedAt);
+
+			LayoutBindings.push_back(LayoutBinding);
+
+			// Persist constant buffers
+			Result->ConstantBuffers.push_back(CreateInfo.ConstantBuffers[LayoutBindingIndex]);
+		}
+
+		for (uint32_t TexBindingIndex = 0; TexBindingIndex < CreateInfo.Textures.size(); TexBindingIndex++)
+		{
+			VkDescriptorSetLayoutBinding LayoutBinding{};
+			LayoutBinding.binding = CreateInfo.Textures[TexBindingIndex].Binding;
+			LayoutBinding.descriptorCount = CreateInfo.Textures[TexBindingIndex].Count;
+			LayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			LayoutBinding.pImmutableSamplers = nullptr;
+			LayoutBinding.stageFlags = ShaderStageToVkStage(CreateInfo.Textures[TexBindingIndex].StageUsedAt);
+
+			LayoutBindings.push_back(LayoutBinding);
+
+			// Persist constant buffers
+			Result->TextureBindings.push_back(CreateInfo.Textures[TexBindingIndex]);
+		}
+
+		for (uint32_t SampBindingIndex = 0; SampBindingIndex < CreateInfo.Samplers.size(); SampBindingIndex++)
+		{
+			VkDescriptorSetLayoutBinding LayoutBinding{};
+			LayoutBinding.binding = CreateInfo.Samplers[SampBindingIndex].Binding;
+			LayoutBinding.descriptorCount = CreateInfo.Samplers[SampBindingIndex].Count;
+			LayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+			LayoutBinding.pImmutableSamplers = nullptr;
+			LayoutBinding.stageFlags = ShaderStageToVkStage(CreateInfo.Samplers[SampBindingIndex].StageUsedAt);
+
+			LayoutBindings.push_back(LayoutBinding);
+
+			Result->SamplerBindings.push_back(CreateInfo.Samplers[SampBindingIndex]);
+		}
+
+		for (uint32_t InputBindingIndex = 0; InputBindingIndex < CreateInfo.InputAttachments.size(); InputBindingIndex++)
+		{
+			VkDescriptorSetLayoutBinding LayoutBinding{};
+			LayoutBinding.binding = CreateInfo.InputAttachments[InputBindingIndex].Binding;
+			LayoutBinding.descriptorCount = CreateInfo.InputAttachments[InputBindingIndex].Count;
+			LayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			LayoutBinding.pImmutableSamplers = nullptr;
+			LayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT; // Input attachments can only be read from fragment shaders
+
+			LayoutBindings.push_back(LayoutBinding);
+
+			Result->InputAttachmentBindings.push_back(CreateInfo.InputAttachments[InputBindingIndex]);
+		}
+
+		for (uint32_t StorageBindingIndex = 0; StorageBindingIndex < CreateInfo.StorageBuffers.size(); StorageBindingIndex++)
+		{
+			VkDescriptorSetLayoutBinding LayoutBinding{};
+			LayoutBinding.binding = CreateInfo.StorageBuffers[StorageBindingIndex].Binding;
+			LayoutBinding.descriptorCount = CreateInfo.StorageBuffers[StorageBindingIndex].Count;
+			LayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			LayoutBinding.pImmutableSamplers = nullptr;
+			LayoutBinding.stageFlags = ShaderStageToVkStage(CreateInfo.StorageBuffers[StorageBindingIndex].StageUsedAt);
+
+			LayoutBindings.push_back(LayoutBinding);
+
+			Result->StorageBufferBindings.push_back(CreateInfo.StorageBuffers[StorageBindingIndex]);
+		}
+
+		for (uint32_t StorageBindingIndex = 0; StorageBindingIndex < CreateInfo.StorageImages.size(); StorageBindingIndex++)
+		{
+			VkDescriptorSetLayoutBinding LayoutBinding{};
+			LayoutBinding.binding = CreateInfo.StorageImages[StorageBindingIndex].Binding;
+			LayoutBinding.descriptorCount = CreateInfo.StorageImages[StorageBindingIndex].Count;
+			LayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			LayoutBinding.pImmutableSamplers = nullptr;
+			LayoutBinding.stageFlags = ShaderStageToVkStage(CreateInfo.StorageImages[StorageBindingIndex].StageUsedAt);
+
+			LayoutBindings.push_back(LayoutBinding);
+
+			Result->StorageImageBindings.push_back(CreateInfo.StorageImages[StorageBindingIndex]);
+		}
+
+		const std::pair<const std::vector<StorageDescription>*, VkDescriptorType> BufferBindings[] = {
+			{ &CreateInfo.UniformTexelBuffers, VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER },
+			{ &CreateInfo.StorageTexelBuffers, VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER },
+			{ &CreateInfo.DynamicUniformBuffers, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC },
+			{ &CreateInfo.DynamicStorageBuffers, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC }
+		};
+		for (const auto& [Descs, DescriptorType] : BufferBindings)
+		{
+			for (const StorageDescription& Desc : *Descs)
+			{
+				VkDescriptorSetLayoutBinding LayoutBinding{};
+				LayoutBinding.binding = Desc.Binding;
+				LayoutBinding.descriptorCount = Desc.Count;
+				LayoutBinding.descriptorType = DescriptorType;
+				LayoutBinding.pImmutableSamplers = nullptr;
+				LayoutBinding.stageFlags = ShaderStageToVkStage(Desc.StageUsedAt);
+
+				LayoutBindings.push_back(LayoutBinding);
+			}
+		}
+
+		Result->UniformTexelBufferBindings = CreateInfo.UniformTexelBuffers;
+		Result->StorageTexelBufferBindings = CreateInfo.StorageTexelBuffers;
+		Result->DynamicUniformBufferBindings = CreateInfo.DynamicUniformBuffers;
+		Result->DynamicStorageBufferBindings = CreateInfo.DynamicStorageBuffers;
+
+		// Total the descriptors of each type so pools can be sized for binding arrays
+		for (const VkDescriptorSetLayoutBinding& LayoutBinding : LayoutBindings)
+		{
+			auto Existing = std::find_if(Result->PoolSizes.begin(), Result->PoolSizes.end(), [&](const VkDescriptorPoolSize& Size)
+			{
+				return Size.type == LayoutBinding.descriptorType;
+			});
+
+			if (Existing != Result->PoolSizes.end())
+				Existing->descriptorCount += LayoutBinding.descriptorCount;
+			else
+				Result->PoolSizes.push_back({ LayoutBinding.descriptorType, LayoutBinding.descriptorCount });
+		}
+
+		VkDescriptorSetLayoutCreateInfo LayoutCreateInfo{};
+		LayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		LayoutCreateInfo.bindingCount = static_cast<uint32_t>(LayoutBindings.size());
+		LayoutCreateInfo.pBindings = LayoutBindings.data();
+
+		if (vkCreateDescriptorSetLayout(GVulkanContext.Device, &LayoutCreateInfo, nullptr, &Result->VkLayout) != VK_SUCCESS)
+		{
+			//GLog->critical("Failed to create Vulkan descriptor set layout");
+			delete Result;
+			return nullptr;
+		}
+
+		RECORD_RESOURCE_ALLOC(Result)
+
+		return LLRM_CAPTURE_RESULT(GResourceLayoutCache.Insert(Key.Bytes, Result, &DestroyVkResourceLayout));
+	}
+
+	void DestroyResourceLayout(ResourceLayout Layout)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyResourceLayout, Layout);
+
+		VulkanResourceLayout* VkLayout = static_cast<VulkanResourceLayout*>(Layout);
+
+		if (GResourceLayoutCache.Release(VkLayout))
+			DestroyVkResourceLayout(VkLayout);
+	}
+
+	// Frees the uniform buffers of a persistent resource set along with the set itself
+	void DestroyVkResourceSet(VulkanResourceSet* VkRes)
+	{
+		for (const auto& ConstBuf : VkRes->ConstantBuffers)
+		{
+			for (const auto& Memory : ConstBuf.Memory)
+				vkFreeMemory(GVulkanContext.Device, Memory, nullptr);
+
+			for (const auto& Buf : ConstBuf.Buffers)
+				vkDestroyBuffer(GVulkanContext.Device, Buf, nullptr);
+
+		}
+
+		delete VkRes;
+	}
+
+	void DestroyResourceSet(ResourceSet Resources)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyResourceSet, Resources);
+
+		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
+
+		// Transient resource sets are released when their frame is reset
+		if (VkRes->bTransient)
+			return;
+
+		WaitDeviceIdle();
+
+		{
+			std::lock_guard<std::mutex> PoolLock(VkRes->Pools->Lock);
+			vkFreeDescriptorSets(GVulkanContext.Device, VkRes->DscPool, static_cast<uint32_t>(VkRes->DescriptorSets.size()), VkRes->DescriptorSets.data());
+		}
+
+		REMOVE_RESOURCE_ALLOC(VkRes)
+
+		DestroyVkResourceSet(VkRes);
+	}
+
+	void CreatePipelineShaderStage(VkShaderStageFlagBits Stage, VkShaderModule Module, VkPipelineShaderStageCreateInfo& OutCreateInfo)
+	{
+		// Setup pipeline stage create info
+		VkPipelineShaderStageCreateInfo NewInfo{};
+		NewInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		NewInfo.stage = Stage;
+		NewInfo.module = Module;
+		NewInfo.pName = "main";
+
+		OutCreateInfo = NewInfo;
+	}
+
+	VkFormat EngineFormatToVkFormat(VertexAttributeFormat Format)
+	{
+		switch (Format)
+		{
+		case VertexAttributeFormat::Float:
+			return VK_FORMAT_R32_SFLOAT;
+		case VertexAttributeFormat::Float2:
+			return VK_FORMAT_R32G32_SFLOAT;
+		case VertexAttributeFormat::Float3:
+			return VK_FORMAT_R32G32B32_SFLOAT;
+		case VertexAttributeFormat::Float4:
+			return VK_FORMAT_R32G32B32A32_SFLOAT;
+		case VertexAttributeFormat::Int32:
+			return VK_FORMAT_R32_SINT;
+		case VertexAttributeFormat::Half2:
+			return VK_FORMAT_R16G16_SFLOAT;
+		case VertexAttributeFormat::Half4:
+			return VK_FORMAT_R16G16B16A16_SFLOAT;
+		case VertexAttributeFormat::Byte2Norm:
+			return VK_FORMAT_R8G8_SNORM;
+		case VertexAttributeFormat::Byte4Norm:
+			return VK_FORMAT_R8G8B8A8_SNORM;
+		case VertexAttributeFormat::UByte2Norm:
+			return VK_FORMAT_R8G8_UNORM;
+		case VertexAttributeFormat::UByte4Norm:
+			return VK_FORMAT_R8G8B8A8_UNORM;
+		case VertexAttributeFormat::Short2Norm:
+			return VK_FORMAT_R16G16_SNORM;
+		case VertexAttributeFormat::Short4Norm:
+			return VK_FORMAT_R16G16B16A16_SNORM;
+		case VertexAttributeFormat::UShort2Norm:
+			return VK_FORMAT_R16G16_UNORM;
+		case VertexAttributeFormat::UShort4Norm:
+			return VK_FORMAT_R16G16B16A16_UNORM;
+		case VertexAttributeFormat::UInt10_10_10_2Norm:
+			return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+		case VertexAttributeFormat::Int10_10_10_2Norm:
+			return VK_FORMAT_A2B10G10R10_SNORM_PACK32;
+		}
+
+		return VK_FORMAT_R32_SFLOAT;
+	}
+
+	VkPrimitiveTopology EngineTopToVkTop(PipelineRenderPrimitive Primitive)
+	{
+		switch (Primitive)
+		{
+		case PipelineRenderPrimitive::TRIANGLES:
+			return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		case PipelineRenderPrimitive::LINES:
+			return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+		}
+
+		return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	}
+
+	void DestroyVkPipeline(VulkanPipeline* VkPipeline)
+	{
+		WaitQueueIdle();
+
+		// Destroy pipeline layout
+		vkDestroyPipelineLayout(GVulkanContext.Device, VkPipeline->PipelineLayout, nullptr);
+
+		// Destroy pipeline
+		vkDestroyPipeline(GVulkanContext.Device, VkPipeline->Pipeline, nullptr);
+
+		REMOVE_RESOURCE_ALLOC(VkPipeline)
+
+		delete VkPipeline;
+	}
+
+	// Programs, render graphs and layouts are keyed by id rather than address, since the address of a destroyed object can be reused
+	void AppendPipelineLayoutsKey(CacheKey& Key, const std::vector<ResourceLayout>& Layouts)
+	{
+		Key << Layouts.size();
+		for (ResourceLayout Layout : Layouts)
+			Key << static_cast<VulkanResourceLayout*>(Layout)->Id;
+	}
+
+	Pipeline CreatePipeline(const PipelineState& CreateInfo)
+	{
+		LLRM_TRACE_FUNCTION();
+		LLRM_CAPTURE_CALL(CaptureOp::CreatePipeline, CreateInfo);
+
+		VulkanShader* VkShader = static_cast<VulkanShader*>(CreateInfo.Shader);
+		VulkanRenderGraph* VkRenderGraph = static_cast<VulkanRenderGraph*>(CreateInfo.CompatibleGraph);
+		if (!VkRenderGraph && !GVulkanContext.bDynamicRendering)
+		{
+			//GLog->critical("Must specify a valid Vulkan RenderGraph when creating a pipeline without dynamic rendering");
+			return nullptr;
+		}
+
+		if (!VkRenderGraph && CreateInfo.AttachmentFormats.empty())
+		{
+			//GLog->critical("Must specify either a compatible RenderGraph or the attachment formats of a dynamic rendering pipeline");
+			return nullptr;
+		}
+
+		CacheKey Key;
+		Key << VK_PIPELINE_BIND_POINT_GRAPHICS << VkShader->Id << (VkRenderGraph ? VkRenderGraph->Id : 0) << CreateInfo.PassIndex;
+		AppendPipelineLayoutsKey(Key, CreateInfo.Layouts);
+		Key << CreateInfo.VertexBufferStride << CreateInfo.VertexAttributes.size();
+		for (const std::pair<VertexAttributeFormat, uint32_t>& Attribute : CreateInfo.VertexAttributes)
+			Key << Attribute.first << Attribute.second;
+		Key << CreateInfo.Primitive << CreateInfo.BlendSettings.size();
+		for (const PipelineBlendSettings& Settings : CreateInfo.BlendSettings)
+		{
+			Key << Settings.bBlendingEnabled << Settings.SrcColorFactor << Settings.DstColorFactor << Settings.SrcAlphaFactor << Settings.DstAlphaFactor
+				<< Settings.ColorOp << Settings.AlphaOp << Settings.WriteMask;
+		}
+		Key << CreateInfo.DepthStencil.bEnableDepthTest << CreateInfo.DepthStencil.bEnableDepthWrite << CreateInfo.DepthStencil.DepthCompare << CreateInfo.Winding << CreateInfo.Cull;
+		if (!VkRenderGraph)
+		{
+			Key << CreateInfo.AttachmentFormats.size();
+			for (AttachmentFormat Format : CreateInfo.AttachmentFormats)
+				Key << Format;
+		}
+
+		if (VulkanPipeline* Cached = GPipelineCache.Acquire(Key.Bytes))
+			return LLRM_CAPTURE_RESULT(Cached);
+
+		if (VkShader->bModulesReleased)
+		{
+			//GLog->critical("Can't create a pipeline from a program whose shader modules were released");
+			return nullptr;
+		}
+
+		for (const std::pair<VertexAttributeFormat, uint32_t>& Attribute : CreateInfo.VertexAttributes)
+		{
+			if (Attribute.first == VertexAttributeFormat::Int10_10_10_2Norm && !GetCaps().bPackedSNormVertexFormat)
+			{
+				//GLog->critical("The device can't read Int10_10_10_2Norm vertex attributes");
+				return nullptr;
+			}
+		}
+
+		VulkanPipeline* Result = new VulkanPipeline;
+
+		std::vector<VkPipelineShaderStageCreateInfo> ShaderCreateInfos;
+		std::vector<VkVertexInputAttributeDescription> VertexAttributes;
+		std::vector<VkVertexInputBindingDescription> VertexBindings;
+
+		if (VkShader->bHasVertexShader)
+		{
+			VkPipelineShaderStageCreateInfo VertInfo{};
+			CreatePipelineShaderStage(VK_SHADER_STAGE_VERTEX_BIT, VkShader->VertexModule->Module, VertInfo);
+			ShaderCreateInfos.push_back(VertInfo);
+		}
+
+		if (VkShader->bHasFragmentShader)
+		{
+			VkPipelineShaderStageCreateInfo FragInfo{};
+			CreatePipelineShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, VkShader->FragmentModule->Module, FragInfo);
+			ShaderCreateInfos.push_back(FragInfo);
+		}
+
+		// Only use a single vertex binding for now
+		VkVertexInputBindingDescription BindingDescription{};
+		BindingDescription.binding = 0;
+		BindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX; // Would probably need to change this for instanced rendering
+		BindingDescription.stride = CreateInfo.VertexBufferStride;
+		VertexBindings.push_back(BindingDescription);
+
+		uint32_t AttribIndex = 0;
+		for(auto& Attrib : CreateInfo.VertexAttributes)
+		{
+			VkVertexInputAttributeDescription AttributeDescription{};
+			AttributeDescription.format = EngineFormatToVkFormat(Attrib.first);
+			AttributeDescription.binding = 0; // Always use one binding for vertex buffers
+			AttributeDescription.location = AttribIndex++;
+			AttributeDescription.offset = Attrib.second;
+
+			VertexAttributes.push_back(AttributeDescription);
+		}
+
+		// Create VkPipelineVertexInputStageCreateInfo
+		VkPipelineVertexInputStateCreateInfo VertexStateCreateInfo{};
+		VertexStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		VertexStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(VertexAttributes.size());
+		VertexStateCreateInfo.pVertexAttributeDescriptions = VertexAttributes.data();
+		VertexStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(VertexBindings.size());
+		VertexStateCreateInfo.pVertexBindingDescriptions = VertexBindings.data();
+
+		// Create input assembly
+		VkPipelineInputAssemblyStateCreateInfo InputAssembly{};
+		InputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		InputAssembly.topology = EngineTopToVkTop(CreateInfo.Primitive);
+		InputAssembly.primitiveRestartEnable = VK_FALSE; // Used for strip topologies
+
+		// VkViewport and VkScissor will always be dynamic to prevent needing to re-create the pipeline on swap chain re-creation
+		VkViewport Viewport{};
+		Viewport.x = 0.0f;
+		Viewport.y = 0.0f;
+		Viewport.width = 1.0f;
+		Viewport.height = 1.0f;
+		Viewport.minDepth = 0.0f;
+		Viewport.maxDepth = 1.0f;
+
+		VkRect2D Scissor{};
+		Scissor.offset = { 0, 0 };
+		Scissor.extent = { 1, 1 };
+
+		VkPipelineViewportStateCreateInfo ViewportStateCreateInfo{};
+		ViewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		ViewportStateCreateInfo.viewportCount = 1;
+		ViewportStateCreateInfo.pViewports = &Viewport;
+		ViewportStateCreateInfo.scissorCount = 1;
+		ViewportStateCreateInfo.pScissors = &Scissor;
+
+		VkPipelineRasterizationStateCreateInfo Rasterizer{};
+		Rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		Rasterizer.depthClampEnable = VK_FALSE;
+		Rasterizer.rasterizerDiscardEnable = VK_FALSE;
+		Rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		Rasterizer.lineWidth = 1.0f;
+		Rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+		if(CreateInfo.Cull == CullMode::Front)
+			Rasterizer.cullMode = VK_CULL_MODE_FRONT_BIT;
+		else if (CreateInfo.Cull == CullMode::None)
+			Rasterizer.cullMode = VK_CULL_MODE_NONE;
+
+		Rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE; // Reverse this from the usual CLOCKWISE because we flip the viewport
+		if(CreateInfo.Winding == VertexWinding::Clockwise)
+			Rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE; // Reverse this from the usual CLOCKWISE because we flip the viewport
+		Rasterizer.depthBiasEnable = VK_FALSE;
+		Rasterizer.depthBiasConstantFactor = 0.0f;
+		Rasterizer.depthBiasClamp = 0.0f;
+		Rasterizer.depthBiasSlopeFactor = 0.0f;
+
+		VkPipelineDepthStencilStateCreateInfo DepthStencilCreateInfo{};
+		DepthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		DepthStencilCreateInfo.depthTestEnable = VK_FALSE;
+		DepthStencilCreateInfo.depthWriteEnable = VK_FALSE;
+		DepthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+		DepthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
+		DepthStencilCreateInfo.minDepthBounds = 0.0f; // Optional
+		DepthStencilCreateInfo.maxDepthBounds = 1.0f; // Optional
+		DepthStencilCreateInfo.stencilTestEnable = VK_FALSE;
+		DepthStencilCreateInfo.front = {}; // Optional
+		DepthStencilCreateInfo.back = {}; // Optional
+		if (CreateInfo.DepthStencil.bEnableDepthTest)
+		{
+			DepthStencilCreateInfo.depthTestEnable = VK_TRUE;
+			DepthStencilCreateInfo.depthWriteEnable = CreateInfo.DepthStencil.bEnableDepthWrite ? VK_TRUE : VK_FALSE;
+			DepthStencilCreateInfo.depthCompareOp = CompareOpToVkCompareOp(CreateInfo.DepthStencil.DepthCompare);
+		}
+
+		VkPipelineMultisampleStateCreateInfo Multisampling{};
+		Multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		Multisampling.sampleShadingEnable = VK_FALSE;
+		Multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		Multisampling.minSampleShading = 1.0f; // Optional
+		Multisampling.pSampleMask = nullptr; // Optional
+		Multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
+		Multisampling.alphaToOneEnable = VK_FALSE; // Optional
+		Multisampling.pSampleMask = nullptr;
+
+		std::vector<VkPipelineColorBlendAttachmentState> ColorBlendAttachments;
+		for(const PipelineBlendSettings& Settings : CreateInfo.BlendSettings)
+		{
+			VkPipelineColorBlendAttachmentState ColorBlendAttachment{};
+			ColorBlendAttachment.colorWriteMask = 0;
+			if (Settings.WriteMask & COLOR_WRITE_R) ColorBlendAttachment.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
+			if (Settings.WriteMask & COLOR_WRITE_G) ColorBlendAttachment.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT;
+			if (Settings.WriteMask & COLOR_WRITE_B) ColorBlendAttachment.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT;
+			if (Settings.WriteMask & COLOR_WRITE_A) ColorBlendAttachment.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT;
+			ColorBlendAttachment.blendEnable = Settings.bBlendingEnabled ? VK_TRUE : VK_FALSE;
+			ColorBlendAttachment.srcColorBlendFactor = BlendFactorToVkFactor(Settings.SrcColorFactor);
+			ColorBlendAttachment.dstColorBlendFactor = BlendFactorToVkFactor(Settings.DstColorFactor);
+			ColorBlendAttachment.colorBlendOp = BlendOpToVkBlend(Settings.ColorOp);
+			ColorBlendAttachment.srcAlphaBlendFactor = BlendFactorToVkFactor(Settings.SrcAlphaFactor);
+			ColorBlendAttachment.dstAlphaBlendFactor = BlendFactorToVkFactor(Settings.DstAlphaFactor);
+			ColorBlendAttachment.alphaBlendOp = BlendOpToVkBlend(Settings.AlphaOp);
+
+			ColorBlendAttachments.push_back(ColorBlendAttachment);
+		}
+
+		VkPipelineColorBlendStateCreateInfo ColorBlending{};
+		ColorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		ColorBlending.logicOpEnable = VK_FALSE;
+		ColorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
+		ColorBlending.attachmentCount = static_cast<uint32_t>(ColorBlendAttachments.size());
+		ColorBlending.pAttachments = ColorBlendAttachments.data();
+		ColorBlending.blendConstants[0] = 0.0f; // Optional
+		ColorBlending.blendConstants[1] = 0.0f; // Optional
+		ColorBlending.blendConstants[2] = 0.0f; // Optional
+		ColorBlending.blendConstants[3] = 0.0f; // Optional
+
+		VkDynamicState DynamicStates[] = {
+			VK_DYNAMIC_STATE_VIEWPORT,
+			VK_DYNAMIC_STATE_SCISSOR
+		};
+
+		VkPipelineDynamicStateCreateInfo DynamicState{};
+		DynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		DynamicState.dynamicStateCount = 2;
+		DynamicState.pDynamicStates = DynamicStates;
+
+		// Create pipeline layout
+		std::vector<VkDescriptorSetLayout> VkLayouts;
+		for (const ResourceLayout& Layout : CreateInfo.Layouts)
+			VkLayouts.push_back(static_cast<VulkanResourceLayout*>(Layout)->VkLayout);
+
+		VkPipelineLayoutCreateInfo PipelineLayoutInfo{};
+		PipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		PipelineLayoutInfo.setLayoutCount = VkLayouts.size();
+		PipelineLayoutInfo.pSetLayouts = VkLayouts.data();
+		PipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
+		PipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+
+		if (vkCreatePipelineLayout(GVulkanContext.Device, &PipelineLayoutInfo, nullptr, &Result->PipelineLayout) != VK_SUCCESS)
 		{
-			std::memcpy(MappedData, Data, ImageSize);
-		}
-		vkUnmapMemory(GVulkanContext.Device, Result->StagingBufferMemory);
+			//GLog->critical("Failed to create pipeline layout");
 
-		ImmediateSubmit([&](CommandBuffer Buf)
-		{
-			TransitionTexture(Buf, Result, PreviousUsage, AttachmentUsage::TransferDestination);
-		});
+			delete Result;
+			return nullptr;
+		}
 
-		ImmediateSubmit([&](CommandBuffer Buf)
+		// Create the pipeline object
+		VkGraphicsPipelineCreateInfo PipelineCreateInfo{};
+		PipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		PipelineCreateInfo.stageCount = static_cast<uint32_t>(ShaderCreateInfos.size());
+		PipelineCreateInfo.pStages = ShaderCreateInfos.data();
+		PipelineCreateInfo.pVertexInputState = &VertexStateCreateInfo;
+		PipelineCreateInfo.pInputAssemblyState = &InputAssembly;
+		PipelineCreateInfo.pViewportState = &ViewportStateCreateInfo;
+		PipelineCreateInfo.pRasterizationState = &Rasterizer;
+		PipelineCreateInfo.pMultisampleState = &Multisampling;
+		PipelineCreateInfo.pDepthStencilState = &DepthStencilCreateInfo;
+		PipelineCreateInfo.pColorBlendState = &ColorBlending;
+		PipelineCreateInfo.pDynamicState = &DynamicState;
+		PipelineCreateInfo.layout = Result->PipelineLayout;
+		PipelineCreateInfo.renderPass = VkRenderGraph ? VkRenderGraph->RenderPass : VK_NULL_HANDLE;
+		PipelineCreateInfo.subpass = VkRenderGraph ? CreateInfo.PassIndex : 0;
+
+		// Without a render graph, the pipeline is compatible with any rendering that uses the same attachment formats
+		std::vector<VkFormat> ColorFormats;
+		VkPipelineRenderingCreateInfoKHR RenderingCreateInfo{};
+		RenderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+		RenderingCreateInfo.depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+		RenderingCreateInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+		if (!VkRenderGraph)
 		{
-			VkCmdBuffer(Buf, [&](VkCommandBuffer Buf)
+			for (AttachmentFormat Format : CreateInfo.AttachmentFormats)
 			{
-				VkBufferImageCopy ImageCopy{};
-				ImageCopy.bufferOffset = 0;
-				ImageCopy.bufferRowLength = 0;
-				ImageCopy.bufferImageHeight = 0;
+				if (IsDepthFormat(Format))
+				{
+					RenderingCreateInfo.depthAttachmentFormat = AttachmentFormatToVkFormat(Format);
+					if (IsStencilFormat(Format))
+						RenderingCreateInfo.stencilAttachmentFormat = RenderingCreateInfo.depthAttachmentFormat;
+				}
+				else
+					ColorFormats.push_back(AttachmentFormatToVkFormat(Format));
+			}
 
-				ImageCopy.imageSubresource.aspectMask = IsColorFormat(Result->TextureFormat) ? VK_IMAGE_ASPECT_COLOR_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
-				ImageCopy.imageSubresource.mipLevel = 0;
-				ImageCopy.imageSubresource.baseArrayLayer = Layer;
-				ImageCopy.imageSubresource.layerCount = 1;
+			RenderingCreateInfo.colorAttachmentCount = static_cast<uint32_t>(ColorFormats.size());
+			RenderingCreateInfo.pColorAttachmentFormats = ColorFormats.data();
+			PipelineCreateInfo.pNext = &RenderingCreateInfo;
+		}
+		PipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+		PipelineCreateInfo.basePipelineIndex = -1;
 
-				ImageCopy.imageOffset = { 0, 0, 0 };
-				ImageCopy.imageExtent = { Width, Height, 1 };
+		// TODO: use a global pipeline cache
+		if (vkCreateGraphicsPipelines(GVulkanContext.Device, VK_NULL_HANDLE, 1, &PipelineCreateInfo, nullptr, &Result->Pipeline) != VK_SUCCESS)
+		{
+			//GLog->critical("Failed to create a Vulkan graphics pipeline");
 
-				// Copy buffer data to image
-				vkCmdCopyBufferToImage
-				(
-					Buf,
-					Result->StagingBuffer,
-					Result->TextureImage,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					1,
-					&ImageCopy
-				);
-			});
-		});
+			vkDestroyPipelineLayout(GVulkanContext.Device, Result->PipelineLayout, nullptr);
+			delete Result;
+			return nullptr;
+		}
 
-		// Transition image to be shader read optimal
-		ImmediateSubmit([&](CommandBuffer Buf)
-		{
-			TransitionTexture(Buf, Result, AttachmentUsage::TransferDestination, FinalUsage);
-		});
+		RECORD_RESOURCE_ALLOC(Result)
+
+		return LLRM_CAPTURE_RESULT(GPipelineCache.Insert(Key.Bytes, Result, &DestroyVkPipeline));
 	}
 
-	void ReadTexture(Texture Tex, uint32_t Attachment, void* Dst, uint64_t BufferSize, AttachmentUsage PreviousUsage)
+	Pipeline CreateComputePipeline(const ComputePipelineState& CreateInfo)
 	{
-		vkDeviceWaitIdle(GVulkanContext.Device);
+		LLRM_CAPTURE_CALL(CaptureOp::CreateComputePipeline, CreateInfo);
 
-		VulkanTexture* VkTex = static_cast<VulkanTexture*>(Tex); 
+		VulkanShader* VkShader = static_cast<VulkanShader*>(CreateInfo.Shader);
+		if (!VkShader || !VkShader->bHasComputeShader)
+		{
+			//GLog->critical("Must specify a compute program when creating a compute pipeline");
+			return nullptr;
+		}
 
-		VkBuffer StagingBuffer;
-		VkDeviceMemory StagingBufferMemory;
-		CreateBuffer
-		(
-			BufferSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			StagingBuffer, StagingBufferMemory
-		);
+		CacheKey Key;
+		Key << VK_PIPELINE_BIND_POINT_COMPUTE << VkShader->Id;
+		AppendPipelineLayoutsKey(Key, CreateInfo.Layouts);
 
-		// Transition image to transfer src from its previous usage
-		ImmediateSubmitAndWait([&](CommandBuffer Dst)
-		{
-			TransitionTexture(Dst, Tex, PreviousUsage, AttachmentUsage::TransferSource);
-		});
+		if (VulkanPipeline* Cached = GPipelineCache.Acquire(Key.Bytes))
+			return LLRM_CAPTURE_RESULT(Cached);
 
-		ImmediateSubmitAndWait([&](CommandBuffer Dst)
+		if (VkShader->bModulesReleased)
 		{
-			VkCmdBuffer(Dst, [&](VkCommandBuffer Buf)
-			{
-				VkBufferImageCopy ImageCopy{};
-				ImageCopy.bufferOffset = 0;
-				ImageCopy.bufferRowLength = 0;
-				ImageCopy.bufferImageHeight = 0;
+			//GLog->critical("Can't create a pipeline from a program whose shader modules were released");
+			return nullptr;
+		}
 
-				ImageCopy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				ImageCopy.imageSubresource.mipLevel = 0;
-				ImageCopy.imageSubresource.baseArrayLayer = 0;
-				ImageCopy.imageSubresource.layerCount = 1;
+		VulkanPipeline* Result = new VulkanPipeline;
+		Result->BindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
 
-				ImageCopy.imageOffset = { 0, 0, 0 };
-				ImageCopy.imageExtent = { VkTex->Width, VkTex->Height, 1 };
+		// Create pipeline layout
+		std::vector<VkDescriptorSetLayout> VkLayouts;
+		for (const ResourceLayout& Layout : CreateInfo.Layouts)
+			VkLayouts.push_back(static_cast<VulkanResourceLayout*>(Layout)->VkLayout);
 
-				// Copy image data to buffer
-				vkCmdCopyImageToBuffer(Buf,
-					VkTex->TextureImage,
-					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-					StagingBuffer,
-					1,
-					&ImageCopy
-				);
-			});
-		});
+		VkPipelineLayoutCreateInfo PipelineLayoutInfo{};
+		PipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		PipelineLayoutInfo.setLayoutCount = VkLayouts.size();
+		PipelineLayoutInfo.pSetLayouts = VkLayouts.data();
 
-		void* MappedData;
-		vkMapMemory(GVulkanContext.Device, StagingBufferMemory, 0, BufferSize, 0, &MappedData);
+		if (vkCreatePipelineLayout(GVulkanContext.Device, &PipelineLayoutInfo, nullptr, &Result->PipelineLayout) != VK_SUCCESS)
 		{
-			std::memcpy(Dst, MappedData, BufferSize);
+			//GLog->critical("Failed to create pipeline layout");
+
+			delete Result;
+			return nullptr;
 		}
-		vkUnmapMemory(GVulkanContext.Device, StagingBufferMemory);
 
-		// Transition image back
-		ImmediateSubmitAndWait([&](CommandBuffer Dst)
+		VkComputePipelineCreateInfo PipelineCreateInfo{};
+		PipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		CreatePipelineShaderStage(VK_SHADER_STAGE_COMPUTE_BIT, VkShader->ComputeModule->Module, PipelineCreateInfo.stage);
+		PipelineCreateInfo.layout = Result->PipelineLayout;
+		PipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+		PipelineCreateInfo.basePipelineIndex = -1;
+
+		if (vkCreateComputePipelines(GVulkanContext.Device, VK_NULL_HANDLE, 1, &PipelineCreateInfo, nullptr, &Result->Pipeline) != VK_SUCCESS)
 		{
-			TransitionTexture(Dst, Tex, AttachmentUsage::TransferSource, PreviousUsage);
-		});
+			//GLog->critical("Failed to create a Vulkan compute pipeline");
 
-		// TODO: optimize this, we should have a staging buffer set aside already and a flag TEXTURE_USAGE_CPU_READ
-		vkFreeMemory(GVulkanContext.Device, StagingBufferMemory, nullptr);
-		vkDestroyBuffer(GVulkanContext.Device, StagingBuffer, nullptr);
-	}
+			vkDestroyPipelineLayout(GVulkanContext.Device, Result->PipelineLayout, nullptr);
+			delete Result;
+			return nullptr;
+		}
 
-	AttachmentFormat GetTextureFormat(Texture Tex)
-	{
-		VulkanTexture* VkTex = static_cast<VulkanTexture*>(Tex);
-		return VkTex->TextureFormat;
+		RECORD_RESOURCE_ALLOC(Result)
+
+		return LLRM_CAPTURE_RESULT(GPipelineCache.Insert(Key.Bytes, Result, &DestroyVkPipeline));
 	}
 
-	VkShaderStageFlags ShaderStageToVkStage(ShaderStage Stage)
+	void DestroyVkRenderGraph(VulkanRenderGraph* VkRenderGraph)
 	{
-		switch (Stage)
-		{
-		case ShaderStage::Vertex:
-			return VK_SHADER_STAGE_VERTEX_BIT;
-		case ShaderStage::Fragment:
-			return VK_SHADER_STAGE_FRAGMENT_BIT;
-		}
+		WaitQueueIdle();
+		vkDestroyRenderPass(GVulkanContext.Device, VkRenderGraph->RenderPass, nullptr);
 
-		return VK_SHADER_STAGE_VERTEX_BIT;
+		REMOVE_RESOURCE_ALLOC(VkRenderGraph)
+
+		delete VkRenderGraph;
 	}
 
-	ResourceLayout CreateResourceLayout(const ResourceLayoutCreateInfo& CreateInfo)
+	RenderGraph CreateRenderGraph(const RenderGraphCreateInfo& CreateInfo)
 	{
-		VulkanResourceLayout* Result = new VulkanResourceLayout;
+		LLRM_CAPTURE_CALL(CaptureOp::CreateRenderGraph, CreateInfo);
 
-		std::vector<VkDescriptorSetLayoutBinding> LayoutBindings;
-		for (uint32_t LayoutBindingIndex = 0; LayoutBindingIndex < CreateInfo.ConstantBuffers.size(); LayoutBindingIndex++)
+		CacheKey Key;
+		Key << CreateInfo.Attachments.size();
+		for (const RenderGraphAttachmentDescription& Description : CreateInfo.Attachments)
 		{
-			VkDescriptorSetLayoutBinding LayoutBinding{};
-			LayoutBinding.binding = CreateInfo.ConstantBuffers[LayoutBindingIndex].Binding;
-			LayoutBinding.descriptorCount = CreateInfo.ConstantBuffers[LayoutBindingIndex].Count;
-			LayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			LayoutBinding.pImmutableSamplers = nullptr;
-			LayoutBinding.stageFlags = ShaderStageToVkStage(CreateInfo.ConstantBuffers[LayoutBindingIndex].StageUsedAt);
-
-			LayoutBindings.push_back(LayoutBinding);
-
-			// Persist constant buffers
-			Result->ConstantBuffers.push_back(CreateInfo.ConstantBuffers[LayoutBindingIndex]);
+			Key << Description.InitialUsage << Description.FinalUsage << Description.Format << Description.LoadOp << Description.StoreOp
+				<< Description.StencilLoadOp << Description.StencilStoreOp;
 		}
-
-		for (uint32_t TexBindingIndex = 0; TexBindingIndex < CreateInfo.Textures.size(); TexBindingIndex++)
+		Key << CreateInfo.Passes.size();
+		for (const RenderPassInfo& PassInfo : CreateInfo.Passes)
 		{
-			VkDescriptorSetLayoutBinding LayoutBinding{};
-			LayoutBinding.binding = CreateInfo.Textures[TexBindingIndex].Binding;
-			LayoutBinding.descriptorCount = CreateInfo.Textures[TexBindingIndex].Count;
-			LayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-			LayoutBinding.pImmutableSamplers = nullptr;
-			LayoutBinding.stageFlags = ShaderStageToVkStage(CreateInfo.Textures[TexBindingIndex].StageUsedAt);
+			for (const std::vector<int32_t>* Refs : { &PassInfo.OutputAttachments, &PassInfo.InputAttachments })
+			{
+				Key << Refs->size();
+				for (int32_t AttachRefIndex : *Refs)
+					Key << AttachRefIndex;
+			}
+		}
 
-			LayoutBindings.push_back(LayoutBinding);
+		if (VulkanRenderGraph* Cached = GRenderGraphCache.Acquire(Key.Bytes))
+			return LLRM_CAPTURE_RESULT(Cached);
 
-			// Persist constant buffers
-			Result->TextureBindings.push_back(CreateInfo.Textures[TexBindingIndex]);
-		}
+		VulkanRenderGraph* Result = new VulkanRenderGraph;
+		Result->Id = GNextObjectId++;
 
-		for (uint32_t SampBindingIndex = 0; SampBindingIndex < CreateInfo.Samplers.size(); SampBindingIndex++)
+		struct VkSubPassInfo
 		{
-			VkDescriptorSetLayoutBinding LayoutBinding{};
-			LayoutBinding.binding = CreateInfo.Samplers[SampBindingIndex].Binding;
-			LayoutBinding.descriptorCount = CreateInfo.Samplers[SampBindingIndex].Count;
-			LayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-			LayoutBinding.pImmutableSamplers = nullptr;
-			LayoutBinding.stageFlags = ShaderStageToVkStage(CreateInfo.Samplers[SampBindingIndex].StageUsedAt);
-
-			LayoutBindings.push_back(LayoutBinding);
+			// Preserve the vector so it doesn't get invalidated
+			std::vector<VkAttachmentReference> ColorAttachmentRefs;
+			std::vector<VkAttachmentReference> InputAttachmentRefs;
+			std::vector<uint32_t> PreserveAttachments;
+			VkAttachmentReference DepthStencilAttachmentRef;
+		};
 
-			Result->SamplerBindings.push_back(CreateInfo.Samplers[SampBindingIndex]);
-		}
+		std::vector<VkSubPassInfo> SubPassInfos(CreateInfo.Passes.size());
+		std::vector<VkAttachmentDescription> AttachmentDescriptions;
+		std::vector<VkSubpassDescription> VkPassDescriptions;
 
-		VkDescriptorSetLayoutCreateInfo LayoutCreateInfo{};
-		LayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		LayoutCreateInfo.bindingCount = static_cast<uint32_t>(LayoutBindings.size());
-		LayoutCreateInfo.pBindings = LayoutBindings.data();
+		// The first and last pass each attachment is used in, used for preserving and external dependencies
+		std::vector<int32_t> FirstUse(CreateInfo.Attachments.size(), -1);
+		std::vector<int32_t> LastUse(CreateInfo.Attachments.size(), -1);
 
-		if (vkCreateDescriptorSetLayout(GVulkanContext.Device, &LayoutCreateInfo, nullptr, &Result->VkLayout) != VK_SUCCESS)
+		// Create attachment descriptions
+		for (uint32_t AttachmentIndex = 0; AttachmentIndex < CreateInfo.Attachments.size(); AttachmentIndex++)
 		{
-			//GLog->critical("Failed to create Vulkan descriptor set layout");
-			return nullptr;
-		}
-
-		RECORD_RESOURCE_ALLOC(Result)
+			const RenderGraphAttachmentDescription& Description = CreateInfo.Attachments[AttachmentIndex];
 
-		return Result;
-	}
+			VkAttachmentDescription VkAttachmentDesc{};
+			VkAttachmentDesc.format = AttachmentFormatToVkFormat(Description.Format);
+			VkAttachmentDesc.samples = VK_SAMPLE_COUNT_1_BIT; // Todo: msaa
+			VkAttachmentDesc.loadOp = LoadOpToVkLoadOp(Description.LoadOp);
+			VkAttachmentDesc.storeOp = StoreOpToVkStoreOp(Description.StoreOp);
+			VkAttachmentDesc.stencilLoadOp = LoadOpToVkLoadOp(Description.StencilLoadOp);
+			VkAttachmentDesc.stencilStoreOp = StoreOpToVkStoreOp(Description.StencilStoreOp);
+			VkAttachmentDesc.initialLayout = AttachmentUsageToVkLayout(Description.InitialUsage);
+			VkAttachmentDesc.finalLayout = AttachmentUsageToVkLayout(Description.FinalUsage);
 
-	void DestroyResourceLayout(ResourceLayout Layout)
-	{
-		VulkanResourceLayout* VkLayout = static_cast<VulkanResourceLayout*>(Layout);
-		vkDestroyDescriptorSetLayout(GVulkanContext.Device, VkLayout->VkLayout, nullptr);
+			AttachmentDescriptions.push_back(VkAttachmentDesc);
+		}
 
-		REMOVE_RESOURCE_ALLOC(VkLayout)
+		for (uint32_t SubpassIndex = 0; SubpassIndex < CreateInfo.Passes.size(); SubpassIndex++)
+		{
+			const RenderPassInfo& PassInfo = CreateInfo.Passes[SubpassIndex];
+			for (const std::vector<int32_t>* Refs : { &PassInfo.OutputAttachments, &PassInfo.InputAttachments })
+			{
+				for (int32_t AttachRefIndex : *Refs)
+				{
+					if (FirstUse[AttachRefIndex] < 0)
+						FirstUse[AttachRefIndex] = SubpassIndex;
+					LastUse[AttachRefIndex] = SubpassIndex;
+				}
+			}
+		}
 
-		delete VkLayout;
-	}
+		// Create subpasses
+		for (uint32_t SubpassIndex = 0; SubpassIndex < CreateInfo.Passes.size(); SubpassIndex++)
+		{
+			const RenderPassInfo& PassInfo = CreateInfo.Passes[SubpassIndex];
+			VkSubPassInfo& SubpassInfo = SubPassInfos[SubpassIndex];
 
-	void DestroyResourceSet(ResourceSet Resources)
-	{
-		vkDeviceWaitIdle(GVulkanContext.Device);
+			VkSubpassDescription VkDescription{};
 
-		VulkanResourceSet* VkRes = static_cast<VulkanResourceSet*>(Resources);
-		for (const auto& ConstBuf : VkRes->ConstantBuffers)
-		{
-			for (const auto& Memory : ConstBuf.Memory)
-				vkFreeMemory(GVulkanContext.Device, Memory, nullptr);
+			VkDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS; // Always bind to graphics, unless Vulkan eventually supports compute subpasses
 
-			for (const auto& Buf : ConstBuf.Buffers)
-				vkDestroyBuffer(GVulkanContext.Device, Buf, nullptr);
+			// Load attachment refs
+			bool UsesDepthStencil = false;
+			for(int32_t AttachRefIndex : PassInfo.OutputAttachments)
+			{
+				VkAttachmentReference AttachRef{};
+				AttachRef.attachment = AttachRefIndex;
 
-		}
+				if (IsColorFormat(CreateInfo.Attachments[AttachRefIndex].Format))
+				{
+					AttachRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+					SubpassInfo.ColorAttachmentRefs.push_back(AttachRef);
+				}
+				else // Depth
+				{
+					AttachRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+					SubpassInfo.DepthStencilAttachmentRef = AttachRef;
+					UsesDepthStencil = true;
+				}
+			}
 
-		vkFreeDescriptorSets(GVulkanContext.Device, GVulkanContext.MainDscPool, static_cast<uint32_t>(VkRes->DescriptorSets.size()), VkRes->DescriptorSets.data());
+			// Input attachment indices in the shader follow the order they're listed in
+			for (int32_t AttachRefIndex : PassInfo.InputAttachments)
+			{
+				VkAttachmentReference AttachRef{};
+				AttachRef.attachment = AttachRefIndex;
 
-		REMOVE_RESOURCE_ALLOC(VkRes)
+				if (IsColorFormat(CreateInfo.Attachments[AttachRefIndex].Format))
+					AttachRef.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				else
+					AttachRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
-		delete VkRes;
-	}
+				SubpassInfo.InputAttachmentRefs.push_back(AttachRef);
+			}
 
-	void CreatePipelineShaderStage(VkShaderStageFlagBits Stage, VkShaderModule Module, VkPipelineShaderStageCreateInfo& OutCreateInfo)
-	{
-		// Setup pipeline stage create info
-		VkPipelineShaderStageCreateInfo NewInfo{};
-		NewInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		NewInfo.stage = Stage;
-		NewInfo.module = Module;
-		NewInfo.pName = "main";
+			// Attachments that are used before and after this pass need their contents preserved through it
+			for (uint32_t AttachmentIndex = 0; AttachmentIndex < CreateInfo.Attachments.size(); AttachmentIndex++)
+			{
+				if (FirstUse[AttachmentIndex] < 0 || FirstUse[AttachmentIndex] >= static_cast<int32_t>(SubpassIndex) || LastUse[AttachmentIndex] <= static_cast<int32_t>(SubpassIndex))
+					continue;
 
-		OutCreateInfo = NewInfo;
-	}
+				bool bUsedInPass = std::find(PassInfo.OutputAttachments.begin(), PassInfo.OutputAttachments.end(), AttachmentIndex) != PassInfo.OutputAttachments.end() ||
+					std::find(PassInfo.InputAttachments.begin(), PassInfo.InputAttachments.end(), AttachmentIndex) != PassInfo.InputAttachments.end();
 
-	VkFormat EngineFormatToVkFormat(VertexAttributeFormat Format)
-	{
-		switch (Format)
-		{
-		case VertexAttributeFormat::Float:
-			return VK_FORMAT_R32_SFLOAT;
-		case VertexAttributeFormat::Float2:
-			return VK_FORMAT_R32G32_SFLOAT;
-		case VertexAttributeFormat::Float3:
-			return VK_FORMAT_R32G32B32_SFLOAT;
-		case VertexAttributeFormat::Float4:
-			return VK_FORMAT_R32G32B32A32_SFLOAT;
-		case VertexAttributeFormat::Int32:
-			return VK_FORMAT_R32_SINT;
-		}
+				if (!bUsedInPass)
+					SubpassInfo.PreserveAttachments.push_back(AttachmentIndex);
+			}
 
-		return VK_FORMAT_R32_SFLOAT;
-	}
+			VkDescription.colorAttachmentCount = static_cast<uint32_t>(SubpassInfo.ColorAttachmentRefs.size());
+			VkDescription.pColorAttachments = SubpassInfo.ColorAttachmentRefs.data();
+			VkDescription.inputAttachmentCount = static_cast<uint32_t>(SubpassInfo.InputAttachmentRefs.size());
+			VkDescription.pInputAttachments = SubpassInfo.InputAttachmentRefs.data();
+			VkDescription.pDepthStencilAttachment = UsesDepthStencil ? &SubpassInfo.DepthStencilAttachmentRef : nullptr;
+			VkDescription.pPreserveAttachments = SubpassInfo.PreserveAttachments.data();
+			VkDescription.preserveAttachmentCount = static_cast<uint32_t>(SubpassInfo.PreserveAttachments.size());
 
-	VkPrimitiveTopology EngineTopToVkTop(PipelineRenderPrimitive Primitive)
-	{
-		switch (Primitive)
-		{
-		case PipelineRenderPrimitive::TRIANGLES:
-			return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		case PipelineRenderPrimitive::LINES:
-			return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+			VkPassDescriptions.push_back(VkDescription);
 		}
 
-		return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	}
-
-	Pipeline CreatePipeline(const PipelineState& CreateInfo)
-	{
-		VulkanShader* VkShader = static_cast<VulkanShader*>(CreateInfo.Shader);
-		VulkanRenderGraph* VkRenderGraph = static_cast<VulkanRenderGraph*>(CreateInfo.CompatibleGraph);
-		if (!VkRenderGraph)
+		// Merge dependencies between the same two subpasses into one
+		std::vector<VkSubpassDependency> Deps;
+		auto AddDependency = [&Deps](uint32_t Src, uint32_t Dst, VkPipelineStageFlags SrcStage, VkAccessFlags SrcAccess, VkPipelineStageFlags DstStage, VkAccessFlags DstAccess, VkDependencyFlags Flags)
 		{
-			//GLog->critical("Must specify a valid Vulkan RenderGraph when creating a pipeline");
-			return nullptr;
-		}
+			auto Existing = std::find_if(Deps.begin(), Deps.end(), [Src, Dst](const VkSubpassDependency& Dep)
+			{
+				return Dep.srcSubpass == Src && Dep.dstSubpass == Dst;
+			});
 
-		VulkanPipeline* Result = new VulkanPipeline;
+			if (Existing == Deps.end())
+			{
+				VkSubpassDependency NewDep{};
+				NewDep.srcSubpass = Src;
+				NewDep.dstSubpass = Dst;
+				Existing = Deps.insert(Deps.end(), NewDep);
+			}
 
-		std::vector<VkPipelineShaderStageCreateInfo> ShaderCreateInfos;
-		std::vector<VkVertexInputAttributeDescription> VertexAttributes;
-		std::vector<VkVertexInputBindingDescription> VertexBindings;
+			Existing->srcStageMask |= SrcStage;
+			Existing->srcAccessMask |= SrcAccess;
+			Existing->dstStageMask |= DstStage;
+			Existing->dstAccessMask |= DstAccess;
+			Existing->dependencyFlags |= Flags;
+		};
 
-		if (VkShader->bHasVertexShader)
-		{
-			VkPipelineShaderStageCreateInfo VertInfo{};
-			CreatePipelineShaderStage(VK_SHADER_STAGE_VERTEX_BIT, VkShader->VertexModule, VertInfo);
-			ShaderCreateInfos.push_back(VertInfo);
-		}
+		const VkPipelineStageFlags DepthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 
-		if (VkShader->bHasFragmentShader)
+		// Dependencies between subpasses, derived from which earlier pass last wrote or read each attachment
+		for (uint32_t SubpassIndex = 1; SubpassIndex < CreateInfo.Passes.size(); SubpassIndex++)
 		{
-			VkPipelineShaderStageCreateInfo FragInfo{};
-			CreatePipelineShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, VkShader->FragmentModule, FragInfo);
-			ShaderCreateInfos.push_back(FragInfo);
-		}
+			const RenderPassInfo& PassInfo = CreateInfo.Passes[SubpassIndex];
 
-		// Only use a single vertex binding for now
-		VkVertexInputBindingDescription BindingDescription{};
-		BindingDescription.binding = 0;
-		BindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX; // Would probably need to change this for instanced rendering
-		BindingDescription.stride = CreateInfo.VertexBufferStride;
-		VertexBindings.push_back(BindingDescription);
+			for (uint32_t PrevIndex = 0; PrevIndex < SubpassIndex; PrevIndex++)
+			{
+				const RenderPassInfo& PrevInfo = CreateInfo.Passes[PrevIndex];
 
-		uint32_t AttribIndex = 0;
-		for(auto& Attrib : CreateInfo.VertexAttributes)
-		{
-			VkVertexInputAttributeDescription AttributeDescription{};
-			AttributeDescription.format = EngineFormatToVkFormat(Attrib.first);
-			AttributeDescription.binding = 0; // Always use one binding for vertex buffers
-			AttributeDescription.location = AttribIndex++;
-			AttributeDescription.offset = Attrib.second;
+				for (int32_t Written : PrevInfo.OutputAttachments)
+				{
+					bool bColor = IsColorFormat(CreateInfo.Attachments[Written].Format);
+					VkPipelineStageFlags WriteStage = bColor ? VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT : DepthStages;
+					VkAccessFlags WriteAccess = bColor ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
-			VertexAttributes.push_back(AttributeDescription);
-		}
+					// Read after write, only the same pixel is ever read so the dependency can be by region
+					if (std::find(PassInfo.InputAttachments.begin(), PassInfo.InputAttachments.end(), Written) != PassInfo.InputAttachments.end())
+						AddDependency(PrevIndex, SubpassIndex, WriteStage, WriteAccess, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_INPUT_ATTACHMENT_READ_BIT, VK_DEPENDENCY_BY_REGION_BIT);
 
-		// Create VkPipelineVertexInputStageCreateInfo
-		VkPipelineVertexInputStateCreateInfo VertexStateCreateInfo{};
-		VertexStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		VertexStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(VertexAttributes.size());
-		VertexStateCreateInfo.pVertexAttributeDescriptions = VertexAttributes.data();
-		VertexStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(VertexBindings.size());
-		VertexStateCreateInfo.pVertexBindingDescriptions = VertexBindings.data();
+					// Write after write
+					if (std::find(PassInfo.OutputAttachments.begin(), PassInfo.OutputAttachments.end(), Written) != PassInfo.OutputAttachments.end())
+						AddDependency(PrevIndex, SubpassIndex, WriteStage, WriteAccess, WriteStage, WriteAccess, VK_DEPENDENCY_BY_REGION_BIT);
+				}
 
-		// Create input assembly
-		VkPipelineInputAssemblyStateCreateInfo InputAssembly{};
-		InputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		InputAssembly.topology = EngineTopToVkTop(CreateInfo.Primitive);
-		InputAssembly.primitiveRestartEnable = VK_FALSE; // Used for strip topologies
+				// Write after read
+				for (int32_t Read : PrevInfo.InputAttachments)
+				{
+					if (std::find(PassInfo.OutputAttachments.begin(), PassInfo.OutputAttachments.end(), Read) == PassInfo.OutputAttachments.end())
+						continue;
 
-		// VkViewport and VkScissor will always be dynamic to prevent needing to re-create the pipeline on swap chain re-creation
-		VkViewport Viewport{};
-		Viewport.x = 0.0f;
-		Viewport.y = 0.0f;
-		Viewport.width = 1.0f;
-		Viewport.height = 1.0f;
-		Viewport.minDepth = 0.0f;
-		Viewport.maxDepth = 1.0f;
+					bool bColor = IsColorFormat(CreateInfo.Attachments[Read].Format);
+					VkPipelineStageFlags WriteStage = bColor ? VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT : DepthStages;
+					VkAccessFlags WriteAccess = bColor ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
-		VkRect2D Scissor{};
-		Scissor.offset = { 0, 0 };
-		Scissor.extent = { 1, 1 };
+					AddDependency(PrevIndex, SubpassIndex, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, WriteStage, WriteAccess, VK_DEPENDENCY_BY_REGION_BIT);
+				}
+			}
+		}
 
-		VkPipelineViewportStateCreateInfo ViewportStateCreateInfo{};
-		ViewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		ViewportStateCreateInfo.viewportCount = 1;
-		ViewportStateCreateInfo.pViewports = &Viewport;
-		ViewportStateCreateInfo.scissorCount = 1;
-		ViewportStateCreateInfo.pScissors = &Scissor;
+		// Define explicit external subpass dependencies against the first and last pass that uses each attachment
+		for (uint32_t AttachmentIndex = 0; AttachmentIndex < CreateInfo.Attachments.size(); AttachmentIndex++)
+		{
+			if (FirstUse[AttachmentIndex] < 0)
+				continue;
 
-		VkPipelineRasterizationStateCreateInfo Rasterizer{};
-		Rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		Rasterizer.depthClampEnable = VK_FALSE;
-		Rasterizer.rasterizerDiscardEnable = VK_FALSE;
-		Rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-		Rasterizer.lineWidth = 1.0f;
-		Rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-		if(CreateInfo.Cull == CullMode::Front)
-			Rasterizer.cullMode = VK_CULL_MODE_FRONT_BIT;
+			uint32_t First = static_cast<uint32_t>(FirstUse[AttachmentIndex]);
+			uint32_t Last = static_cast<uint32_t>(LastUse[AttachmentIndex]);
 
-		Rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE; // Reverse this from the usual CLOCKWISE because we flip the viewport
-		if(CreateInfo.Winding == VertexWinding::Clockwise)
-			Rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE; // Reverse this from the usual CLOCKWISE because we flip the viewport
-		Rasterizer.depthBiasEnable = VK_FALSE;
-		Rasterizer.depthBiasConstantFactor = 0.0f;
-		Rasterizer.depthBiasClamp = 0.0f;
-		Rasterizer.depthBiasSlopeFactor = 0.0f;
+			if (IsColorFormat(CreateInfo.Attachments[AttachmentIndex].Format))
+			{
+				// Wait for the previous color attachment to be written, and transition the image at the color attachment output stage
+				AddDependency(VK_SUBPASS_EXTERNAL, First,
+					VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0,
+					VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0);
+
+				// Next render pass needs this fbo to be made available
+				AddDependency(Last, VK_SUBPASS_EXTERNAL,
+					VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, 0);
+			}
+			else
+			{
+				AddDependency(VK_SUBPASS_EXTERNAL, First,
+					VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+					VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, 0);
 
-		VkPipelineDepthStencilStateCreateInfo DepthStencilCreateInfo{};
-		DepthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		DepthStencilCreateInfo.depthTestEnable = VK_FALSE;
-		DepthStencilCreateInfo.depthWriteEnable = VK_FALSE;
-		DepthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
-		DepthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
-		DepthStencilCreateInfo.minDepthBounds = 0.0f; // Optional
-		DepthStencilCreateInfo.maxDepthBounds = 1.0f; // Optional
-		DepthStencilCreateInfo.stencilTestEnable = VK_FALSE;
-		DepthStencilCreateInfo.front = {}; // Optional
-		DepthStencilCreateInfo.back = {}; // Optional
-		if (CreateInfo.DepthStencil.bEnableDepthTest)
-		{
-			DepthStencilCreateInfo.depthTestEnable = VK_TRUE;
-			DepthStencilCreateInfo.depthWriteEnable = VK_TRUE;
+				AddDependency(Last, VK_SUBPASS_EXTERNAL,
+					DepthStages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+					VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT, 0);
+			}
 		}
 
-		VkPipelineMultisampleStateCreateInfo Multisampling{};
-		Multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		Multisampling.sampleShadingEnable = VK_FALSE;
-		Multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-		Multisampling.minSampleShading = 1.0f; // Optional
-		Multisampling.pSampleMask = nullptr; // Optional
-		Multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-		Multisampling.alphaToOneEnable = VK_FALSE; // Optional
-		Multisampling.pSampleMask = nullptr;
+		// Create the render pass
+		VkRenderPassCreateInfo RenderPassCreateInfo{};
+		RenderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		RenderPassCreateInfo.attachmentCount = static_cast<uint32_t>(AttachmentDescriptions.size());
+		RenderPassCreateInfo.pAttachments = AttachmentDescriptions.data();
+		RenderPassCreateInfo.subpassCount = static_cast<uint32_t>(VkPassDescriptions.size());
+		RenderPassCreateInfo.pSubpasses = VkPassDescriptions.data();
+		RenderPassCreateInfo.dependencyCount = static_cast<uint32_t>(Deps.size());
+		RenderPassCreateInfo.pDependencies = Deps.data();
 
-		std::vector<VkPipelineColorBlendAttachmentState> ColorBlendAttachments;
-		for(const PipelineBlendSettings& Settings : CreateInfo.BlendSettings)
+		if (vkCreateRenderPass(GVulkanContext.Device, &RenderPassCreateInfo, nullptr, &Result->RenderPass) != VK_SUCCESS)
 		{
-			VkPipelineColorBlendAttachmentState ColorBlendAttachment{};
-			ColorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-			ColorBlendAttachment.blendEnable = Settings.bBlendingEnabled ? VK_TRUE : VK_FALSE;
-			ColorBlendAttachment.srcColorBlendFactor = BlendFactorToVkFactor(Settings.SrcColorFactor);
-			ColorBlendAttachment.dstColorBlendFactor = BlendFactorToVkFactor(Settings.DstColorFactor);
-			ColorBlendAttachment.colorBlendOp = BlendOpToVkBlend(Settings.ColorOp);
-			ColorBlendAttachment.srcAlphaBlendFactor = BlendFactorToVkFactor(Settings.SrcAlphaFactor);
-			ColorBlendAttachment.dstAlphaBlendFactor = BlendFactorToVkFactor(Settings.DstAlphaFactor);
-			ColorBlendAttachment.alphaBlendOp = BlendOpToVkBlend(Settings.AlphaOp);
+			//GLog->critical("Failed to create Vulkan render pass");
 
-			ColorBlendAttachments.push_back(ColorBlendAttachment);
+			delete Result;
+			return nullptr;
 		}
 
-		VkPipelineColorBlendStateCreateInfo ColorBlending{};
-		ColorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		ColorBlending.logicOpEnable = VK_FALSE;
-		ColorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
-		ColorBlending.attachmentCount = static_cast<uint32_t>(ColorBlendAttachments.size());
-		ColorBlending.pAttachments = ColorBlendAttachments.data();
-		ColorBlending.blendConstants[0] = 0.0f; // Optional
-		ColorBlending.blendConstants[1] = 0.0f; // Optional
-		ColorBlending.blendConstants[2] = 0.0f; // Optional
-		ColorBlending.blendConstants[3] = 0.0f; // Optional
+		RECORD_RESOURCE_ALLOC(Result)
+
+		return LLRM_CAPTURE_RESULT(GRenderGraphCache.Insert(Key.Bytes, Result, &DestroyVkRenderGraph));
+	}
+
+	CommandBuffer CreateCommandBuffer(bool bOneTimeUse)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateCommandBuffer, bOneTimeUse);
 
-		VkDynamicState DynamicStates[] = {
-			VK_DYNAMIC_STATE_VIEWPORT,
-			VK_DYNAMIC_STATE_SCISSOR
-		};
+		VulkanThreadPools* Pools = GetThreadPools();
+		if (!Pools)
+			return nullptr;
 
-		VkPipelineDynamicStateCreateInfo DynamicState{};
-		DynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		DynamicState.dynamicStateCount = 2;
-		DynamicState.pDynamicStates = DynamicStates;
+		// Free the command buffers other threads destroyed since the last allocation
+		{
+			std::lock_guard<std::mutex> PoolLock(Pools->Lock);
+			if (!Pools->PendingCommandBufferFrees.empty())
+			{
+				vkFreeCommandBuffers(GVulkanContext.Device, Pools->CommandPool, static_cast<uint32_t>(Pools->PendingCommandBufferFrees.size()), Pools->PendingCommandBufferFrees.data());
+				Pools->PendingCommandBufferFrees.clear();
+			}
+		}
 
-		// Create pipeline layout
-		std::vector<VkDescriptorSetLayout> VkLayouts;
-		for (const ResourceLayout& Layout : CreateInfo.Layouts)
-			VkLayouts.push_back(static_cast<VulkanResourceLayout*>(Layout)->VkLayout);
+		// Create a single command buffer
+		VkCommandBufferAllocateInfo CmdBufAllocInfo{};
+		CmdBufAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		CmdBufAllocInfo.commandPool = Pools->CommandPool;
+		CmdBufAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY; // TODO: support secondary command buffers
+		CmdBufAllocInfo.commandBufferCount = 1;
 
-		VkPipelineLayoutCreateInfo PipelineLayoutInfo{};
-		PipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		PipelineLayoutInfo.setLayoutCount = VkLayouts.size();
-		PipelineLayoutInfo.pSetLayouts = VkLayouts.data();
-		PipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-		PipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+		VulkanCommandBuffer* NewCmdBuf = new VulkanCommandBuffer;
+		NewCmdBuf->Pools = Pools;
+		NewCmdBuf->bOneTimeUse = bOneTimeUse;
 
-		if (vkCreatePipelineLayout(GVulkanContext.Device, &PipelineLayoutInfo, nullptr, &Result->PipelineLayout) != VK_SUCCESS)
+		if (vkAllocateCommandBuffers(GVulkanContext.Device, &CmdBufAllocInfo, &NewCmdBuf->CmdBuffer) != VK_SUCCESS)
 		{
-			//GLog->critical("Failed to create pipeline layout");
+			//GLog->critical("Failed to allocate command buffer");
 
-			delete Result;
+			delete NewCmdBuf;
 			return nullptr;
 		}
 
-		// Create the pipeline object
-		VkGraphicsPipelineCreateInfo PipelineCreateInfo{};
-		PipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		PipelineCreateInfo.stageCount = static_cast<uint32_t>(ShaderCreateInfos.size());
-		PipelineCreateInfo.pStages = ShaderCreateInfos.data();
-		PipelineCreateInfo.pVertexInputState = &VertexStateCreateInfo;
-		PipelineCreateInfo.pInputAssemblyState = &InputAssembly;
-		PipelineCreateInfo.pViewportState = &ViewportStateCreateInfo;
-		PipelineCreateInfo.pRasterizationState = &Rasterizer;
-		PipelineCreateInfo.pMultisampleState = &Multisampling;
-		PipelineCreateInfo.pDepthStencilState = &DepthStencilCreateInfo;
-		PipelineCreateInfo.pColorBlendState = &ColorBlending;
-		PipelineCreateInfo.pDynamicState = &DynamicState;
-		PipelineCreateInfo.layout = Result->PipelineLayout;
-		PipelineCreateInfo.renderPass = VkRenderGraph->RenderPass;
-		PipelineCreateInfo.subpass = CreateInfo.PassIndex;
-		PipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
-		PipelineCreateInfo.basePipelineIndex = -1;
+		RECORD_RESOURCE_ALLOC(NewCmdBuf)
 
-		// TODO: use a global pipeline cache
-		if (vkCreateGraphicsPipelines(GVulkanContext.Device, VK_NULL_HANDLE, 1, &PipelineCreateInfo, nullptr, &Result->Pipeline) != VK_SUCCESS)
+		return LLRM_CAPTURE_RESULT(NewCmdBuf);
+	}
+
+	const uint32_t FirstDescriptorPoolSize = 256;
+	const uint32_t MaxDescriptorPoolSize = 4096;
+	const uint32_t TransientDescriptorPoolSize = 1024;
+	const uint64_t UniformBlockSize = 1 << 20;
+
+	// Tries the newest pool first, then older pools that may have room from freed sets, and adds a pool twice as large as the last one when none do.
+	// SetSizes are the descriptors one of the sets needs, so the new pool always fits the sets being allocated.
+	bool AllocatePersistentDescriptorSets(VulkanThreadPools* Pools, const std::vector<VkDescriptorSetLayout>& Layouts, const std::vector<VkDescriptorPoolSize>& SetSizes, VkDescriptorSet* OutSets, VkDescriptorPool& OutPool)
+	{
+		VkDescriptorSetAllocateInfo SetAllocInfo{};
+		SetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		SetAllocInfo.descriptorSetCount = static_cast<uint32_t>(Layouts.size());
+		SetAllocInfo.pSetLayouts = Layouts.data();
+
+		for (auto Pool = Pools->DscPools.rbegin(); Pool != Pools->DscPools.rend(); ++Pool)
 		{
-			//GLog->critical("Failed to create a Vulkan graphics pipeline");
+			SetAllocInfo.descriptorPool = *Pool;
+			if (vkAllocateDescriptorSets(GVulkanContext.Device, &SetAllocInfo, OutSets) == VK_SUCCESS)
+			{
+				OutPool = *Pool;
+				return true;
+			}
+		}
 
-			delete Result;
-			return nullptr;
+		uint32_t PoolSize = std::max({ Pools->NextDscPoolSize, FirstDescriptorPoolSize, SetAllocInfo.descriptorSetCount });
+
+		VkDescriptorPool NewPool;
+		if (!CreateVkDescriptorPool(GVulkanContext.Device, PoolSize, true, NewPool, SetSizes))
+		{
+			//GLog->critical("Failed to create Vulkan descriptor pool");
+			return false;
 		}
 
-		RECORD_RESOURCE_ALLOC(Result)
+		Pools->DscPools.push_back(NewPool);
+		Pools->NextDscPoolSize = std::min(PoolSize * 2, MaxDescriptorPoolSize);
 
-		return Result;
+		SetAllocInfo.descriptorPool = NewPool;
+		if (vkAllocateDescriptorSets(GVulkanContext.Device, &SetAllocInfo, OutSets) != VK_SUCCESS)
+		{
+			//GLog->critical("Failed to allocate descriptor sets from a new pool sized for their layout");
+			return false;
+		}
+
+		OutPool = NewPool;
+		return true;
 	}
 
-	RenderGraph CreateRenderGraph(const RenderGraphCreateInfo& CreateInfo)
+	// Allocates from the current pool of the frame, moving on to the next pool (and creating it if needed) once it's full
+	bool AllocateTransientDescriptorSet(VulkanTransientFrame& Frame, VkDescriptorSetLayout Layout, const std::vector<VkDescriptorPoolSize>& SetSizes, VkDescriptorSet& OutSet, VkDescriptorPool& OutPool)
 	{
-		VulkanRenderGraph* Result = new VulkanRenderGraph;
+		VkDescriptorSetAllocateInfo SetAllocInfo{};
+		SetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		SetAllocInfo.descriptorSetCount = 1;
+		SetAllocInfo.pSetLayouts = &Layout;
 
-		struct VkSubPassInfo
+		while (true)
 		{
-			// Preserve the vector so it doesn't get invalidated
-			std::vector<VkAttachmentReference> ColorAttachmentRefs;
-			VkAttachmentReference DepthStencilAttachmentRef;
-		};
+			bool bNewPool = Frame.CurrentDscPool == Frame.DscPools.size();
+			if (bNewPool)
+			{
+				VkDescriptorPool NewPool;
+				if (!CreateVkDescriptorPool(GVulkanContext.Device, TransientDescriptorPoolSize, false, NewPool, SetSizes))
+				{
+					//GLog->critical("Failed to create transient Vulkan descriptor pool");
+					return false;
+				}
 
-		std::vector<VkSubPassInfo> SubPassInfos(CreateInfo.Passes.size());
-		std::vector<VkAttachmentDescription> AttachmentDescriptions;
-		std::vector<VkSubpassDescription> VkPassDescriptions;
+				Frame.DscPools.push_back(NewPool);
+			}
 
-		bool HasDepthAttachment = false;
-		bool HasColorAttachment = false;
+			SetAllocInfo.descriptorPool = Frame.DscPools[Frame.CurrentDscPool];
+			if (vkAllocateDescriptorSets(GVulkanContext.Device, &SetAllocInfo, &OutSet) == VK_SUCCESS)
+			{
+				OutPool = SetAllocInfo.descriptorPool;
+				return true;
+			}
 
-		// Create attachment descriptions
-		for (uint32_t AttachmentIndex = 0; AttachmentIndex < CreateInfo.Attachments.size(); AttachmentIndex++)
+			// The set doesn't even fit in an empty pool sized for its layout
+			if (bNewPool)
+			{
+				//GLog->critical("Failed to allocate a transient descriptor set from a new pool");
+				return false;
+			}
+
+			Frame.CurrentDscPool++;
+		}
+	}
+
+	// Sub-allocates uniform memory from the current block of the frame, adding a block once the existing ones are full
+	bool AllocateTransientUniforms(VulkanTransientFrame& Frame, uint64_t Size, VkBuffer& OutBuffer, uint64_t& OutOffset, uint8_t*& OutMapped)
+	{
+		const uint64_t Alignment = GVulkanContext.UniformBufferAlignment;
+
+		while (Frame.CurrentUniformBlock < Frame.UniformBlocks.size())
 		{
-			const RenderGraphAttachmentDescription& Description = CreateInfo.Attachments[AttachmentIndex];
+			const VulkanUniformBlock& Block = Frame.UniformBlocks[Frame.CurrentUniformBlock];
 
-			VkAttachmentDescription VkAttachmentDesc{};
-			VkAttachmentDesc.format = AttachmentFormatToVkFormat(Description.Format);
-			VkAttachmentDesc.samples = VK_SAMPLE_COUNT_1_BIT; // Todo: msaa
-			VkAttachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			VkAttachmentDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			VkAttachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-			VkAttachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			VkAttachmentDesc.initialLayout = AttachmentUsageToVkLayout(Description.InitialUsage);
-			VkAttachmentDesc.finalLayout = AttachmentUsageToVkLayout(Description.FinalUsage);
+			uint64_t Offset = (Frame.UniformOffset + Alignment - 1) / Alignment * Alignment;
+			if (Offset + Size <= Block.Size)
+			{
+				Frame.UniformOffset = Offset + Size;
 
-			AttachmentDescriptions.push_back(VkAttachmentDesc);
+				OutBuffer = Block.Buffer;
+				OutOffset = Offset;
+				OutMapped = Block.Mapped + Offset;
+				return true;
+			}
 
-			if (IsDepthFormat(Description.Format))
-				HasDepthAttachment = true;
-			if (IsColorFormat(Description.Format))
-				HasColorAttachment = true;
+			Frame.CurrentUniformBlock++;
+			Frame.UniformOffset = 0;
 		}
 
-		// Create subpasses
-		for (uint32_t SubpassIndex = 0; SubpassIndex < CreateInfo.Passes.size(); SubpassIndex++)
+		VulkanUniformBlock NewBlock;
+		NewBlock.Size = std::max(UniformBlockSize, Size);
+
+		if (!CreateBuffer(NewBlock.Size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			NewBlock.Buffer, NewBlock.Memory))
 		{
-			const RenderPassInfo& PassInfo = CreateInfo.Passes[SubpassIndex];
-			VkSubPassInfo& SubpassInfo = SubPassInfos[SubpassIndex];
+			return false;
+		}
 
-			VkSubpassDescription VkDescription{};
+		vkMapMemory(GVulkanContext.Device, NewBlock.Memory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&NewBlock.Mapped));
+		Frame.UniformBlocks.push_back(NewBlock);
+		Frame.UniformOffset = Size;
 
-			VkDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS; // Always bind to graphics, unless Vulkan eventually supports compute subpasses
+		OutBuffer = NewBlock.Buffer;
+		OutOffset = 0;
+		OutMapped = NewBlock.Mapped;
+		return true;
+	}
 
-			// Load attachment refs
-			bool UsesDepthStencil = false;
-			for(int32_t AttachRefIndex : PassInfo.OutputAttachments)
+	ResourceSet CreateResourceSet(const ResourceSetCreateInfo& CreateInfo)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateResourceSet, CreateInfo);
+
+		VulkanResourceLayout* VkLayout = static_cast<VulkanResourceLayout*>(CreateInfo.Layout);
+
+		VulkanThreadPools* Pools = GetThreadPools();
+		if (!Pools)
+			return nullptr;
+
+		VulkanResourceSet* Result = new VulkanResourceSet;
+		Result->Pools = Pools;
+		CopyUniformBufferBindings(VkLayout->UniformTexelBufferBindings, Result->UniformTexelBufferBindings);
+		CopyUniformBufferBindings(VkLayout->DynamicUniformBufferBindings, Result->DynamicUniformBufferBindings);
+
+		// Allocate buffers
+		for (const auto& ConstBuf : VkLayout->ConstantBuffers)
+		{
+			ConstantBufferStorage BufStorage;
+			BufStorage.Binding = ConstBuf.Binding;
+
+			for (uint32_t Image = 0; Image < GVulkanContext.FramesInFlight; Image++)
 			{
-				VkAttachmentReference AttachRef{};
-				AttachRef.attachment = AttachRefIndex;
+				VkBuffer NewBuffer;
+				VkDeviceMemory NewMemory;
+				bool bSuccess = CreateBuffer(ConstBuf.BufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					NewBuffer, NewMemory);
 
-				if (IsColorFormat(CreateInfo.Attachments[AttachRefIndex].Format))
-				{
-					AttachRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-					SubpassInfo.ColorAttachmentRefs.push_back(AttachRef);
-				}
-				else // Depth
+				if (!bSuccess)
 				{
-					AttachRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-					SubpassInfo.DepthStencilAttachmentRef = AttachRef;
-					UsesDepthStencil = true;
+					//GLog->critical("Failed to allocate uniform buffer for resource set");
+					Result->ConstantBuffers.push_back(BufStorage);
+					DestroyVkResourceSet(Result);
+					return nullptr;
 				}
+
+				BufStorage.Buffers.push_back(NewBuffer);
+				BufStorage.Memory.push_back(NewMemory);
 			}
 
-			VkDescription.colorAttachmentCount = static_cast<uint32_t>(SubpassInfo.ColorAttachmentRefs.size());
-			VkDescription.pColorAttachments = SubpassInfo.ColorAttachmentRefs.data();
-			VkDescription.inputAttachmentCount = 0; // TODO: eventually support these
-			VkDescription.pInputAttachments = nullptr;
-			VkDescription.pDepthStencilAttachment = UsesDepthStencil ? &SubpassInfo.DepthStencilAttachmentRef : nullptr;
-			VkDescription.pPreserveAttachments = nullptr;
-			VkDescription.preserveAttachmentCount = 0;
+			Result->ConstantBuffers.push_back(BufStorage);
+		}
 
-			VkPassDescriptions.push_back(VkDescription);
+		// Allocate a descriptor set for every frame in flight at once
+		std::vector<VkDescriptorSetLayout> SetLayouts(GVulkanContext.FramesInFlight, VkLayout->VkLayout);
+		Result->DescriptorSets.resize(GVulkanContext.FramesInFlight);
+
+		std::lock_guard<std::mutex> PoolLock(Pools->Lock);
+
+		if (!AllocatePersistentDescriptorSets(Pools, SetLayouts, VkLayout->PoolSizes, Result->DescriptorSets.data(), Result->DscPool))
+		{
+			//GLog->critical("Failed to create vulkan descriptor set");
+			DestroyVkResourceSet(Result);
+			return nullptr;
+		}
+
+		RECORD_RESOURCE_ALLOC(Result);
+
+		return LLRM_CAPTURE_RESULT(Result);
+	}
+
+	ResourceSet CreateTransientResourceSet(const ResourceSetCreateInfo& CreateInfo)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateTransientResourceSet, CreateInfo);
+
+		if (!GVulkanContext.bInsideFrame)
+		{
+			//GLog->critical("Transient resource sets can only be created between BeginFrame and EndFrame");
+			return nullptr;
+		}
+
+		VulkanResourceLayout* VkLayout = static_cast<VulkanResourceLayout*>(CreateInfo.Layout);
+
+		VulkanThreadPools* Pools = GetThreadPools();
+		if (!Pools)
+			return nullptr;
+
+		std::lock_guard<std::mutex> PoolLock(Pools->Lock);
+		VulkanTransientFrame& Frame = Pools->TransientFrames[GVulkanContext.CurrentFrame];
+
+		if (Frame.UsedSets == Frame.Sets.size())
+		{
+			VulkanResourceSet* NewSet = new VulkanResourceSet;
+			NewSet->Pools = Pools;
+			NewSet->bTransient = true;
+			NewSet->DescriptorSets.resize(1);
+			Frame.Sets.push_back(NewSet);
 		}
 
-		// Define explit external subpass dependencies
-		VkSubpassDependency PreviousDep{};
-		VkSubpassDependency PostDep{};
-		PreviousDep.srcSubpass = VK_SUBPASS_EXTERNAL;
-		PreviousDep.dstSubpass = 0;
-		PostDep.srcSubpass = 0;
-		PostDep.dstSubpass = VK_SUBPASS_EXTERNAL;
+		VulkanResourceSet* Result = Frame.Sets[Frame.UsedSets];
+		CopyUniformBufferBindings(VkLayout->UniformTexelBufferBindings, Result->UniformTexelBufferBindings);
+		CopyUniformBufferBindings(VkLayout->DynamicUniformBufferBindings, Result->DynamicUniformBufferBindings);
 
-		if(HasColorAttachment)
+		if (!AllocateTransientDescriptorSet(Frame, VkLayout->VkLayout, VkLayout->PoolSizes, Result->DescriptorSets[0], Result->DscPool))
 		{
-			PreviousDep.srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; // Wait for the previous color attachment to be written
-			PreviousDep.srcAccessMask |= 0;
-			PreviousDep.dstStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; // Transition image at the color attachment output stage
-			PreviousDep.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT; // Ensure we can write to color attachment
+			//GLog->critical("Failed to create transient vulkan descriptor set");
+			return nullptr;
+		}
+
+		Result->ConstantBuffers.resize(VkLayout->ConstantBuffers.size());
+		for (uint32_t BufferIndex = 0; BufferIndex < VkLayout->ConstantBuffers.size(); BufferIndex++)
+		{
+			ConstantBufferStorage& BufStorage = Result->ConstantBuffers[BufferIndex];
+			BufStorage.Binding = VkLayout->ConstantBuffers[BufferIndex].Binding;
+			BufStorage.Buffers.resize(1);
+
+			if (!AllocateTransientUniforms(Frame, VkLayout->ConstantBuffers[BufferIndex].BufferSize, BufStorage.Buffers[0], BufStorage.Offset, BufStorage.Mapped))
+			{
+				//GLog->critical("Failed to allocate transient uniform buffer");
+				return nullptr;
+			}
+		}
+
+		Frame.UsedSets++;
+
+		return LLRM_CAPTURE_RESULT(Result);
+	}
+
+	void FillImageCreateInfo(VkImageCreateInfo& ImageCreate, AttachmentFormat Format, uint32_t Width, uint32_t Height, uint64_t Flags, uint32_t Layers, uint32_t MipLevels)
+	{
+		ImageCreate = {};
+		ImageCreate.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		ImageCreate.imageType = VK_IMAGE_TYPE_2D;
+		ImageCreate.extent.width = Width;
+		ImageCreate.extent.height = Height;
+		ImageCreate.extent.depth = 1;
+		ImageCreate.mipLevels = MipLevels;
+		ImageCreate.arrayLayers = Layers;
+		ImageCreate.format = AttachmentFormatToVkFormat(Format);
+		ImageCreate.tiling = VK_IMAGE_TILING_OPTIMAL;
+		ImageCreate.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		ImageCreate.samples = VK_SAMPLE_COUNT_1_BIT;
+		ImageCreate.flags = 0;
+		ImageCreate.usage = 0;
+
+		// Set usage based on flags
+		if (Flags & TEXTURE_USAGE_WRITE)
+			ImageCreate.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		if (Flags & TEXTURE_USAGE_SAMPLE)
+			ImageCreate.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+		if (Flags & TEXTURE_USAGE_READ)
+			ImageCreate.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+		// Mip levels are generated by blitting within the image
+		if (MipLevels > 1 && !IsCompressedFormat(Format))
+			ImageCreate.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
-			PostDep.srcStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; // We wrote to the FBO
-			PostDep.srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			PostDep.dstStageMask |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT; // Next render pass needs this fbo to be made available
-			PostDep.dstAccessMask |= VK_ACCESS_SHADER_READ_BIT; // Ensure next pass can read from fbo
+		if(Flags & TEXTURE_USAGE_RT)
+		{
+			if(IsColorFormat(Format))
+				ImageCreate.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			else
+				ImageCreate.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
 		}
+		if (Flags & TEXTURE_USAGE_INPUT_ATTACHMENT)
+			ImageCreate.usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+		if (Flags & TEXTURE_USAGE_STORAGE)
+			ImageCreate.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
 
-		// Add depth buffer dependencies
-		if (HasDepthAttachment)
+		// Transient attachments aren't allowed any usage besides being an attachment
+		if (Flags & TEXTURE_USAGE_TRANSIENT)
 		{
-			PreviousDep.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-			PreviousDep.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-			PreviousDep.srcAccessMask |= VK_ACCESS_SHADER_READ_BIT;
-			PreviousDep.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			ImageCreate.usage &= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+			ImageCreate.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+	}
+
+	MemoryRequirements GetTextureMemoryRequirements(AttachmentFormat Format, uint32_t Width, uint32_t Height, uint64_t Flags, uint32_t Layers)
+	{
+		VkImageCreateInfo ImageCreate;
+		FillImageCreateInfo(ImageCreate, Format, Width, Height, Flags, Layers, 1);
 
-			PostDep.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-			PostDep.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-			PostDep.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-			PostDep.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+		// Create a throwaway image, since the requirements of an image can only be queried once it exists
+		VkImage Image;
+		if (vkCreateImage(GVulkanContext.Device, &ImageCreate, nullptr, &Image) != VK_SUCCESS)
+		{
+			//GLog->critical("Failed to create vulkan image");
+			return {};
+		}
 
-			/*PreviousDep.srcStageMask |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-			PreviousDep.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-			PreviousDep.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		VkMemoryRequirements MemReq{};
+		vkGetImageMemoryRequirements(GVulkanContext.Device, Image, &MemReq);
+		vkDestroyImage(GVulkanContext.Device, Image, nullptr);
 
-			PostDep.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-			PostDep.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-			PostDep.dstStageMask |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-			PostDep.dstAccessMask |= VK_ACCESS_SHADER_READ_BIT;*/
+		return { MemReq.size, MemReq.alignment, MemReq.memoryTypeBits };
+	}
 
-			/*
-			PreviousDep.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-			PreviousDep.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-			PreviousDep.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	DeviceMemory AllocateDeviceMemory(const MemoryRequirements& Requirements)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::AllocateDeviceMemory, Requirements);
 
-			PostDep.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-			PostDep.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-			PostDep.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-			PostDep.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-		*/
+		int32_t MemoryType = FindMemoryType(GVulkanContext.PhysicalDevice, Requirements.MemoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (MemoryType < 0)
+		{
+			//GLog->critical("No device local memory type satisfies the requirements");
+			return nullptr;
 		}
 
-		std::vector<VkSubpassDependency> Deps = { PreviousDep, PostDep };
+		VkMemoryAllocateInfo AllocInfo{};
+		AllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		AllocInfo.allocationSize = Requirements.Size;
+		AllocInfo.memoryTypeIndex = static_cast<uint32_t>(MemoryType);
 
-		// Create the render pass
-		VkRenderPassCreateInfo RenderPassCreateInfo{};
-		RenderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		RenderPassCreateInfo.attachmentCount = static_cast<uint32_t>(AttachmentDescriptions.size());
-		RenderPassCreateInfo.pAttachments = AttachmentDescriptions.data();
-		RenderPassCreateInfo.subpassCount = static_cast<uint32_t>(VkPassDescriptions.size());
-		RenderPassCreateInfo.pSubpasses = VkPassDescriptions.data();
-		RenderPassCreateInfo.dependencyCount = static_cast<uint32_t>(Deps.size());
-		RenderPassCreateInfo.pDependencies = Deps.data();
+		VulkanDeviceMemory* Result = new VulkanDeviceMemory;
+		Result->Size = Requirements.Size;
 
-		if (vkCreateRenderPass(GVulkanContext.Device, &RenderPassCreateInfo, nullptr, &Result->RenderPass) != VK_SUCCESS)
+		if (vkAllocateMemory(GVulkanContext.Device, &AllocInfo, nullptr, &Result->Memory) != VK_SUCCESS)
 		{
-			//GLog->critical("Failed to create Vulkan render pass");
+			//GLog->critical("Failed to allocate device memory");
 
 			delete Result;
 			return nullptr;
@@ -2785,103 +5714,81 @@ namespace llrm
 
 		RECORD_RESOURCE_ALLOC(Result)
 
-		return Result;
+		return LLRM_CAPTURE_RESULT(Result);
 	}
 
-	CommandBuffer CreateCommandBuffer(bool bOneTimeUse)
+	Texture CreateAliasedTexture(AttachmentFormat Format, uint32_t Width, uint32_t Height, uint64_t Flags, uint32_t Layers, DeviceMemory Memory, uint64_t Offset)
 	{
-		// Create a single command buffer
-		VkCommandBufferAllocateInfo CmdBufAllocInfo{};
-		CmdBufAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		CmdBufAllocInfo.commandPool = GVulkanContext.MainCommandPool;
-		CmdBufAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY; // TODO: support secondary command buffers
-		CmdBufAllocInfo.commandBufferCount = 1;
+		LLRM_CAPTURE_CALL(CaptureOp::CreateAliasedTexture, Format, Width, Height, Flags, Layers, Memory, Offset);
 
-		VulkanCommandBuffer* NewCmdBuf = new VulkanCommandBuffer;
-		NewCmdBuf->bOneTimeUse = bOneTimeUse;
+		VulkanDeviceMemory* VkMemory = static_cast<VulkanDeviceMemory*>(Memory);
 
-		if (vkAllocateCommandBuffers(GVulkanContext.Device, &CmdBufAllocInfo, &NewCmdBuf->CmdBuffer) != VK_SUCCESS)
+		VulkanTexture* Result = new VulkanTexture;
+		Result->TextureFormat = Format;
+		Result->Width = Width;
+		Result->Height = Height;
+		Result->TextureFlags = Flags & ~TEXTURE_USAGE_WRITE; // Aliased textures never own a staging buffer
+		Result->Layers = Layers;
+		Result->bOwnsMemory = false;
+
+		VkImageCreateInfo ImageCreate;
+		FillImageCreateInfo(ImageCreate, Format, Width, Height, Flags, Layers, 1);
+
+		if (vkCreateImage(GVulkanContext.Device, &ImageCreate, nullptr, &Result->TextureImage) != VK_SUCCESS)
 		{
-			//GLog->critical("Failed to allocate command buffer");
+			//GLog->critical("Failed to create vulkan image");
 
-			delete NewCmdBuf;
+			delete Result;
 			return nullptr;
 		}
 
-		RECORD_RESOURCE_ALLOC(NewCmdBuf)
-
-		return NewCmdBuf;
-	}
-
-	ResourceSet CreateResourceSet(const ResourceSetCreateInfo& CreateInfo)
-	{
-		VulkanResourceLayout* VkLayout = static_cast<VulkanResourceLayout*>(CreateInfo.Layout);
-
-		VulkanResourceSet* Result = new VulkanResourceSet;
-
-		// Allocate buffers
-		for (const auto& ConstBuf : VkLayout->ConstantBuffers)
-		{
-			ConstantBufferStorage BufStorage;
-			BufStorage.Binding = ConstBuf.Binding;
-
-			for (uint32_t Image = 0; Image < MAX_FRAMES_IN_FLIGHT; Image++)
-			{
-				VkBuffer NewBuffer;
-				VkDeviceMemory NewMemory;
-				bool bSuccess = CreateBuffer(ConstBuf.BufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-					NewBuffer, NewMemory);
+		Result->TextureMemory = VkMemory->Memory;
+		vkBindImageMemory(GVulkanContext.Device, Result->TextureImage, VkMemory->Memory, Offset);
 
-				if (!bSuccess)
-				{
-					//GLog->critical("Failed to allocate uniform buffer for resource set");
-					return nullptr;
-				}
+		// No initial transition, the contents and layout are undefined until the texture's first use
 
-				BufStorage.Buffers.push_back(NewBuffer);
-				BufStorage.Memory.push_back(NewMemory);
-			}
+		RECORD_RESOURCE_ALLOC(Result)
 
-			Result->ConstantBuffers.push_back(BufStorage);
-		}
+		return LLRM_CAPTURE_RESULT(Result);
+	}
 
-		for (uint32_t Image = 0; Image < MAX_FRAMES_IN_FLIGHT; Image++)
-		{
-			// Allocate descriptor sets
-			VkDescriptorSetAllocateInfo SetAllocInfo{};
-			SetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			SetAllocInfo.descriptorPool = GVulkanContext.MainDscPool;
-			SetAllocInfo.descriptorSetCount = 1;
-			SetAllocInfo.pSetLayouts = &VkLayout->VkLayout;
+	void FreeDeviceMemory(DeviceMemory Memory)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::FreeDeviceMemory, Memory);
 
-			VkDescriptorSet NewSet;
-			if (vkAllocateDescriptorSets(GVulkanContext.Device, &SetAllocInfo, &NewSet) != VK_SUCCESS)
-			{
-				//GLog->critical("Failed to create vulkan descriptor set");
-				return nullptr;
-			}
+		WaitDeviceIdle();
+		VulkanDeviceMemory* VkMemory = static_cast<VulkanDeviceMemory*>(Memory);
 
-			Result->DescriptorSets.push_back(NewSet);
-		}
+		vkFreeMemory(GVulkanContext.Device, VkMemory->Memory, nullptr);
 
-		RECORD_RESOURCE_ALLOC(Result);
+		REMOVE_RESOURCE_ALLOC(VkMemory)
 
-		return Result;
+		delete VkMemory;
 	}
 
-	Texture CreateTexture(AttachmentFormat Format, AttachmentUsage InitialUsage, uint32_t Width, uint32_t Height, uint64_t Flags, uint32_t Layers, uint64_t ImageSize, void* Data)
+	Texture CreateTexture(AttachmentFormat Format, AttachmentUsage InitialUsage, uint32_t Width, uint32_t Height, uint64_t Flags, uint32_t Layers, uint64_t ImageSize, void* Data, uint32_t MipLevels)
 	{
 		VulkanTexture* Result = new VulkanTexture;
 
+		if (MipLevels == 0)
+			MipLevels = CalcMipLevels(Width, Height);
+
+		if (ImageSize == 0 && Data)
+			ImageSize = CalcTextureSizeBytes(Format, Width, Height) * Layers;
+
+		LLRM_CAPTURE_CALL(CaptureOp::CreateTexture, Format, InitialUsage, Width, Height, Flags, Layers, CaptureBlob{ Data, ImageSize }, MipLevels);
+
 		Result->TextureFormat = Format;
 		Result->Width = Width;
 		Result->Height = Height;
 		Result->TextureFlags = Flags;
+		Result->Layers = Layers;
+		Result->MipLevels = MipLevels;
 
 		// Create staging buffer and write initial data to it
 		if(Flags & TEXTURE_USAGE_WRITE && Data)
 		{
+			Result->StagingBufferSize = ImageSize;
 			CreateBuffer
 			(
 				ImageSize,
@@ -2901,36 +5808,8 @@ namespace llrm
 			}
 		}
 
-		VkImageCreateInfo ImageCreate{};
-		ImageCreate.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-		ImageCreate.imageType = VK_IMAGE_TYPE_2D;
-		ImageCreate.extent.width = Width;
-		ImageCreate.extent.height = Height;
-		ImageCreate.extent.depth = 1;
-		ImageCreate.mipLevels = 1;
-		ImageCreate.arrayLayers = Layers;
-		ImageCreate.format = AttachmentFormatToVkFormat(Result->TextureFormat);
-		ImageCreate.tiling = VK_IMAGE_TILING_OPTIMAL;
-		ImageCreate.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		ImageCreate.samples = VK_SAMPLE_COUNT_1_BIT;
-		ImageCreate.flags = 0;
-		ImageCreate.usage = 0;
-
-		// Set usage based on flags
-		if (Flags & TEXTURE_USAGE_WRITE)
-			ImageCreate.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-		if (Flags & TEXTURE_USAGE_SAMPLE)
-			ImageCreate.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
-		if (Flags & TEXTURE_USAGE_READ)
-			ImageCreate.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-
-		if(Flags & TEXTURE_USAGE_RT)
-		{
-			if(IsColorFormat(Format))
-				ImageCreate.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-			else
-				ImageCreate.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-		}
+		VkImageCreateInfo ImageCreate;
+		FillImageCreateInfo(ImageCreate, Format, Width, Height, Flags, Layers, MipLevels);
 
 		if (vkCreateImage(GVulkanContext.Device, &ImageCreate, nullptr, &Result->TextureImage) != VK_SUCCESS)
 		{
@@ -2941,10 +5820,17 @@ namespace llrm
 		VkMemoryRequirements MemReq{};
 		vkGetImageMemoryRequirements(GVulkanContext.Device, Result->TextureImage, &MemReq);
 
+		// Prefer lazily allocated memory for transient attachments, so they may never need to be backed by real memory
+		int32_t MemoryType = -1;
+		if (Flags & TEXTURE_USAGE_TRANSIENT)
+			MemoryType = FindMemoryType(GVulkanContext.PhysicalDevice, MemReq.memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+		if (MemoryType < 0)
+			MemoryType = FindMemoryType(GVulkanContext.PhysicalDevice, MemReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
 		VkMemoryAllocateInfo AllocInfo{};
 		AllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 		AllocInfo.allocationSize = MemReq.size;
-		AllocInfo.memoryTypeIndex = FindMemoryType(GVulkanContext.PhysicalDevice, MemReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		AllocInfo.memoryTypeIndex = static_cast<uint32_t>(MemoryType);
 
 		if (vkAllocateMemory(GVulkanContext.Device, &AllocInfo, nullptr, &Result->TextureMemory) != VK_SUCCESS)
 		{
@@ -2959,8 +5845,7 @@ namespace llrm
 		{
 			ImmediateSubmitAndWait([&](CommandBuffer Buf)
 			{
-
-				TransitionTexture(Buf, Result, AttachmentUsage::Undefined, AttachmentUsage::TransferDestination);
+				TransitionTexture(Buf, Result, AttachmentUsage::Undefined, AttachmentUsage::TransferDestination, 0, Layers, 0, 1);
 			});
 
 			ImmediateSubmitAndWait([&](CommandBuffer Buf)
@@ -2993,10 +5878,21 @@ namespace llrm
 				});
 			});
 
-			// Transition image to be shader read optimal
+			// Fill in the rest of the mip chain from the base level and transition the whole image to its initial usage
 			ImmediateSubmitAndWait([&](CommandBuffer Buf)
 			{
-				TransitionTexture(Buf, Result, AttachmentUsage::TransferDestination, InitialUsage);
+				if (IsCompressedFormat(Format))
+				{
+					// Compressed mips can't be generated, they're expected to be uploaded with WriteTexture later.
+					// Only the base level was written, the rest of the chain is still undefined.
+					TransitionTexture(Buf, Result, AttachmentUsage::TransferDestination, InitialUsage, 0, Layers, 0, 1);
+					if (MipLevels > 1)
+						TransitionTexture(Buf, Result, AttachmentUsage::Undefined, InitialUsage, 0, Layers, 1, MIP_LEVELS_REMAINING);
+				}
+				else
+				{
+					GenerateMips(Buf, Result, AttachmentUsage::TransferDestination, InitialUsage);
+				}
 			});
 		}
 		else
@@ -3004,17 +5900,19 @@ namespace llrm
 			// Transition image to be an attachment
 			ImmediateSubmitAndWait([&](CommandBuffer Buf)
 			{
-				TransitionTexture(Buf, Result, AttachmentUsage::Undefined, InitialUsage, 0, Layers);
+				TransitionTexture(Buf, Result, AttachmentUsage::Undefined, InitialUsage, 0, Layers, 0, MipLevels);
 			});
 		}
 
 		RECORD_RESOURCE_ALLOC(Result)
 
-		return Result;
+		return LLRM_CAPTURE_RESULT(Result);
 	}
 
-	TextureView CreateTextureView(Texture Image, uint8_t Flags, TextureViewType ViewType, uint32_t BaseArrayLayer, uint32_t LayerCount)
+	TextureView CreateTextureView(Texture Image, uint8_t Flags, TextureViewType ViewType, uint32_t BaseArrayLayer, uint32_t LayerCount, uint32_t BaseMip, uint32_t MipCount)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateTextureView, Image, Flags, ViewType, BaseArrayLayer, LayerCount, BaseMip, MipCount);
+
 		VulkanTexture* Texture = reinterpret_cast<VulkanTexture*>(Image);
 		VulkanTextureView* VkView = new VulkanTextureView{};
 
@@ -3030,11 +5928,12 @@ namespace llrm
 			ViewInfo.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_COLOR_BIT;
 		if (Flags & DEPTH_ASPECT)
 			ViewInfo.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_DEPTH_BIT;
+		VkView->bDepth = (Flags & DEPTH_ASPECT) != 0;
 		if (Flags & STENCIL_ASPECT)
 			ViewInfo.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
 
-		ViewInfo.subresourceRange.baseMipLevel = 0;
-		ViewInfo.subresourceRange.levelCount = 1;
+		ViewInfo.subresourceRange.baseMipLevel = BaseMip;
+		ViewInfo.subresourceRange.levelCount = MipCount;
 		ViewInfo.subresourceRange.baseArrayLayer = BaseArrayLayer;
 		ViewInfo.subresourceRange.layerCount = LayerCount;
 
@@ -3044,11 +5943,27 @@ namespace llrm
 			return nullptr;
 		}
 
-		return VkView;
+		return LLRM_CAPTURE_RESULT(VkView);
+	}
+
+	void DestroyVkSampler(VulkanSampler* VkSamp)
+	{
+		vkDestroySampler(GVulkanContext.Device, VkSamp->Sampler, nullptr);
+
+		delete VkSamp;
 	}
 
 	Sampler CreateSampler(const SamplerCreateInfo& CreateInfo)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateSampler, CreateInfo);
+
+		CacheKey Key;
+		Key << CreateInfo.MinFilter << CreateInfo.MagFilter << CreateInfo.UWrapMode << CreateInfo.VWrapMode << CreateInfo.WWrapMode
+			<< CreateInfo.MipFilter << CreateInfo.MipLodBias << CreateInfo.MinLod << CreateInfo.MaxLod;
+
+		if (VulkanSampler* Cached = GSamplerCache.Acquire(Key.Bytes))
+			return LLRM_CAPTURE_RESULT(Cached);
+
 		VulkanSampler* Result = new VulkanSampler;
 
 		VkSamplerCreateInfo SamplerInfo{};
@@ -3064,22 +5979,25 @@ namespace llrm
 		SamplerInfo.unnormalizedCoordinates = VK_FALSE;
 		SamplerInfo.compareEnable = VK_FALSE;
 		SamplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-		SamplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		SamplerInfo.mipLodBias = 0.0f;
-		SamplerInfo.minLod = 0.0f;
-		SamplerInfo.maxLod = 0.0f;
+		SamplerInfo.mipmapMode = CreateInfo.MipFilter == FilterType::NEAREST ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		SamplerInfo.mipLodBias = CreateInfo.MipLodBias;
+		SamplerInfo.minLod = CreateInfo.MinLod;
+		SamplerInfo.maxLod = CreateInfo.MaxLod;
 
 		if (vkCreateSampler(GVulkanContext.Device, &SamplerInfo, nullptr, &Result->Sampler) != VK_SUCCESS)
 		{
 			//GLog->critical("Failed to create vulkan sampler");
+			delete Result;
 			return nullptr;
 		}
 
-		return Result;
+		return LLRM_CAPTURE_RESULT(GSamplerCache.Insert(Key.Bytes, Result, &DestroyVkSampler));
 	}
 
 	FrameBuffer CreateFrameBuffer(const FrameBufferCreateInfo& CreateInfo)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateFrameBuffer, CreateInfo);
+
 		VulkanRenderGraph* VkRenderGraph = static_cast<VulkanRenderGraph*>(CreateInfo.Target);
 
 		VulkanFrameBuffer* Result = new VulkanFrameBuffer;
@@ -3099,11 +6017,13 @@ namespace llrm
 
 		RECORD_RESOURCE_ALLOC(Result)
 
-		return Result;
+		return LLRM_CAPTURE_RESULT(Result);
 	}
 
 	VertexBuffer CreateVertexBuffer(uint64_t Size, const void* Data)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateVertexBuffer, Size, CaptureBlob{ Data, Size });
+
 		VulkanVertexBuffer* VulkanVbo = new VulkanVertexBuffer;
 
 		// Create staging buffer. This needs the transfer source bit since we will be transferring it to the device memory.
@@ -3138,10 +6058,13 @@ namespace llrm
 		AllocInfo.commandPool = GVulkanContext.MainCommandPool;
 		AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-		if (vkAllocateCommandBuffers(GVulkanContext.Device, &AllocInfo, &VulkanVbo->VertexStagingCommandBuffer) != VK_SUCCESS)
 		{
-			//GLog->critical("Failed to create staging command buffer");
-			return nullptr;
+			std::lock_guard<std::mutex> PoolLock(GMainCommandPoolMutex);
+			if (vkAllocateCommandBuffers(GVulkanContext.Device, &AllocInfo, &VulkanVbo->VertexStagingCommandBuffer) != VK_SUCCESS)
+			{
+				//GLog->critical("Failed to create staging command buffer");
+				return nullptr;
+			}
 		}
 
 		if(Data)
@@ -3151,11 +6074,13 @@ namespace llrm
 
 		RECORD_RESOURCE_ALLOC(VulkanVbo)
 
-		return VulkanVbo;
+		return LLRM_CAPTURE_RESULT(VulkanVbo);
 	}
 
 	IndexBuffer CreateIndexBuffer(uint64_t Size, const void* Data)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateIndexBuffer, Size, CaptureBlob{ Data, Size });
+
 		VulkanIndexBuffer* VulkanIbo = new VulkanIndexBuffer;
 
 		CreateBuffer(Size,
@@ -3188,10 +6113,13 @@ namespace llrm
 		AllocInfo.commandPool = GVulkanContext.MainCommandPool;
 		AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-		if(vkAllocateCommandBuffers(GVulkanContext.Device, &AllocInfo, &VulkanIbo->IndexStagingCommandBuffer) != VK_SUCCESS)
 		{
-			//GLog->critical("Failed to create staging command buffer");
-			return nullptr;
+			std::lock_guard<std::mutex> PoolLock(GMainCommandPoolMutex);
+			if(vkAllocateCommandBuffers(GVulkanContext.Device, &AllocInfo, &VulkanIbo->IndexStagingCommandBuffer) != VK_SUCCESS)
+			{
+				//GLog->critical("Failed to create staging command buffer");
+				return nullptr;
+			}
 		}
 
 		if (Data)
@@ -3200,49 +6128,224 @@ namespace llrm
 		}
 
 		RECORD_RESOURCE_ALLOC(VulkanIbo)
-		return VulkanIbo;
+		return LLRM_CAPTURE_RESULT(VulkanIbo);
+	}
+
+	StorageBuffer CreateStorageBuffer(uint64_t Size, const void* Data, uint64_t BufferFlags)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateStorageBuffer, Size, CaptureBlob{ Data, Size }, BufferFlags);
+
+		VulkanStorageBuffer* VulkanSbo = new VulkanStorageBuffer;
+		VulkanSbo->Size = Size;
+		VulkanSbo->Flags = (BufferFlags & BUFFER_PER_FRAME) ? (BufferFlags | BUFFER_HOST_WRITE) : BufferFlags;
+
+		// Storage buffers can also be viewed as texel buffers, or bound as dynamic uniform buffers
+		const VkBufferUsageFlags DescriptorUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+			VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+
+		if (VulkanSbo->Flags & BUFFER_HOST_WRITE)
+		{
+			const uint64_t Alignment = GVulkanContext.BufferSliceAlignment;
+			uint32_t Slices = (VulkanSbo->Flags & BUFFER_PER_FRAME) ? GVulkanContext.FramesInFlight : 1;
+			VulkanSbo->SliceSize = (Size + Alignment - 1) / Alignment * Alignment;
+
+			bool bSuccess = CreateBuffer(VulkanSbo->SliceSize * Slices,
+				DescriptorUsage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+				VulkanSbo->DeviceStorageBuffer, VulkanSbo->DeviceStorageBufferMemory
+			);
+
+			if (!bSuccess || vkMapMemory(GVulkanContext.Device, VulkanSbo->DeviceStorageBufferMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&VulkanSbo->Mapped)) != VK_SUCCESS)
+			{
+				//GLog->critical("Failed to create host written storage buffer");
+				delete VulkanSbo;
+				return nullptr;
+			}
+
+			if (Data)
+			{
+				UploadStorageBufferData(VulkanSbo, Data, Size);
+			}
+
+			RECORD_RESOURCE_ALLOC(VulkanSbo)
+			return LLRM_CAPTURE_RESULT(VulkanSbo);
+		}
+
+		CreateBuffer(Size,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+			VulkanSbo->StagingStorageBuffer, VulkanSbo->StagingStorageBufferMemory
+		);
+
+		// The indirect bit lets compute shaders generate their own dispatch arguments
+		CreateBuffer(Size,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | DescriptorUsage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VulkanSbo->DeviceStorageBuffer, VulkanSbo->DeviceStorageBufferMemory
+		);
+
+		VkFenceCreateInfo FenceCreate{};
+		FenceCreate.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		FenceCreate.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		if (vkCreateFence(GVulkanContext.Device, &FenceCreate, nullptr, &VulkanSbo->StorageStagingCompleteFence) != VK_SUCCESS)
+		{
+			//GLog->critical("Failed to create staging fence");
+			return nullptr;
+		}
+
+		VkCommandBufferAllocateInfo AllocInfo{};
+		AllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		AllocInfo.commandBufferCount = 1;
+		AllocInfo.commandPool = GVulkanContext.MainCommandPool;
+		AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+		{
+			std::lock_guard<std::mutex> PoolLock(GMainCommandPoolMutex);
+			if (vkAllocateCommandBuffers(GVulkanContext.Device, &AllocInfo, &VulkanSbo->StorageStagingCommandBuffer) != VK_SUCCESS)
+			{
+				//GLog->critical("Failed to create staging command buffer");
+				return nullptr;
+			}
+		}
+
+		if (Data)
+		{
+			UploadStorageBufferData(VulkanSbo, Data, Size);
+		}
+
+		RECORD_RESOURCE_ALLOC(VulkanSbo)
+		return LLRM_CAPTURE_RESULT(VulkanSbo);
+	}
+
+	TexelBufferView CreateTexelBufferView(StorageBuffer Buffer, AttachmentFormat Format, uint64_t Offset, uint64_t Range)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::CreateTexelBufferView, Buffer, Format, Offset, Range);
+
+		VulkanStorageBuffer* VulkanSbo = static_cast<VulkanStorageBuffer*>(Buffer);
+
+		// Each slice of a per frame buffer gets its own view, at the same place within the slice
+		uint32_t Slices = (VulkanSbo->Flags & BUFFER_PER_FRAME) ? GVulkanContext.FramesInFlight : 1;
+
+		VkBufferViewCreateInfo ViewInfo{};
+		ViewInfo.sType = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO;
+		ViewInfo.buffer = VulkanSbo->DeviceStorageBuffer;
+		ViewInfo.format = AttachmentFormatToVkFormat(Format);
+		ViewInfo.range = std::min(Range, VulkanSbo->Size - Offset);
+
+		VulkanTexelBufferView* Result = new VulkanTexelBufferView;
+		Result->Views.resize(Slices, VK_NULL_HANDLE);
+
+		for (uint32_t Slice = 0; Slice < Slices; Slice++)
+		{
+			ViewInfo.offset = GetBufferSliceOffset(VulkanSbo, Slice) + Offset;
+			if (vkCreateBufferView(GVulkanContext.Device, &ViewInfo, nullptr, &Result->Views[Slice]) != VK_SUCCESS)
+			{
+				//GLog->critical("Failed to create texel buffer view");
+				for (VkBufferView View : Result->Views)
+					vkDestroyBufferView(GVulkanContext.Device, View, nullptr);
+				delete Result;
+				return nullptr;
+			}
+		}
+
+		RECORD_RESOURCE_ALLOC(Result)
+		return LLRM_CAPTURE_RESULT(Result);
 	}
 
 	void DestroyVertexBuffer(VertexBuffer VertexBuffer)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyVertexBuffer, VertexBuffer);
+
 		VulkanVertexBuffer* VulkanVbo = static_cast<VulkanVertexBuffer*>(VertexBuffer);
 		REMOVE_RESOURCE_ALLOC(VulkanVbo)
 
-		vkDeviceWaitIdle(GVulkanContext.Device);
+		WaitDeviceIdle();
 
 		vkFreeMemory(GVulkanContext.Device, VulkanVbo->DeviceVertexBufferMemory, nullptr);
 		vkFreeMemory(GVulkanContext.Device, VulkanVbo->StagingVertexBufferMemory, nullptr);
 		vkDestroyBuffer(GVulkanContext.Device, VulkanVbo->StagingVertexBuffer, nullptr);
 		vkDestroyBuffer(GVulkanContext.Device, VulkanVbo->DeviceVertexBuffer, nullptr);
 		vkDestroyFence(GVulkanContext.Device, VulkanVbo->VertexStagingCompleteFence, nullptr);
-		vkFreeCommandBuffers(GVulkanContext.Device, GVulkanContext.MainCommandPool, 1, &VulkanVbo->VertexStagingCommandBuffer);
+		{
+			std::lock_guard<std::mutex> PoolLock(GMainCommandPoolMutex);
+			vkFreeCommandBuffers(GVulkanContext.Device, GVulkanContext.MainCommandPool, 1, &VulkanVbo->VertexStagingCommandBuffer);
+		}
 
 		delete VulkanVbo;
 	}
 
 	void DestroyIndexBuffer(IndexBuffer IndexBuffer)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyIndexBuffer, IndexBuffer);
+
 		VulkanIndexBuffer* VulkanIbo = static_cast<VulkanIndexBuffer*>(IndexBuffer);
 		REMOVE_RESOURCE_ALLOC(VulkanVbo)
 
-		vkDeviceWaitIdle(GVulkanContext.Device);
+		WaitDeviceIdle();
 
 		vkFreeMemory(GVulkanContext.Device, VulkanIbo->DeviceIndexBufferMemory, nullptr);
 		vkFreeMemory(GVulkanContext.Device, VulkanIbo->StagingIndexBufferMemory, nullptr);
 		vkDestroyBuffer(GVulkanContext.Device, VulkanIbo->StagingIndexBuffer, nullptr);
 		vkDestroyBuffer(GVulkanContext.Device, VulkanIbo->DeviceIndexBuffer, nullptr);
 		vkDestroyFence(GVulkanContext.Device, VulkanIbo->IndexStagingCompleteFence, nullptr);
-		vkFreeCommandBuffers(GVulkanContext.Device, GVulkanContext.MainCommandPool, 1, &VulkanIbo->IndexStagingCommandBuffer);
+		{
+			std::lock_guard<std::mutex> PoolLock(GMainCommandPoolMutex);
+			vkFreeCommandBuffers(GVulkanContext.Device, GVulkanContext.MainCommandPool, 1, &VulkanIbo->IndexStagingCommandBuffer);
+		}
 
 		delete VulkanIbo;
 	}
 
+	void DestroyStorageBuffer(StorageBuffer StorageBuffer)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyStorageBuffer, StorageBuffer);
+
+		VulkanStorageBuffer* VulkanSbo = static_cast<VulkanStorageBuffer*>(StorageBuffer);
+		REMOVE_RESOURCE_ALLOC(VulkanSbo)
+
+		WaitDeviceIdle();
+
+		if (VulkanSbo->Mapped)
+			vkUnmapMemory(GVulkanContext.Device, VulkanSbo->DeviceStorageBufferMemory);
+
+		vkFreeMemory(GVulkanContext.Device, VulkanSbo->DeviceStorageBufferMemory, nullptr);
+		vkFreeMemory(GVulkanContext.Device, VulkanSbo->StagingStorageBufferMemory, nullptr);
+		vkDestroyBuffer(GVulkanContext.Device, VulkanSbo->StagingStorageBuffer, nullptr);
+		vkDestroyBuffer(GVulkanContext.Device, VulkanSbo->DeviceStorageBuffer, nullptr);
+		vkDestroyFence(GVulkanContext.Device, VulkanSbo->StorageStagingCompleteFence, nullptr);
+		if (VulkanSbo->StorageStagingCommandBuffer)
+		{
+			std::lock_guard<std::mutex> PoolLock(GMainCommandPoolMutex);
+			vkFreeCommandBuffers(GVulkanContext.Device, GVulkanContext.MainCommandPool, 1, &VulkanSbo->StorageStagingCommandBuffer);
+		}
+
+		delete VulkanSbo;
+	}
+
+	void DestroyTexelBufferView(TexelBufferView View)
+	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyTexelBufferView, View);
+
+		VulkanTexelBufferView* VkView = static_cast<VulkanTexelBufferView*>(View);
+		REMOVE_RESOURCE_ALLOC(VkView)
+
+		WaitDeviceIdle();
+
+		for (VkBufferView BufferView : VkView->Views)
+			vkDestroyBufferView(GVulkanContext.Device, BufferView, nullptr);
+
+		delete VkView;
+	}
+
 	void DestroyFrameBuffer(FrameBuffer FrameBuffer)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyFrameBuffer, FrameBuffer);
+
 		VulkanFrameBuffer* VkFbo = static_cast<VulkanFrameBuffer*>(FrameBuffer);
 		REMOVE_RESOURCE_ALLOC(VkFbo)
 
-		vkDeviceWaitIdle(GVulkanContext.Device);
+		WaitDeviceIdle();
 
 		vkDestroyFramebuffer(GVulkanContext.Device, VkFbo->VulkanFbo, nullptr);
 
@@ -3251,54 +6354,52 @@ namespace llrm
 
 	void DestroyCommandBuffer(CommandBuffer CmdBuffer)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyCommandBuffer, CmdBuffer);
+
 		VulkanCommandBuffer* VkCmdBuffer = static_cast<VulkanCommandBuffer*>(CmdBuffer);
 		REMOVE_RESOURCE_ALLOC(VkCmdBuffer)
 
-		vkQueueWaitIdle(GVulkanContext.GraphicsQueue);
-		vkFreeCommandBuffers(GVulkanContext.Device, GVulkanContext.MainCommandPool, 1, &VkCmdBuffer->CmdBuffer);
+		WaitQueueIdle();
+
+		// Only the thread that owns the pool may free into it, other threads leave the command buffer for the owner to free
+		if (VkCmdBuffer->Pools->Owner == std::this_thread::get_id())
+			vkFreeCommandBuffers(GVulkanContext.Device, VkCmdBuffer->Pools->CommandPool, 1, &VkCmdBuffer->CmdBuffer);
+		else
+		{
+			std::lock_guard<std::mutex> PoolLock(VkCmdBuffer->Pools->Lock);
+			VkCmdBuffer->Pools->PendingCommandBufferFrees.push_back(VkCmdBuffer->CmdBuffer);
+		}
 
 		delete VkCmdBuffer;
 	}
 
 	void DestroyRenderGraph(RenderGraph Graph)
 	{
-		VulkanRenderGraph* VkRenderGraph = static_cast<VulkanRenderGraph*>(Graph);
-
-		vkQueueWaitIdle(GVulkanContext.GraphicsQueue);
-		vkDestroyRenderPass(GVulkanContext.Device, VkRenderGraph->RenderPass, nullptr);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyRenderGraph, Graph);
 
-		REMOVE_RESOURCE_ALLOC(VkRenderGraph)
+		VulkanRenderGraph* VkRenderGraph = static_cast<VulkanRenderGraph*>(Graph);
 
-		delete VkRenderGraph;
+		if (GRenderGraphCache.Release(VkRenderGraph))
+			DestroyVkRenderGraph(VkRenderGraph);
 	}
 
 	void DestroyPipeline(Pipeline Pipeline)
 	{
-		VulkanPipeline* VkPipeline = static_cast<VulkanPipeline*>(Pipeline);
-
-		vkQueueWaitIdle(GVulkanContext.GraphicsQueue);
-
-		// Destroy pipeline layout
-		vkDestroyPipelineLayout(GVulkanContext.Device, VkPipeline->PipelineLayout, nullptr);
-
-		// Destroy pipeline
-		vkDestroyPipeline(GVulkanContext.Device, VkPipeline->Pipeline, nullptr);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyPipeline, Pipeline);
 
-		REMOVE_RESOURCE_ALLOC(VkPipeline)
+		VulkanPipeline* VkPipeline = static_cast<VulkanPipeline*>(Pipeline);
 
-		delete VkPipeline;
+		if (GPipelineCache.Release(VkPipeline))
+			DestroyVkPipeline(VkPipeline);
 	}
 
 	void DestroyProgram(ShaderProgram Shader)
 	{
-		VulkanShader* VkShader = static_cast<VulkanShader*>(Shader);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyProgram, Shader);
 
-		vkQueueWaitIdle(GVulkanContext.GraphicsQueue);
+		VulkanShader* VkShader = static_cast<VulkanShader*>(Shader);
 
-		if (VkShader->bHasVertexShader)
-			vkDestroyShaderModule(GVulkanContext.Device, VkShader->VertexModule, nullptr);
-		if (VkShader->bHasFragmentShader)
-			vkDestroyShaderModule(GVulkanContext.Device, VkShader->FragmentModule, nullptr);
+		ReleaseShaderModules(VkShader);
 
 		REMOVE_RESOURCE_ALLOC(VkShader)
 
@@ -3307,11 +6408,14 @@ namespace llrm
 
 	void DestroyTexture(Texture Image)
 	{
-		vkDeviceWaitIdle(GVulkanContext.Device);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyTexture, Image);
+
+		WaitDeviceIdle();
 		VulkanTexture* VkTex = static_cast<VulkanTexture*>(Image);
 
-		vkFreeMemory(GVulkanContext.Device, VkTex->TextureMemory, nullptr);
 		vkDestroyImage(GVulkanContext.Device, VkTex->TextureImage, nullptr);
+		if (VkTex->bOwnsMemory)
+			vkFreeMemory(GVulkanContext.Device, VkTex->TextureMemory, nullptr);
 
 		if(VkTex->TextureFlags & TEXTURE_USAGE_WRITE)
 		{
@@ -3326,7 +6430,9 @@ namespace llrm
 
 	void DestroyTextureView(TextureView ImageView)
 	{
-		vkDeviceWaitIdle(GVulkanContext.Device);
+		LLRM_CAPTURE_CALL(CaptureOp::DestroyTextureView, ImageView);
+
+		WaitDeviceIdle();
 		VulkanTextureView* VkTex = static_cast<VulkanTextureView*>(ImageView);
 
 		vkDestroyImageView(GVulkanContext.Device, VkTex->ImageView, nullptr);
@@ -3334,9 +6440,12 @@ namespace llrm
 
 	void DestroySampler(Sampler Samp)
 	{
+		LLRM_CAPTURE_CALL(CaptureOp::DestroySampler, Samp);
+
 		VulkanSampler* VkSamp = static_cast<VulkanSampler*>(Samp);
 
-		vkDestroySampler(GVulkanContext.Device, VkSamp->Sampler, nullptr);
+		if (GSamplerCache.Release(VkSamp))
+			DestroyVkSampler(VkSamp);
 	}
 }
 
@@ -2,6 +2,10 @@
 
 #include "llrm.h"
 #include "vulkan/vulkan.h"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 
 // Helper to record stack traces of allocated resources to track down resource that need to be freed
@@ -14,20 +18,16 @@ std::unordered_map<void*, boost::stacktrace::stacktrace> AllocatedTraces;
 #define REMOVE_RESOURCE_ALLOC(Res) // Do nothing
 #endif
 
-#define MAX_FRAMES_IN_FLIGHT 3
-
-// Frame in flight
+// Swap chain synchronization for a frame in flight. The fence that tracks the frame belongs to the context, since it's shared by every window.
 struct VulkanFrame
 {
 	VkSemaphore ImageAvailableSemaphore;
 	VkSemaphore RenderingFinishedSemaphore;
-	VkFence InFlightFence;
 
-	VulkanFrame(VkSemaphore ImageAvailableSem, VkSemaphore RenderingFinishedSem, VkFence FlightFence)
+	VulkanFrame(VkSemaphore ImageAvailableSem, VkSemaphore RenderingFinishedSem)
 	{
 		this->ImageAvailableSemaphore = ImageAvailableSem;
 		this->RenderingFinishedSemaphore = RenderingFinishedSem;
-		this->InFlightFence = FlightFence;
 	}
 };
 
@@ -41,6 +41,7 @@ struct VulkanTexture
 	// This staging buffer is used if the texture can be uploaded to from the CPU
 	VkBuffer StagingBuffer{};
 	VkDeviceMemory StagingBufferMemory{};
+	uint64_t StagingBufferSize{};
 
 	VkDeviceMemory TextureMemory{};
 	VkImage TextureImage{};
@@ -49,11 +50,23 @@ struct VulkanTexture
 
 	llrm::AttachmentFormat TextureFormat{};
 	uint32_t Width = 0, Height = 0;
+	uint32_t Layers = 1;
+	uint32_t MipLevels = 1;
+
+	// False when the texture is placed in memory shared with other textures
+	bool bOwnsMemory = true;
+};
+
+struct VulkanDeviceMemory
+{
+	VkDeviceMemory Memory{};
+	uint64_t Size = 0;
 };
 
 struct VulkanTextureView
 {
 	VkImageView ImageView{};
+	bool bDepth = false; // Whether the view covers the depth aspect, which decides the layout it's read in as an input attachment
 };
 
 struct VulkanSwapChain
@@ -63,13 +76,14 @@ struct VulkanSwapChain
 	VkPresentModeKHR PresentMode;
 	VkExtent2D SwapChainExtent;
 
+	// Kept so the same present mode is selected when the swap chain is recreated
+	std::vector<llrm::PresentMode> PresentModePreferences;
+
 	std::vector<VulkanTexture>	   Images;
 	std::vector<VulkanTextureView> ImageViews;
 
-	int32_t CurrentFrame = 0;
-
 	/**
-	 * Keep track of frames in flight for this swap chain.
+	 * Keep track of frames in flight for this swap chain, indexed by the context's current frame.
 	 */
 	std::vector<VulkanFrame> FramesInFlight;
 
@@ -78,8 +92,6 @@ struct VulkanSwapChain
 	// The image index acquired for the current frame
 	uint32_t AcquiredImageIndex;
 
-	bool bInsideFrame = false;
-
 };
 
 struct VulkanSurface
@@ -99,21 +111,37 @@ struct VulkanContext
 	 */
 	VkPhysicalDevice PhysicalDevice;
 
+	/**
+	 * Every device that was considered when picking the physical device, and the index of the picked one.
+	 */
+	std::vector<llrm::DeviceInfo> DeviceCandidates;
+	int32_t SelectedDevice = -1;
+
 	/**
 	 * The logical device created for a particular physical device.
 	 */
 	VkDevice Device;
 
 	/**
-	 * The primary pool for allocating command buffers.
+	 * The pool that the staging command buffers of vertex, index and storage buffers are allocated from. Other command buffers come from the pools of the thread that created them.
 	 */
 	VkCommandPool MainCommandPool;
 
 	/**
-	 * The primary pool for allocating descriptor sets.
+	 * The descriptor pool given to ImGui. Resource sets are allocated from the pools of the thread that created them.
 	 */
 	VkDescriptorPool MainDscPool;
 
+	/**
+	 * The alignment of uniform buffer offsets, which transient uniform buffers are sub-allocated with.
+	 */
+	uint64_t UniformBufferAlignment = 256;
+
+	/**
+	 * The alignment of the slices of per frame storage buffers, which satisfies every kind of buffer descriptor offset.
+	 */
+	uint64_t BufferSliceAlignment = 256;
+
 	/**
 	 * The queue family index of the graphics queue.
 	 */
@@ -134,10 +162,60 @@ struct VulkanContext
 	 */
 	VkQueue PresentQueue;
 
-	// Resources for current frame
-	VulkanSwapChain* CurrentSwapChain{};
-	GLFWwindow* CurrentWindow{};
-	llrm::Surface CurrentSurface{};
+	/**
+	 * The optional device features that were enabled when creating the logical device.
+	 */
+	VkPhysicalDeviceFeatures EnabledFeatures{};
+
+	/**
+	 * Whether VK_KHR_dynamic_rendering is enabled, along with its command entry points.
+	 */
+	bool bDynamicRendering = false;
+	PFN_vkCmdBeginRenderingKHR CmdBeginRendering = nullptr;
+	PFN_vkCmdEndRenderingKHR CmdEndRendering = nullptr;
+
+	/**
+	 * Whether VK_EXT_conditional_rendering is enabled, along with its command entry points.
+	 */
+	bool bConditionalRendering = false;
+	PFN_vkCmdBeginConditionalRenderingEXT CmdBeginConditionalRendering = nullptr;
+	PFN_vkCmdEndConditionalRenderingEXT CmdEndConditionalRendering = nullptr;
+
+	/**
+	 * Whether VK_KHR_synchronization2 is enabled, along with its command entry points.
+	 */
+	bool bSynchronization2 = false;
+	PFN_vkCmdPipelineBarrier2KHR CmdPipelineBarrier2 = nullptr;
+
+	/**
+	 * VK_EXT_debug_utils entry points for naming objects and labeling command buffers. Only loaded with LLRM_DEBUG_LABELS, and null when
+	 * neither the loader nor a layer provides the extension.
+	 */
+	PFN_vkSetDebugUtilsObjectNameEXT SetDebugUtilsObjectName = nullptr;
+	PFN_vkCmdBeginDebugUtilsLabelEXT CmdBeginDebugUtilsLabel = nullptr;
+	PFN_vkCmdEndDebugUtilsLabelEXT CmdEndDebugUtilsLabel = nullptr;
+
+	/**
+	 * Whether the context was created without a window system. There are no surfaces or swap chains, and the present queue is the graphics queue.
+	 */
+	bool bHeadless = false;
+
+	/**
+	 * The number of frames that can be recorded while previous frames are still executing.
+	 */
+	uint32_t FramesInFlight = 3;
+
+	/**
+	 * Fences signaled when each frame in flight has finished executing, whether it rendered to swap chains or offscreen.
+	 */
+	std::vector<VkFence> FrameFences;
+
+	// The frame in flight being recorded, which selects the copy of each resource set that's bound and updated
+	uint32_t CurrentFrame = 0;
+	bool bInsideFrame = false;
+
+	// The frame started by the single window or offscreen BeginFrame, which EndFrame submits
+	std::vector<llrm::SwapChainFrame> BegunFrames;
 
 	/**
 	 * Extensions that are used by the Vulkan instance.
@@ -161,22 +239,34 @@ struct VulkanContext
 
 };
 
+// Shared by every program with a stage of identical SPIR-V
+struct VulkanShaderModule
+{
+	VkShaderModule Module;
+};
+
 struct VulkanShader
 {
-	bool bHasVertexShader;
-	bool bHasFragmentShader;
-	VkShaderModule VertexModule;
-	VkShaderModule FragmentModule;
+	uint64_t Id = 0; // Unique for the lifetime of the process, so pipeline cache keys never match a destroyed program whose address was reused
+	bool bHasVertexShader = false;
+	bool bHasFragmentShader = false;
+	bool bHasComputeShader = false;
+	bool bModulesReleased = false; // Pipelines can't be created from the program anymore, unless an identical one is still cached
+	VulkanShaderModule* VertexModule{};
+	VulkanShaderModule* FragmentModule{};
+	VulkanShaderModule* ComputeModule{};
 };
 
 struct VulkanPipeline
 {
 	VkPipelineLayout PipelineLayout;
 	VkPipeline Pipeline;
+	VkPipelineBindPoint BindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 };
 
 struct VulkanRenderGraph
 {
+	uint64_t Id = 0;
 	VkRenderPass RenderPass;
 };
 
@@ -204,6 +294,46 @@ struct VulkanIndexBuffer
 	VkFence IndexStagingCompleteFence;
 };
 
+struct VulkanStorageBuffer
+{
+	VkBuffer DeviceStorageBuffer{};
+	VkDeviceMemory DeviceStorageBufferMemory{};
+
+	VkBuffer StagingStorageBuffer{};
+	VkDeviceMemory StagingStorageBufferMemory{};
+
+	VkCommandBuffer StorageStagingCommandBuffer{};
+	VkFence StorageStagingCompleteFence{};
+
+	uint64_t Size;
+
+	// BUFFER_HOST_WRITE buffers keep the device buffer mapped and have no staging resources
+	uint64_t Flags = 0;
+	uint8_t* Mapped = nullptr;
+	uint64_t SliceSize = 0; // BUFFER_PER_FRAME buffers hold one slice per frame in flight, each aligned for descriptor offsets
+};
+
+/*
+ * Holds Count queries per frame in flight, frame F using queries [F * Count, (F + 1) * Count).
+ * Resolved results are one uint32_t per query in host visible memory, which also feeds conditional rendering.
+ */
+struct VulkanQueryPool
+{
+	VkQueryPool Pool{};
+	uint32_t Count = 0;
+
+	VkBuffer ResultBuffer{};
+	VkDeviceMemory ResultMemory{};
+	uint32_t* Results = nullptr;
+
+	std::vector<std::vector<bool>> Issued; // The queries begun in each frame in flight since its queries were last reset
+};
+
+struct VulkanTexelBufferView
+{
+	std::vector<VkBufferView> Views; // One per slice of a BUFFER_PER_FRAME buffer, otherwise a single view
+};
+
 struct VulkanFrameBuffer
 {
 	uint32_t AttachmentWidth;
@@ -218,8 +348,61 @@ struct VulkanFrameBuffer
 	VkRenderPass                                  CreatedFor;
 };
 
+struct VulkanUniformBlock
+{
+	VkBuffer Buffer{};
+	VkDeviceMemory Memory{};
+	uint8_t* Mapped = nullptr; // Stays mapped for the lifetime of the block
+	uint64_t Size = 0;
+};
+
+struct VulkanResourceSet;
+
+/*
+ * Descriptor sets and uniform memory handed out by transient resource sets during one frame in flight.
+ * Everything is reset at once when the frame is begun again, so allocating only bumps a cursor.
+ */
+struct VulkanTransientFrame
+{
+	// Created without VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, since their sets are only ever released by resetting the pool
+	std::vector<VkDescriptorPool> DscPools;
+	uint32_t CurrentDscPool = 0;
+
+	std::vector<VulkanUniformBlock> UniformBlocks;
+	uint32_t CurrentUniformBlock = 0;
+	uint64_t UniformOffset = 0;
+
+	// Recycled every frame, so creating a transient resource set doesn't allocate once the frame has been used before
+	std::vector<VulkanResourceSet*> Sets;
+	uint32_t UsedSets = 0;
+};
+
+/*
+ * Pools owned by a single thread. Command and descriptor pools can't be used from several threads at once,
+ * so every thread that creates command buffers or resource sets gets its own. They're destroyed along with the context.
+ */
+struct VulkanThreadPools
+{
+	std::thread::id Owner;
+	VkCommandPool CommandPool{};
+
+	// Persistent resource sets are allocated from these. Another pool is added whenever the existing ones are exhausted or too fragmented.
+	std::vector<VkDescriptorPool> DscPools;
+	uint32_t NextDscPoolSize = 0;
+
+	// Indexed by the frame in flight
+	std::vector<VulkanTransientFrame> TransientFrames;
+
+	// Guards the descriptor pools and the pending frees, which other threads touch when they destroy resources created by the owner
+	std::mutex Lock;
+
+	// Command buffers destroyed by other threads. Only the owner may use the command pool, so it frees them the next time it allocates.
+	std::vector<VkCommandBuffer> PendingCommandBufferFrees;
+};
+
 struct VulkanCommandBuffer
 {
+	VulkanThreadPools* Pools{};
 	VulkanSwapChain* CurrentSwapChain{};
 	VulkanFrameBuffer* CurrentFbo{};
 	VkCommandBuffer CmdBuffer;
@@ -227,15 +410,28 @@ struct VulkanCommandBuffer
 	bool bOneTimeUse = false; // Whether this command buffer is intended to only be used once
 	bool bTargetSwapChain = false; // Whether this command buffer targets the swap chain (i.e. references a frame with vkBeginRenderPass)
 
+	// Whether the current render graph was begun with a RenderingInfo, and the height of its render area for flipping the viewport
+	bool bDynamicRendering = false;
+	uint32_t RenderingHeight = 0;
+
 	VulkanPipeline* BoundPipeline = nullptr;
 };
 
 struct VulkanResourceLayout
 {
+	uint64_t Id = 0;
 	VkDescriptorSetLayout VkLayout;
 	std::vector<llrm::ConstantBufferDescription> ConstantBuffers;
 	std::vector<llrm::TextureSamplerDescription> TextureBindings;
 	std::vector<llrm::TextureSamplerDescription> SamplerBindings;
+	std::vector<llrm::TextureSamplerDescription> InputAttachmentBindings;
+	std::vector<llrm::StorageDescription> StorageBufferBindings;
+	std::vector<llrm::StorageDescription> StorageImageBindings;
+	std::vector<llrm::StorageDescription> UniformTexelBufferBindings;
+	std::vector<llrm::StorageDescription> StorageTexelBufferBindings;
+	std::vector<llrm::StorageDescription> DynamicUniformBufferBindings;
+	std::vector<llrm::StorageDescription> DynamicStorageBufferBindings;
+	std::vector<VkDescriptorPoolSize> PoolSizes; // Descriptors of each type one set needs
 };
 
 struct ConstantBufferStorage
@@ -243,10 +439,120 @@ struct ConstantBufferStorage
 	uint32_t Binding;
 	std::vector<VkBuffer> Buffers;
 	std::vector<VkDeviceMemory> Memory;
+
+	// Transient resource sets place their single buffer in a uniform block of the frame instead of owning it
+	uint64_t Offset = 0;
+	uint8_t* Mapped = nullptr;
 };
 
 struct VulkanResourceSet
 {
+	VulkanThreadPools* Pools{};
+	VkDescriptorPool DscPool{}; // The pool the descriptor sets were allocated from
+
+	// Tell uniform and storage flavours of texel and dynamic buffer bindings apart. Copied from the layout, which may be destroyed before the set
+	std::vector<uint32_t> UniformTexelBufferBindings;
+	std::vector<uint32_t> DynamicUniformBufferBindings;
 	std::vector<ConstantBufferStorage> ConstantBuffers;
+
+	// One per frame in flight, except for transient resource sets which only have one for the frame they were created in
 	std::vector<VkDescriptorSet> DescriptorSets;
-};
\ No newline at end of file
+	bool bTransient = false;
+};
+
+/*
+ * Shares objects created from identical descriptions. The key holds the bytes of every field of the description,
+ * each creation takes a reference and the object is only destroyed once every reference has been released.
+ */
+template<typename T>
+struct VulkanObjectCache
+{
+	struct Entry
+	{
+		T* Object;
+		uint32_t References;
+	};
+
+	std::mutex Lock;
+	std::unordered_map<std::string, Entry> Entries;
+	std::unordered_map<T*, std::string> Keys;
+	uint64_t Hits = 0;
+	uint64_t Misses = 0;
+
+	// Returns the cached object with another reference, or null when the object needs to be created
+	T* Acquire(const std::string& Key)
+	{
+		std::lock_guard<std::mutex> CacheLock(Lock);
+		auto Found = Entries.find(Key);
+		if (Found == Entries.end())
+		{
+			Misses++;
+			return nullptr;
+		}
+
+		Hits++;
+		Found->second.References++;
+		return Found->second.Object;
+	}
+
+	// Adds a newly created object. If another thread created the same object in the meantime, the new one is destroyed and the existing one is returned.
+	T* Insert(const std::string& Key, T* Created, void (*Destroy)(T*))
+	{
+		T* Existing = nullptr;
+		{
+			std::lock_guard<std::mutex> CacheLock(Lock);
+			auto Found = Entries.find(Key);
+			if (Found == Entries.end())
+			{
+				Entries.emplace(Key, Entry{ Created, 1 });
+				Keys.emplace(Created, Key);
+				return Created;
+			}
+
+			Found->second.References++;
+			Existing = Found->second.Object;
+		}
+
+		Destroy(Created);
+		return Existing;
+	}
+
+	// Returns true when the last reference was released, after which the caller destroys the object
+	bool Release(T* Object)
+	{
+		std::lock_guard<std::mutex> CacheLock(Lock);
+		auto Key = Keys.find(Object);
+		if (Key == Keys.end())
+			return true;
+
+		auto Found = Entries.find(Key->second);
+		if (--Found->second.References > 0)
+			return false;
+
+		Entries.erase(Found);
+		Keys.erase(Key);
+		return true;
+	}
+
+	llrm::CacheCounters GetCounters()
+	{
+		std::lock_guard<std::mutex> CacheLock(Lock);
+		return { Hits, Misses, static_cast<uint32_t>(Entries.size()) };
+	}
+
+	// Forgets every object without destroying them, used when the device they were created on is gone
+	void Clear()
+	{
+		std::lock_guard<std::mutex> CacheLock(Lock);
+		Entries.clear();
+		Keys.clear();
+		Hits = 0;
+		Misses = 0;
+	}
+};
+
+namespace llrm
+{
+	// Held while submitting to or presenting with the queues, or waiting for the device to idle. Code that uses the queues directly, such as ImGui's Vulkan backend, must hold it too.
+	extern std::mutex GQueueMutex;
+}
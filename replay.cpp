@@ -0,0 +1,41 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "llrm.h"
+#include "llrm_capture.h"
+
+int main(int ArgCount, char** Args)
+{
+	if (ArgCount < 2)
+	{
+		std::cerr << "Usage: LLRM-replay <capture> [loops]" << std::endl;
+		return 1;
+	}
+
+	const char* Path = Args[1];
+	uint32_t Loops = ArgCount > 2 ? static_cast<uint32_t>(std::strtoul(Args[2], nullptr, 10)) : 1;
+
+	// Captures don't depend on a window, their swap chains are replayed as textures
+	llrm::Context Context = llrm::CreateContext({ .bHeadless = true });
+	if (!Context)
+	{
+		std::cerr << "Failed to create a headless context" << std::endl;
+		return 1;
+	}
+
+	llrm::ReplayStats Stats;
+	bool bSuccess = llrm::ReplayCapture(Path, Loops, Stats);
+
+	std::cout << "Replayed " << Path << (bSuccess ? "" : " (stopped at a malformed record)") << std::endl;
+	std::cout << "  Frames:   " << Stats.Frames << " over " << Loops << " loop(s)" << std::endl;
+	std::cout << "  Calls:    " << Stats.Calls << " (" << Stats.SkippedCalls << " skipped)" << std::endl;
+	std::cout << "  Snapshot: " << Stats.SnapshotMs << " ms" << std::endl;
+	std::cout << "  Replay:   " << Stats.FramesMs << " ms";
+	if (Stats.Frames > 0)
+		std::cout << " (" << Stats.FramesMs / Stats.Frames << " ms per frame)";
+	std::cout << std::endl;
+
+	llrm::DestroyContext(Context);
+
+	return bSuccess ? 0 : 1;
+}
@@ -135,6 +135,8 @@ std::string GetProgramPath()
     char ModulePath[1024];
     (void)GetModuleFileNameA(NULL, ModulePath, std::size(ModulePath));
     return ModulePath;
+#else
+    return std::filesystem::canonical("/proc/self/exe").string();
 #endif
 }
 
@@ -235,7 +237,7 @@ bool CompileShader(std::string Vert, std::string Frag, ShaderCompileResult& OutR
     if (!LoadShaderSource(Frag, FragSrc))
         return false;
 
-#ifdef LLRM_VULKAN
+#if defined(LLRM_VULKAN) || defined(LLRM_NULL)
     return HlslToSpv(VertSrc, FragSrc, OutResult);
 #endif
 }
@@ -168,6 +168,7 @@ int main()
 		}
 		EndImGuiFrame();
 
+		// No frame is begun while the window can't be rendered to, e.g. when it's minimized, so there's nothing to end either
 		int32_t ImageIndex = llrm::BeginFrame(Window, WndDat.Swap, WndDat.Surface);
 		if(ImageIndex >= 0)
 		{